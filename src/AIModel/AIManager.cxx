@@ -45,6 +45,9 @@
 #include "AIGroundVehicle.hxx"
 #include "AIEscort.hxx"
 
+// how far an object may move between spatial index rebuilds
+const double FGAIManager::INDEX_SLACK_M = 500.0;
+
 FGAIManager::FGAIManager() :
     cb_ai_bare(SGPropertyChangeCallback<FGAIManager>(this,&FGAIManager::updateLOD,
                fgGetNode("/sim/rendering/static-lod/ai-bare", true))),
@@ -168,6 +171,8 @@ FGAIManager::update(double dt) {
     }
   
     ai_list.erase(ai_list.begin(), firstAlive);
+
+    rebuildSpatialIndex();
   
     // every remaining item is alive
     BOOST_FOREACH(FGAIBase* base, ai_list) {
@@ -393,59 +398,72 @@ FGAIManager::getStartPosition(const string& id, const string& pid,
     return found;
 }
 
+void
+FGAIManager::rebuildSpatialIndex()
+{
+    spatial_index.clear();
+    BOOST_FOREACH(FGAIBase* base, ai_list) {
+        spatial_index.insert(base, base->getType(), base->getCartPos());
+    }
+    spatial_index.commit();
+}
+
+void
+FGAIManager::findObjectsInRange(const SGVec3d& cartPos, double rangeM, unsigned int typeMask,
+                                FGAISpatialIndex::ObjectVec& result) const
+{
+    spatial_index.findWithinRange(cartPos, rangeM + INDEX_SLACK_M, typeMask, result);
+}
+
+void
+FGAIManager::findNearestObjects(const SGVec3d& cartPos, unsigned int k, double maxRangeM,
+                                unsigned int typeMask, FGAISpatialIndex::ObjectVec& result) const
+{
+    spatial_index.findNearest(cartPos, k, maxRangeM + INDEX_SLACK_M, typeMask, result);
+}
+
 const FGAIBase *
 FGAIManager::calcCollision(double alt, double lat, double lon, double fuse_range)
 {
     // we specify tgt extent (ft) according to the AIObject type
-    double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
-    double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
-    ai_list_iterator ai_list_itr = ai_list.begin();
-    ai_list_iterator end = ai_list.end();
+    static const double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
+    static const double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
+    static const double max_length = 750;
+
+    // ballistic objects, storms and thermals can't be hit
+    static const unsigned int hit_types = FGAISpatialIndex::ALL_TYPES &
+        ~((1u << FGAIBase::otBallistic) | (1u << FGAIBase::otStorm) |
+          (1u << FGAIBase::otThermal));
 
     SGGeod pos(SGGeod::fromDegFt(lon, lat, alt));
     SGVec3d cartPos(SGVec3d::fromGeod(pos));
-    
-    while (ai_list_itr != end) {
-        double tgt_alt = (*ai_list_itr)->_getAltitude();
-        int type       = (*ai_list_itr)->getType();
-        tgt_ht[type] += fuse_range;
-
-        if (fabs(tgt_alt - alt) > tgt_ht[type] || type == FGAIBase::otBallistic
-            || type == FGAIBase::otStorm || type == FGAIBase::otThermal ) {
-                //SG_LOG(SG_AI, SG_DEBUG, "AIManager: skipping "
-                //    << fabs(tgt_alt - alt)
-                //    << " "
-                //    << type
-                //    );
-                ++ai_list_itr;
-                continue;
-        }
 
-        int id         = (*ai_list_itr)->getID();
+    // candidates come back nearest first
+    findObjectsInRange(cartPos, (max_length + fuse_range) * SG_FEET_TO_METER,
+                       hit_types, collision_candidates);
 
-        double range = calcRange(cartPos, (*ai_list_itr));
+    BOOST_FOREACH(FGAIBase* base, collision_candidates) {
+        if (base->getDie()) {
+            continue;
+        }
 
-        //SG_LOG(SG_AI, SG_DEBUG, "AIManager:  AI list size "
-        //    << ai_list.size()
-        //    << " type " << type
-        //    << " ID " << id
-        //    << " range " << range
-        //    //<< " bearing " << bearing
-        //    << " alt " << tgt_alt
-        //    );
+        double tgt_alt = base->_getAltitude();
+        int type       = base->getType();
 
-        tgt_length[type] += fuse_range;
+        if (fabs(tgt_alt - alt) > tgt_ht[type] + fuse_range) {
+            continue;
+        }
 
-        if (range < tgt_length[type]){
+        double range = calcRange(cartPos, base);
+        if (range < tgt_length[type] + fuse_range) {
             SG_LOG(SG_AI, SG_DEBUG, "AIManager: HIT! "
                 << " type " << type
-                << " ID " << id
+                << " ID " << base->getID()
                 << " range " << range
                 << " alt " << tgt_alt
                 );
-            return (*ai_list_itr).get();
+            return base;
         }
-        ++ai_list_itr;
     }
     return 0;
 }
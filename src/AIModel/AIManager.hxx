@@ -33,6 +33,7 @@
 
 #include <AIModel/AIBase.hxx>
 #include <AIModel/AIFlightPlan.hxx>
+#include <AIModel/AISpatialIndex.hxx>
 
 #include <Traffic/SchedFlight.hxx>
 #include <Traffic/Schedule.hxx>
@@ -72,6 +73,19 @@ public:
 
     const FGAIBase *calcCollision(double alt, double lat, double lon, double fuse_range);
 
+    /**
+     * Spatial queries over the AI objects, see FGAISpatialIndex. The index
+     * is rebuilt once per frame, so objects may have moved by up to
+     * INDEX_SLACK_M since; query ranges are padded accordingly and callers
+     * needing exact ranges should re-check the current positions.
+     */
+    void findObjectsInRange(const SGVec3d& cartPos, double rangeM, unsigned int typeMask,
+                            FGAISpatialIndex::ObjectVec& result) const;
+    void findNearestObjects(const SGVec3d& cartPos, unsigned int k, double maxRangeM,
+                            unsigned int typeMask, FGAISpatialIndex::ObjectVec& result) const;
+
+    static const double INDEX_SLACK_M;
+
     inline double get_user_latitude() const { return user_latitude; }
     inline double get_user_longitude() const { return user_longitude; }
     inline double get_user_altitude() const { return user_altitude; }
@@ -98,6 +112,11 @@ private:
   
     double calcRange(const SGVec3d& aCartPos, FGAIBase* aObject) const;
 
+    void rebuildSpatialIndex();
+
+    FGAISpatialIndex spatial_index;
+    FGAISpatialIndex::ObjectVec collision_candidates;
+
     SGPropertyNode_ptr root;
     SGPropertyNode_ptr enabled;
     SGPropertyNode_ptr thermal_lift_node;
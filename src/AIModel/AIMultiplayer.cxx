@@ -25,6 +25,7 @@
 #  include <config.h>
 #endif
 
+#include <cstring>
 #include <string>
 
 #include "AIMultiplayer.hxx"
@@ -32,6 +33,9 @@
 
 // #define SG_DEBUG SG_ALERT
 
+std::vector<int> FGAIMultiplayer::sPropertySlots;
+unsigned FGAIMultiplayer::sNumPropertySlots = 0;
+
 FGAIMultiplayer::FGAIMultiplayer() :
    FGAIBase(otMultiplayer, false)
 {
@@ -43,6 +47,13 @@ FGAIMultiplayer::FGAIMultiplayer() :
    mLastTimestamp = 0;
    lastUpdateTime = 0;
 
+   mMotionInfo.resize(MOTION_SAMPLES);
+   mMotionFirst = 0;
+   mMotionCount = 0;
+   mMotionCursor = 0;
+
+   mPropertiesApplied = 0;
+   mPropertiesSkipped = 0;
 } 
 
 FGAIMultiplayer::~FGAIMultiplayer() {
@@ -109,7 +120,7 @@ void FGAIMultiplayer::update(double dt)
   FGAIBase::update(dt);
 
   // Check if we already got data
-  if (mMotionInfo.empty())
+  if (mMotionCount == 0)
     return;
 
   // The current simulation time we need to update for,
@@ -118,8 +129,8 @@ void FGAIMultiplayer::update(double dt)
   double curtime = globals->get_sim_time_sec();
 
   // Get the last available time
-  MotionInfo::reverse_iterator it = mMotionInfo.rbegin();
-  double curentPkgTime = it->second.time;
+  FGExternalMotionData& lastMotion = motionAt(mMotionCount - 1);
+  double curentPkgTime = lastMotion.time;
 
   // Dynamically optimize the time offset between the feeder and the client
   // Well, 'dynamically' means that the dynamic of that update must be very
@@ -130,7 +141,7 @@ void FGAIMultiplayer::update(double dt)
   // component will provide this. We just take the error of the currently
   // requested time to the most recent available packet. This is the
   // target we want to reach in average.
-  double lag = it->second.lag;
+  double lag = lastMotion.lag;
   if (!mTimeOffsetSet) {
     mTimeOffsetSet = true;
     mTimeOffset = curentPkgTime - curtime - lag;
@@ -169,7 +180,7 @@ void FGAIMultiplayer::update(double dt)
       SG_LOG(SG_AI, SG_DEBUG, "Offset adjust system: time offset = "
              << mTimeOffset << ", expected longitudinal position error due to "
              " current adjustment of the offset: "
-             << fabs(norm(it->second.linearVel)*systemIncrement));
+             << fabs(norm(lastMotion.linearVel)*systemIncrement));
     }
   }
 
@@ -186,65 +197,29 @@ void FGAIMultiplayer::update(double dt)
     // that is good ...
 
     // Find the first packet before the target time
-    MotionInfo::iterator nextIt = mMotionInfo.upper_bound(tInterp);
-    if (nextIt == mMotionInfo.begin()) {
+    unsigned next = findMotionAfter(tInterp);
+    // at the time of the last packet: interpolate up to it
+    if (next == mMotionCount)
+      --next;
+    if (next == 0) {
       SG_LOG(SG_AI, SG_DEBUG, "Taking oldest packet!");
       // We have no packet before the target time, just use the first one
-      MotionInfo::iterator firstIt = mMotionInfo.begin();
-      ecPos = firstIt->second.position;
-      ecOrient = firstIt->second.orientation;
-      speed = norm(firstIt->second.linearVel) * SG_METER_TO_NM * 3600.0;
-
-      std::vector<FGPropertyData*>::const_iterator firstPropIt;
-      std::vector<FGPropertyData*>::const_iterator firstPropItEnd;
-      firstPropIt = firstIt->second.properties.begin();
-      firstPropItEnd = firstIt->second.properties.end();
-      while (firstPropIt != firstPropItEnd) {
-        //cout << " Setting property..." << (*firstPropIt)->id;
-        PropertyMap::iterator pIt = mPropertyMap.find((*firstPropIt)->id);
-        if (pIt != mPropertyMap.end())
-        {
-          //cout << "Found " << pIt->second->getPath() << ":";
-          switch ((*firstPropIt)->type) {
-            case props::INT:
-            case props::BOOL:
-            case props::LONG:
-              pIt->second->setIntValue((*firstPropIt)->int_value);
-              //cout << "Int: " << (*firstPropIt)->int_value << "\n";
-              break;
-            case props::FLOAT:
-            case props::DOUBLE:
-              pIt->second->setFloatValue((*firstPropIt)->float_value);
-              //cout << "Flo: " << (*firstPropIt)->float_value << "\n";
-              break;
-            case props::STRING:
-            case props::UNSPECIFIED:
-              pIt->second->setStringValue((*firstPropIt)->string_value);
-              //cout << "Str: " << (*firstPropIt)->string_value << "\n";    
-              break;
-            default:
-              // FIXME - currently defaults to float values
-              pIt->second->setFloatValue((*firstPropIt)->float_value);
-              //cout << "Unknown: " << (*firstPropIt)->float_value << "\n";
-              break;
-          }            
-        }
-        else
-        {
-          SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << (*firstPropIt)->id << "\n");
-        }
-        ++firstPropIt;
-      }
+      FGExternalMotionData& first = motionAt(0);
+      ecPos = first.position;
+      ecOrient = first.orientation;
+      speed = norm(first.linearVel) * SG_METER_TO_NM * 3600.0;
+
+      setProperties(first);
 
     } else {
       // Ok, we have really found something where our target time is in between
       // do interpolation here
-      MotionInfo::iterator prevIt = nextIt;
-      --prevIt;
+      FGExternalMotionData& prevMotion = motionAt(next - 1);
+      FGExternalMotionData& nextMotion = motionAt(next);
 
       // Interpolation coefficient is between 0 and 1
-      double intervalStart = prevIt->second.time;
-      double intervalEnd = nextIt->second.time;
+      double intervalStart = prevMotion.time;
+      double intervalEnd = nextMotion.time;
       double intervalLen = intervalEnd - intervalStart;
       double tau = (tInterp - intervalStart)/intervalLen;
 
@@ -253,83 +228,60 @@ void FGAIMultiplayer::update(double dt)
              << intervalLen << ", interpolation parameter = " << tau);
 
       // Here we do just linear interpolation on the position
-      ecPos = ((1-tau)*prevIt->second.position + tau*nextIt->second.position);
-      ecOrient = interpolate((float)tau, prevIt->second.orientation,
-                             nextIt->second.orientation);
-      speed = norm((1-tau)*prevIt->second.linearVel
-                   + tau*nextIt->second.linearVel) * SG_METER_TO_NM * 3600.0;
-
-      if (prevIt->second.properties.size()
-          == nextIt->second.properties.size()) {
+      ecPos = ((1-tau)*prevMotion.position + tau*nextMotion.position);
+      ecOrient = interpolate((float)tau, prevMotion.orientation,
+                             nextMotion.orientation);
+      speed = norm((1-tau)*prevMotion.linearVel
+                   + tau*nextMotion.linearVel) * SG_METER_TO_NM * 3600.0;
+
+      if (prevMotion.properties.size()
+          == nextMotion.properties.size()) {
         std::vector<FGPropertyData*>::const_iterator prevPropIt;
         std::vector<FGPropertyData*>::const_iterator prevPropItEnd;
         std::vector<FGPropertyData*>::const_iterator nextPropIt;
         std::vector<FGPropertyData*>::const_iterator nextPropItEnd;
-        prevPropIt = prevIt->second.properties.begin();
-        prevPropItEnd = prevIt->second.properties.end();
-        nextPropIt = nextIt->second.properties.begin();
-        nextPropItEnd = nextIt->second.properties.end();
+        prevPropIt = prevMotion.properties.begin();
+        prevPropItEnd = prevMotion.properties.end();
+        nextPropIt = nextMotion.properties.begin();
+        nextPropItEnd = nextMotion.properties.end();
         while (prevPropIt != prevPropItEnd) {
-          PropertyMap::iterator pIt = mPropertyMap.find((*prevPropIt)->id);
-          //cout << " Setting property..." << (*prevPropIt)->id;
-          
-          if (pIt != mPropertyMap.end())
-          {
-            //cout << "Found " << pIt->second->getPath() << ":";
-          
-            int ival;
-            float val;
-            switch ((*prevPropIt)->type) {
-              case props::INT:
-              case props::BOOL:
-              case props::LONG:
-                ival = (int) (0.5+(1-tau)*((double) (*prevPropIt)->int_value) +
-                  tau*((double) (*nextPropIt)->int_value));
-                pIt->second->setIntValue(ival);
-                //cout << "Int: " << ival << "\n";
-                break;
-              case props::FLOAT:
-              case props::DOUBLE:
-                val = (1-tau)*(*prevPropIt)->float_value +
-                  tau*(*nextPropIt)->float_value;
-                //cout << "Flo: " << val << "\n";
-                pIt->second->setFloatValue(val);
-                break;
-              case props::STRING:
-              case props::UNSPECIFIED:
-                //cout << "Str: " << (*nextPropIt)->string_value << "\n";
-                pIt->second->setStringValue((*nextPropIt)->string_value);
-                break;
-              default:
-                // FIXME - currently defaults to float values
-                val = (1-tau)*(*prevPropIt)->float_value +
-                  tau*(*nextPropIt)->float_value;
-                //cout << "Unk: " << val << "\n";
-                pIt->second->setFloatValue(val);
-                break;
-            }            
-          }
-          else
-          {
-            SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << (*prevPropIt)->id << "\n");
+          unsigned id = (*prevPropIt)->id;
+          switch ((*prevPropIt)->type) {
+            case props::INT:
+            case props::BOOL:
+            case props::LONG:
+              setIntProperty(id, (int) (0.5+(1-tau)*((double) (*prevPropIt)->int_value) +
+                                        tau*((double) (*nextPropIt)->int_value)));
+              break;
+            case props::FLOAT:
+            case props::DOUBLE:
+              setFloatProperty(id, (1-tau)*(*prevPropIt)->float_value +
+                                   tau*(*nextPropIt)->float_value);
+              break;
+            case props::STRING:
+            case props::UNSPECIFIED:
+              setStringProperty(id, (*nextPropIt)->string_value);
+              break;
+            default:
+              // FIXME - currently defaults to float values
+              setFloatProperty(id, (1-tau)*(*prevPropIt)->float_value +
+                                   tau*(*nextPropIt)->float_value);
+              break;
           }
-          
+
           ++prevPropIt;
           ++nextPropIt;
         }
       }
 
-      // Now throw away too old data
-      if (prevIt != mMotionInfo.begin()) 
-      {
-        --prevIt;
-        mMotionInfo.erase(mMotionInfo.begin(), prevIt);
-      }
+      // Now throw away too old data, keeping one sample before prevMotion
+      if (next > 2)
+        dropMotion(next - 2);
     }
   } else {
     // Ok, we need to predict the future, so, take the best data we can have
     // and do some eom computation to guess that for now.
-    FGExternalMotionData& motionInfo = it->second;
+    FGExternalMotionData& motionInfo = lastMotion;
 
     // The time to predict, limit to 5 seconds
     double t = tInterp - motionInfo.time;
@@ -359,48 +311,8 @@ void FGAIMultiplayer::update(double dt)
       t -= h;
     }
 
-    std::vector<FGPropertyData*>::const_iterator firstPropIt;
-    std::vector<FGPropertyData*>::const_iterator firstPropItEnd;
     speed = norm(linearVel) * SG_METER_TO_NM * 3600.0;
-    firstPropIt = it->second.properties.begin();
-    firstPropItEnd = it->second.properties.end();
-    while (firstPropIt != firstPropItEnd) {
-      PropertyMap::iterator pIt = mPropertyMap.find((*firstPropIt)->id);
-      //cout << " Setting property..." << (*firstPropIt)->id;
-      
-      if (pIt != mPropertyMap.end())
-      {
-        switch ((*firstPropIt)->type) {
-          case props::INT:
-          case props::BOOL:
-          case props::LONG:
-            pIt->second->setIntValue((*firstPropIt)->int_value);
-            //cout << "Int: " << (*firstPropIt)->int_value << "\n";
-            break;
-          case props::FLOAT:
-          case props::DOUBLE:
-            pIt->second->setFloatValue((*firstPropIt)->float_value);
-            //cout << "Flo: " << (*firstPropIt)->float_value << "\n";
-            break;
-          case props::STRING:
-          case props::UNSPECIFIED:
-            pIt->second->setStringValue((*firstPropIt)->string_value);
-            //cout << "Str: " << (*firstPropIt)->string_value << "\n";
-            break;
-          default:
-            // FIXME - currently defaults to float values
-            pIt->second->setFloatValue((*firstPropIt)->float_value);
-            //cout << "Unk: " << (*firstPropIt)->float_value << "\n";
-            break;
-        }            
-      }
-      else
-      {
-        SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << (*firstPropIt)->id << "\n");
-      }
-      
-      ++firstPropIt;
-    }
+    setProperties(lastMotion);
   }
   
   // extract the position
@@ -472,21 +384,78 @@ FGAIMultiplayer::addMotionInfo(FGExternalMotionData& motionInfo,
 {
   mLastTimestamp = stamp;
 
-  if (!mMotionInfo.empty()) {
-    double diff = motionInfo.time - mMotionInfo.rbegin()->first;
+  bool replace = false;
+  if (mMotionCount > 0) {
+    double diff = motionInfo.time - motionAt(mMotionCount - 1).time;
 
     // packet is very old -- MP has probably reset (incl. his timebase)
     if (diff < -10.0)
-      mMotionInfo.clear();
+      dropMotion(mMotionCount);
 
     // drop packets arriving out of order
     else if (diff < 0.0)
       return;
+
+    // a packet for the same time replaces the previous one
+    else if (diff == 0.0)
+      replace = true;
   }
-  mMotionInfo[motionInfo.time] = motionInfo;
-  // We just copied the property (pointer) list - they are ours now. Clear the
+
+  if (!replace && (mMotionCount == MOTION_SAMPLES))
+    dropMotion(1);
+
+  FGExternalMotionData& slot = motionAt(replace ? mMotionCount - 1 : mMotionCount++);
+  std::vector<FGPropertyData*>::const_iterator propIt;
+  for (propIt = slot.properties.begin(); propIt != slot.properties.end(); ++propIt)
+    delete *propIt;
+
+  // We take over the property (pointer) list - they are ours now. Clear the
   // properties list in given/returned object, so former owner won't deallocate them.
-  motionInfo.properties.clear();
+  std::vector<FGPropertyData*> properties;
+  properties.swap(motionInfo.properties);
+  slot = motionInfo;
+  slot.properties.swap(properties);
+}
+
+// the index of the first sample later than time, or mMotionCount
+unsigned
+FGAIMultiplayer::findMotionAfter(double time)
+{
+  unsigned i = mMotionCursor;
+  if ((i > mMotionCount) || ((i > 0) && (motionAt(i - 1).time > time))) {
+    // went back in time: binary search
+    unsigned lo = 0, hi = mMotionCount;
+    while (lo < hi) {
+      unsigned mid = (lo + hi) / 2;
+      if (motionAt(mid).time <= time)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    i = lo;
+  } else {
+    while ((i < mMotionCount) && (motionAt(i).time <= time))
+      ++i;
+  }
+  mMotionCursor = i;
+  return i;
+}
+
+// throw away the oldest count samples
+void
+FGAIMultiplayer::dropMotion(unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i) {
+    FGExternalMotionData& motion = motionAt(i);
+    std::vector<FGPropertyData*>::const_iterator propIt;
+    for (propIt = motion.properties.begin(); propIt != motion.properties.end(); ++propIt)
+      delete *propIt;
+    motion.properties.clear();
+  }
+
+  mMotionFirst = (mMotionFirst + count) & (MOTION_SAMPLES - 1);
+  mMotionCount -= count;
+  mMotionCursor = mMotionCursor > count ? mMotionCursor - count : 0;
 }
 
 void
@@ -495,3 +464,108 @@ FGAIMultiplayer::setDoubleProperty(const std::string& prop, double val)
   SGPropertyNode* pNode = props->getChild(prop.c_str(), true);
   pNode->setDoubleValue(val);
 }
+
+void
+FGAIMultiplayer::addPropertyId(unsigned id, const char* name)
+{
+  if (id >= sPropertySlots.size())
+    sPropertySlots.resize(id + 1, -1);
+  if (sPropertySlots[id] < 0)
+    sPropertySlots[id] = sNumPropertySlots++;
+
+  unsigned slot = sPropertySlots[id];
+  if (slot >= mProperties.size())
+    mProperties.resize(slot + 1);
+  mProperties[slot].node = props->getNode(name, true);
+}
+
+FGAIMultiplayer::PropertySlot*
+FGAIMultiplayer::findProperty(unsigned id)
+{
+  if (id < sPropertySlots.size()) {
+    int slot = sPropertySlots[id];
+    if ((slot >= 0) && ((unsigned) slot < mProperties.size())
+        && mProperties[slot].node)
+      return &mProperties[slot];
+  }
+
+  SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << id << "\n");
+  return 0;
+}
+
+// Properties which already hold the value received are not written again,
+// so that their listeners are not fired. The node itself is compared, as
+// anything else, Nasal or a reset, may have changed it since.
+
+void
+FGAIMultiplayer::setIntProperty(unsigned id, int value)
+{
+  PropertySlot* slot = findProperty(id);
+  if (!slot)
+    return;
+  if (slot->node->hasValue() && (slot->node->getIntValue() == value)) {
+    ++mPropertiesSkipped;
+    return;
+  }
+  slot->node->setIntValue(value);
+  ++mPropertiesApplied;
+}
+
+void
+FGAIMultiplayer::setFloatProperty(unsigned id, float value)
+{
+  PropertySlot* slot = findProperty(id);
+  if (!slot)
+    return;
+  if (slot->node->hasValue() && (slot->node->getFloatValue() == value)) {
+    ++mPropertiesSkipped;
+    return;
+  }
+  slot->node->setFloatValue(value);
+  ++mPropertiesApplied;
+}
+
+void
+FGAIMultiplayer::setStringProperty(unsigned id, const char* value)
+{
+  PropertySlot* slot = findProperty(id);
+  if (!slot)
+    return;
+  if (!value)
+    value = "";
+  if (slot->node->hasValue() && !strcmp(slot->node->getStringValue(), value)) {
+    ++mPropertiesSkipped;
+    return;
+  }
+  slot->node->setStringValue(value);
+  ++mPropertiesApplied;
+}
+
+// set the properties of a sample as they are
+void
+FGAIMultiplayer::setProperties(const FGExternalMotionData& motionInfo)
+{
+  std::vector<FGPropertyData*>::const_iterator propIt;
+  for (propIt = motionInfo.properties.begin();
+       propIt != motionInfo.properties.end(); ++propIt) {
+    switch ((*propIt)->type) {
+      case simgear::props::INT:
+      case simgear::props::BOOL:
+      case simgear::props::LONG:
+        setIntProperty((*propIt)->id, (*propIt)->int_value);
+        break;
+      case simgear::props::FLOAT:
+      case simgear::props::DOUBLE:
+        setFloatProperty((*propIt)->id, (*propIt)->float_value);
+        break;
+      case simgear::props::STRING:
+      case simgear::props::UNSPECIFIED:
+        setStringProperty((*propIt)->id, (*propIt)->string_value);
+        break;
+      default:
+        // FIXME - currently defaults to float values
+        setFloatProperty((*propIt)->id, (*propIt)->float_value);
+        break;
+    }
+  }
+}
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <MultiPlayer/mpmessages.hxx>
 #include "AIBase.hxx"
@@ -55,8 +56,14 @@ public:
   double getLagAdjustSystemSpeed(void) const
   { return mLagAdjustSystemSpeed; }
 
-  void addPropertyId(unsigned id, const char* name)
-  { mPropertyMap[id] = props->getNode(name, true); }
+  void addPropertyId(unsigned id, const char* name);
+
+  // received property values written to the tree, and skipped because
+  // they did not change
+  unsigned getPropertiesApplied() const
+  { return mPropertiesApplied; }
+  unsigned getPropertiesSkipped() const
+  { return mPropertiesSkipped; }
 
   SGPropertyNode* getPropertyRoot()
   { return props; }
@@ -65,14 +72,40 @@ public:
 
 private:
 
-  // Automatic sorting of motion data according to its timestamp
-  typedef std::map<double,FGExternalMotionData> MotionInfo;
-  MotionInfo mMotionInfo;
-
-  // Map between the property id's from the multiplayers network packets
-  // and the property nodes
-  typedef std::map<unsigned, SGSharedPtr<SGPropertyNode> > PropertyMap;
-  PropertyMap mPropertyMap;
+  // Motion data ordered by timestamp, in a ring buffer of MOTION_SAMPLES
+  // entries; the oldest samples are overwritten when it is full
+  enum { MOTION_SAMPLES = 256 };
+  std::vector<FGExternalMotionData> mMotionInfo;
+  unsigned mMotionFirst;
+  unsigned mMotionCount;
+  // where the last lookup ended, the next one usually ends there or
+  // slightly later
+  unsigned mMotionCursor;
+
+  FGExternalMotionData& motionAt(unsigned i)
+  { return mMotionInfo[(mMotionFirst + i) & (MOTION_SAMPLES - 1)]; }
+  unsigned findMotionAfter(double time);
+  void dropMotion(unsigned count);
+
+  // The property node for a property id from the multiplayers network
+  // packets
+  struct PropertySlot {
+    SGPropertyNode_ptr node;
+  };
+  std::vector<PropertySlot> mProperties;
+
+  // The slot of each property id, or -1; the same for all multiplayers
+  static std::vector<int> sPropertySlots;
+  static unsigned sNumPropertySlots;
+
+  PropertySlot* findProperty(unsigned id);
+  void setIntProperty(unsigned id, int value);
+  void setFloatProperty(unsigned id, float value);
+  void setStringProperty(unsigned id, const char* value);
+  void setProperties(const FGExternalMotionData& motionInfo);
+
+  unsigned mPropertiesApplied;
+  unsigned mPropertiesSkipped;
 
   double mTimeOffset;
   bool mTimeOffsetSet;
@@ -0,0 +1,263 @@
+// FGAISpatialIndex - uniform grid over the cartesian (ECEF) positions of
+// AI objects, for range and proximity queries
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/math/sg_random.h>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "AISpatialIndex.hxx"
+#include "AIBase.hxx"
+
+// cell coordinates are packed into 21 bits each, which covers the whole
+// earth with any cell size above ~7m
+static const int CELL_BITS = 21;
+static const int CELL_BIAS = 1 << (CELL_BITS - 1);
+
+FGAISpatialIndex::FGAISpatialIndex(double cellSizeM) :
+    _cellSize(cellSizeM)
+{
+}
+
+void
+FGAISpatialIndex::clear()
+{
+    _entries.clear();
+}
+
+void
+FGAISpatialIndex::insert(FGAIBase* object, int type, const SGVec3d& cartPos)
+{
+    Entry e;
+    e.cell = cellKey(cellCoord(cartPos.x()), cellCoord(cartPos.y()),
+                     cellCoord(cartPos.z()));
+    e.type = type;
+    e.object = object;
+    e.cart = cartPos;
+    _entries.push_back(e);
+}
+
+void
+FGAISpatialIndex::commit()
+{
+    std::sort(_entries.begin(), _entries.end());
+}
+
+int
+FGAISpatialIndex::cellCoord(double v) const
+{
+    return static_cast<int>(floor(v / _cellSize));
+}
+
+unsigned long long
+FGAISpatialIndex::cellKey(int x, int y, int z)
+{
+    return (static_cast<unsigned long long>(x + CELL_BIAS) << (2 * CELL_BITS)) |
+        (static_cast<unsigned long long>(y + CELL_BIAS) << CELL_BITS) |
+        static_cast<unsigned long long>(z + CELL_BIAS);
+}
+
+void
+FGAISpatialIndex::collectEntries(EntryVec::const_iterator begin,
+                                 EntryVec::const_iterator end,
+                                 const SGVec3d& cartPos, double rangeSqr,
+                                 unsigned int typeMask,
+                                 RangedObjectVec& found) const
+{
+    for (EntryVec::const_iterator it = begin; it != end; ++it) {
+        if (!(typeMask & (1u << it->type))) {
+            continue;
+        }
+
+        double d2 = distSqr(cartPos, it->cart);
+        if (d2 <= rangeSqr) {
+            found.push_back(RangedObject(d2, it->object));
+        }
+    }
+}
+
+void
+FGAISpatialIndex::collect(const SGVec3d& cartPos, double rangeM,
+                          unsigned int typeMask, RangedObjectVec& found) const
+{
+    found.clear();
+    if (_entries.empty()) {
+        return;
+    }
+
+    double rangeSqr = rangeM * rangeM;
+    int x0 = cellCoord(cartPos.x() - rangeM), x1 = cellCoord(cartPos.x() + rangeM);
+    int y0 = cellCoord(cartPos.y() - rangeM), y1 = cellCoord(cartPos.y() + rangeM);
+    int z0 = cellCoord(cartPos.z() - rangeM), z1 = cellCoord(cartPos.z() + rangeM);
+
+    // for large ranges, visiting the cells costs more than a plain scan
+    double columns = double(x1 - x0 + 1) * double(y1 - y0 + 1);
+    if (columns > _entries.size()) {
+        collectEntries(_entries.begin(), _entries.end(), cartPos, rangeSqr,
+                       typeMask, found);
+        return;
+    }
+
+    // z is the least significant part of the key, so each (x, y) column of
+    // cells is a contiguous range of the sorted entries
+    Entry lo, hi;
+    for (int x = x0; x <= x1; ++x) {
+        for (int y = y0; y <= y1; ++y) {
+            lo.cell = cellKey(x, y, z0);
+            hi.cell = cellKey(x, y, z1);
+            EntryVec::const_iterator begin =
+                std::lower_bound(_entries.begin(), _entries.end(), lo);
+            EntryVec::const_iterator end =
+                std::upper_bound(begin, _entries.end(), hi);
+            collectEntries(begin, end, cartPos, rangeSqr, typeMask, found);
+        }
+    }
+}
+
+void
+FGAISpatialIndex::findWithinRange(const SGVec3d& cartPos, double rangeM,
+                                  unsigned int typeMask, ObjectVec& result) const
+{
+    result.clear();
+    collect(cartPos, rangeM, typeMask, _scratch);
+    std::sort(_scratch.begin(), _scratch.end());
+
+    result.reserve(_scratch.size());
+    for (RangedObjectVec::const_iterator it = _scratch.begin(); it != _scratch.end(); ++it) {
+        result.push_back(it->second);
+    }
+}
+
+void
+FGAISpatialIndex::findNearest(const SGVec3d& cartPos, unsigned int k,
+                              double maxRangeM, unsigned int typeMask,
+                              ObjectVec& result) const
+{
+    result.clear();
+    if (k == 0) {
+        return;
+    }
+
+    // grow the search sphere until it holds enough candidates
+    double range = std::min(_cellSize, maxRangeM);
+    for (;;) {
+        collect(cartPos, range, typeMask, _scratch);
+        if ((_scratch.size() >= k) || (range >= maxRangeM)) {
+            break;
+        }
+        range = std::min(range * 2.0, maxRangeM);
+    }
+
+    unsigned int n = std::min<unsigned int>(k, _scratch.size());
+    std::partial_sort(_scratch.begin(), _scratch.begin() + n, _scratch.end());
+
+    result.reserve(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        result.push_back(_scratch[i].second);
+    }
+}
+
+void
+FGAISpatialIndex::benchmark(unsigned int numObjects, unsigned int numQueries,
+                            double rangeM, SGPropertyNode* results)
+{
+    // synthetic traffic: random positions within ~100km of a point,
+    // between the surface and FL400
+    const SGGeod center = SGGeod::fromDeg(8.57, 50.03);
+    const double spreadDeg = 1.0;
+    const double maxAltFt = 40000.0;
+
+    if ((numObjects == 0) || (numQueries == 0)) {
+        return;
+    }
+
+    FGAISpatialIndex index;
+    std::vector<SGVec3d> positions;
+    for (unsigned int i = 0; i < numObjects; ++i) {
+        SGGeod g = SGGeod::fromDegFt(center.getLongitudeDeg() + (sg_random() - 0.5) * 2 * spreadDeg,
+                                     center.getLatitudeDeg() + (sg_random() - 0.5) * 2 * spreadDeg,
+                                     sg_random() * maxAltFt);
+        SGVec3d cart = SGVec3d::fromGeod(g);
+        positions.push_back(cart);
+        index.insert(NULL, 1 + (i % (FGAIBase::MAX_OBJECTS - 1)), cart);
+    }
+
+    SGTimeStamp st;
+    st.stamp();
+    index.commit();
+    double buildMSec = st.elapsedMSec();
+
+    std::vector<SGVec3d> queries;
+    for (unsigned int q = 0; q < numQueries; ++q) {
+        queries.push_back(positions[q % positions.size()]);
+    }
+
+    // linear scan, as FGAIManager::calcCollision used to do
+    st.stamp();
+    unsigned int linearHits = 0;
+    double rangeSqr = rangeM * rangeM;
+    for (unsigned int q = 0; q < numQueries; ++q) {
+        for (unsigned int i = 0; i < positions.size(); ++i) {
+            if (distSqr(queries[q], positions[i]) <= rangeSqr) {
+                ++linearHits;
+            }
+        }
+    }
+    double linearMSec = st.elapsedMSec();
+
+    st.stamp();
+    unsigned int indexHits = 0;
+    ObjectVec found;
+    for (unsigned int q = 0; q < numQueries; ++q) {
+        index.findWithinRange(queries[q], rangeM, ALL_TYPES, found);
+        indexHits += found.size();
+    }
+    double indexMSec = st.elapsedMSec();
+
+    st.stamp();
+    for (unsigned int q = 0; q < numQueries; ++q) {
+        index.findNearest(queries[q], 8, 100000.0, ALL_TYPES, found);
+    }
+    double nearestMSec = st.elapsedMSec();
+
+    SG_LOG(SG_AI, SG_INFO, "AI spatial index benchmark: " << numObjects
+           << " objects, " << numQueries << " queries of " << rangeM << "m: build "
+           << buildMSec << "ms, linear " << linearMSec << "ms (" << linearHits
+           << " hits), indexed " << indexMSec << "ms (" << indexHits
+           << " hits), nearest-8 " << nearestMSec << "ms");
+
+    if (linearHits != indexHits) {
+        SG_LOG(SG_AI, SG_ALERT, "AI spatial index benchmark: result mismatch");
+    }
+
+    if (results) {
+        results->setIntValue("objects", numObjects);
+        results->setIntValue("queries", numQueries);
+        results->setDoubleValue("build-msec", buildMSec);
+        results->setDoubleValue("linear-msec", linearMSec);
+        results->setDoubleValue("indexed-msec", indexMSec);
+        results->setDoubleValue("nearest-msec", nearestMSec);
+        results->setBoolValue("results-match", linearHits == indexHits);
+    }
+}
@@ -0,0 +1,104 @@
+// FGAISpatialIndex - uniform grid over the cartesian (ECEF) positions of
+// AI objects, for range and proximity queries
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AISPATIALINDEX_HXX
+#define _FG_AISPATIALINDEX_HXX
+
+#include <vector>
+
+#include <simgear/math/SGMath.hxx>
+
+class FGAIBase;
+class SGPropertyNode;
+
+/**
+ * Objects are bucketed into cubic cells of the earth-centred cartesian
+ * frame. The index is rebuilt from scratch (clear, insert, commit) rather
+ * than updated, which keeps it a single sorted array: queries binary-search
+ * the cells overlapping the query sphere.
+ *
+ * Type masks are bit sets of (1 << FGAIBase::object_type); ALL_TYPES
+ * matches every object.
+ */
+class FGAISpatialIndex
+{
+public:
+    typedef std::vector<FGAIBase*> ObjectVec;
+
+    static const unsigned int ALL_TYPES = ~0u;
+
+    FGAISpatialIndex(double cellSizeM = 2000.0);
+
+    void clear();
+    void insert(FGAIBase* object, int type, const SGVec3d& cartPos);
+
+    /// sort the inserted objects; must be called before querying
+    void commit();
+
+    unsigned int size() const { return _entries.size(); }
+
+    /**
+     * All objects within rangeM of cartPos whose type is in typeMask,
+     * ordered by increasing distance.
+     */
+    void findWithinRange(const SGVec3d& cartPos, double rangeM,
+                         unsigned int typeMask, ObjectVec& result) const;
+
+    /**
+     * The (up to) k nearest objects within maxRangeM of cartPos whose type
+     * is in typeMask, ordered by increasing distance.
+     */
+    void findNearest(const SGVec3d& cartPos, unsigned int k, double maxRangeM,
+                     unsigned int typeMask, ObjectVec& result) const;
+
+    /**
+     * Compare range queries through the index against a linear scan, using
+     * synthetic traffic spread over an area around a point. Timings are
+     * logged and written below results, if not NULL.
+     */
+    static void benchmark(unsigned int numObjects, unsigned int numQueries,
+                          double rangeM, SGPropertyNode* results);
+private:
+    struct Entry
+    {
+        unsigned long long cell;
+        int type;
+        FGAIBase* object;
+        SGVec3d cart;
+
+        bool operator<(const Entry& other) const { return cell < other.cell; }
+    };
+
+    typedef std::vector<Entry> EntryVec;
+    typedef std::pair<double, FGAIBase*> RangedObject;
+    typedef std::vector<RangedObject> RangedObjectVec;
+
+    int cellCoord(double v) const;
+    static unsigned long long cellKey(int x, int y, int z);
+
+    void collect(const SGVec3d& cartPos, double rangeM, unsigned int typeMask,
+                 RangedObjectVec& found) const;
+    void collectEntries(EntryVec::const_iterator begin, EntryVec::const_iterator end,
+                        const SGVec3d& cartPos, double rangeSqr, unsigned int typeMask,
+                        RangedObjectVec& found) const;
+
+    double _cellSize;
+    EntryVec _entries;
+    mutable RangedObjectVec _scratch;
+};
+
+#endif  // _FG_AISPATIALINDEX_HXX
@@ -25,6 +25,7 @@
 #endif
 
 #include <algorithm>
+#include <cmath>
 
 #include <osg/Geode>
 #include <osg/Geometry>
@@ -440,6 +441,130 @@ bool FGTrafficRecord::pushBackAllowed() const
     return allowPushback;
 }
 
+/***************************************************************************
+ * FGTrafficIndex
+ *
+ **************************************************************************/
+const double FGTrafficIndex::CELL_SIZE = 0.002;
+
+FGTrafficIndex::FGTrafficIndex() :
+        maxRadius(0)
+{
+}
+
+FGTrafficIndex::Cell FGTrafficIndex::cellOf(double lat, double lon)
+{
+    return Cell((int) floor(lat / CELL_SIZE), (int) floor(lon / CELL_SIZE));
+}
+
+void FGTrafficIndex::add(TrafficVectorIterator rec)
+{
+    EntryMap::iterator e = entries.find(rec->getId());
+    if (e != entries.end()) {
+        removeFromCell(e->second.cell, e->second.rec);
+    }
+
+    Entry entry;
+    entry.rec = rec;
+    entry.cell = cellOf(rec->getLatitude(), rec->getLongitude());
+    entries[rec->getId()] = entry;
+    cells[entry.cell].push_back(rec);
+    if (rec->getRadius() > maxRadius) {
+        maxRadius = rec->getRadius();
+    }
+}
+
+void FGTrafficIndex::remove(TrafficVectorIterator rec)
+{
+    EntryMap::iterator e = entries.find(rec->getId());
+    if (e != entries.end()) {
+        removeFromCell(e->second.cell, e->second.rec);
+        entries.erase(e);
+    }
+}
+
+void FGTrafficIndex::moved(TrafficVectorIterator rec)
+{
+    EntryMap::iterator e = entries.find(rec->getId());
+    if (e == entries.end()) {
+        return;
+    }
+    Cell cell = cellOf(rec->getLatitude(), rec->getLongitude());
+    if (cell != e->second.cell) {
+        removeFromCell(e->second.cell, rec);
+        cells[cell].push_back(rec);
+        e->second.cell = cell;
+    }
+}
+
+void FGTrafficIndex::removeFromCell(const Cell& cell, TrafficVectorIterator rec)
+{
+    CellMap::iterator c = cells.find(cell);
+    if (c == cells.end()) {
+        return;
+    }
+    TrafficIteratorVec::iterator i = std::find(c->second.begin(), c->second.end(), rec);
+    if (i != c->second.end()) {
+        c->second.erase(i);
+    }
+    if (c->second.empty()) {
+        cells.erase(c);
+    }
+}
+
+void FGTrafficIndex::clear()
+{
+    entries.clear();
+    cells.clear();
+    maxRadius = 0;
+}
+
+void FGTrafficIndex::swap(FGTrafficIndex& other)
+{
+    entries.swap(other.entries);
+    cells.swap(other.cells);
+    std::swap(maxRadius, other.maxRadius);
+}
+
+TrafficVectorIterator FGTrafficIndex::find(int id, TrafficVector& traffic) const
+{
+    EntryMap::const_iterator e = entries.find(id);
+    return (e != entries.end()) ? e->second.rec : traffic.end();
+}
+
+void FGTrafficIndex::findNear(double lat, double lon, double range,
+                              TrafficIteratorVec& result) const
+{
+    // a degree of latitude is at least 110.5 km, one of longitude at least
+    // 111.3 km times the cosine of the latitude: round both down
+    double dLat = range / 110000.0;
+    double maxLat = fabs(lat) + dLat;
+    double dLon = (maxLat < 89.0) ?
+        range / (111000.0 * cos(maxLat * SGD_DEGREES_TO_RADIANS)) : 360.0;
+
+    Cell low = cellOf(lat - dLat, lon - dLon);
+    Cell high = cellOf(lat + dLat, lon + dLon);
+    double numCells = (high.first - low.first + 1.0) * (high.second - low.second + 1.0);
+
+    // near the poles or the date line, or when there are more cells to
+    // look at than cells with traffic, take all of it
+    if ((lon - dLon < -180.0) || (lon + dLon > 180.0) || (numCells > cells.size())) {
+        for (CellMap::const_iterator c = cells.begin(); c != cells.end(); c++) {
+            result.insert(result.end(), c->second.begin(), c->second.end());
+        }
+        return;
+    }
+
+    for (int y = low.first; y <= high.first; y++) {
+        for (int x = low.second; x <= high.second; x++) {
+            CellMap::const_iterator c = cells.find(Cell(y, x));
+            if (c != cells.end()) {
+                result.insert(result.end(), c->second.begin(), c->second.end());
+            }
+        }
+    }
+}
+
 
 
 
@@ -816,18 +941,7 @@ void FGTowerController::announcePosition(int id,
         FGAIAircraft * ref)
 {
     init();
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search whether the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     // Add a new TrafficRecord if no one exsists for this aircraft.
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         FGTrafficRecord rec;
@@ -840,6 +954,7 @@ void FGTowerController::announcePosition(int id,
         rec.setRadius(radius);
         rec.setAircraft(ref);
         activeTraffic.push_back(rec);
+        trafficIndex.add(--activeTraffic.end());
         // Don't just schedule the aircraft for the tower controller, also assign if to the correct active runway.
         ActiveRunwayVecIterator rwy = activeRunways.begin();
         if (activeRunways.size()) {
@@ -862,6 +977,7 @@ void FGTowerController::announcePosition(int id,
         //cerr << ref->getTrafficRef()->getCallSign() << " You are number " << rwy->getDepartureCueSize() <<  " for takeoff " << endl;
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
     }
 }
 
@@ -869,25 +985,15 @@ void FGTowerController::updateAircraftInformation(int id, double lat, double lon
         double heading, double speed, double alt,
         double dt)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search whether the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     TrafficVectorIterator current, closest;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
 //    // update position of the current aircraft
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: updating aircraft without traffic record at " << SG_ORIGIN);
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
         current = i;
     }
     setDt(getDt() + dt);
@@ -953,18 +1059,7 @@ void FGTowerController::updateAircraftInformation(int id, double lat, double lon
 
 void FGTowerController::signOff(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     // If this aircraft has left the runway, we can clear the departure record for this runway
     ActiveRunwayVecIterator rwy = activeRunways.begin();
     if (activeRunways.size()) {
@@ -988,6 +1083,7 @@ void FGTowerController::signOff(int id)
                "AI error: Aircraft without traffic record is signing off from tower at " << SG_ORIGIN);
     } else {
         i->getAircraft()->resetTakeOffStatus();
+        trafficIndex.remove(i);
         i = activeTraffic.erase(i);
         //cerr << "Signing off from tower controller" << endl;
     }
@@ -1001,18 +1097,7 @@ void FGTowerController::signOff(int id)
 // Note that this function is probably obsolete
 bool FGTowerController::hasInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: checking ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1025,18 +1110,7 @@ bool FGTowerController::hasInstruction(int id)
 
 FGATCInstruction FGTowerController::getInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: requesting ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1080,18 +1154,7 @@ void FGStartupController::announcePosition(int id,
         FGAIAircraft * ref)
 {
     init();
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search whether the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     // Add a new TrafficRecord if no one exsists for this aircraft.
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         FGTrafficRecord rec;
@@ -1105,9 +1168,11 @@ void FGStartupController::announcePosition(int id,
         rec.setAircraft(ref);
         rec.setHoldPosition(true);
         activeTraffic.push_back(rec);
+        trafficIndex.add(--activeTraffic.end());
     } else {
         i->setPositionAndIntentions(currentPosition, intendedRoute);
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
 
     }
 }
@@ -1120,18 +1185,7 @@ void FGStartupController::announcePosition(int id,
 // Note that this function is probably obsolete
 bool FGStartupController::hasInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: checking ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1144,18 +1198,7 @@ bool FGStartupController::hasInstruction(int id)
 
 FGATCInstruction FGStartupController::getInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: requesting ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1167,23 +1210,13 @@ FGATCInstruction FGStartupController::getInstruction(int id)
 
 void FGStartupController::signOff(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: Aircraft without traffic record is signing off from tower at " << SG_ORIGIN);
     } else {
         //cerr << i->getAircraft()->getCallSign() << " signing off from startupcontroller" << endl;
+        trafficIndex.remove(i);
         i = activeTraffic.erase(i);
     }
 }
@@ -1225,19 +1258,8 @@ void FGStartupController::updateAircraftInformation(int id, double lat, double l
         double heading, double speed, double alt,
         double dt)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     TrafficVectorIterator current, closest;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
 //    // update position of the current aircraft
 
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
@@ -1245,6 +1267,7 @@ void FGStartupController::updateAircraftInformation(int id, double lat, double l
                "AI error: updating aircraft without traffic record at " << SG_ORIGIN);
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
         current = i;
     }
     setDt(getDt() + dt);
@@ -1538,18 +1561,7 @@ void FGApproachController::announcePosition(int id,
         int leg, FGAIAircraft * ref)
 {
     init();
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search whether the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     // Add a new TrafficRecord if no one exsists for this aircraft.
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         FGTrafficRecord rec;
@@ -1561,8 +1573,10 @@ void FGApproachController::announcePosition(int id,
         //rec.setCallSign(callsign);
         rec.setAircraft(ref);
         activeTraffic.push_back(rec);
+        trafficIndex.add(--activeTraffic.end());
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
     }
 }
 
@@ -1570,25 +1584,15 @@ void FGApproachController::updateAircraftInformation(int id, double lat, double
         double heading, double speed, double alt,
         double dt)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     TrafficVectorIterator current, closest;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
 //    // update position of the current aircraft
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: updating aircraft without traffic record at " << SG_ORIGIN);
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
         current = i;
         //cerr << "ApproachController: checking for speed" << endl;
         time_t time_diff =
@@ -1620,22 +1624,12 @@ void FGApproachController::updateAircraftInformation(int id, double lat, double
 
 void FGApproachController::signOff(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: Aircraft without traffic record is signing off from approach at " << SG_ORIGIN);
     } else {
+        trafficIndex.remove(i);
         i = activeTraffic.erase(i);
     }
 }
@@ -1649,18 +1643,7 @@ void FGApproachController::update(double dt)
 
 bool FGApproachController::hasInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: checking ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1673,18 +1656,7 @@ bool FGApproachController::hasInstruction(int id)
 
 FGATCInstruction FGApproachController::getInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_ATC, SG_ALERT,
                "AI error: requesting ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
 
 #include <osg/Geode>
 #include <osg/Geometry>
@@ -166,6 +167,9 @@ public:
         radius = rad;
     };
     void setPositionAndIntentions(int pos, FGAIFlightPlan *route);
+    void setCurrentPosition(int pos) {
+        currentPos = pos;
+    };
     void setRunway(const std::string& rwy) {
         runway = rwy;
     };
@@ -308,6 +312,68 @@ public:
 
 typedef std::list<FGTrafficRecord> TrafficVector;
 typedef std::list<FGTrafficRecord>::iterator TrafficVectorIterator;
+typedef std::vector<TrafficVectorIterator> TrafficIteratorVec;
+
+/***********************************************************************
+ * The active traffic of a controller by aircraft id, and by position.
+ * Positions are kept in cells of CELL_SIZE degrees, so that the traffic
+ * near an aircraft is found without looking at all of it.
+ **********************************************************************/
+class FGTrafficIndex
+{
+public:
+    static const double CELL_SIZE;
+
+    FGTrafficIndex();
+
+    // call after adding a record to the active traffic
+    void add(TrafficVectorIterator rec);
+    // call before erasing a record from the active traffic
+    void remove(TrafficVectorIterator rec);
+    // call after changing the position of a record
+    void moved(TrafficVectorIterator rec);
+    void clear();
+    void swap(FGTrafficIndex& other);
+
+    /**
+     * The record of an aircraft, or traffic.end() if it has none.
+     */
+    TrafficVectorIterator find(int id, TrafficVector& traffic) const;
+
+    /**
+     * Add the records that may be within range meters of a position to
+     * result. Some of them may be further away, but none closer is left
+     * out.
+     */
+    void findNear(double lat, double lon, double range,
+                  TrafficIteratorVec& result) const;
+
+    int size() const {
+        return entries.size();
+    };
+    // the largest radius of the records added so far
+    double getMaxRadius() const {
+        return maxRadius;
+    };
+
+private:
+    typedef std::pair<int, int> Cell;
+
+    struct Entry {
+        TrafficVectorIterator rec;
+        Cell cell;
+    };
+
+    typedef std::map<int, Entry> EntryMap;
+    typedef std::map<Cell, TrafficIteratorVec> CellMap;
+
+    static Cell cellOf(double lat, double lon);
+    void removeFromCell(const Cell& cell, TrafficVectorIterator rec);
+
+    EntryMap entries;
+    CellMap cells;
+    double maxRadius;
+};
 
 typedef std::vector<time_t> TimeVector;
 typedef std::vector<time_t>::iterator TimeVectorIterator;
@@ -462,6 +528,7 @@ class FGTowerController : public FGATCController
 {
 private:
     TrafficVector activeTraffic;
+    FGTrafficIndex trafficIndex;
     ActiveRunwayVec activeRunways;
     FGAirportDynamics *parent;
 
@@ -487,6 +554,9 @@ public:
     TrafficVector &getActiveTraffic() {
         return activeTraffic;
     };
+    const FGTrafficIndex &getTrafficIndex() const {
+        return trafficIndex;
+    };
 };
 
 /******************************************************************************
@@ -498,6 +568,7 @@ class FGStartupController : public FGATCController
 {
 private:
     TrafficVector activeTraffic;
+    FGTrafficIndex trafficIndex;
     //ActiveRunwayVec activeRunways;
     FGAirportDynamics *parent;
 
@@ -538,6 +609,7 @@ class FGApproachController : public FGATCController
 {
 private:
     TrafficVector activeTraffic;
+    FGTrafficIndex trafficIndex;
     ActiveRunwayVec activeRunways;
     FGAirportDynamics *parent;
 
@@ -31,6 +31,7 @@
 #include <simgear/debug/logstream.hxx>
 #include <simgear/props/props_io.hxx>
 #include <simgear/misc/ResourceManager.hxx>
+#include <simgear/misc/stdint.hxx>
 #include <simgear/misc/strutils.hxx>
 #include <simgear/structure/exception.hxx>
 #include <simgear/math/SGMath.hxx>
@@ -278,6 +279,17 @@ FGFlightRecorder::processSignalList(const char* pSignalType, TSignalList& Signal
                                 << pInterpolation<< "' of signal '" << PPath << "'");
                         Capture.Interpolation = linear;
                     }
+
+                    // optional lossy storage on tapes, only for floating point signals
+                    Capture.Quantum = 0.0;
+                    if ((0==strcmp(pSignalType,"double"))||
+                        (0==strcmp(pSignalType,"float")))
+                    {
+                        Capture.Quantum = SignalNode->getDoubleValue("quantum", 0.0);
+                        if (Capture.Quantum < 0.0)
+                            Capture.Quantum = 0.0;
+                    }
+
                     if (haveProperty(Capture.Signal))
                     {
                         SG_LOG(SG_SYSTEMS, SG_ALERT, "FlightRecorder: Property '"
@@ -578,6 +590,8 @@ FGFlightRecorder::getConfig(SGPropertyNode* root, const char* typeStr, const Fli
         SignalProp->setStringValue("type", typeStr);
         SignalProp->setStringValue("interpolation", InterpolationTypes[SignalList[i].Interpolation]);
         SignalProp->setStringValue("property", SignalList[i].Signal->getPath());
+        if (SignalList[i].Quantum > 0.0)
+            SignalProp->setDoubleValue("quantum", SignalList[i].Quantum);
     }
     SG_LOG(SG_SYSTEMS, SG_DEBUG, "FlightRecorder: Have " << SignalCount << " signals of type " << typeStr);
     root->setIntValue(typeStr, SignalCount);
@@ -599,3 +613,252 @@ FGFlightRecorder::getConfig(SGPropertyNode* root)
     root->setIntValue("recorder/record-size", getRecordSize());
     root->setIntValue("recorder/signal-count", SignalCount);
 }
+
+/******************************************************************************
+ * Column format of flight recorder tapes.
+ *
+ * A block of records is transposed into one column per signal (sim time
+ * first, then all signals in record order). Consecutive values of a column
+ * are mostly identical or close, so each value is stored relative to its
+ * predecessor:
+ *  - doubles/floats: XOR of the IEEE bit patterns, as a varint. Signals with
+ *    a "quantum" are rounded to multiples of it and stored as integer deltas
+ *    instead (lossy, but much smaller).
+ *  - integers: zigzag encoded deltas, as varints.
+ *  - booleans: XOR of the packed flag bytes.
+ * The gzip container compresses the (mostly zero) result further.
+ *****************************************************************************/
+
+/** Quantised values beyond this many steps (or NaN) are stored as 0. */
+static const double MaxQuantumSteps = 4.0e18;
+
+static inline void
+putVarint(std::string& Buffer, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        Buffer.push_back((char) ((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    Buffer.push_back((char) v);
+}
+
+static inline bool
+getVarint(const unsigned char*& p, const unsigned char* pEnd, uint64_t& v)
+{
+    v = 0;
+    for (int Shift=0; (p<pEnd)&&(Shift<64); Shift+=7)
+    {
+        unsigned char c = *p++;
+        v |= ((uint64_t) (c & 0x7f)) << Shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static inline uint64_t
+zigzag(int64_t v)
+{
+    return (((uint64_t) v) << 1) ^ ((uint64_t) (v >> 63));
+}
+
+static inline int64_t
+unzigzag(uint64_t v)
+{
+    return ((int64_t) (v >> 1)) ^ -((int64_t) (v & 1));
+}
+
+template<class T, class TBits>
+static void
+encodeRealColumn(const char* const* Rows, size_t Count, int Offset, double Quantum, std::string& Buffer)
+{
+    if (Quantum > 0.0)
+    {
+        int64_t Last = 0;
+        for (size_t r=0; r<Count; r++)
+        {
+            T v;
+            memcpy(&v, Rows[r] + Offset, sizeof(T));
+            double Steps = floor(v / Quantum + 0.5);
+            int64_t Step = ((Steps > -MaxQuantumSteps)&&(Steps < MaxQuantumSteps)) ? (int64_t) Steps : 0;
+            putVarint(Buffer, zigzag(Step - Last));
+            Last = Step;
+        }
+    }
+    else
+    {
+        TBits Last = 0;
+        for (size_t r=0; r<Count; r++)
+        {
+            TBits Bits;
+            memcpy(&Bits, Rows[r] + Offset, sizeof(TBits));
+            putVarint(Buffer, Bits ^ Last);
+            Last = Bits;
+        }
+    }
+}
+
+template<class T, class TBits>
+static bool
+decodeRealColumn(const unsigned char*& p, const unsigned char* pEnd, char* const* Rows, size_t Count,
+                 int Offset, double Quantum)
+{
+    uint64_t u;
+    if (Quantum > 0.0)
+    {
+        int64_t Last = 0;
+        for (size_t r=0; r<Count; r++)
+        {
+            if (!getVarint(p, pEnd, u))
+                return false;
+            Last += unzigzag(u);
+            T v = (T) (Last * Quantum);
+            memcpy(Rows[r] + Offset, &v, sizeof(T));
+        }
+    }
+    else
+    {
+        TBits Last = 0;
+        for (size_t r=0; r<Count; r++)
+        {
+            if (!getVarint(p, pEnd, u))
+                return false;
+            Last ^= (TBits) u;
+            memcpy(Rows[r] + Offset, &Last, sizeof(TBits));
+        }
+    }
+    return true;
+}
+
+template<class T>
+static void
+encodeIntColumn(const char* const* Rows, size_t Count, int Offset, std::string& Buffer)
+{
+    int64_t Last = 0;
+    for (size_t r=0; r<Count; r++)
+    {
+        T v;
+        memcpy(&v, Rows[r] + Offset, sizeof(T));
+        putVarint(Buffer, zigzag((int64_t) v - Last));
+        Last = v;
+    }
+}
+
+template<class T>
+static bool
+decodeIntColumn(const unsigned char*& p, const unsigned char* pEnd, char* const* Rows, size_t Count, int Offset)
+{
+    uint64_t u;
+    int64_t Last = 0;
+    for (size_t r=0; r<Count; r++)
+    {
+        if (!getVarint(p, pEnd, u))
+            return false;
+        Last += unzigzag(u);
+        T v = (T) Last;
+        memcpy(Rows[r] + Offset, &v, sizeof(T));
+    }
+    return true;
+}
+
+/** Append records [First, First+Count) of the given list to Buffer, in column format. */
+void
+FGFlightRecorder::encodeColumns(const replay_list_type& Records, size_t First, size_t Count,
+                                std::string& Buffer)
+{
+    std::vector<const char*> RowVec(Count);
+    for (size_t r=0; r<Count; r++)
+        RowVec[r] = (const char*) Records[First+r];
+    const char* const* Rows = Count ? &RowVec[0] : NULL;
+
+    Buffer.clear();
+    putVarint(Buffer, Count);
+
+    int Offset = 0;
+    encodeRealColumn<double, uint64_t>(Rows, Count, Offset, 0.0, Buffer); // sim time
+    Offset += sizeof(double);
+
+    for (size_t i=0; i<m_CaptureDouble.size(); i++, Offset += sizeof(double))
+        encodeRealColumn<double, uint64_t>(Rows, Count, Offset, m_CaptureDouble[i].Quantum, Buffer);
+    for (size_t i=0; i<m_CaptureFloat.size(); i++, Offset += sizeof(float))
+        encodeRealColumn<float, uint32_t>(Rows, Count, Offset, m_CaptureFloat[i].Quantum, Buffer);
+    for (size_t i=0; i<m_CaptureInteger.size(); i++, Offset += sizeof(int))
+        encodeIntColumn<int>(Rows, Count, Offset, Buffer);
+    for (size_t i=0; i<m_CaptureInt16.size(); i++, Offset += sizeof(short int))
+        encodeIntColumn<short int>(Rows, Count, Offset, Buffer);
+    for (size_t i=0; i<m_CaptureInt8.size(); i++, Offset += sizeof(signed char))
+        encodeIntColumn<signed char>(Rows, Count, Offset, Buffer);
+
+    // booleans: one column per flag byte
+    int FlagBytes = (m_CaptureBool.size()+7)/8;
+    for (int b=0; b<FlagBytes; b++, Offset++)
+    {
+        unsigned char Last = 0;
+        for (size_t r=0; r<Count; r++)
+        {
+            unsigned char v = (unsigned char) Rows[r][Offset];
+            Buffer.push_back((char) (v ^ Last));
+            Last = v;
+        }
+    }
+
+    assert(Offset == m_TotalRecordSize);
+}
+
+/** Decode a block in column format. Its Count records are stored back to back
+ * (getRecordSize() bytes each) in Records.
+ * Returns false when the block is corrupt or does not match the current
+ * signal configuration. */
+bool
+FGFlightRecorder::decodeColumns(const char* pData, size_t Size, std::vector<char>& Records, size_t& Count)
+{
+    const unsigned char* p = (const unsigned char*) pData;
+    const unsigned char* pEnd = p + Size;
+
+    // every record takes at least one byte per column
+    uint64_t RecordCount = 0;
+    if ((!getVarint(p, pEnd, RecordCount))||(RecordCount > Size)||(!m_TotalRecordSize))
+        return false;
+    Count = RecordCount;
+
+    Records.resize(Count * m_TotalRecordSize);
+    std::vector<char*> RowVec(Count);
+    for (size_t r=0; r<Count; r++)
+        RowVec[r] = &Records[r * m_TotalRecordSize];
+    char* const* Rows = Count ? &RowVec[0] : NULL;
+
+    int Offset = 0;
+    bool ok = decodeRealColumn<double, uint64_t>(p, pEnd, Rows, Count, Offset, 0.0);
+    Offset += sizeof(double);
+
+    for (size_t i=0; ok && i<m_CaptureDouble.size(); i++, Offset += sizeof(double))
+        ok = decodeRealColumn<double, uint64_t>(p, pEnd, Rows, Count, Offset, m_CaptureDouble[i].Quantum);
+    for (size_t i=0; ok && i<m_CaptureFloat.size(); i++, Offset += sizeof(float))
+        ok = decodeRealColumn<float, uint32_t>(p, pEnd, Rows, Count, Offset, m_CaptureFloat[i].Quantum);
+    for (size_t i=0; ok && i<m_CaptureInteger.size(); i++, Offset += sizeof(int))
+        ok = decodeIntColumn<int>(p, pEnd, Rows, Count, Offset);
+    for (size_t i=0; ok && i<m_CaptureInt16.size(); i++, Offset += sizeof(short int))
+        ok = decodeIntColumn<short int>(p, pEnd, Rows, Count, Offset);
+    for (size_t i=0; ok && i<m_CaptureInt8.size(); i++, Offset += sizeof(signed char))
+        ok = decodeIntColumn<signed char>(p, pEnd, Rows, Count, Offset);
+
+    int FlagBytes = (m_CaptureBool.size()+7)/8;
+    for (int b=0; ok && b<FlagBytes; b++, Offset++)
+    {
+        if ((size_t) (pEnd - p) < Count)
+        {
+            ok = false;
+            break;
+        }
+        unsigned char Last = 0;
+        for (size_t r=0; r<Count; r++)
+        {
+            Last ^= *p++;
+            Rows[r][Offset] = (char) Last;
+        }
+    }
+
+    // the block must be consumed exactly, otherwise the signals don't match
+    return ok && (p == pEnd);
+}
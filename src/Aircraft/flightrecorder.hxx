@@ -41,6 +41,7 @@ namespace FlightRecorder
     {
         SGPropertyNode_ptr  Signal;
         TInterpolation      Interpolation;
+        double              Quantum;    // tape storage resolution, 0 for lossless
     } TCapture;
 
     typedef std::vector<TCapture> TSignalList;
@@ -64,6 +65,11 @@ public:
     int             getRecordSize       (void) { return m_TotalRecordSize;}
     void            getConfig           (SGPropertyNode* root);
 
+    void            encodeColumns       (const replay_list_type& Records, size_t First, size_t Count,
+                                         std::string& Buffer);
+    bool            decodeColumns       (const char* pData, size_t Size, std::vector<char>& Records,
+                                         size_t& Count);
+
 private:
     SGPropertyNode_ptr getDefault(void);
     void initSignalList(const char* pSignalType, FlightRecorder::TSignalList& SignalList,
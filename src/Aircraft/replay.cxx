@@ -26,6 +26,9 @@
 #endif
 
 #include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
 
 #include <simgear/constants.h>
 #include <simgear/structure/exception.hxx>
@@ -40,7 +43,6 @@
 #include "replay.hxx"
 #include "flightrecorder.hxx"
 
-using std::deque;
 using std::vector;
 using simgear::gzContainerReader;
 using simgear::gzContainerWriter;
@@ -64,11 +66,110 @@ namespace ReplayContainer
         Properties = 2, /**< XML data describing the recorded flight recorder properties.
                              Format is identical to flight recorder XML configuration. Also contains some
                              extra data to verify flight recorder consistency. */
-        RawData    = 3  /**< Actual binary data blobs (the recorder's tape).
+        RawData    = 3, /**< Actual binary data blobs (the recorder's tape).
                              One "RawData" blob is used for each resolution. */
+        TimeIndex  = 4, /**< XML data listing tier, time range, record count and size of
+                             each following "ColumnData" block (column format tapes only). */
+        ColumnData = 5  /**< Block of records in column format, see FGFlightRecorder::encodeColumns. */
     };
 }
 
+/** Number of records per "ColumnData" block, i.e. granularity of the time index. */
+static const size_t ColumnBlockRecords = 1024;
+
+/** Value of "recorder/tape-format" in the tape's properties for column format tapes.
+ *  Tapes without this property use the raw format. */
+static const char* const ColumnTapeFormat = "columnar";
+
+/** Replay tiers in the order they're stored in column format tapes: oldest data first. */
+static const char* const ReplayTierNames[] = {"long-term", "medium-term", "short-term"};
+static const int ReplayTierCount = 3;
+
+FGReplayBuffer::FGReplayBuffer() :
+    m_pSlab(NULL),
+    m_RecordSize(0),
+    m_Stride(0),
+    m_Capacity(0),
+    m_First(0),
+    m_Count(0)
+{
+}
+
+FGReplayBuffer::~FGReplayBuffer()
+{
+    delete[] m_pSlab;
+}
+
+void
+FGReplayBuffer::reset(size_t RecordSize, size_t Capacity)
+{
+    delete[] m_pSlab;
+    m_pSlab = NULL;
+    m_RecordSize = RecordSize;
+    m_Stride = stride(RecordSize);
+    m_Capacity = (RecordSize > 0) ? Capacity : 0;
+    m_First = 0;
+    m_Count = 0;
+    if (m_Capacity)
+    {
+        m_pSlab = new (std::nothrow) char[m_Capacity * m_Stride];
+        if (!m_pSlab)
+        {
+            SG_LOG(SG_SYSTEMS, SG_ALERT, "ReplaySystem: Out of memory!");
+            m_Capacity = 0;
+        }
+    }
+}
+
+FGReplayData*
+FGReplayBuffer::append()
+{
+    if (!m_Capacity)
+        return NULL;
+    if (full())
+        pop_front();
+    m_Count++;
+    return back();
+}
+
+void
+FGReplayBuffer::push_back(const FGReplayData* pRecord)
+{
+    FGReplayData* pSlot = append();
+    if (pSlot)
+        memcpy(pSlot, pRecord, m_RecordSize);
+}
+
+void
+FGReplayBuffer::pop_front()
+{
+    if (!m_Count)
+        return;
+    m_Count--;
+    m_First++;
+    if (m_First >= m_Capacity)
+        m_First = 0;
+}
+
+size_t
+FGReplayBuffer::upperBound(double Time) const
+{
+    size_t First = 0;
+    size_t Count = m_Count;
+    while (Count > 0)
+    {
+        size_t Step = Count / 2;
+        if ((*this)[First + Step]->sim_time <= Time)
+        {
+            First += Step + 1;
+            Count -= Step + 1;
+        }
+        else
+            Count = Step;
+    }
+    return First;
+}
+
 /**
  * Constructor
  */
@@ -78,6 +179,7 @@ FGReplay::FGReplay() :
     last_mt_time(0.0),
     last_lt_time(0.0),
     last_msg_time(0),
+    last_stats_time(0),
     last_replay_state(0),
     m_high_res_time(60.0),
     m_medium_res_time(600.0),
@@ -106,26 +208,9 @@ FGReplay::~FGReplay()
 void
 FGReplay::clear()
 {
-    while ( !short_term.empty() )
-    {
-        m_pRecorder->deleteRecord(short_term.front());
-        short_term.pop_front();
-    }
-    while ( !medium_term.empty() )
-    {
-        m_pRecorder->deleteRecord(medium_term.front());
-        medium_term.pop_front();
-    }
-    while ( !long_term.empty() )
-    {
-        m_pRecorder->deleteRecord(long_term.front());
-        long_term.pop_front();
-    }
-    while ( !recycler.empty() )
-    {
-        m_pRecorder->deleteRecord(recycler.front());
-        recycler.pop_front();
-    }
+    short_term.clear();
+    medium_term.clear();
+    long_term.clear();
 
     // clear messages belonging to old replay session
     fgGetNode("/sim/replay/messages", 0, true)->removeChildren("msg", false);
@@ -162,6 +247,7 @@ FGReplay::reinit()
     last_mt_time = 0.0;
     last_lt_time = 0.0;
     last_msg_time = 0.0;
+    last_stats_time = 0.0;
 
     // Flush queues
     clear();
@@ -174,7 +260,7 @@ FGReplay::reinit()
     m_medium_sample_rate = fgGetDouble("/sim/replay/buffer/medium-res-sample-dt", 0.5); // medium term sample rate (sec)
     m_long_sample_rate   = fgGetDouble("/sim/replay/buffer/low-res-sample-dt",    5.0); // long term sample rate (sec)
 
-    fillRecycler();
+    allocateBuffers();
     loadMessages();
 
     replay_master->setIntValue(0);
@@ -202,23 +288,51 @@ FGReplay::unbind()
     // nothing to unbind
 }
 
+/** Size the replay buffers for the configured replay times, within the memory budget. */
 void
-FGReplay::fillRecycler()
+FGReplay::allocateBuffers()
 {
-    // Create an estimated nr of required ReplayData objects
+    size_t RecordSize = m_pRecorder->getRecordSize();
+
     // 120 is an estimated maximum frame rate.
-    int estNrObjects = (int) ((m_high_res_time*120) + (m_medium_res_time*m_medium_sample_rate) +
-                             (m_low_res_time*m_long_sample_rate));
-    for (int i = 0; i < estNrObjects; i++)
+    double Records[3];
+    Records[0] = m_high_res_time * 120;
+    Records[1] = m_medium_res_time / std::max(m_medium_sample_rate, 0.001);
+    Records[2] = m_low_res_time    / std::max(m_long_sample_rate,   0.001);
+
+    double Bytes = (Records[0] + Records[1] + Records[2]) * FGReplayBuffer::stride(RecordSize);
+    double Budget = fgGetDouble("/sim/replay/buffer/memory-budget-mbyte", 128.0) * 1024 * 1024;
+    double Scale = 1.0;
+    if ((Budget > 0)&&(Bytes > Budget))
     {
-        FGReplayData* r = m_pRecorder->createEmptyRecord();
-        if (r)
-            recycler.push_back(r);
-        else
-        {
-            SG_LOG(SG_SYSTEMS, SG_ALERT, "ReplaySystem: Out of memory!");
-        }
+        Scale = Budget / Bytes;
+        SG_LOG(SG_SYSTEMS, SG_WARN, "ReplaySystem: Replay buffers limited to memory budget of "
+               << Budget / (1024*1024) << " MB. Keeping " << (int) (Scale*100) << "% of the configured replay time.");
     }
+
+    short_term.reset (RecordSize, (size_t) (Records[0] * Scale) + 1);
+    medium_term.reset(RecordSize, (size_t) (Records[1] * Scale) + 1);
+    long_term.reset  (RecordSize, (size_t) (Records[2] * Scale) + 1);
+
+    updateStatistics();
+}
+
+/** Expose buffer usage and recording density in the property tree. */
+void
+FGReplay::updateStatistics()
+{
+    size_t Used = short_term.bytesUsed() + medium_term.bytesUsed() + long_term.bytesUsed();
+    size_t Allocated = short_term.bytesAllocated() + medium_term.bytesAllocated() + long_term.bytesAllocated();
+    double Duration = get_end_time() - get_start_time();
+
+    SGPropertyNode* Stats = fgGetNode("/sim/replay/buffer", true);
+    Stats->setDoubleValue("memory-used-mbyte",      Used / (1024*1024.0));
+    Stats->setDoubleValue("memory-allocated-mbyte", Allocated / (1024*1024.0));
+    Stats->setDoubleValue("recorded-time",          Duration);
+    Stats->setDoubleValue("bytes-per-second",       (Duration > 0) ? Used / Duration : 0.0);
+    Stats->setIntValue("high-res-records",          short_term.size());
+    Stats->setIntValue("medium-res-records",        medium_term.size());
+    Stats->setIntValue("low-res-records",           long_term.size());
 }
 
 static void
@@ -320,6 +434,7 @@ FGReplay::start(bool NewTape)
     unsigned long buffer_elements =  short_term.size()+medium_term.size()+long_term.size();
     fgSetDouble("/sim/replay/buffer-size-mbyte",
                 buffer_elements*m_pRecorder->getRecordSize() / (1024*1024.0));
+    updateStatistics();
     if ((fgGetBool("/sim/freeze/master"))||
         (0 == replay_master->getIntValue()))
         guiMessage("Replay active. 'Esc' to stop.");
@@ -487,6 +602,23 @@ FGReplay::update( double dt )
         sim_time = new_sim_time;
     }
 
+    // age the buffers before capturing, so a full short term buffer doesn't
+    // overwrite a record which is due for the medium term buffer
+    const FGReplayData* st_expired = expire(short_term, m_high_res_time);
+    if ( st_expired && (sim_time - last_mt_time > m_medium_sample_rate) )
+    {
+        last_mt_time = sim_time;
+        const FGReplayData* mt_expired = expire(medium_term, m_medium_res_time);
+        if ( mt_expired && (sim_time - last_lt_time > m_long_sample_rate) )
+        {
+            last_lt_time = sim_time;
+            expire(long_term, m_low_res_time);
+            long_term.push_back( mt_expired );
+        }
+        // after the long term copy - this may reuse the slot of mt_expired
+        medium_term.push_back( st_expired );
+    }
+
     FGReplayData* r = record(sim_time);
     if (!r)
     {
@@ -494,62 +626,10 @@ FGReplay::update( double dt )
         return;
     }
 
-    // update the short term list
-    short_term.push_back( r );
-    FGReplayData *st_front = short_term.front();
-    
-    if (!st_front)
+    if ( sim_time - last_stats_time >= 1.0 )
     {
-        SG_LOG(SG_SYSTEMS, SG_ALERT, "ReplaySystem: Inconsistent data!");
-    }
-
-    if ( sim_time - st_front->sim_time > m_high_res_time )
-    {
-        while ( sim_time - st_front->sim_time > m_high_res_time )
-        {
-            st_front = short_term.front();
-            recycler.push_back(st_front);
-            short_term.pop_front();
-        }
-
-        // update the medium term list
-        if ( sim_time - last_mt_time > m_medium_sample_rate )
-        {
-            last_mt_time = sim_time;
-            st_front = short_term.front();
-            medium_term.push_back( st_front );
-            short_term.pop_front();
-
-            FGReplayData *mt_front = medium_term.front();
-            if ( sim_time - mt_front->sim_time > m_medium_res_time )
-            {
-                while ( sim_time - mt_front->sim_time > m_medium_res_time )
-                {
-                    mt_front = medium_term.front();
-                    recycler.push_back(mt_front);
-                    medium_term.pop_front();
-                }
-                // update the long term list
-                if ( sim_time - last_lt_time > m_long_sample_rate )
-                {
-                    last_lt_time = sim_time;
-                    mt_front = medium_term.front();
-                    long_term.push_back( mt_front );
-                    medium_term.pop_front();
-
-                    FGReplayData *lt_front = long_term.front();
-                    if ( sim_time - lt_front->sim_time > m_low_res_time )
-                    {
-                        while ( sim_time - lt_front->sim_time > m_low_res_time )
-                        {
-                            lt_front = long_term.front();
-                            recycler.push_back(lt_front);
-                            long_term.pop_front();
-                        }
-                    }
-                }
-            }
-        }
+        last_stats_time = sim_time;
+        updateStatistics();
     }
 
 #if 0
@@ -566,16 +646,31 @@ FGReplay::update( double dt )
    //stamp("point_finished");
 }
 
-FGReplayData*
-FGReplay::record(double time)
+/**
+ * Drop records older than max_age from the given buffer, and the oldest
+ * record if the buffer is full. Returns the most recent dropped record, which
+ * stays valid until the next record is added to the buffer.
+ */
+const FGReplayData*
+FGReplay::expire(replay_list_type& list, double max_age)
 {
-    FGReplayData* r = NULL;
-
-    if (recycler.size())
+    const FGReplayData* expired = NULL;
+    while ( !list.empty() &&
+            (list.full() || (sim_time - list.front()->sim_time > max_age)) )
     {
-        r = recycler.front();
-        recycler.pop_front();
+        expired = list.front();
+        list.pop_front();
     }
+    return expired;
+}
+
+/** Capture a new record into the short term buffer. */
+FGReplayData*
+FGReplay::record(double time)
+{
+    FGReplayData* r = short_term.append();
+    if (!r)
+        return NULL;
 
     return m_pRecorder->capture(time, r);
 }
@@ -598,30 +693,14 @@ FGReplay::interpolate( double time, const replay_list_type &list)
         return;
     }
 
-    unsigned int last = list.size() - 1;
-    unsigned int first = 0;
-    unsigned int mid = ( last + first ) / 2;
+    // interpolate between the first frame after the given time and its predecessor
+    size_t next = list.upperBound(time);
+    if (next == 0)
+        next = 1;
+    else if (next >= list.size())
+        next = list.size() - 1;
 
-    bool done = false;
-    while ( !done )
-    {
-        // cout << "  " << first << " <=> " << last << endl;
-        if ( last == first ) {
-            done = true;
-        } else if ( list[mid]->sim_time < time && list[mid+1]->sim_time < time ) {
-            // too low
-            first = mid;
-            mid = ( last + first ) / 2;
-        } else if ( list[mid]->sim_time > time && list[mid+1]->sim_time > time ) {
-            // too high
-            last = mid;
-            mid = ( last + first ) / 2;
-        } else {
-            done = true;
-        }
-    }
-
-    replay(time, list[mid+1], list[mid]);
+    replay(time, list[next], list[next-1]);
 }
 
 /** 
@@ -745,12 +824,11 @@ saveRawReplayData(gzContainerWriter& output, const replay_list_type& ReplayData,
     }
 
     // write the raw data (all records in the given list)
-    replay_list_type::const_iterator it = ReplayData.begin();
     size_t CheckCount = 0;
-    while ((it != ReplayData.end())&&
+    while ((CheckCount < Count)&&
            !output.fail())
     {
-        const FGReplayData* pRecord = *it++;
+        const FGReplayData* pRecord = ReplayData[CheckCount];
         output.write((char*)pRecord, RecordSize);
         CheckCount++;
     }
@@ -768,7 +846,7 @@ saveRawReplayData(gzContainerWriter& output, const replay_list_type& ReplayData,
 
 /** Load raw replay data from a separate container */
 static bool
-loadRawReplayData(gzContainerReader& input, FGFlightRecorder* pRecorder, replay_list_type& ReplayData, size_t RecordSize)
+loadRawReplayData(gzContainerReader& input, replay_list_type& ReplayData, size_t RecordSize)
 {
     size_t Size = 0;
     simgear::ContainerType Type = ReplayContainer::Invalid;
@@ -791,12 +869,17 @@ loadRawReplayData(gzContainerReader& input, FGFlightRecorder* pRecorder, replay_
     SG_LOG(SG_SYSTEMS, MY_SG_DEBUG, "Loading replay data. Container size is " << Size << ", record size " << RecordSize <<
            ", expected record count " << Count << ".");
 
+    // make sure the whole tape fits
+    if (ReplayData.capacity() < Count)
+        ReplayData.reset(RecordSize, Count);
+
     size_t CheckCount = 0;
     for (CheckCount=0; (CheckCount<Count)&&(!input.eof()); ++CheckCount)
     {
-        FGReplayData* pBuffer = pRecorder->createEmptyRecord();
+        FGReplayData* pBuffer = ReplayData.append();
+        if (!pBuffer)
+            break;
         input.read((char*) pBuffer, RecordSize);
-        ReplayData.push_back(pBuffer);
     }
 
     // did we get all we have hoped for?
@@ -814,6 +897,229 @@ loadRawReplayData(gzContainerReader& input, FGFlightRecorder* pRecorder, replay_
     return true;
 }
 
+/** Save replay data in column format: a time index followed by blocks of
+ *  delta encoded columns. Tiers are stored oldest first, so blocks are in
+ *  chronological order. */
+static bool
+saveColumnReplayData(gzContainerWriter& output, FGFlightRecorder* pRecorder,
+                     const replay_list_type* Tiers[], size_t RecordSize)
+{
+    // encode everything first - the index preceding the blocks needs their sizes
+    std::vector<std::string> Blocks;
+    SGPropertyNode_ptr Index = new SGPropertyNode();
+    size_t TotalRecords = 0;
+    size_t TotalBytes = 0;
+    for (int t=0; t<ReplayTierCount; t++)
+    {
+        const replay_list_type& List = *Tiers[t];
+        for (size_t First=0; First<List.size(); First+=ColumnBlockRecords)
+        {
+            size_t Count = std::min(ColumnBlockRecords, List.size()-First);
+            Blocks.push_back(std::string());
+            pRecorder->encodeColumns(List, First, Count, Blocks.back());
+
+            SGPropertyNode* Block = Index->addChild("block");
+            Block->setStringValue("tier", ReplayTierNames[t]);
+            Block->setIntValue("records", Count);
+            Block->setIntValue("size", Blocks.back().size());
+            Block->setDoubleValue("start-time", List[First]->sim_time);
+            Block->setDoubleValue("end-time", List[First+Count-1]->sim_time);
+            if (!TotalRecords)
+                Index->setDoubleValue("start-time", List[First]->sim_time);
+            Index->setDoubleValue("end-time", List[First+Count-1]->sim_time);
+            TotalRecords += Count;
+            TotalBytes += Blocks.back().size();
+        }
+    }
+    Index->setIntValue("records", TotalRecords);
+
+    if (!output.writeContainer(ReplayContainer::TimeIndex, Index.get()))
+    {
+        SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to save replay data. Cannot write index container. Disk full?");
+        return false;
+    }
+
+    for (size_t i=0; (i<Blocks.size())&&(!output.fail()); i++)
+    {
+        if (!output.writeContainerHeader(ReplayContainer::ColumnData, Blocks[i].size()))
+        {
+            SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to save replay data. Cannot write data container. Disk full?");
+            return false;
+        }
+        output.write(Blocks[i].data(), Blocks[i].size());
+    }
+
+    SG_LOG(SG_SYSTEMS, SG_INFO, "Saved " << TotalRecords << " records in " << Blocks.size() << " blocks, "
+           << TotalBytes << " bytes before compression (raw format: " << TotalRecords * RecordSize << " bytes).");
+    return !output.fail();
+}
+
+/** Read the time index of a column format tape, once its container header has been read. */
+static bool
+readColumnIndex(gzContainerReader& input, size_t Size, SGPropertyNode* Index)
+{
+    if (Size < 1)
+        return false;
+
+    std::vector<char> IndexXML(Size);
+    input.read(&IndexXML[0], Size);
+    if (input.fail())
+    {
+        SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to load replay data. Unexpected end of file in time index.");
+        return false;
+    }
+
+    try
+    {
+        readProperties(&IndexXML[0], Size-1, Index);
+    } catch (const sg_exception &e)
+    {
+        SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to load replay data. Invalid time index, XML parser message:"
+               << e.getFormattedMessage());
+        return false;
+    }
+    return true;
+}
+
+/** Load replay data in column format. Only blocks overlapping the time window
+ *  [StartTime, EndTime] are decoded. Since blocks are stored chronologically,
+ *  reading stops at the first block beyond the window. */
+static bool
+loadColumnReplayData(gzContainerReader& input, FGFlightRecorder* pRecorder, replay_list_type* Tiers[],
+                     double StartTime, double EndTime)
+{
+    size_t Size = 0;
+    simgear::ContainerType Type = ReplayContainer::Invalid;
+    if ((!input.readContainerHeader(&Type, &Size))||
+        (Type != ReplayContainer::TimeIndex))
+    {
+        SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to load replay data. Missing time index.");
+        return false;
+    }
+
+    SGPropertyNode_ptr Index = new SGPropertyNode();
+    if (!readColumnIndex(input, Size, Index.get()))
+        return false;
+
+    simgear::PropertyList Blocks = Index->getChildren("block");
+
+    // make sure all records within the window fit
+    size_t TierRecords[ReplayTierCount] = {0, 0, 0};
+    for (size_t i=0; i<Blocks.size(); i++)
+    {
+        for (int Tier=0; Tier<ReplayTierCount; Tier++)
+        {
+            if ((0==strcmp(Blocks[i]->getStringValue("tier"), ReplayTierNames[Tier]))&&
+                (Blocks[i]->getDoubleValue("start-time") <= EndTime)&&
+                (Blocks[i]->getDoubleValue("end-time") >= StartTime))
+                TierRecords[Tier] += Blocks[i]->getIntValue("records");
+        }
+    }
+    size_t RecordSize = pRecorder->getRecordSize();
+    for (int Tier=0; Tier<ReplayTierCount; Tier++)
+    {
+        if (Tiers[Tier]->capacity() < TierRecords[Tier])
+            Tiers[Tier]->reset(RecordSize, TierRecords[Tier]);
+    }
+
+    std::vector<char> Buffer;
+    std::vector<char> Records;
+    size_t LoadedRecords = 0;
+    size_t SkippedBlocks = 0;
+    for (size_t i=0; i<Blocks.size(); i++)
+    {
+        const SGPropertyNode* Block = Blocks[i];
+        if (Block->getDoubleValue("start-time") > EndTime)
+        {
+            SkippedBlocks += Blocks.size()-i;
+            break;
+        }
+
+        int Tier = 0;
+        while ((Tier<ReplayTierCount)&&
+               (0!=strcmp(Block->getStringValue("tier"), ReplayTierNames[Tier])))
+            Tier++;
+        if (Tier == ReplayTierCount)
+        {
+            SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to load replay data. Unknown tier '"
+                   << Block->getStringValue("tier") << "' in time index.");
+            return false;
+        }
+
+        if ((!input.readContainerHeader(&Type, &Size))||
+            (Type != ReplayContainer::ColumnData)||
+            (Size != (size_t) Block->getIntValue("size")))
+        {
+            SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to load replay data. Data block " << i << " does not match time index.");
+            return false;
+        }
+
+        if (Block->getDoubleValue("end-time") < StartTime)
+        {
+            input.ignore(Size);
+            SkippedBlocks++;
+            continue;
+        }
+
+        Buffer.resize(Size);
+        input.read(&Buffer[0], Size);
+        if (input.fail())
+        {
+            SG_LOG(SG_SYSTEMS, SG_ALERT, "Unexpected end of file.");
+            return false;
+        }
+
+        size_t Count = 0;
+        if (!pRecorder->decodeColumns(&Buffer[0], Size, Records, Count))
+        {
+            SG_LOG(SG_SYSTEMS, SG_ALERT, "Failed to load replay data. Data block " << i
+                   << " is corrupt or does not match the signal configuration.");
+            return false;
+        }
+        for (size_t r=0; r<Count; r++)
+            Tiers[Tier]->push_back((const FGReplayData*) &Records[r * RecordSize]);
+        LoadedRecords += Count;
+    }
+
+    SG_LOG(SG_SYSTEMS, MY_SG_DEBUG, "Loaded " << LoadedRecords << " records, skipped " << SkippedBlocks
+           << " of " << Blocks.size() << " blocks.");
+    return true;
+}
+
+/** Add the time index of a column format tape to the preview data.
+ *  Raw format tapes have no index - their data isn't touched for a preview. */
+static void
+previewColumnIndex(gzContainerReader& input, SGPropertyNode* UserData)
+{
+    size_t Size = 0;
+    simgear::ContainerType Type = ReplayContainer::Invalid;
+
+    // skip recorder configuration
+    if ((!input.readContainerHeader(&Type, &Size))||
+        (Type != ReplayContainer::Properties))
+        return;
+    input.ignore(Size);
+
+    if ((!input.readContainerHeader(&Type, &Size))||
+        (Type != ReplayContainer::TimeIndex))
+    {
+        UserData->setStringValue("tape-format", "raw");
+        UserData->removeChild("tape-start-time", 0, false);
+        UserData->removeChild("tape-end-time", 0, false);
+        UserData->removeChild("tape-records", 0, false);
+        return;
+    }
+
+    SGPropertyNode_ptr Index = new SGPropertyNode();
+    if (readColumnIndex(input, Size, Index.get()))
+    {
+        UserData->setStringValue("tape-format", ColumnTapeFormat);
+        UserData->setDoubleValue("tape-start-time", Index->getDoubleValue("start-time"));
+        UserData->setDoubleValue("tape-end-time", Index->getDoubleValue("end-time"));
+        UserData->setIntValue("tape-records", Index->getIntValue("records"));
+    }
+}
+
 /** Write flight recorder tape with given filename and meta properties to disk */
 bool
 FGReplay::saveTape(const char* Filename, SGPropertyNode* MetaDataProps)
@@ -832,11 +1138,15 @@ FGReplay::saveTape(const char* Filename, SGPropertyNode* MetaDataProps)
     ok &= output.writeContainer(ReplayContainer::MetaData, MetaDataProps);
 
     /* write flight recorder configuration **************************/
+    // raw format tapes can still be written for older FlightGear versions
+    bool Columnar = !fgGetBool("/sim/replay/tape-raw-format", false);
     SGPropertyNode_ptr Config;
     if (ok)
     {
         Config = new SGPropertyNode();
         m_pRecorder->getConfig(Config.get());
+        if (Columnar)
+            Config->setStringValue("recorder/tape-format", ColumnTapeFormat);
         ok &= output.writeContainer(ReplayContainer::Properties, Config.get());
     }
 
@@ -846,12 +1156,21 @@ FGReplay::saveTape(const char* Filename, SGPropertyNode* MetaDataProps)
         size_t RecordSize = Config->getIntValue("recorder/record-size", 0);
         SG_LOG(SG_SYSTEMS, MY_SG_DEBUG, "Total signal count: " <<  Config->getIntValue("recorder/signal-count", 0)
                << ", record size: " << RecordSize);
-        if (ok)
-            ok &= saveRawReplayData(output, short_term,  RecordSize);
-        if (ok)
-            ok &= saveRawReplayData(output, medium_term, RecordSize);
-        if (ok)
-            ok &= saveRawReplayData(output, long_term,   RecordSize);
+        if (Columnar)
+        {
+            const replay_list_type* Tiers[ReplayTierCount] = {&long_term, &medium_term, &short_term};
+            if (ok)
+                ok &= saveColumnReplayData(output, m_pRecorder, Tiers, RecordSize);
+        }
+        else
+        {
+            if (ok)
+                ok &= saveRawReplayData(output, short_term,  RecordSize);
+            if (ok)
+                ok &= saveRawReplayData(output, medium_term, RecordSize);
+            if (ok)
+                ok &= saveRawReplayData(output, long_term,   RecordSize);
+        }
         Config = 0;
     }
 
@@ -932,9 +1251,11 @@ FGReplay::saveTape(const SGPropertyNode* ConfigData)
 
 /** Read a flight recorder tape with given filename from disk and return meta properties.
  * Actual data and signal configuration is not read when in "Preview" mode.
+ * Column format tapes only load data within [StartTime, EndTime] (at block granularity).
  */
 bool
-FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData)
+FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData,
+                   double StartTime, double EndTime)
 {
     bool ok = true;
 
@@ -989,6 +1310,12 @@ FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData)
         }
     }
 
+    /* read time index for preview **********************************/
+    if ((ok)&&(Preview))
+    {
+        previewColumnIndex(input, UserData);
+    }
+
     /* read flight recorder configuration **************************/
     if ((ok)&&(!Preview))
     {
@@ -1027,7 +1354,7 @@ FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData)
                 // reconfigure the recorder - and wipe old data (no longer matches the current recorder)
                 m_pRecorder->reinit(Config);
                 clear();
-                fillRecycler();
+                allocateBuffers();
             }
         }
 
@@ -1051,12 +1378,21 @@ FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData)
                        << ", expected size was " << OriginalSize << ".");
             }
 
-            if (ok)
-                ok &= loadRawReplayData(input, m_pRecorder, short_term,  RecordSize);
-            if (ok)
-                ok &= loadRawReplayData(input, m_pRecorder, medium_term, RecordSize);
-            if (ok)
-                ok &= loadRawReplayData(input, m_pRecorder, long_term,   RecordSize);
+            if (0==strcmp(Config->getStringValue("recorder/tape-format", ""), ColumnTapeFormat))
+            {
+                replay_list_type* Tiers[ReplayTierCount] = {&long_term, &medium_term, &short_term};
+                if (ok)
+                    ok &= loadColumnReplayData(input, m_pRecorder, Tiers, StartTime, EndTime);
+            }
+            else
+            {
+                if (ok)
+                    ok &= loadRawReplayData(input, short_term,  RecordSize);
+                if (ok)
+                    ok &= loadRawReplayData(input, medium_term, RecordSize);
+                if (ok)
+                    ok &= loadRawReplayData(input, long_term,   RecordSize);
+            }
 
             // restore replay messages
             if (ok)
@@ -1141,6 +1477,9 @@ FGReplay::loadTape(const SGPropertyNode* ConfigData)
         tapeDirectory.append(tape);
         tapeDirectory.concat(".fgtape");
         SG_LOG(SG_SYSTEMS, MY_SG_DEBUG, "Checking flight recorder file " << tapeDirectory << ", preview: " << Preview);
-        return loadTape(tapeDirectory.c_str(), Preview, UserData);
+        // optional time window, to load only part of a long (column format) tape
+        double StartTime = ConfigData->getDoubleValue("start-time", -DBL_MAX);
+        double EndTime   = ConfigData->getDoubleValue("end-time",    DBL_MAX);
+        return loadTape(tapeDirectory.c_str(), Preview, UserData, StartTime, EndTime);
     }
 }
@@ -34,7 +34,6 @@
 #include <simgear/props/props.hxx>
 #include <simgear/structure/subsystem_mgr.hxx>
 
-#include <deque>
 #include <vector>
 
 class FGFlightRecorder;
@@ -51,7 +50,63 @@ typedef struct {
     std::string speaker;
 } FGReplayMessages;
 
-typedef std::deque < FGReplayData *> replay_list_type;
+/**
+ * Fixed capacity ring buffer of replay records, stored back to back in a
+ * single slab. Index 0 is the oldest record. Adding a record to a full
+ * buffer overwrites the oldest one.
+ */
+class FGReplayBuffer
+{
+public:
+    FGReplayBuffer();
+    ~FGReplayBuffer();
+
+    /** Discard all records and reallocate for Capacity records of RecordSize bytes. */
+    void reset(size_t RecordSize, size_t Capacity);
+    void clear() { m_First = 0; m_Count = 0; }
+
+    size_t size() const { return m_Count; }
+    bool empty() const { return m_Count == 0; }
+    bool full() const { return m_Count == m_Capacity; }
+    size_t capacity() const { return m_Capacity; }
+    size_t bytesUsed() const { return m_Count * m_Stride; }
+    size_t bytesAllocated() const { return m_Capacity * m_Stride; }
+
+    FGReplayData* operator[](size_t Index) const
+    {
+        Index += m_First;
+        if (Index >= m_Capacity)
+            Index -= m_Capacity;
+        return (FGReplayData*) &m_pSlab[Index * m_Stride];
+    }
+    FGReplayData* front() const { return (*this)[0]; }
+    FGReplayData* back() const { return (*this)[m_Count-1]; }
+
+    /** Slot for a new most recent record. NULL when there is no capacity. */
+    FGReplayData* append();
+    /** Add a copy of the given record. */
+    void push_back(const FGReplayData* pRecord);
+    void pop_front();
+
+    /** Index of the first record recorded after the given time, size() if none. */
+    size_t upperBound(double Time) const;
+
+    /** Slab size of a record: keep sim_time (and all doubles) aligned. */
+    static size_t stride(size_t RecordSize) { return (RecordSize + sizeof(double) - 1) & ~(sizeof(double) - 1); }
+
+private:
+    FGReplayBuffer(const FGReplayBuffer&);
+    FGReplayBuffer& operator=(const FGReplayBuffer&);
+
+    char*  m_pSlab;
+    size_t m_RecordSize;
+    size_t m_Stride;
+    size_t m_Capacity;
+    size_t m_First;
+    size_t m_Count;
+};
+
+typedef FGReplayBuffer replay_list_type;
 typedef std::vector < FGReplayMessages > replay_messages_type;
 
 /**
@@ -82,7 +137,9 @@ private:
     void replay(double time, FGReplayData* pCurrentFrame, FGReplayData* pOldFrame=NULL);
     void guiMessage(const char* message);
     void loadMessages();
-    void fillRecycler();
+    void allocateBuffers();
+    void updateStatistics();
+    const FGReplayData* expire(replay_list_type& list, double max_age);
 
     bool replay( double time );
     void replayMessage( double time );
@@ -92,12 +149,14 @@ private:
 
     bool listTapes(bool SameAircraftFilter, const SGPath& tapeDirectory);
     bool saveTape(const char* Filename, SGPropertyNode* MetaData);
-    bool loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData);
+    bool loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData,
+                  double StartTime, double EndTime);
 
     double sim_time;
     double last_mt_time;
     double last_lt_time;
     double last_msg_time;
+    double last_stats_time;
     replay_messages_type::iterator current_msg;
     int last_replay_state;
     bool was_finished_already;
@@ -105,7 +164,6 @@ private:
     replay_list_type short_term;
     replay_list_type medium_term;
     replay_list_type long_term;
-    replay_list_type recycler;
     replay_messages_type replay_messages;
 
     SGPropertyNode_ptr disable_replay;
@@ -31,7 +31,6 @@
 #include <simgear/compiler.h>
 
 #include <stdlib.h> // atof(), atoi()
-#include <string.h> // memchr()
 #include <ctype.h> // isspace()
 
 #include <simgear/constants.h>
@@ -47,6 +46,7 @@
 #include "runways.hxx"
 #include "pavement.hxx"
 #include <Navaids/NavDataCache.hxx>
+#include <Navaids/DatFileReader.hxx>
 #include <ATC/CommStation.hxx>
 
 #include <iostream>
@@ -86,71 +86,50 @@ public:
 
   void parseAPT(const SGPath &aptdb_file)
   {
-    sg_gzifstream in( aptdb_file.str() );
+    DatFileReader in( aptdb_file );
 
-    if ( !in.is_open() ) {
+    if ( !in.isOpen() ) {
         SG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << aptdb_file );
         exit(-1);
     }
 
-    string line;
-    char tmp[2049];
-    tmp[2048] = 0;
-    
     unsigned int line_id = 0;
-    unsigned int line_num = 0;
-
-    while ( ! in.eof() ) {
-      in.getline(tmp, 2048);
-      line = tmp; // string copy, ack
-      line_num++;
 
-      if ( !line.size() || isspace(tmp[0])) {
+    while ( in.nextLine() ) {
+      const char* tmp = in.line();
+      if ( !in.lineLength() || isspace(tmp[0])) {
         continue;
       }
       
-      if (line.size() >= 3) {
-          char *p = (char *)memchr(tmp, ' ', 3);
-          if ( p )
-              *p = 0;
-      }
-
-      line_id = atoi(tmp);
+      line_id = in.token(0).toInt();
       if ( tmp[0] == 'I' ) {
         // First line, indicates IBM (i.e. DOS line endings I
         // believe.)
 
         // move past this line and read and discard the next line
         // which is the version and copyright information
-        in.getline(tmp, 2048);
-        // vector<string> vers_token = simgear::strutils::split( tmp );
-        if ( strlen(tmp) > 4 ) {
-           char *p = (char *)memchr(tmp, ' ', 4);
-           if ( p )
-              *p = 0;
-        }
-        SG_LOG( SG_GENERAL, SG_INFO, "Data file version = " << tmp );
+        in.nextLine();
+        string version = in.numTokens() ? in.token(0).str() : string();
+        SG_LOG( SG_GENERAL, SG_INFO, "Data file version = " << version );
       } else if ( line_id == 1 /* Airport */ ||
                     line_id == 16 /* Seaplane base */ ||
                     line_id == 17 /* Heliport */ ) {
-        parseAirportLine(simgear::strutils::split(line));
+        parseAirportLine(in);
       } else if ( line_id == 10 ) { // Runway v810
-        parseRunwayLine810(simgear::strutils::split(line));
+        parseRunwayLine810(in);
       } else if ( line_id == 100 ) { // Runway v850
-        parseRunwayLine850(simgear::strutils::split(line));
+        parseRunwayLine850(in);
       } else if ( line_id == 101 ) { // Water Runway v850
-        parseWaterRunwayLine850(simgear::strutils::split(line));
+        parseWaterRunwayLine850(in);
       } else if ( line_id == 102 ) { // Helipad v850
-        parseHelipadLine850(simgear::strutils::split(line));
+        parseHelipadLine850(in);
       } else if ( line_id == 18 ) {
             // beacon entry (ignore)
       } else if ( line_id == 14 ) {
         // control tower entry
-        vector<string> token(simgear::strutils::split(line));
-        
-        double lat = atof( token[1].c_str() );
-        double lon = atof( token[2].c_str() );
-        double elev = atof( token[3].c_str() );
+        double lat = in.token(1).toDouble();
+        double lon = in.token(2).toDouble();
+        double elev = in.token(3).toDouble();
         tower = SGGeod::fromDegFt(lon, lat, elev + last_apt_elev);
         got_tower = true;
         
@@ -166,13 +145,13 @@ public:
       } else if ( line_id == 0 ) {
           // ??
       } else if ( line_id >= 50 && line_id <= 56) {
-        parseCommLine(line_id, simgear::strutils::split(line));
+        parseCommLine(line_id, in);
       } else if ( line_id == 110 ) {
         pavement = true;
-        parsePavementLine850(simgear::strutils::split(line, 0, 4));
+        parsePavementLine850(in);
       } else if ( line_id >= 111 && line_id <= 114 ) {
         if ( pavement )
-          parsePavementNodeLine850(line_id, simgear::strutils::split(line));
+          parsePavementNodeLine850(line_id, in);
       } else if ( line_id >= 115 && line_id <= 116 ) {
           // other pavement nodes (ignore)
       } else if ( line_id == 120 ) {
@@ -183,7 +162,7 @@ public:
           SG_LOG( SG_GENERAL, SG_DEBUG, "End of file reached" );
       } else {
           SG_LOG( SG_GENERAL, SG_ALERT, 
-                  "Unknown line(#" << line_num << ") in file: " << line );
+                  "Unknown line(#" << in.lineNumber() << ") in file: " << tmp );
           exit( -1 );
       }
     }
@@ -192,7 +171,6 @@ public:
   }
   
 private:
-  vector<string> token;
   double rwy_lat_accum;
   double rwy_lon_accum;
   double last_rwy_heading;
@@ -245,10 +223,10 @@ private:
     currentAirportID = 0;
   }
   
-  void parseAirportLine(const vector<string>& token)
+  void parseAirportLine(const DatFileReader& in)
   {
-    const string& id(token[4]);
-    double elev = atof( token[1].c_str() );
+    string id(in.token(4).str());
+    double elev = in.token(1).toDouble();
 
   // finish the previous airport
     finishAirport();
@@ -256,39 +234,35 @@ private:
     last_apt_elev = elev;
     got_tower = false;
 
-    string name;
     // build the name
-    for ( unsigned int i = 5; i < token.size() - 1; ++i ) {
-        name += token[i] + " ";
-    }
-    name += token[token.size() - 1];
+    string name = in.join(5);
 
     // clear runway list for start of next airport
     rwy_lon_accum = 0.0;
     rwy_lat_accum = 0.0;
     rwy_count = 0;
     
-    int robinType = atoi(token[0].c_str());
+    int robinType = in.token(0).toInt();
     currentAirportID = cache->insertAirport(fptypeFromRobinType(robinType), id, name);
   }
   
-  void parseRunwayLine810(const vector<string>& token)
+  void parseRunwayLine810(const DatFileReader& in)
   {
-    double lat = atof( token[1].c_str() );
-    double lon = atof( token[2].c_str() );
+    double lat = in.token(1).toDouble();
+    double lon = in.token(2).toDouble();
     rwy_lat_accum += lat;
     rwy_lon_accum += lon;
     rwy_count++;
 
-    const string& rwy_no(token[3]);
+    string rwy_no(in.token(3).str());
 
-    double heading = atof( token[4].c_str() );
-    double length = atoi( token[5].c_str() );
-    double width = atoi( token[8].c_str() );
+    double heading = in.token(4).toDouble();
+    double length = in.token(5).toInt();
+    double width = in.token(8).toInt();
 
     last_rwy_heading = heading;
 
-    int surface_code = atoi( token[10].c_str() );
+    int surface_code = in.token(10).toInt();
     SGGeod pos(SGGeod::fromDegFt(lon, lat, last_apt_elev));
     
     if (rwy_no[0] == 'x') {
@@ -296,13 +270,13 @@ private:
                           heading, length, width, 0, 0, surface_code);
     } else {
       // (pair of) runways
-      string rwy_displ_threshold = token[6];
+      string rwy_displ_threshold = in.token(6).str();
       vector<string> displ
           = simgear::strutils::split( rwy_displ_threshold, "." );
       double displ_thresh1 = atof( displ[0].c_str() );
       double displ_thresh2 = atof( displ[1].c_str() );
 
-      string rwy_stopway = token[7];
+      string rwy_stopway = in.token(7).str();
       vector<string> stop
           = simgear::strutils::split( rwy_stopway, "." );
       double stopway1 = atof( stop[0].c_str() );
@@ -323,20 +297,20 @@ private:
     }
   }
 
-  void parseRunwayLine850(const vector<string>& token)
+  void parseRunwayLine850(const DatFileReader& in)
   {
-    double width = atof( token[1].c_str() ) * SG_METER_TO_FEET;
-    int surface_code = atoi( token[2].c_str() );
+    double width = in.token(1).toDouble() * SG_METER_TO_FEET;
+    int surface_code = in.token(2).toInt();
 
-    double lat_1 = atof( token[9].c_str() );
-    double lon_1 = atof( token[10].c_str() );
+    double lat_1 = in.token(9).toDouble();
+    double lon_1 = in.token(10).toDouble();
     SGGeod pos_1(SGGeod::fromDegFt(lon_1, lat_1, 0.0));
     rwy_lat_accum += lat_1;
     rwy_lon_accum += lon_1;
     rwy_count++;
 
-    double lat_2 = atof( token[18].c_str() );
-    double lon_2 = atof( token[19].c_str() );
+    double lat_2 = in.token(18).toDouble();
+    double lon_2 = in.token(19).toDouble();
     SGGeod pos_2(SGGeod::fromDegFt(lon_2, lat_2, 0.0));
     rwy_lat_accum += lat_2;
     rwy_lon_accum += lon_2;
@@ -350,16 +324,16 @@ private:
 
     last_rwy_heading = heading_1;
 
-    const string& rwy_no_1(token[8]);
-    const string& rwy_no_2(token[17]);
+    string rwy_no_1(in.token(8).str());
+    string rwy_no_2(in.token(17).str());
     if ( rwy_no_1.size() == 0 || rwy_no_2.size() == 0 )
         return;
 
-    double displ_thresh1 = atof( token[11].c_str() );
-    double displ_thresh2 = atof( token[20].c_str() );
+    double displ_thresh1 = in.token(11).toDouble();
+    double displ_thresh2 = in.token(20).toDouble();
 
-    double stopway1 = atof( token[12].c_str() );
-    double stopway2 = atof( token[21].c_str() );
+    double stopway1 = in.token(12).toDouble();
+    double stopway2 = in.token(21).toDouble();
 
     PositionedID rwy = cache->insertRunway(FGPositioned::RUNWAY, rwy_no_1, pos,
                                            currentAirportID, heading_1, length,
@@ -375,19 +349,19 @@ private:
     cache->setRunwayReciprocal(rwy, reciprocal);
   }
 
-  void parseWaterRunwayLine850(const vector<string>& token)
+  void parseWaterRunwayLine850(const DatFileReader& in)
   {
-    double width = atof( token[1].c_str() ) * SG_METER_TO_FEET;
+    double width = in.token(1).toDouble() * SG_METER_TO_FEET;
 
-    double lat_1 = atof( token[4].c_str() );
-    double lon_1 = atof( token[5].c_str() );
+    double lat_1 = in.token(4).toDouble();
+    double lon_1 = in.token(5).toDouble();
     SGGeod pos_1(SGGeod::fromDegFt(lon_1, lat_1, 0.0));
     rwy_lat_accum += lat_1;
     rwy_lon_accum += lon_1;
     rwy_count++;
 
-    double lat_2 = atof( token[7].c_str() );
-    double lon_2 = atof( token[8].c_str() );
+    double lat_2 = in.token(7).toDouble();
+    double lon_2 = in.token(8).toDouble();
     SGGeod pos_2(SGGeod::fromDegFt(lon_2, lat_2, 0.0));
     rwy_lat_accum += lat_2;
     rwy_lon_accum += lon_2;
@@ -400,8 +374,8 @@ private:
 
     last_rwy_heading = heading_1;
 
-    const string& rwy_no_1(token[3]);
-    const string& rwy_no_2(token[6]);
+    string rwy_no_1(in.token(3).str());
+    string rwy_no_2(in.token(6).str());
 
     PositionedID rwy = cache->insertRunway(FGPositioned::RUNWAY, rwy_no_1, pos,
                                            currentAirportID, heading_1, length,
@@ -415,45 +389,43 @@ private:
     cache->setRunwayReciprocal(rwy, reciprocal);
   }
 
-  void parseHelipadLine850(const vector<string>& token)
+  void parseHelipadLine850(const DatFileReader& in)
   {
-    double length = atof( token[5].c_str() ) * SG_METER_TO_FEET;
-    double width = atof( token[6].c_str() ) * SG_METER_TO_FEET;
+    double length = in.token(5).toDouble() * SG_METER_TO_FEET;
+    double width = in.token(6).toDouble() * SG_METER_TO_FEET;
 
-    double lat = atof( token[2].c_str() );
-    double lon = atof( token[3].c_str() );
+    double lat = in.token(2).toDouble();
+    double lon = in.token(3).toDouble();
     SGGeod pos(SGGeod::fromDegFt(lon, lat, 0.0));
     rwy_lat_accum += lat;
     rwy_lon_accum += lon;
     rwy_count++;
 
-    double heading = atof( token[4].c_str() );
+    double heading = in.token(4).toDouble();
 
     last_rwy_heading = heading;
 
-    const string& rwy_no(token[1]);
-    int surface_code = atoi( token[7].c_str() );
+    string rwy_no(in.token(1).str());
+    int surface_code = in.token(7).toInt();
 
     cache->insertRunway(FGPositioned::RUNWAY, rwy_no, pos,
                         currentAirportID, heading, length,
                         width, 0.0, 0.0, surface_code);
   }
 
-  void parsePavementLine850(const vector<string>& token)
+  void parsePavementLine850(const DatFileReader& in)
   {
-    if ( token.size() >= 5 ) {
-      pavement_ident = token[4];
-      if ( !pavement_ident.empty() && pavement_ident[pavement_ident.size()-1] == '\r' )
-        pavement_ident.erase( pavement_ident.size()-1 );
+    if ( in.numTokens() >= 5 ) {
+      pavement_ident = in.rest(4).str();
     } else {
       pavement_ident = "xx";
     }
   }
 
-  void parsePavementNodeLine850(int num, const vector<string>& token)
+  void parsePavementNodeLine850(int num, const DatFileReader& in)
   {
-    double lat = atof( token[1].c_str() );
-    double lon = atof( token[2].c_str() );
+    double lat = in.token(1).toDouble();
+    double lon = in.token(2).toDouble();
     SGGeod pos(SGGeod::fromDegFt(lon, lat, 0.0));
 
     FGPavement* pvt = 0;
@@ -465,8 +437,8 @@ private:
       pvt = pavements.back();
     }
     if ( num == 112 || num == 114 ) {
-      double lat_b = atof( token[3].c_str() );
-      double lon_b = atof( token[4].c_str() );
+      double lat_b = in.token(3).toDouble();
+      double lon_b = in.token(4).toDouble();
       SGGeod pos_b(SGGeod::fromDegFt(lon_b, lat_b, 0.0));
       pvt->addBezierNode(pos, pos_b, num == 114);
     } else {
@@ -474,7 +446,7 @@ private:
     }
   }
 
-  void parseCommLine(int lineId, const vector<string>& token) 
+  void parseCommLine(int lineId, const DatFileReader& in) 
   {
     if ( rwy_count <= 0 ) {
       SG_LOG( SG_GENERAL, SG_ALERT, "No runways; skipping comm for " + last_apt_id);
@@ -484,18 +456,18 @@ private:
         rwy_lat_accum / (double)rwy_count, last_apt_elev);
     
     // short int representing tens of kHz:
-    int freqKhz = atoi(token[1].c_str()) * 10;
+    int freqKhz = in.token(1).toInt() * 10;
     int rangeNm = 50;
     FGPositioned::Type ty;
     // Make sure we only pass on stations with at least a name
-    if (token.size() >2){
+    if (in.numTokens() >2){
 
         switch (lineId) {
             case 50:
                 ty = FGPositioned::FREQ_AWOS;
-                for( size_t i = 2; i < token.size(); ++i )
+                for( size_t i = 2; i < in.numTokens(); ++i )
                 {
-                  if( token[i] == "ATIS" )
+                  if( in.token(i) == "ATIS" )
                   {
                     ty = FGPositioned::FREQ_ATIS;
                     break;
@@ -515,9 +487,7 @@ private:
 
       // Name can contain white spaces. All tokens after the second token are
       // part of the name.
-      std::string name = token[2];
-      for( size_t i = 3; i < token.size(); ++i )
-        name += ' ' + token[i];
+      std::string name = in.join(2);
 
       cache->insertCommStation(ty, name, pos, freqKhz, rangeNm, currentAirportID);
     }
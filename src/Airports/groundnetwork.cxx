@@ -28,6 +28,9 @@
 #include <algorithm>
 #include <fstream>
 #include <map>
+#include <list>
+#include <queue>
+#include <functional>
 #include <boost/foreach.hpp>
 
 #include <osg/Geode>
@@ -61,6 +64,9 @@
 using std::string;
 using flightgear::NavDataCache;
 
+// number of computed routes kept per ground network
+static const unsigned int ROUTE_CACHE_SIZE = 256;
+
 /***************************************************************************
  * FGTaxiSegment
  **************************************************************************/
@@ -156,6 +162,268 @@ bool FGTaxiRoute::next(PositionedID *nde)
     return true;
 };
 
+static int edgePenalty(FGTaxiNode* tn)
+{
+  return (tn->type() == FGPositioned::PARKING ? 10000 : 0) +
+    (tn->getIsOnRunway() ? 1000 : 0);
+}
+
+/***************************************************************************
+ * FGTaxiGraph
+ *
+ * Compact, in-memory adjacency representation of a ground network, built
+ * once from the NavDataCache so route searches don't have to go back to
+ * SQLite for every edge relaxation. Nodes are renumbered densely and the
+ * outgoing edges are stored contiguously per node (CSR layout), with the
+ * edge cost (length plus the penalty of the target node) precomputed.
+ **************************************************************************/
+
+class FGTaxiGraph
+{
+public:
+  FGTaxiGraph(PositionedID aAirport, bool onlyPushback);
+
+  /**
+   * A* search from start to end. Returns false if either node is unknown,
+   * or no route exists. On success, the node ids (including start and end)
+   * and the total cost are returned.
+   */
+  bool findRoute(PositionedID start, PositionedID end,
+                 PositionedIDVec& route, double& distance);
+
+  unsigned int numNodes() const { return _ids.size(); }
+  unsigned int numEdges() const { return _edgeTarget.size(); }
+private:
+  int indexOf(PositionedID aId) const;
+  int addNode(PositionedID aId);
+
+  typedef std::map<PositionedID, int> IdIndexMap;
+  IdIndexMap _index;
+
+  PositionedIDVec _ids;
+  std::vector<SGVec3d> _carts;
+  std::vector<unsigned int> _firstEdge; // size numNodes() + 1
+  std::vector<int> _edgeTarget;
+  std::vector<double> _edgeCost;
+
+  // search scratch space, re-used between searches
+  std::vector<double> _score;
+  std::vector<int> _previous;
+};
+
+FGTaxiGraph::FGTaxiGraph(PositionedID aAirport, bool onlyPushback)
+{
+  NavDataCache* cache = NavDataCache::instance();
+  PositionedIDVec nodes(cache->groundNetNodes(aAirport, onlyPushback));
+  BOOST_FOREACH(PositionedID n, nodes) {
+    addNode(n);
+  }
+
+// only nodes returned by the query above are expanded during a search;
+// edge targets outside that set are added as nodes without outgoing edges.
+  std::vector<PositionedIDVec> edges(nodes.size());
+  for (unsigned int i = 0; i < nodes.size(); ++i) {
+    edges[i] = cache->groundNetEdgesFrom(nodes[i], onlyPushback);
+    BOOST_FOREACH(PositionedID target, edges[i]) {
+      addNode(target);
+    }
+  }
+
+  std::vector<int> penalty(_ids.size());
+  _carts.resize(_ids.size());
+  for (unsigned int i = 0; i < _ids.size(); ++i) {
+    FGTaxiNode* tn = static_cast<FGTaxiNode*>(cache->loadById(_ids[i]));
+    _carts[i] = tn->cart();
+    penalty[i] = edgePenalty(tn);
+  }
+
+  _firstEdge.resize(_ids.size() + 1, 0);
+  for (unsigned int i = 0; i < _ids.size(); ++i) {
+    _firstEdge[i] = _edgeTarget.size();
+    if (i >= edges.size()) {
+      continue;
+    }
+
+    BOOST_FOREACH(PositionedID target, edges[i]) {
+      int t = indexOf(target);
+      _edgeTarget.push_back(t);
+      _edgeCost.push_back(dist(_carts[i], _carts[t]) + penalty[t]);
+    }
+  }
+  _firstEdge[_ids.size()] = _edgeTarget.size();
+}
+
+int FGTaxiGraph::indexOf(PositionedID aId) const
+{
+  IdIndexMap::const_iterator it = _index.find(aId);
+  return (it == _index.end()) ? -1 : it->second;
+}
+
+int FGTaxiGraph::addNode(PositionedID aId)
+{
+  IdIndexMap::iterator it = _index.find(aId);
+  if (it != _index.end()) {
+    return it->second;
+  }
+
+  int index = _ids.size();
+  _ids.push_back(aId);
+  _index[aId] = index;
+  return index;
+}
+
+bool FGTaxiGraph::findRoute(PositionedID start, PositionedID end,
+                            PositionedIDVec& route, double& distance)
+{
+  int first = indexOf(start), last = indexOf(end);
+  if ((first < 0) || (last < 0)) {
+    return false;
+  }
+
+  _score.assign(_ids.size(), HUGE_VAL);
+  _previous.assign(_ids.size(), -1);
+
+// A* with a binary heap. The heuristic is the straight-line distance to the
+// goal, which never overestimates since edge costs are straight-line segment
+// lengths plus non-negative penalties. Stale heap entries are skipped rather
+// than decreased in place.
+  typedef std::pair<double, int> HeapEntry;
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry> > open;
+  const SGVec3d& goal(_carts[last]);
+
+  _score[first] = 0.0;
+  open.push(HeapEntry(dist(_carts[first], goal), first));
+
+  while (!open.empty()) {
+    HeapEntry top = open.top();
+    open.pop();
+
+    int best = top.second;
+    if (best == last) {
+      break;
+    }
+
+    double bestScore = _score[best];
+    if (top.first > bestScore + dist(_carts[best], goal)) {
+      continue; // stale entry, node was reached more cheaply since
+    }
+
+    for (unsigned int e = _firstEdge[best]; e < _firstEdge[best + 1]; ++e) {
+      int tgt = _edgeTarget[e];
+      double alt = bestScore + _edgeCost[e];
+      if (alt < _score[tgt]) {    // Relax (u,v)
+        _score[tgt] = alt;
+        _previous[tgt] = best;
+        open.push(HeapEntry(alt + dist(_carts[tgt], goal), tgt));
+      }
+    } // of outgoing arcs/segments from current best node iteration
+  } // of open nodes remaining
+
+  if (_score[last] == HUGE_VAL) {
+    return false;
+  }
+
+// assemble route from backtrace information
+  route.clear();
+  for (int bt = last; bt != first; bt = _previous[bt]) {
+    route.push_back(_ids[bt]);
+  }
+  route.push_back(start);
+  reverse(route.begin(), route.end());
+  distance = _score[last];
+  return true;
+}
+
+/***************************************************************************
+ * FGTaxiRouteCache
+ *
+ * Small least-recently-used cache of computed routes. It is cleared, with
+ * the routing graphs, whenever a ground network is reloaded into the
+ * NavDataCache.
+ **************************************************************************/
+
+class FGTaxiRouteCache
+{
+public:
+  FGTaxiRouteCache(unsigned int aCapacity) :
+    _capacity(aCapacity),
+    _hits(0),
+    _misses(0)
+  {}
+
+  bool get(PositionedID start, PositionedID end, bool fullSearch,
+           FGTaxiRoute& route);
+  void put(PositionedID start, PositionedID end, bool fullSearch,
+           const FGTaxiRoute& route);
+  void clear();
+
+  unsigned int hits() const { return _hits; }
+  unsigned int misses() const { return _misses; }
+private:
+  struct Key
+  {
+    Key(PositionedID s, PositionedID e, bool f) :
+      start(s), end(e), fullSearch(f)
+    {}
+
+    bool operator<(const Key& other) const
+    {
+      if (start != other.start) return start < other.start;
+      if (end != other.end) return end < other.end;
+      return fullSearch < other.fullSearch;
+    }
+
+    PositionedID start, end;
+    bool fullSearch;
+  };
+
+  typedef std::list<std::pair<Key, FGTaxiRoute> > RouteList;
+  typedef std::map<Key, RouteList::iterator> RouteMap;
+
+  unsigned int _capacity;
+  RouteList _routes; // most recently used at the front
+  RouteMap _lookup;
+  unsigned int _hits, _misses;
+};
+
+bool FGTaxiRouteCache::get(PositionedID start, PositionedID end, bool fullSearch,
+                           FGTaxiRoute& route)
+{
+  RouteMap::iterator it = _lookup.find(Key(start, end, fullSearch));
+  if (it == _lookup.end()) {
+    ++_misses;
+    return false;
+  }
+
+  ++_hits;
+  _routes.splice(_routes.begin(), _routes, it->second);
+  route = it->second->second;
+  return true;
+}
+
+void FGTaxiRouteCache::put(PositionedID start, PositionedID end, bool fullSearch,
+                           const FGTaxiRoute& route)
+{
+  Key k(start, end, fullSearch);
+  if (_lookup.find(k) != _lookup.end()) {
+    return;
+  }
+
+  _routes.push_front(std::make_pair(k, route));
+  _lookup[k] = _routes.begin();
+  if (_routes.size() > _capacity) {
+    _lookup.erase(_routes.back().first);
+    _routes.pop_back();
+  }
+}
+
+void FGTaxiRouteCache::clear()
+{
+  _routes.clear();
+  _lookup.clear();
+  _hits = _misses = 0;
+}
+
 /***************************************************************************
  * FGGroundNetwork()
  **************************************************************************/
@@ -165,8 +433,14 @@ bool compare_trafficrecords(FGTrafficRecord a, FGTrafficRecord b)
     return (a.getIntentions().size() < b.getIntentions().size());
 }
 
+bool FGGroundNetwork::useTrafficIndex = true;
+
 FGGroundNetwork::FGGroundNetwork() :
-  parent(NULL)
+  parent(NULL),
+  taxiGraph(NULL),
+  pushbackGraph(NULL),
+  routeCache(new FGTaxiRouteCache(ROUTE_CACHE_SIZE)),
+  routeGeneration(NavDataCache::instance()->groundnetGeneration())
 {
     hasNetwork = false;
     totalDistance = 0;
@@ -194,6 +468,10 @@ FGGroundNetwork::~FGGroundNetwork()
   BOOST_FOREACH(FGTaxiSegment* seg, segments) {
     delete seg;
   }
+
+  delete taxiGraph;
+  delete pushbackGraph;
+  delete routeCache;
 }
 
 void FGGroundNetwork::saveElevationCache()
@@ -253,6 +531,7 @@ void FGGroundNetwork::init(FGAirport* pr)
   // establish pairing of segments
     BOOST_FOREACH(FGTaxiSegment* segment, segments) {
       segment->setIndex(index++);
+      segmentsTo[segment->endNode].push_back(segment);
       
       if (segment->oppositeDirection) {
         continue; // already establish
@@ -273,6 +552,17 @@ void FGGroundNetwork::init(FGAirport* pr)
     networkInitialized = true;
 }
 
+void FGGroundNetwork::blockSegmentsTo(FGTaxiSegment* seg, int id,
+                                      time_t blockTime, time_t now)
+{
+    // all segments merging into this one at its end
+    BOOST_FOREACH(FGTaxiSegment* other, segmentsTo[seg->endNode]) {
+        if (other != seg) {
+            other->block(id, blockTime, now);
+        }
+    }
+}
+
 void FGGroundNetwork::loadSegments()
 {
   flightgear::NavDataCache* cache = flightgear::NavDataCache::instance();
@@ -380,36 +670,51 @@ FGTaxiSegment* FGGroundNetwork::findSegment(PositionedID from, PositionedID to)
     return NULL; // not found
 }
 
-static int edgePenalty(FGTaxiNode* tn)
+/***************************************************************************
+ * FGGroundNetwork route finding
+ **************************************************************************/
+
+FGTaxiRoute FGGroundNetwork::findShortestRoute(PositionedID start, PositionedID end,
+        bool fullSearch)
 {
-  return (tn->type() == FGPositioned::PARKING ? 10000 : 0) +
-    (tn->getIsOnRunway() ? 1000 : 0);
+    discardStaleRoutes();
+
+    FGTaxiRoute route;
+    if (routeCache && routeCache->get(start, end, fullSearch, route)) {
+        return route;
+    }
+
+    route = searchRoute(start, end, fullSearch);
+    if (routeCache) {
+        routeCache->put(start, end, fullSearch, route);
+    }
+    return route;
 }
 
-class ShortestPathData
+// the graphs and cached routes are derived from the NavDataCache, and must
+// be rebuilt once a ground network has been reloaded into it
+void FGGroundNetwork::discardStaleRoutes()
 {
-public:
-  ShortestPathData() :
-    score(HUGE_VAL)
-  {}
-  
-  double score;
-  FGTaxiNode_ptr previousNode;
-};
+    unsigned int generation = NavDataCache::instance()->groundnetGeneration();
+    if (generation == routeGeneration) {
+        return;
+    }
 
-FGTaxiRoute FGGroundNetwork::findShortestRoute(PositionedID start, PositionedID end,
+    delete taxiGraph;
+    taxiGraph = NULL;
+    delete pushbackGraph;
+    pushbackGraph = NULL;
+    if (routeCache) {
+        routeCache->clear();
+    }
+    routeGeneration = generation;
+}
+
+FGTaxiRoute FGGroundNetwork::searchRoute(PositionedID start, PositionedID end,
         bool fullSearch)
 {
-//implements Dijkstra's algorithm to find shortest distance route from start to end
-//taken from http://en.wikipedia.org/wiki/Dijkstra's_algorithm
-    FGTaxiNodeVector unvisited;
-    flightgear::NavDataCache* cache = flightgear::NavDataCache::instance();
-    std::map<FGTaxiNode*, ShortestPathData> searchData;
-  
-    BOOST_FOREACH(PositionedID n, cache->groundNetNodes(parent->guid(), !fullSearch)) {
-      unvisited.push_back(findNode(n));
-    }
-  
+    discardStaleRoutes();
+
     FGTaxiNode *firstNode = findNode(start);
     if (!firstNode)
     {
@@ -418,7 +723,6 @@ FGTaxiRoute FGGroundNetwork::findShortestRoute(PositionedID start, PositionedID
                << " at " << ((parent) ? parent->getId() : "<unknown>"));
         return FGTaxiRoute();
     }
-    searchData[firstNode].score = 0.0;
 
     FGTaxiNode *lastNode = findNode(end);
     if (!lastNode)
@@ -429,35 +733,17 @@ FGTaxiRoute FGGroundNetwork::findShortestRoute(PositionedID start, PositionedID
         return FGTaxiRoute();
     }
 
-    while (!unvisited.empty()) {
-        FGTaxiNode *best = unvisited.front();
-        BOOST_FOREACH(FGTaxiNode* i, unvisited) {
-            if (searchData[i].score < searchData[best].score) {
-                best = i;
-            }
-        }
-      
-      // remove 'best' from the unvisited set
-        FGTaxiNodeVectorIterator newend =
-            remove(unvisited.begin(), unvisited.end(), best);
-        unvisited.erase(newend, unvisited.end());
-
-        if (best == lastNode) { // found route or best not connected
-            break;
-        }
-      
-        BOOST_FOREACH(PositionedID targetId, cache->groundNetEdgesFrom(best->guid(), !fullSearch)) {
-            FGTaxiNode* tgt = (FGTaxiNode*) cache->loadById(targetId);
-            double edgeLength = dist(best->cart(), tgt->cart());          
-            double alt = searchData[best].score + edgeLength + edgePenalty(tgt);
-            if (alt < searchData[tgt].score) {    // Relax (u,v)
-                searchData[tgt].score = alt;
-                searchData[tgt].previousNode = best;
-            }
-        } // of outgoing arcs/segments from current best node iteration
-    } // of unvisited nodes remaining
+    FGTaxiGraph*& graph = fullSearch ? taxiGraph : pushbackGraph;
+    if (!graph) {
+        graph = new FGTaxiGraph(parent->guid(), !fullSearch);
+        SG_LOG(SG_GENERAL, SG_DEBUG, "Built " << (fullSearch ? "taxi" : "pushback")
+               << " graph for " << parent->getId() << ": " << graph->numNodes()
+               << " nodes, " << graph->numEdges() << " edges");
+    }
 
-    if (searchData[lastNode].score == HUGE_VAL) {
+    PositionedIDVec nodes;
+    double distance = 0.0;
+    if (!graph->findRoute(start, end, nodes, distance)) {
         // no valid route found
         if (fullSearch) {
             SG_LOG(SG_GENERAL, SG_ALERT,
@@ -467,17 +753,234 @@ FGTaxiRoute FGGroundNetwork::findShortestRoute(PositionedID start, PositionedID
       
         return FGTaxiRoute();
     }
-  
-    // assemble route from backtrace information
-    PositionedIDVec nodes;
-    FGTaxiNode *bt = lastNode;
-    while (searchData[bt].previousNode != 0) {
-        nodes.push_back(bt->guid());
-        bt = searchData[bt].previousNode;
-    }
-    nodes.push_back(start);
-    reverse(nodes.begin(), nodes.end());
-    return FGTaxiRoute(nodes, searchData[lastNode].score, 0);
+
+    return FGTaxiRoute(nodes, distance, 0);
+}
+
+void FGGroundNetwork::findBenchmarkEndpoints(PositionedIDVec& parkings,
+                                             PositionedIDVec& runwayNodes)
+{
+    NavDataCache* cache = NavDataCache::instance();
+    BOOST_FOREACH(PositionedID n, cache->groundNetNodes(parent->guid(), false)) {
+        if (findNode(n)->type() == FGPositioned::PARKING) {
+            parkings.push_back(n);
+        }
+    }
+
+    for (unsigned int r = 0; r < parent->numRunways(); ++r) {
+        FGRunway* rwy = parent->getRunwayByIndex(r);
+        PositionedID node = findNearestNodeOnRunway(rwy->pointOnCenterline(5.0));
+        if (node > 0) {
+            runwayNodes.push_back(node);
+        }
+    }
+}
+
+void FGGroundNetwork::benchmarkRouting(SGPropertyNode* aResults)
+{
+    PositionedIDVec parkings, runwayNodes;
+    findBenchmarkEndpoints(parkings, runwayNodes);
+
+    // make sure the graph is built before timing
+    delete taxiGraph;
+    taxiGraph = new FGTaxiGraph(parent->guid(), false);
+
+    int found = 0;
+    SGTimeStamp st;
+    st.stamp();
+    BOOST_FOREACH(PositionedID p, parkings) {
+        BOOST_FOREACH(PositionedID r, runwayNodes) {
+            if (!searchRoute(p, r, true).empty()) {
+                ++found;
+            }
+        }
+    }
+    double searchSec = st.elapsedMSec() / 1000.0;
+
+    if (routeCache) {
+        routeCache->clear();
+    }
+    unsigned int nRoutes = parkings.size() * runwayNodes.size();
+    SGTimeStamp ct;
+    ct.stamp();
+    for (int pass = 0; pass < 2; ++pass) {
+        BOOST_FOREACH(PositionedID p, parkings) {
+            BOOST_FOREACH(PositionedID r, runwayNodes) {
+                findShortestRoute(p, r, true);
+            }
+        }
+    }
+    double cachedSec = ct.elapsedMSec() / 1000.0;
+
+    double searchRate = (searchSec > 0.0) ? nRoutes / searchSec : 0.0;
+    double cachedRate = (cachedSec > 0.0) ? (2 * nRoutes) / cachedSec : 0.0;
+    SG_LOG(SG_GENERAL, SG_INFO, "Ground network routing benchmark at " << parent->getId()
+           << ": " << parkings.size() << " parkings x " << runwayNodes.size()
+           << " runway nodes, " << found << " routes found, "
+           << searchRate << " routes/sec (search), "
+           << cachedRate << " routes/sec (cached)");
+
+    if (aResults) {
+        aResults->setStringValue("airport", parent->getId());
+        aResults->setIntValue("graph-nodes", taxiGraph->numNodes());
+        aResults->setIntValue("graph-edges", taxiGraph->numEdges());
+        aResults->setIntValue("parkings", parkings.size());
+        aResults->setIntValue("runway-nodes", runwayNodes.size());
+        aResults->setIntValue("routes-found", found);
+        aResults->setDoubleValue("search-routes-per-sec", searchRate);
+        aResults->setDoubleValue("cached-routes-per-sec", cachedRate);
+        if (routeCache) {
+            aResults->setIntValue("cache-hits", routeCache->hits());
+            aResults->setIntValue("cache-misses", routeCache->misses());
+        }
+    }
+}
+
+namespace {
+
+// the route of the simulated aircraft of FGGroundNetwork::benchmarkTraffic
+struct BenchmarkPath
+{
+    std::vector<SGGeod> points;
+    std::vector<double> distances;  // from the start of the route
+    intVec segments;                // the segment starting at each point
+};
+
+} // of anonymous namespace
+
+void FGGroundNetwork::benchmarkTraffic(int aNumAircraft, int aSteps, SGPropertyNode* aResults)
+{
+    if (!towerController) {
+        SG_LOG(SG_GENERAL, SG_WARN, "Ground traffic benchmark: no tower controller at "
+               << parent->getId());
+        return;
+    }
+
+    PositionedIDVec parkings, runwayNodes;
+    findBenchmarkEndpoints(parkings, runwayNodes);
+
+    // one route per aircraft, as long as there are enough of them
+    std::vector<BenchmarkPath> paths;
+    unsigned int nRoutes = parkings.size() * runwayNodes.size();
+    for (unsigned int r = 0; (r < nRoutes) && ((int) paths.size() < aNumAircraft); ++r) {
+        FGTaxiRoute route = findShortestRoute(parkings[r % parkings.size()],
+                                              runwayNodes[(r / parkings.size()) % runwayNodes.size()]);
+        PositionedIDVec nodes;
+        PositionedID node;
+        route.first();
+        while (route.next(&node)) {
+            nodes.push_back(node);
+        }
+
+        BenchmarkPath path;
+        double distance = 0;
+        for (unsigned int n = 0; n < nodes.size(); ++n) {
+            SGGeod geod = findNode(nodes[n])->geod();
+            if (n > 0) {
+                distance += SGGeodesy::distanceM(path.points.back(), geod);
+            }
+            path.points.push_back(geod);
+            path.distances.push_back(distance);
+            FGTaxiSegment* seg = (n + 1 < nodes.size()) ? findSegment(nodes[n], nodes[n + 1]) : NULL;
+            path.segments.push_back(seg ? seg->getIndex() : 0);
+        }
+        if ((nodes.size() > 1) && (distance > 0)) {
+            paths.push_back(path);
+        }
+    }
+    if (paths.empty()) {
+        SG_LOG(SG_GENERAL, SG_WARN, "Ground traffic benchmark: no taxi routes at "
+               << parent->getId());
+        return;
+    }
+
+    // aircraft sharing a route start this far apart, and all of them move
+    // this far each step
+    const double spacing = 80.0;
+    const double stepLength = 10.0;
+    double alt = parent->getElevation() * SG_FEET_TO_METER;
+
+    TrafficVector savedTraffic;
+    FGTrafficIndex savedIndex;
+    savedTraffic.swap(activeTraffic);
+    savedIndex.swap(trafficIndex);
+    bool indexed = useTrafficIndex;
+
+    double msec[2];
+    int slowdowns[2] = { 0, 0 };
+    for (int pass = 0; pass < 2; ++pass) {
+        useTrafficIndex = (pass == 0);
+        for (int k = 0; k < aNumAircraft; ++k) {
+            FGTrafficRecord rec;
+            rec.setId(k + 1);
+            rec.setRadius(20.0 + 10.0 * (k % 3));
+            activeTraffic.push_back(rec);
+            trafficIndex.add(--activeTraffic.end());
+        }
+
+        msec[pass] = 0;
+        for (int step = 0; step < aSteps; ++step) {
+            int k = 0;
+            for (TrafficVectorIterator i = activeTraffic.begin(); i != activeTraffic.end(); ++i, ++k) {
+                const BenchmarkPath& path = paths[k % paths.size()];
+                double d = fmod((k / paths.size()) * spacing + step * stepLength,
+                                path.distances.back());
+                unsigned int n = std::upper_bound(path.distances.begin(), path.distances.end(), d)
+                                 - path.distances.begin() - 1;
+                double length = path.distances[n + 1] - path.distances[n];
+                double f = (length > 0) ? (d - path.distances[n]) / length : 0;
+                const SGGeod& a = path.points[n];
+                const SGGeod& b = path.points[n + 1];
+
+                if (i->getCurrentPosition() != path.segments[n]) {
+                    i->setCurrentPosition(path.segments[n]);
+                    i->getIntentions().assign(path.segments.begin() + n + 1, path.segments.end() - 1);
+                }
+                i->setPositionAndHeading(a.getLatitudeDeg() + f * (b.getLatitudeDeg() - a.getLatitudeDeg()),
+                                         a.getLongitudeDeg() + f * (b.getLongitudeDeg() - a.getLongitudeDeg()),
+                                         SGGeodesy::courseDeg(a, b),
+                                         stepLength * SG_METER_TO_NM * 3600, alt);
+                trafficIndex.moved(i);
+            }
+
+            SGTimeStamp st;
+            st.stamp();
+            for (TrafficVectorIterator i = activeTraffic.begin(); i != activeTraffic.end(); ++i) {
+                checkSpeedAdjustment(i->getId(), i->getLatitude(), i->getLongitude(),
+                                     i->getHeading(), i->getSpeed(), i->getAltitude());
+            }
+            msec[pass] += (SGTimeStamp::now() - st).toUSecs() / 1000.0;
+
+            for (TrafficVectorIterator i = activeTraffic.begin(); i != activeTraffic.end(); ++i) {
+                if (i->getSpeedAdjustment()) {
+                    ++slowdowns[pass];
+                }
+            }
+        }
+
+        activeTraffic.clear();
+        trafficIndex.clear();
+    }
+
+    activeTraffic.swap(savedTraffic);
+    trafficIndex.swap(savedIndex);
+    useTrafficIndex = indexed;
+
+    SG_LOG(SG_GENERAL, SG_INFO, "Ground traffic benchmark at " << parent->getId()
+           << ": " << aNumAircraft << " aircraft on " << paths.size() << " routes, "
+           << aSteps << " steps, indexed " << msec[0] << " ms, linear " << msec[1]
+           << " ms, slowdowns " << slowdowns[0] << " / " << slowdowns[1]);
+
+    if (aResults) {
+        aResults->setStringValue("airport", parent->getId());
+        aResults->setIntValue("aircraft", aNumAircraft);
+        aResults->setIntValue("routes", paths.size());
+        aResults->setIntValue("steps", aSteps);
+        aResults->setDoubleValue("indexed-msec", msec[0]);
+        aResults->setDoubleValue("linear-msec", msec[1]);
+        aResults->setIntValue("slowdowns-indexed", slowdowns[0]);
+        aResults->setIntValue("slowdowns-linear", slowdowns[1]);
+    }
 }
 
 /* ATC Related Functions */
@@ -492,18 +995,7 @@ void FGGroundNetwork::announcePosition(int id,
 {
     assert(parent);
   
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     // Add a new TrafficRecord if no one exsists for this aircraft.
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         FGTrafficRecord rec;
@@ -515,35 +1007,28 @@ void FGGroundNetwork::announcePosition(int id,
         rec.setAircraft(aircraft);
         if (leg == 2) {
             activeTraffic.push_front(rec);
+            trafficIndex.add(activeTraffic.begin());
         } else {
             activeTraffic.push_back(rec);   
+            trafficIndex.add(--activeTraffic.end());
         }
         
     } else {
         i->setPositionAndIntentions(currentPosition, intendedRoute);
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
     }
 }
 
 
 void FGGroundNetwork::signOff(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: Aircraft without traffic record is signing off at " << SG_ORIGIN);
     } else {
+        trafficIndex.remove(i);
         i = activeTraffic.erase(i);
     }
 }
@@ -606,25 +1091,15 @@ void FGGroundNetwork::updateAircraftInformation(int id, double lat, double lon,
     // Probably use a status mechanism similar to the Engine start procedure in the startup controller.
 
 
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     TrafficVectorIterator current, closest;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
     // update position of the current aircraft
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: updating aircraft without traffic record at " << SG_ORIGIN);
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
+        trafficIndex.moved(i);
         current = i;
     }
 
@@ -691,18 +1166,10 @@ void FGGroundNetwork::checkSpeedAdjustment(int id, double lat,
 {
 
     TrafficVectorIterator current, closest, closestOnNetwork;
-    TrafficVectorIterator i = activeTraffic.begin();
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     bool otherReasonToSlowDown = false;
 //    bool previousInstruction;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && (i != activeTraffic.end()))
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    } else {
+    if (activeTraffic.empty()) {
         return;
     }
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
@@ -720,8 +1187,30 @@ void FGGroundNetwork::checkSpeedAdjustment(int id, double lat,
         //TrafficVector iterator closest;
         closest = current;
         closestOnNetwork = current;
-        for (TrafficVectorIterator i = activeTraffic.begin();
-                i != activeTraffic.end(); i++) {
+
+        // Aircraft further away than twice the largest allowable distance
+        // below never make a difference, so with the traffic indexes only
+        // the nearby ones are looked at.
+        const FGTrafficIndex& towerIndex = towerController->getTrafficIndex();
+        double range = 2.2 * (current->getRadius() +
+                              std::max(trafficIndex.getMaxRadius(), towerIndex.getMaxRadius()));
+        TrafficIteratorVec nearby, nearbyTower;
+        if (useTrafficIndex) {
+            trafficIndex.findNear(lat, lon, range, nearby);
+            towerIndex.findNear(lat, lon, range, nearbyTower);
+        } else {
+            for (TrafficVectorIterator i = activeTraffic.begin();
+                    i != activeTraffic.end(); i++) {
+                nearby.push_back(i);
+            }
+            for (TrafficVectorIterator i =
+                        towerController->getActiveTraffic().begin();
+                    i != towerController->getActiveTraffic().end(); i++) {
+                nearbyTower.push_back(i);
+            }
+        }
+
+        BOOST_FOREACH(TrafficVectorIterator i, nearby) {
             if (i == current) {
                 continue;
             }
@@ -743,9 +1232,7 @@ void FGGroundNetwork::checkSpeedAdjustment(int id, double lat,
         }
         //Check traffic at the tower controller
         if (towerController->hasActiveTraffic()) {
-            for (TrafficVectorIterator i =
-                        towerController->getActiveTraffic().begin();
-                    i != towerController->getActiveTraffic().end(); i++) {
+            BOOST_FOREACH(TrafficVectorIterator i, nearbyTower) {
                 //cerr << "Comparing " << current->getId() << " and " << i->getId() << endl;
                 SGGeod other(SGGeod::fromDegM(i->getLongitude(),
                                               i->getLatitude(),
@@ -839,16 +1326,8 @@ void FGGroundNetwork::checkHoldPosition(int id, double lat,
                                         double speed, double alt)
 {
     TrafficVectorIterator current;
-    TrafficVectorIterator i = activeTraffic.begin();
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end())
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    } else {
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
+    if (activeTraffic.empty()) {
         return;
     }
     time_t now = time(NULL) + fgGetLong("/sim/time/warp");
@@ -986,16 +1465,9 @@ bool FGGroundNetwork::checkForCircularWaits(int id)
     //cerr << "Performing Wait check " << id << endl;
     int target = 0;
     TrafficVectorIterator current, other;
-    TrafficVectorIterator i = activeTraffic.begin();
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     int trafficSize = activeTraffic.size();
-    if (trafficSize) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    } else {
+    if (trafficSize == 0) {
         return false;
     }
     if (i == activeTraffic.end() || (trafficSize == 0)) {
@@ -1016,18 +1488,7 @@ bool FGGroundNetwork::checkForCircularWaits(int id)
 
     while ((target > 0) && (target != id) && counter++ < trafficSize) {
         //printed = true;
-        TrafficVectorIterator i = activeTraffic.begin();
-        if (trafficSize) {
-            //while ((i->getId() != id) && i != activeTraffic.end())
-            while (i != activeTraffic.end()) {
-                if (i->getId() == target) {
-                    break;
-                }
-                i++;
-            }
-        } else {
-            return false;
-        }
+        TrafficVectorIterator i = trafficIndex.find(target, activeTraffic);
         if (i == activeTraffic.end() || (trafficSize == 0)) {
             //cerr << "[Waiting for traffic at Runway: DONE] " << endl << endl;;
             // The target id is not found on the current network, which means it's at the tower
@@ -1078,18 +1539,7 @@ bool FGGroundNetwork::checkForCircularWaits(int id)
 // Note that this function is probably obsolete...
 bool FGGroundNetwork::hasInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: checking ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1101,18 +1551,7 @@ bool FGGroundNetwork::hasInstruction(int id)
 
 FGATCInstruction FGGroundNetwork::getInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = trafficIndex.find(id, activeTraffic);
     if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: requesting ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
@@ -1334,6 +1773,19 @@ void FGGroundNetwork::update(double dt)
         (*tsi)->unblock(now);
     }
     int priority = 1;
+
+    // the segments taxiing aircraft are heading towards, driving the other way
+    std::vector<bool> opposed(segments.size() + 1, false);
+    for (TrafficVectorIterator j = activeTraffic.begin(); j != activeTraffic.end(); j++) {
+        int pos = j->getCurrentPosition();
+        if (pos > 0) {
+            FGTaxiSegment *seg = segments[pos-1]->opposite();
+            if (seg) {
+                opposed[seg->getIndex()] = true;
+            }
+        }
+    }
+
     //sort(activeTraffic.begin(), activeTraffic.end(), compare_trafficrecords);
     // Handle traffic that is under ground control first; this way we'll prevent clutter at the gate areas.
     // Don't allow an aircraft to pushback when a taxiing aircraft is currently using part of the intended route.
@@ -1347,19 +1799,10 @@ void FGGroundNetwork::update(double dt)
 
             // Check for all active aircraft whether it's current pos segment is
             // an opposite of one of the departing aircraft's intentions
-            for (TrafficVectorIterator j = activeTraffic.begin(); j != activeTraffic.end(); j++) {
-                int pos = j->getCurrentPosition();
-                if (pos > 0) {
-                    FGTaxiSegment *seg = segments[pos-1]->opposite();
-                    if (seg) {
-                        int posReverse = seg->getIndex();
-                        for (intVecIterator k = i->getIntentions().begin(); k != i->getIntentions().end(); k++) {
-                            if ((*k) == posReverse) {
-                                i->denyPushBack();
-                                segments[posReverse-1]->block(i->getId(), now, now);
-                            }
-                        }
-                    }
+            for (intVecIterator k = i->getIntentions().begin(); k != i->getIntentions().end(); k++) {
+                if (((*k) > 0) && ((*k) < (int) opposed.size()) && opposed[*k]) {
+                    i->denyPushBack();
+                    segments[(*k)-1]->block(i->getId(), now, now);
                 }
             }
             // if the current aircraft is still allowed to pushback, we can start reserving a route for if by blocking all the entry taxiways.
@@ -1368,26 +1811,16 @@ void FGGroundNetwork::update(double dt)
                 int pos = i->getCurrentPosition();
                 if (pos > 0) {
                     FGTaxiSegment *seg = segments[pos-1];
-                    FGTaxiNode *node = seg->getEnd();
                     length = seg->getLength();
-                    for (FGTaxiSegmentVectorIterator tsi = segments.begin(); tsi != segments.end(); tsi++) {
-                        if (((*tsi)->getEnd() == node) && ((*tsi) != seg)) {
-                            (*tsi)->block(i->getId(), now, now);
-                        }
-                    }
+                    blockSegmentsTo(seg, i->getId(), now, now);
                 }
                 for (intVecIterator j = i->getIntentions().begin(); j != i->getIntentions().end(); j++) {
                     int pos = (*j);
                     if (pos > 0) {
                         FGTaxiSegment *seg = segments[pos-1];
-                        FGTaxiNode *node = seg->getEnd();
                         length += seg->getLength();
                         time_t blockTime = now + (length / vTaxi);
-                        for (FGTaxiSegmentVectorIterator tsi = segments.begin(); tsi != segments.end(); tsi++) {
-                            if (((*tsi)->getEnd() == node) && ((*tsi) != seg)) {
-                                (*tsi)->block(i->getId(), blockTime-30, now);
-                            }
-                        }
+                        blockSegmentsTo(seg, i->getId(), blockTime-30, now);
                     }
                 }
             }
@@ -1418,14 +1851,9 @@ void FGGroundNetwork::update(double dt)
             int pos = (*j);
             if (pos > 0) {
                 FGTaxiSegment *seg = segments[pos-1];
-                FGTaxiNode *node = seg->getEnd();
                 length += seg->getLength();
-                for (FGTaxiSegmentVectorIterator tsi = segments.begin(); tsi != segments.end(); tsi++) {
-                    if (((*tsi)->getEnd() == node) && ((*tsi) != seg)) {
-                        time_t blockTime = now + (length / vTaxi);
-                        (*tsi)->block(i->getId(), blockTime - 30, now);
-                    }
-                }
+                time_t blockTime = now + (length / vTaxi);
+                blockSegmentsTo(seg, i->getId(), blockTime - 30, now);
             }
         }
     }
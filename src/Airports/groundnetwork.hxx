@@ -41,6 +41,9 @@ class FGRunway;
 class FGTaxiSegment; // forward reference
 class FGAIFlightPlan; // forward reference
 class FGAirport;      // forward reference
+class FGTaxiGraph;    // forward reference
+class FGTaxiRouteCache; // forward reference
+class SGPropertyNode;
 
 typedef std::vector<FGTaxiSegment*>  FGTaxiSegmentVector;
 typedef FGTaxiSegmentVector::iterator FGTaxiSegmentVectorIterator;
@@ -201,12 +204,25 @@ private:
 
     TrafficVector activeTraffic;
     TrafficVectorIterator currTraffic;
+    FGTrafficIndex trafficIndex;
+
+    // the segments ending at each node
+    std::map<PositionedID, FGTaxiSegmentVector> segmentsTo;
+
+    static bool useTrafficIndex;
 
     bool foundRoute;
     double totalDistance, maxDistance;
     FGTowerController *towerController;
     FGAirport *parent;
 
+    // routing graphs are built lazily, on the first search of each kind
+    FGTaxiGraph *taxiGraph;
+    FGTaxiGraph *pushbackGraph;
+    FGTaxiRouteCache *routeCache;
+    // NavDataCache::groundnetGeneration() the above were built from
+    unsigned int routeGeneration;
+
 
     //void printRoutingError(string);
 
@@ -215,10 +231,19 @@ private:
     void checkHoldPosition(int id, double lat, double lon,
                            double heading, double speed, double alt);
 
+    // block the other segments ending where seg ends
+    void blockSegmentsTo(FGTaxiSegment* seg, int id, time_t blockTime, time_t now);
+
 
     void parseCache();
   
     void loadSegments();
+
+    FGTaxiRoute searchRoute(PositionedID start, PositionedID end, bool fullSearch);
+    void discardStaleRoutes();
+
+    // the parking positions and runway nodes routed by the benchmarks
+    void findBenchmarkEndpoints(PositionedIDVec& parkings, PositionedIDVec& runwayNodes);
 public:
     FGGroundNetwork();
     ~FGGroundNetwork();
@@ -250,6 +275,31 @@ public:
   
     FGTaxiRoute findShortestRoute(PositionedID start, PositionedID end, bool fullSearch=true);
 
+    /**
+     * Route every parking position to every runway and report the number
+     * of routes per second, both for uncached searches and for lookups
+     * through the route cache. Results are logged, and written below
+     * aResults if it is not NULL.
+     */
+    void benchmarkRouting(SGPropertyNode* aResults = NULL);
+
+    /**
+     * Move aNumAircraft simulated aircraft along routes from the parking
+     * positions to the runways for aSteps steps, checking the speed
+     * adjustments of all of them at each step, once looking only at the
+     * nearby traffic through the traffic indexes and once at all of it.
+     * The active traffic is set aside meanwhile. Results are logged, and
+     * written below aResults if it is not NULL.
+     */
+    void benchmarkTraffic(int aNumAircraft, int aSteps, SGPropertyNode* aResults = NULL);
+
+    /**
+     * Whether conflicts are searched among the nearby traffic only, as
+     * found by the traffic indexes, or among all of it.
+     */
+    static void setUseTrafficIndex(bool use) { useTrafficIndex = use; }
+    static bool getUseTrafficIndex() { return useTrafficIndex; }
+
     virtual void announcePosition(int id, FGAIFlightPlan *intendedRoute, int currentRoute,
                                   double lat, double lon, double hdg, double spd, double alt,
                                   double radius, int leg, FGAIAircraft *aircraft);
@@ -28,7 +28,7 @@ using namespace FGXMLAutopilot;
 AnalogComponent::AnalogComponent() :
   Component(),
   _feedback_if_disabled(false),
-  _passive_mode( fgGetNode("/autopilot/locks/passive-mode", true) )
+  _passive_mode( get_property_root()->getNode( "/autopilot/locks/passive-mode", true ) )
 {
 }
 
@@ -66,19 +66,19 @@ bool AnalogComponent::configure( const std::string & nodeName, SGPropertyNode_pt
     // backwards compatibility: allow <prop> elements
     SGPropertyNode_ptr prop;
     for( int i = 0; (prop = configNode->getChild("prop", i)) != NULL; i++ ) { 
-      SGPropertyNode *tmp = fgGetNode( prop->getStringValue(), true );
+      SGPropertyNode *tmp = get_property_root()->getNode( prop->getStringValue(), true );
       _output_list.push_back( tmp );
       found++;
     }
     for( int i = 0; (prop = configNode->getChild("property", i)) != NULL; i++ ) { 
-      SGPropertyNode *tmp = fgGetNode( prop->getStringValue(), true );
+      SGPropertyNode *tmp = get_property_root()->getNode( prop->getStringValue(), true );
       _output_list.push_back( tmp );
       found++;
     }
 
     // no <prop> elements, text node of <output> is property name
     if( found == 0 )
-      _output_list.push_back( fgGetNode(configNode->getStringValue(), true ) );
+      _output_list.push_back( get_property_root()->getNode( configNode->getStringValue(), true ) );
 
     return true;
   }
@@ -27,6 +27,7 @@
 
 #include "autopilot.hxx"
 #include "autopilotgroup.hxx"
+#include "inputvalue.hxx"
 
 #include <string>
 #include <vector>
@@ -34,6 +35,7 @@
 #include <simgear/props/props_io.hxx>
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/structure/exception.hxx>
+#include <simgear/timing/timestamp.hxx>
 #include <Main/fg_props.hxx>
 #include <boost/foreach.hpp>
 
@@ -178,6 +180,68 @@ void FGXMLAutopilotGroup::addAutopilotFromFile( const std::string & name, SGProp
     }
 }
 
+bool FGXMLAutopilotGroup::benchmark( const char * path, int iterations, double dt, SGPropertyNode * results )
+{
+    SGPath config = globals->resolve_maybe_aircraft_path(path);
+    if (config.isNull())
+    {
+        SG_LOG( SG_AUTOPILOT, SG_ALERT, "Cannot find property-rule configuration file '" << path << "'." );
+        return false;
+    }
+
+    SGPropertyNode_ptr configNode = new SGPropertyNode();
+    try {
+        readProperties( config.str(), configNode );
+    } catch (const sg_exception& e) {
+        SG_LOG( SG_AUTOPILOT, SG_ALERT, "Failed to load property-rule configuration: "
+            << config.str() << ":" << e.getMessage() );
+        return false;
+    }
+
+    // each pass builds its components on its own copy of the property
+    // tree, so that neither pass sees the state left by the other and
+    // their outputs neither reach the simulation nor trigger its
+    // listeners. The global root stays in place for the other threads.
+    bool useProgram = FGXMLAutopilot::InputValue::get_use_program();
+    double msec[2];
+    try {
+        for( int pass = 0; pass < 2; pass++ ) {
+            SGPropertyNode_ptr props = new SGPropertyNode();
+            copyProperties( globals->get_props(), props );
+
+            FGXMLAutopilot::InputValue::set_use_program( pass == 0 );
+            FGXMLAutopilot::Component::set_property_root( props );
+            FGXMLAutopilot::Autopilot * ap = new FGXMLAutopilot::Autopilot(
+                props->getNode( "autopilot-benchmark", true ), configNode );
+            ap->init();
+            FGXMLAutopilot::Component::set_property_root( NULL );
+
+            SGTimeStamp st;
+            st.stamp();
+            for( int i = 0; i < iterations; i++ )
+                ap->update( dt );
+            msec[pass] = (SGTimeStamp::now() - st).toUSecs() / 1000.0;
+
+            delete ap;
+        }
+    } catch (...) {
+        FGXMLAutopilot::Component::set_property_root( NULL );
+        FGXMLAutopilot::InputValue::set_use_program( useProgram );
+        throw;
+    }
+    FGXMLAutopilot::InputValue::set_use_program( useProgram );
+
+    SG_LOG( SG_AUTOPILOT, SG_INFO, "Property-rule benchmark, " << config.str() << " x "
+            << iterations << ": compiled inputs " << msec[0] << "ms, interpreted inputs "
+            << msec[1] << "ms" );
+
+    results->setStringValue( "path", config.str() );
+    results->setIntValue( "iterations", iterations );
+    results->setDoubleValue( "compiled-msec", msec[0] );
+    results->setDoubleValue( "interpreted-msec", msec[1] );
+    return true;
+}
+
 FGXMLAutopilotGroup * FGXMLAutopilotGroup::createInstance(const std::string& nodeName)
 {
     return new FGXMLAutopilotGroupImplementation(nodeName);
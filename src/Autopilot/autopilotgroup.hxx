@@ -35,6 +35,16 @@ public:
     void addAutopilotFromFile( const std::string & name, SGPropertyNode_ptr apNode, const char * path );
     virtual void addAutopilot( const std::string & name, SGPropertyNode_ptr apNode, SGPropertyNode_ptr config ) = 0;
     virtual void removeAutopilot( const std::string & name ) = 0;
+
+    /**
+     * Time the configuration file at path, loaded outside of any group and
+     * updated iterations times, with the inputs of its components computed
+     * by their compiled programs and then by walking the configuration.
+     * Each run builds its components on its own copy of the global
+     * properties, so the runs start from the same state and the simulation
+     * is left untouched. Returns false if the file can not be read.
+     */
+    static bool benchmark( const char * path, int iterations, double dt, SGPropertyNode * results );
 protected:
     FGXMLAutopilotGroup() : SGSubsystemGroup() {}
 
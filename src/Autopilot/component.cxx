@@ -27,6 +27,8 @@
 
 using namespace FGXMLAutopilot;
 
+SGPropertyNode_ptr Component::_propertyRoot;
+
 Component::Component() :
   _enable_value(NULL),
   _enabled(false),
@@ -74,15 +76,15 @@ bool Component::configure( const std::string & nodeName, SGPropertyNode_ptr conf
     SGPropertyNode_ptr prop;
 
     if( (prop = configNode->getChild("condition")) != NULL ) {
-      _condition = sgReadCondition(fgGetNode("/"), prop);
+      _condition = sgReadCondition(get_property_root(), prop);
       return true;
     } 
     if ( (prop = configNode->getChild( "property" )) != NULL ) {
-      _enable_prop = fgGetNode( prop->getStringValue(), true );
+      _enable_prop = get_property_root()->getNode( prop->getStringValue(), true );
     }
        
     if ( (prop = configNode->getChild( "prop" )) != NULL ) {
-      _enable_prop = fgGetNode( prop->getStringValue(), true );
+      _enable_prop = get_property_root()->getNode( prop->getStringValue(), true );
     }
 
     if ( (prop = configNode->getChild( "value" )) != NULL ) {
@@ -129,3 +131,13 @@ void Component::update( double dt )
   if( _enabled ) update( firstTime, dt );
   else disabled( dt );
 }
+
+SGPropertyNode * Component::get_property_root()
+{
+  return _propertyRoot != NULL ? _propertyRoot.ptr() : globals->get_props();
+}
+
+void Component::set_property_root( SGPropertyNode * root )
+{
+  _propertyRoot = root;
+}
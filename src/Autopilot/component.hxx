@@ -133,6 +133,24 @@ public:
      * Returns true, if neither &lt;condition&gt; nor &lt;prop&gt; exists
      */
     bool isPropertyEnabled();
+
+    /**
+     * @brief the node the property paths of the configuration are resolved
+     *        against, the global property root unless set_property_root()
+     *        gave another one
+     */
+    static SGPropertyNode * get_property_root();
+
+    /**
+     * @brief resolve the property paths of the components configured from
+     *        now on against root, or against the global property root if
+     *        root is NULL. Components are configured on the main thread only,
+     *        so this does not affect other threads.
+     */
+    static void set_property_root( SGPropertyNode * root );
+
+private:
+    static SGPropertyNode_ptr _propertyRoot;
 };
 
 
@@ -71,7 +71,7 @@ bool DigitalComponent::configure( const std::string & nodeName, SGPropertyNode_p
       buf << "Input" << _input.size();
       name = buf.str();
     }
-    _input[name] = sgReadCondition( fgGetNode("/"), configNode );
+    _input[name] = sgReadCondition( get_property_root(), configNode );
     return true;
   } 
 
@@ -93,10 +93,10 @@ bool DigitalComponent::configure( const std::string & nodeName, SGPropertyNode_p
       o->setInverted( n->getBoolValue() );
 
     if( (n = configNode->getNode("property")) != NULL )
-      o->setProperty( fgGetNode( n->getStringValue(), true ) );
+      o->setProperty( get_property_root()->getNode( n->getStringValue(), true ) );
 
     if( configNode->nChildren() == 0 )
-      o->setProperty( fgGetNode( configNode->getStringValue(), true ) );
+      o->setProperty( get_property_root()->getNode( configNode->getStringValue(), true ) );
 
     return true;
   } 
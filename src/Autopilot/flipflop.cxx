@@ -415,32 +415,32 @@ bool FlipFlop::configure( const std::string & nodeName, SGPropertyNode_ptr confi
   }
 
   if (nodeName == "set"||nodeName == "S") {
-    _input["S"] = sgReadCondition( fgGetNode("/"), configNode );
+    _input["S"] = sgReadCondition( get_property_root(), configNode );
     return true;
   }
 
   if (nodeName == "reset" || nodeName == "R" ) {
-    _input["R"] = sgReadCondition( fgGetNode("/"), configNode );
+    _input["R"] = sgReadCondition( get_property_root(), configNode );
     return true;
   } 
 
   if (nodeName == "J") {
-    _input["J"] = sgReadCondition( fgGetNode("/"), configNode );
+    _input["J"] = sgReadCondition( get_property_root(), configNode );
     return true;
   } 
 
   if (nodeName == "K") {
-    _input["K"] = sgReadCondition( fgGetNode("/"), configNode );
+    _input["K"] = sgReadCondition( get_property_root(), configNode );
     return true;
   } 
 
   if (nodeName == "D") {
-    _input["D"] = sgReadCondition( fgGetNode("/"), configNode );
+    _input["D"] = sgReadCondition( get_property_root(), configNode );
     return true;
   } 
 
   if (nodeName == "clock") {
-    _input["clock"] = sgReadCondition( fgGetNode("/"), configNode );
+    _input["clock"] = sgReadCondition( get_property_root(), configNode );
     return true;
   }
 
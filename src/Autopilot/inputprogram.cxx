@@ -0,0 +1,294 @@
+// inputprogram.cxx - flat evaluation programs for autopilot input values
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#include <cmath>
+#include <cstring>
+
+#include "inputprogram.hxx"
+
+#include <simgear/math/SGMath.hxx>
+#include "component.hxx"
+
+using namespace FGXMLAutopilot;
+
+InputProgram::InputProgram() :
+  _depth(0),
+  _maxDepth(0)
+{
+}
+
+void InputProgram::clear()
+{
+  _code.clear();
+  _properties.clear();
+  _expressions.clear();
+  _depth = 0;
+  _maxDepth = 0;
+}
+
+unsigned InputProgram::arity( Opcode op )
+{
+  switch( op ) {
+    case PUSH_CONSTANT:
+    case PUSH_PROPERTY:
+    case PUSH_EXPRESSION:
+      return 0;
+    case ADD: case SUBTRACT: case MULTIPLY: case DIVIDE: case POW: case ATAN2:
+    case MIN: case MAX: case CLAMP_MIN: case CLAMP_MAX:
+      return 2;
+    case PERIODIC:
+      return 3;
+    default:
+      return 1;
+  }
+}
+
+void InputProgram::push( const Instruction & instruction )
+{
+  _code.push_back( instruction );
+  _depth = _depth + 1 - arity( instruction.op );
+  if( _depth > _maxDepth )
+    _maxDepth = _depth;
+}
+
+void InputProgram::push_constant( double value )
+{
+  Instruction i = { PUSH_CONSTANT, value, NULL, NULL };
+  push( i );
+}
+
+void InputProgram::push_property( SGPropertyNode * property )
+{
+  _properties.push_back( property );
+  Instruction i = { PUSH_PROPERTY, 0.0, property, NULL };
+  push( i );
+}
+
+void InputProgram::push_expression( SGExpressiond * expression )
+{
+  if( expression->isConst() ) {
+    push_constant( expression->getValue(NULL) );
+    return;
+  }
+  _expressions.push_back( expression );
+  Instruction i = { PUSH_EXPRESSION, 0.0, NULL, expression };
+  push( i );
+}
+
+void InputProgram::apply( Opcode op )
+{
+  Instruction i = { op, 0.0, NULL, NULL };
+  unsigned n = arity( op );
+
+  // fold the operation if all operands are constants
+  unsigned size = _code.size();
+  bool fold = n > 0 && size >= n;
+  for( unsigned k = size - n; fold && k < size; k++ )
+    fold = _code[k].op == PUSH_CONSTANT;
+
+  if( !fold ) {
+    push( i );
+    return;
+  }
+
+  double stack[3];
+  for( unsigned k = 0; k < n; k++ )
+    stack[k] = _code[size - n + k].value;
+  execute( i, stack + n );
+
+  _code.resize( size - n );
+  _depth -= n;
+  push_constant( stack[0] );
+}
+
+void InputProgram::append( const InputProgram & program )
+{
+  if( program.is_constant() ) {
+    push_constant( program._code[0].value );
+    return;
+  }
+
+  if( _depth + program._maxDepth > _maxDepth )
+    _maxDepth = _depth + program._maxDepth;
+  _depth += program._depth;
+
+  _code.insert( _code.end(), program._code.begin(), program._code.end() );
+  _properties.insert( _properties.end(),
+                      program._properties.begin(), program._properties.end() );
+  _expressions.insert( _expressions.end(),
+                       program._expressions.begin(), program._expressions.end() );
+}
+
+bool InputProgram::compile_nary( const SGPropertyNode * expression, Opcode op )
+{
+  int count = expression->nChildren();
+  if( count < 1 )
+    return false;
+
+  if( !compile_expression( expression->getChild(0) ) )
+    return false;
+
+  for( int i = 1; i < count; i++ ) {
+    if( !compile_expression( expression->getChild(i) ) )
+      return false;
+    apply( op );
+  }
+  return true;
+}
+
+bool InputProgram::compile_unary( const SGPropertyNode * expression, Opcode op )
+{
+  if( expression->nChildren() != 1 ||
+      !compile_expression( expression->getChild(0) ) )
+    return false;
+
+  apply( op );
+  return true;
+}
+
+bool InputProgram::compile_binary( const SGPropertyNode * expression, Opcode op )
+{
+  if( expression->nChildren() != 2 ||
+      !compile_expression( expression->getChild(0) ) ||
+      !compile_expression( expression->getChild(1) ) )
+    return false;
+
+  apply( op );
+  return true;
+}
+
+bool InputProgram::compile_expression( const SGPropertyNode * expression )
+{
+  if( expression == NULL )
+    return false;
+
+  const char * name = expression->getName();
+
+  if( !strcmp( name, "value" ) ) {
+    push_constant( expression->getDoubleValue() );
+    return true;
+  }
+
+  if( !strcmp( name, "property" ) ) {
+    push_property( Component::get_property_root()->getNode( expression->getStringValue(), true ) );
+    return true;
+  }
+
+  if( !strcmp( name, "sum" ) )
+    return compile_nary( expression, ADD );
+  if( !strcmp( name, "difference" ) || !strcmp( name, "dif" ) )
+    return compile_nary( expression, SUBTRACT );
+  if( !strcmp( name, "product" ) || !strcmp( name, "prod" ) )
+    return compile_nary( expression, MULTIPLY );
+  if( !strcmp( name, "min" ) )
+    return compile_nary( expression, MIN );
+  if( !strcmp( name, "max" ) )
+    return compile_nary( expression, MAX );
+
+  if( !strcmp( name, "div" ) )
+    return compile_binary( expression, DIVIDE );
+  if( !strcmp( name, "pow" ) )
+    return compile_binary( expression, POW );
+  if( !strcmp( name, "atan2" ) )
+    return compile_binary( expression, ATAN2 );
+
+  if( !strcmp( name, "abs" ) || !strcmp( name, "fabs" ) )
+    return compile_unary( expression, ABS );
+  if( !strcmp( name, "sqr" ) )
+    return compile_unary( expression, SQR );
+  if( !strcmp( name, "sqrt" ) )
+    return compile_unary( expression, SQRT );
+  if( !strcmp( name, "sin" ) )
+    return compile_unary( expression, SIN );
+  if( !strcmp( name, "cos" ) )
+    return compile_unary( expression, COS );
+  if( !strcmp( name, "tan" ) )
+    return compile_unary( expression, TAN );
+  if( !strcmp( name, "atan" ) )
+    return compile_unary( expression, ATAN );
+  if( !strcmp( name, "exp" ) )
+    return compile_unary( expression, EXP );
+  if( !strcmp( name, "log" ) )
+    return compile_unary( expression, LOG );
+  if( !strcmp( name, "log10" ) )
+    return compile_unary( expression, LOG10 );
+  if( !strcmp( name, "ceil" ) )
+    return compile_unary( expression, CEIL );
+  if( !strcmp( name, "floor" ) )
+    return compile_unary( expression, FLOOR );
+  if( !strcmp( name, "deg2rad" ) )
+    return compile_unary( expression, DEG2RAD );
+  if( !strcmp( name, "rad2deg" ) )
+    return compile_unary( expression, RAD2DEG );
+
+  // tables, clip, acos, asin, ...: leave it to SGExpression
+  return false;
+}
+
+// sp points past the topmost value; returns the new stack pointer
+inline double * InputProgram::execute( const Instruction & i, double * sp )
+{
+  switch( i.op ) {
+    case PUSH_CONSTANT:   *sp++ = i.value; break;
+    case PUSH_PROPERTY:   *sp++ = i.property->getDoubleValue(); break;
+    case PUSH_EXPRESSION: *sp++ = i.expression->getValue(NULL); break;
+
+    case ADD:       --sp; sp[-1] += sp[0]; break;
+    case SUBTRACT:  --sp; sp[-1] -= sp[0]; break;
+    case MULTIPLY:  --sp; sp[-1] *= sp[0]; break;
+    case DIVIDE:    --sp; sp[-1] /= sp[0]; break;
+    case POW:       --sp; sp[-1] = pow( sp[-1], sp[0] ); break;
+    case ATAN2:     --sp; sp[-1] = atan2( sp[-1], sp[0] ); break;
+    case MIN:       --sp; sp[-1] = SGMiscd::min( sp[-1], sp[0] ); break;
+    case MAX:       --sp; sp[-1] = SGMiscd::max( sp[-1], sp[0] ); break;
+    case CLAMP_MIN: --sp; if( sp[-1] < sp[0] ) sp[-1] = sp[0]; break;
+    case CLAMP_MAX: --sp; if( sp[-1] > sp[0] ) sp[-1] = sp[0]; break;
+
+    case PERIODIC:
+      sp -= 2;
+      sp[-1] = SGMiscd::normalizePeriodic( sp[0], sp[1], sp[-1] );
+      break;
+
+    case ABS:     sp[-1] = fabs( sp[-1] ); break;
+    case SQR:     sp[-1] = sp[-1] * sp[-1]; break;
+    case SQRT:    sp[-1] = sqrt( sp[-1] ); break;
+    case SIN:     sp[-1] = sin( sp[-1] ); break;
+    case COS:     sp[-1] = cos( sp[-1] ); break;
+    case TAN:     sp[-1] = tan( sp[-1] ); break;
+    case ATAN:    sp[-1] = atan( sp[-1] ); break;
+    case EXP:     sp[-1] = exp( sp[-1] ); break;
+    case LOG:     sp[-1] = log( sp[-1] ); break;
+    case LOG10:   sp[-1] = log10( sp[-1] ); break;
+    case CEIL:    sp[-1] = ceil( sp[-1] ); break;
+    case FLOOR:   sp[-1] = floor( sp[-1] ); break;
+    case DEG2RAD: sp[-1] = SGMiscd::deg2rad( sp[-1] ); break;
+    case RAD2DEG: sp[-1] = SGMiscd::rad2deg( sp[-1] ); break;
+  }
+  return sp;
+}
+
+double InputProgram::run() const
+{
+  double stack[MAX_DEPTH];
+  double * sp = stack;
+
+  const Instruction * end = &_code[0] + _code.size();
+  for( const Instruction * i = &_code[0]; i != end; ++i )
+    sp = execute( *i, sp );
+
+  return stack[0];
+}
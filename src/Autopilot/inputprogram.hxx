@@ -0,0 +1,125 @@
+// inputprogram.hxx - flat evaluation programs for autopilot input values
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifndef _INPUTPROGRAM_HXX
+#define _INPUTPROGRAM_HXX 1
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <vector>
+
+#include <simgear/props/props.hxx>
+#include <simgear/structure/SGExpression.hxx>
+
+namespace FGXMLAutopilot {
+
+/**
+ * @brief A flat stack program computing the value of an InputValue
+ *
+ * InputValues are compiled into these once, when the configuration is
+ * read: nested scale, offset, min, max and period values are inlined,
+ * and so are expressions built from the common operators. Operations on
+ * constants are folded as they are added, so an input that only depends
+ * on <value> elements becomes a single constant.
+ *
+ * Expressions using operators not known here stay SGExpressions, called
+ * from the program.
+ */
+class InputProgram {
+public:
+    enum Opcode {
+        PUSH_CONSTANT,
+        PUSH_PROPERTY,
+        PUSH_EXPRESSION,
+
+        // binary, applied to the two topmost values
+        ADD, SUBTRACT, MULTIPLY, DIVIDE, POW, ATAN2,
+        MIN, MAX,               // as the <min> and <max> expressions
+        CLAMP_MIN, CLAMP_MAX,   // as the <min> and <max> of an InputValue
+
+        // value, period minimum, period maximum
+        PERIODIC,
+
+        // unary, applied to the topmost value
+        ABS, SQR, SQRT, SIN, COS, TAN, ATAN, EXP, LOG, LOG10, CEIL, FLOOR,
+        DEG2RAD, RAD2DEG
+    };
+
+    /** programs needing a deeper stack are not run */
+    static const unsigned MAX_DEPTH = 32;
+
+    InputProgram();
+
+    void clear();
+    bool empty() const { return _code.empty(); }
+    unsigned size() const { return _code.size(); }
+    unsigned max_depth() const { return _maxDepth; }
+
+    /** true if the program always computes the same value */
+    bool is_constant() const {
+      return _code.size() == 1 && _code[0].op == PUSH_CONSTANT;
+    }
+
+    void push_constant( double value );
+    void push_property( SGPropertyNode * property );
+    void push_expression( SGExpressiond * expression );
+
+    /** add an operation, folding it if its operands are constants */
+    void apply( Opcode op );
+
+    /** add the code of another program, pushing its value */
+    void append( const InputProgram & program );
+
+    /**
+     * Compile the XML of an expression as read by SGReadDoubleExpression.
+     * Returns false, leaving the program undefined, if it uses an operator
+     * not handled here.
+     */
+    bool compile_expression( const SGPropertyNode * expression );
+
+    double run() const;
+
+private:
+    struct Instruction {
+        Opcode op;
+        double value;
+        SGPropertyNode * property;
+        SGExpressiond * expression;
+    };
+
+    static double * execute( const Instruction & instruction, double * sp );
+    static unsigned arity( Opcode op );
+
+    void push( const Instruction & instruction );
+    bool compile_nary( const SGPropertyNode * expression, Opcode op );
+    bool compile_unary( const SGPropertyNode * expression, Opcode op );
+    bool compile_binary( const SGPropertyNode * expression, Opcode op );
+
+    std::vector<Instruction> _code;
+    unsigned _depth;
+    unsigned _maxDepth;
+
+    // the nodes and expressions the code points to
+    std::vector<SGPropertyNode_ptr> _properties;
+    std::vector<SGSharedPtr<SGExpressiond> > _expressions;
+};
+
+}
+
+#endif
@@ -21,10 +21,12 @@
 #include <cstdlib>
 
 #include "inputvalue.hxx"
-#include <Main/fg_props.hxx>
+#include "component.hxx"
 
 using namespace FGXMLAutopilot;
 
+bool InputValue::_useProgram = true;
+
 PeriodicalValue::PeriodicalValue( SGPropertyNode_ptr root )
 {
   SGPropertyNode_ptr minNode = root->getChild( "min" );
@@ -69,14 +71,17 @@ void InputValue::parse( SGPropertyNode_ptr node, double aValue, double aOffset,
     _min = NULL;
     _max = NULL;
     _periodical = NULL;
+    _expression = NULL;
 
-    if( node == NULL )
+    if( node == NULL ) {
+        compile( NULL );
         return;
+    }
 
     SGPropertyNode * n;
 
     if( (n = node->getChild("condition")) != NULL ) {
-        _condition = sgReadCondition(fgGetNode("/"), n);
+        _condition = sgReadCondition(Component::get_property_root(), n);
     }
 
     if( (n = node->getChild( "scale" )) != NULL ) {
@@ -108,8 +113,10 @@ void InputValue::parse( SGPropertyNode_ptr node, double aValue, double aOffset,
         _value = valueNode->getDoubleValue();
     }
 
-    if ((n = node->getChild("expression")) != NULL) {
-      _expression = SGReadDoubleExpression(fgGetNode("/"), n->getChild(0));
+    SGPropertyNode * expressionNode = node->getChild("expression");
+    if (expressionNode != NULL) {
+      _expression = SGReadDoubleExpression(Component::get_property_root(), expressionNode->getChild(0));
+      compile( expressionNode->getChild(0) );
       return;
     }
     
@@ -120,7 +127,7 @@ void InputValue::parse( SGPropertyNode_ptr node, double aValue, double aOffset,
         n = node->getChild( "prop" );
 
     if (  n != NULL ) {
-        _property = fgGetNode(  n->getStringValue(), true );
+        _property = Component::get_property_root()->getNode( n->getStringValue(), true );
         if ( valueNode != NULL ) {
             // initialize property with given value 
             // if both <prop> and <value> exist
@@ -131,6 +138,7 @@ void InputValue::parse( SGPropertyNode_ptr node, double aValue, double aOffset,
               _property->setDoubleValue( 0 ); // if scale is zero, value*scale is zero
         }
         
+        compile( NULL );
         return;
     } // of have a <property> or <prop>
 
@@ -144,8 +152,70 @@ void InputValue::parse( SGPropertyNode_ptr node, double aValue, double aOffset,
         // a property name
         _value = strtod( textnode, &endp );
         if( endp == textnode ) {
-          _property = fgGetNode( textnode, true );
+          _property = Component::get_property_root()->getNode( textnode, true );
+        }
+    }
+
+    compile( NULL );
+}
+
+/*
+ * Build the program doing what evaluate() does. Nested inputs have
+ * been compiled by their constructors and are inlined; if one of them
+ * could not be, neither can this one and get_value() uses evaluate().
+ */
+void InputValue::compile( const SGPropertyNode * expressionNode )
+{
+    _program.clear();
+
+    if (_expression) {
+        InputProgram expression;
+        if( expression.compile_expression( expressionNode ) )
+            _program.append( expression );
+        else
+            _program.push_expression( _expression );
+    } else if( _property != NULL ) {
+        _program.push_property( _property );
+    } else {
+        _program.push_constant( _value );
+    }
+
+    InputValue * operands[] = { _scale, _offset, _min, _max };
+    InputProgram::Opcode ops[] = {
+        InputProgram::MULTIPLY, InputProgram::ADD,
+        InputProgram::CLAMP_MIN, InputProgram::CLAMP_MAX
+    };
+    for( unsigned i = 0; i < 4; i++ ) {
+        if( operands[i] == NULL )
+            continue;
+        if( operands[i]->_program.empty() ) {
+            _program.clear();
+            return;
+        }
+        _program.append( operands[i]->_program );
+        _program.apply( ops[i] );
+    }
+
+    if( _periodical ) {
+        InputValue * minPeriod = _periodical->minPeriod;
+        InputValue * maxPeriod = _periodical->maxPeriod;
+        if( minPeriod == NULL || maxPeriod == NULL ||
+            minPeriod->_program.empty() || maxPeriod->_program.empty() ) {
+            _program.clear();
+            return;
         }
+        _program.append( minPeriod->_program );
+        _program.append( maxPeriod->_program );
+        _program.apply( InputProgram::PERIODIC );
+    }
+
+    if( _abs )
+        _program.apply( InputProgram::ABS );
+
+    if( _program.max_depth() > InputProgram::MAX_DEPTH ) {
+        SG_LOG(SG_AUTOPILOT, SG_DEBUG, "input value too deeply nested to compile, "
+               << _program.max_depth() << " stack slots needed" );
+        _program.clear();
     }
 }
 
@@ -161,7 +231,7 @@ void InputValue::set_value( double aValue )
         _property->setDoubleValue( 0 ); // if scale is zero, value*scale is zero
 }
 
-double InputValue::get_value() const
+double InputValue::evaluate() const
 {
     double value = _value;
 
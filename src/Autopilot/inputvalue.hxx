@@ -28,6 +28,8 @@
 
 #include <simgear/structure/SGExpression.hxx>
 
+#include "inputprogram.hxx"
+
 namespace FGXMLAutopilot {
 
 typedef SGSharedPtr<class InputValue> InputValue_ptr;
@@ -41,6 +43,8 @@ typedef SGSharedPtr<class PeriodicalValue> PeriodicalValue_ptr;
  */
 class PeriodicalValue : public SGReferenced {
 private:
+     friend class InputValue;
+
      InputValue_ptr minPeriod; // The minimum value of the period
      InputValue_ptr maxPeriod; // The maximum value of the period
 public:
@@ -68,14 +72,22 @@ private:
      PeriodicalValue_ptr  _periodical; //
      SGSharedPtr<const SGCondition> _condition;
      SGSharedPtr<SGExpressiond> _expression;  ///< expression to generate the value
-     
+     InputProgram       _program;  // all of the above, compiled; empty if not possible
+
+     static bool _useProgram;
+
+     void compile( const SGPropertyNode * expressionNode );
+     double evaluate() const;
+
 public:
     InputValue( SGPropertyNode_ptr node = NULL, double value = 0.0, double offset = 0.0, double scale = 1.0 );
     
     void parse( SGPropertyNode_ptr, double value = 0.0, double offset = 0.0, double scale = 1.0 );
 
     /* get the value of this input, apply scale and offset and clipping */
-    double get_value() const;
+    inline double get_value() const {
+      return _useProgram && !_program.empty() ? _program.run() : evaluate();
+    }
 
     /* set the input value after applying offset and scale */
     void set_value( double value );
@@ -92,6 +104,11 @@ public:
       return _condition == NULL ? true : _condition->test();
     }
 
+    /* evaluate inputs by their compiled programs (the default) or by
+       walking the configuration, as used to compare both */
+    static void set_use_program( bool value ) { _useProgram = value; }
+    static bool get_use_program() { return _useProgram; }
+
 };
 
 /**
@@ -0,0 +1,294 @@
+// jsbsim-bench - time the lookup tables and the functions of a JSBSim
+// aircraft.
+//
+//   jsbsim-bench tables <aircraft.xml> [steps]
+//
+// Every table of the aircraft file, and of the files its sections are
+// read from, is evaluated steps times: first with its inputs swept
+// smoothly across and a little beyond their breakpoints, as in flight,
+// then with the inputs set at random, which defeats the search starting
+// from the last breakpoint found.
+//
+//   jsbsim-bench model <aircraft-dir> <aero> [steps]
+//
+// The whole model is loaded as FlightGear does, started at 10000 ft and
+// 250 kts, and flown for steps frames: first with the functions evaluated
+// by their compiled programs, then by walking their trees. Both flights
+// must end at the same place.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <simgear/structure/exception.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "FGJSBBase.h"
+#include "FGFDMExec.h"
+#include "initialization/FGInitialCondition.h"
+#include "input_output/FGXMLParse.h"
+#include "input_output/FGXMLElement.h"
+#include "input_output/FGPropertyManager.h"
+#include "math/FGFunction.h"
+#include "math/FGTable.h"
+
+using std::string;
+using std::vector;
+using namespace JSBSim;
+
+// a table input, and the keys the tables looking it up span
+struct Input {
+  FGPropertyManager* node;
+  double lo, hi;
+};
+
+// the parsers own the documents read
+static vector<FGXMLParse*> sParsers;
+
+static Element* load(string fileName)
+{
+  if (fileName.find(".xml") == string::npos)
+    fileName += ".xml";
+  std::ifstream in(fileName.c_str());
+  if (!in.is_open())
+    return 0;
+
+  FGXMLParse* parser = new FGXMLParse;
+  sParsers.push_back(parser);
+  try {
+    readXML(in, *parser, fileName);
+  } catch (const sg_exception& e) {
+    fprintf(stderr, "jsbsim-bench: %s\n", e.getFormattedMessage().c_str());
+    return 0;
+  }
+  return parser->GetDocument();
+}
+
+static void collectTables(Element* el, vector<Element*>& tables)
+{
+  for (unsigned i = 0; i < el->GetNumElements(); ++i) {
+    Element* child = el->GetElement(i);
+    if (child->GetName() == "table")
+      tables.push_back(child);
+    else
+      collectTables(child, tables);
+  }
+}
+
+// evaluate all tables steps times, return the seconds spent in the lookups
+static double run(const vector<FGTable*>& tables, const vector<Input>& inputs,
+                  int steps, bool random, double& checksum)
+{
+  unsigned seed = 12345;
+  double elapsed = 0.0;
+  checksum = 0.0;
+
+  for (int s = 0; s < steps; ++s) {
+    for (unsigned i = 0; i < inputs.size(); ++i) {
+      const Input& input = inputs[i];
+      double center = 0.5 * (input.lo + input.hi);
+      double amplitude = 0.55 * (input.hi - input.lo);
+      double x;
+      if (random) {
+        seed = seed * 1103515245 + 12345;
+        x = 2.0 * (seed >> 8) / 16777216.0 - 1.0;
+      } else {
+        x = -cos(2.0 * M_PI * s * (1 + i % 7) / steps);
+      }
+      input.node->setDoubleValue(center + amplitude * x);
+    }
+
+    SGTimeStamp st;
+    st.stamp();
+    for (unsigned t = 0; t < tables.size(); ++t)
+      checksum += tables[t]->GetValue();
+    elapsed += (SGTimeStamp::now() - st).toSecs();
+  }
+  return elapsed;
+}
+
+static int benchTables(const string& aircraftFile, int steps)
+{
+  Element* document = load(aircraftFile);
+  if (!document) {
+    fprintf(stderr, "jsbsim-bench: cannot read %s\n", aircraftFile.c_str());
+    return EXIT_FAILURE;
+  }
+  string::size_type slash = aircraftFile.find_last_of('/');
+  string dir = slash == string::npos ? "." : aircraftFile.substr(0, slash);
+
+  vector<Element*> tableElements;
+  collectTables(document, tableElements);
+  for (unsigned i = 0; i < document->GetNumElements(); ++i) {
+    string file = document->GetElement(i)->GetAttributeValue("file");
+    if (file.empty())
+      continue;
+    Element* section = load(dir + "/" + file);
+    if (!section)
+      section = load(dir + "/Systems/" + file);
+    if (section)
+      collectTables(section, tableElements);
+    else
+      fprintf(stderr, "jsbsim-bench: cannot read %s, skipped\n", file.c_str());
+  }
+
+  FGPropertyManager* root = new FGPropertyManager;
+  vector<FGTable*> tables;
+  std::map<FGPropertyManager*, Input> inputs;
+  for (unsigned i = 0; i < tableElements.size(); ++i) {
+    Element* el = tableElements[i];
+    // internal tables are not looked up through properties
+    if (!el->GetAttributeValue("type").empty())
+      continue;
+
+    vector<FGPropertyManager*> nodes;
+    vector<unsigned> axes;
+    Element* var = el->FindElement("independentVar");
+    for (; var; var = el->FindNextElement("independentVar")) {
+      string lookup = var->GetAttributeValue("lookup");
+      nodes.push_back(root->GetNode(var->GetDataLine(), true));
+      axes.push_back(lookup == "column" ? 1 : (lookup == "table" ? 2 : 0));
+    }
+    if (nodes.empty())
+      continue;
+
+    FGTable* table;
+    try {
+      table = new FGTable(root, el);
+    } catch (const string& msg) {
+      fprintf(stderr, "jsbsim-bench: table skipped: %s\n", msg.c_str());
+      continue;
+    } catch (const char* msg) {
+      fprintf(stderr, "jsbsim-bench: table skipped: %s\n", msg);
+      continue;
+    }
+    tables.push_back(table);
+
+    for (unsigned j = 0; j < nodes.size(); ++j) {
+      double lo, hi;
+      if (!table->GetKeyRange(axes[j], lo, hi))
+        continue;
+      std::map<FGPropertyManager*, Input>::iterator it = inputs.find(nodes[j]);
+      if (it == inputs.end()) {
+        Input input = { nodes[j], lo, hi };
+        inputs[nodes[j]] = input;
+      } else {
+        it->second.lo = std::min(it->second.lo, lo);
+        it->second.hi = std::max(it->second.hi, hi);
+      }
+    }
+  }
+
+  if (tables.empty()) {
+    fprintf(stderr, "jsbsim-bench: no tables in %s\n", aircraftFile.c_str());
+    return EXIT_FAILURE;
+  }
+
+  vector<Input> sweep;
+  std::map<FGPropertyManager*, Input>::iterator it;
+  for (it = inputs.begin(); it != inputs.end(); ++it)
+    sweep.push_back(it->second);
+
+  printf("%u tables looking up %u properties, %d steps\n",
+         (unsigned)tables.size(), (unsigned)sweep.size(), steps);
+  double lookups = (double)steps * tables.size();
+  for (int pass = 0; pass < 2; ++pass) {
+    double checksum;
+    double secs = run(tables, sweep, steps, pass == 1, checksum);
+    printf("%s inputs: %.1f ns per lookup (checksum %.10g)\n",
+           pass == 0 ? "swept" : "random", 1e9 * secs / lookups, checksum);
+  }
+
+  for (unsigned i = 0; i < tables.size(); ++i)
+    delete tables[i];
+  for (unsigned i = 0; i < sParsers.size(); ++i)
+    delete sParsers[i];
+  return EXIT_SUCCESS;
+}
+
+static int benchModel(const string& dir, const string& aero, int steps)
+{
+  bool compiled = FGFunction::GetCompiled();
+  double elapsed[2], speed[2], altitude[2];
+
+  for (int pass = 0; pass < 2; ++pass) {
+    FGFunction::SetCompiled(pass == 0);
+    FGFDMExec* fdm = new FGFDMExec;
+    if (!fdm->LoadModel(dir, dir + "/Engines", dir + "/Systems", aero, false)) {
+      fprintf(stderr, "jsbsim-bench: cannot load %s from %s\n",
+              aero.c_str(), dir.c_str());
+      delete fdm;
+      FGFunction::SetCompiled(compiled);
+      return EXIT_FAILURE;
+    }
+
+    fdm->GetIC()->SetAltitudeASLFtIC(10000.0);
+    fdm->GetIC()->SetVcalibratedKtsIC(250.0);
+    fdm->Setdt(1.0 / 120.0);
+    fdm->RunIC();
+
+    SGTimeStamp st;
+    st.stamp();
+    for (int s = 0; s < steps; ++s)
+      fdm->Run();
+    elapsed[pass] = (SGTimeStamp::now() - st).toSecs();
+    speed[pass] = fdm->GetPropertyValue("velocities/vt-fps");
+    altitude[pass] = fdm->GetPropertyValue("position/h-sl-ft");
+    delete fdm;
+  }
+  FGFunction::SetCompiled(compiled);
+
+  printf("%s, %d steps\n", aero.c_str(), steps);
+  for (int pass = 0; pass < 2; ++pass) {
+    printf("%s functions: %.1f us per step (ends at %.10g ft, %.10g ft/s)\n",
+           pass == 0 ? "compiled" : "tree", 1e6 * elapsed[pass] / steps,
+           altitude[pass], speed[pass]);
+  }
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+  string mode = argc > 1 ? argv[1] : "";
+  int args = mode == "model" ? 4 : 3;
+  if ((mode != "tables" && mode != "model") || argc < args) {
+    fprintf(stderr, "Usage: jsbsim-bench tables <aircraft.xml> [steps]\n"
+                    "       jsbsim-bench model <aircraft-dir> <aero> [steps]\n");
+    return EXIT_FAILURE;
+  }
+
+  int steps = argc > args ? atoi(argv[args]) : 10000;
+  if (steps < 1) {
+    fprintf(stderr, "jsbsim-bench: need at least one step\n");
+    return EXIT_FAILURE;
+  }
+  FGJSBBase::debug_lvl = 0;
+
+  if (mode == "model")
+    return benchModel(argv[2], argv[3], steps);
+  return benchTables(argv[2], steps);
+}
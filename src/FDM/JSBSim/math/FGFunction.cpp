@@ -33,6 +33,7 @@ INCLUDES
 #include <cstdlib>
 #include <cmath>
 #include "FGFunction.h"
+#include "FGFunctionProgram.h"
 #include "FGTable.h"
 #include "FGPropertyValue.h"
 #include "FGRealValue.h"
@@ -102,6 +103,8 @@ const std::string FGFunction::not_string = "not";
 const std::string FGFunction::ifthen_string = "ifthen";
 const std::string FGFunction::switch_string = "switch";
 
+bool FGFunction::useProgram = true;
+
 FGFunction::FGFunction(FGPropertyManager* propMan, Element* el, const string& prefix)
                                       : PropertyManager(propMan), Prefix(prefix)
 {
@@ -109,6 +112,7 @@ FGFunction::FGFunction(FGPropertyManager* propMan, Element* el, const string& pr
   string operation, property_name;
   cached = false;
   cachedValue = -HUGE_VAL;
+  Program = 0;
   invlog2val = 1.0/log10(2.0);
 
   Name = el->GetAttributeValue("name");
@@ -290,6 +294,14 @@ FGFunction::FGFunction(FGPropertyManager* propMan, Element* el, const string& pr
 
   bind(); // Allow any function to save its value
 
+  if (Type == eTopLevel) {
+    Program = new FGFunctionProgram;
+    if (Program->Add(this) < 0) {
+      delete Program;
+      Program = 0;
+    }
+  }
+
   Debug(0);
 }
 
@@ -297,6 +309,7 @@ FGFunction::FGFunction(FGPropertyManager* propMan, Element* el, const string& pr
 
 FGFunction::~FGFunction(void)
 {
+  delete Program;
   for (unsigned int i=0; i<Parameters.size(); i++) delete Parameters[i];
 }
 
@@ -327,13 +340,25 @@ unsigned int FGFunction::GetBinary(double val) const
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 double FGFunction::GetValue(void) const
+{
+  if (cached) return cachedValue;
+
+  if (Program && useProgram) {
+    Program->Run();
+    return Program->GetResult(0);
+  }
+
+  return Evaluate();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+double FGFunction::Evaluate(void) const
 {
   unsigned int i;
   double scratch;
   double temp=0;
 
-  if (cached) return cachedValue;
-
   temp = Parameters[0]->GetValue();
   
   switch (Type) {
@@ -52,6 +52,7 @@ namespace JSBSim {
 
 class FGPropertyManager;
 class Element;
+class FGFunctionProgram;
 
 /*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 CLASS DOCUMENTATION
@@ -203,8 +204,18 @@ public:
     @param shouldCache specifies whether the function should cache the computed value. */
   void cacheValue(bool shouldCache);
 
+/** Specifies whether top level functions are evaluated by their compiled
+    program, which is the default, or by walking their tree.
+    @param compiled false to walk the trees, to compare both. */
+  static void SetCompiled(bool compiled) {useProgram = compiled;}
+  static bool GetCompiled(void) {return useProgram;}
+
 private:
+  friend class FGFunctionProgram;
+
   std::vector <FGParameter*> Parameters;
+  FGFunctionProgram* Program;
+  static bool useProgram;
   FGPropertyManager* const PropertyManager;
   bool cached;
   double invlog2val;
@@ -268,6 +279,7 @@ private:
   std::string Name;
 
   unsigned int GetBinary(double) const;
+  double Evaluate(void) const;
   void bind(void);
   void Debug(int from);
 };
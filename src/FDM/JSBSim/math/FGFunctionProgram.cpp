@@ -0,0 +1,408 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       FGFunctionProgram.cpp
+ Purpose:      Evaluates compiled functions
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+FUNCTIONAL DESCRIPTION
+--------------------------------------------------------------------------------
+The functions are first turned into a graph of operations, in which an
+operation on the same operands is only found once. The program is made from
+the graph on the first run: an operation used more than once is evaluated the
+first time it is needed and stored, later uses load it.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <sstream>
+#include <cmath>
+#include "FGFunctionProgram.h"
+#include "FGFunction.h"
+#include "FGPropertyValue.h"
+#include "FGRealValue.h"
+#include "input_output/FGPropertyManager.h"
+
+using namespace std;
+
+namespace JSBSim {
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+FGFunctionProgram::FGFunctionProgram(void) : Compiled(false)
+{
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGFunctionProgram::GetArity(opcode op)
+{
+  switch (op) {
+  case eConstant: case eProperty: case eParameter: case eLoad:
+    return 0;
+  case eAdd: case eSubtract: case eMultiply: case eDivide: case eQuotient:
+  case ePow: case eATan2: case eMod: case eMin: case eMax:
+  case eLT: case eLE: case eGT: case eGE: case eEQ: case eNE:
+    return 2;
+  default:
+    return 1;
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// The operations are those of FGFunction::GetValue(), done the same way. sp
+// points past the topmost value; the new stack pointer is returned.
+
+inline double* FGFunctionProgram::Execute(const Instruction& i, double* sp,
+                                          double* temporaries, double* results)
+{
+  double scratch;
+
+  switch (i.op) {
+  case eConstant:  *sp++ = i.value; break;
+  case eProperty:  *sp++ = i.node->getDoubleValue(); break;
+  case eParameter: *sp++ = i.parameter->GetValue(); break;
+  case eLoad:      *sp++ = temporaries[i.slot]; break;
+  case eStore:     temporaries[i.slot] = sp[-1]; break;
+  case eResult:    results[i.slot] = *--sp; break;
+
+  case eAdd:      --sp; sp[-1] += sp[0]; break;
+  case eSubtract: --sp; sp[-1] -= sp[0]; break;
+  case eMultiply: --sp; sp[-1] *= sp[0]; break;
+  case eDivide:   --sp; sp[-1] /= sp[0]; break;
+  case eQuotient:
+    --sp;
+    if (sp[0] != 0.0) sp[-1] /= sp[0];
+    else sp[-1] = HUGE_VAL;
+    break;
+  case ePow:   --sp; sp[-1] = pow(sp[-1], sp[0]); break;
+  case eATan2: --sp; sp[-1] = atan2(sp[-1], sp[0]); break;
+  case eMod:   --sp; sp[-1] = ((int)sp[-1]) % ((int)sp[0]); break;
+  case eMin:   --sp; if (sp[0] < sp[-1]) sp[-1] = sp[0]; break;
+  case eMax:   --sp; if (sp[0] > sp[-1]) sp[-1] = sp[0]; break;
+  case eLT:    --sp; sp[-1] = (sp[-1] < sp[0])?1:0; break;
+  case eLE:    --sp; sp[-1] = (sp[-1] <= sp[0])?1:0; break;
+  case eGT:    --sp; sp[-1] = (sp[-1] > sp[0])?1:0; break;
+  case eGE:    --sp; sp[-1] = (sp[-1] >= sp[0])?1:0; break;
+  case eEQ:    --sp; sp[-1] = (sp[-1] == sp[0])?1:0; break;
+  case eNE:    --sp; sp[-1] = (sp[-1] != sp[0])?1:0; break;
+
+  case eExp: sp[-1] = exp(sp[-1]); break;
+  case eLog2:
+    if (sp[-1] > 0.00) sp[-1] = log10(sp[-1])*i.value;
+    else sp[-1] = -HUGE_VAL;
+    break;
+  case eLn:
+    if (sp[-1] > 0.00) sp[-1] = log(sp[-1]);
+    else sp[-1] = -HUGE_VAL;
+    break;
+  case eLog10:
+    if (sp[-1] > 0.00) sp[-1] = log10(sp[-1]);
+    else sp[-1] = -HUGE_VAL;
+    break;
+  case eAbs:  sp[-1] = fabs(sp[-1]); break;
+  case eSign: sp[-1] = sp[-1] < 0 ? -1:1; break;
+  case eSin:  sp[-1] = sin(sp[-1]); break;
+  case eCos:  sp[-1] = cos(sp[-1]); break;
+  case eTan:  sp[-1] = tan(sp[-1]); break;
+  case eASin: sp[-1] = asin(sp[-1]); break;
+  case eACos: sp[-1] = acos(sp[-1]); break;
+  case eATan: sp[-1] = atan(sp[-1]); break;
+  case eFrac: sp[-1] = modf(sp[-1], &scratch); break;
+  case eInteger:
+    modf(sp[-1], &scratch);
+    sp[-1] = scratch;
+    break;
+  }
+  return sp;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGFunctionProgram::AddNode(const Instruction& instruction,
+                                        const vector<unsigned int>& args)
+{
+  ostringstream key;
+  key << instruction.op;
+  if (instruction.op == eProperty)
+    key << ':' << instruction.node;
+  else if (instruction.op == eParameter)
+    key << ':' << instruction.parameter;
+  for (unsigned int i=0; i<args.size(); i++) key << ',' << args[i];
+
+  map<string, unsigned int>::iterator it = NodeIndex.find(key.str());
+  if (it != NodeIndex.end()) return it->second;
+
+  Node node;
+  node.instruction = instruction;
+  node.args = args;
+  node.uses = 0;
+  node.slot = -1;
+  for (unsigned int i=0; i<args.size(); i++) Nodes[args[i]].uses++;
+
+  Nodes.push_back(node);
+  NodeIndex[key.str()] = Nodes.size() - 1;
+  return Nodes.size() - 1;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Constants are not shared: loading one costs no more than loading a stored
+// value.
+
+unsigned int FGFunctionProgram::AddConstant(double value)
+{
+  Node node;
+  Instruction i = {eConstant, value, 0, 0, 0};
+  node.instruction = i;
+  node.uses = 0;
+  node.slot = -1;
+  Nodes.push_back(node);
+  return Nodes.size() - 1;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGFunctionProgram::AddOperation(opcode op,
+                                             const vector<unsigned int>& args)
+{
+  Instruction i = {op, op == eLog2 ? 1.0/log10(2.0) : 0.0, 0, 0, 0};
+
+  bool fold = true;
+  for (unsigned int k=0; fold && k<args.size(); k++)
+    fold = Nodes[args[k]].instruction.op == eConstant;
+  // an integer division by zero is left to happen where the tree would have
+  if (fold && op == eMod && (int)Nodes[args[1]].instruction.value == 0)
+    fold = false;
+
+  if (!fold) return AddNode(i, args);
+
+  double stack[2];
+  for (unsigned int k=0; k<args.size(); k++)
+    stack[k] = Nodes[args[k]].instruction.value;
+  Execute(i, stack + args.size(), 0, 0);
+  return AddConstant(stack[0]);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Applies a binary operation to the arguments from left to right, as the
+// tree does.
+
+unsigned int FGFunctionProgram::AddFold(opcode op,
+                                        const vector<unsigned int>& args)
+{
+  unsigned int result = args[0];
+  vector<unsigned int> operands(2);
+
+  for (unsigned int k=1; k<args.size(); k++) {
+    operands[0] = result;
+    operands[1] = args[k];
+    result = AddOperation(op, operands);
+  }
+  return result;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGFunctionProgram::AddParameter(const FGParameter* parameter)
+{
+  const FGRealValue* real = dynamic_cast<const FGRealValue*>(parameter);
+  if (real) return AddConstant(real->GetValue());
+
+  const FGPropertyValue* property = dynamic_cast<const FGPropertyValue*>(parameter);
+  if (property && property->GetNode()) {
+    Instruction i = {eProperty, 0.0, property->GetNode(), 0, 0};
+    return AddNode(i, vector<unsigned int>());
+  }
+
+  const FGFunction* function = dynamic_cast<const FGFunction*>(parameter);
+  if (function) return AddFunction(function);
+
+  // tables, and properties that did not exist when the function was loaded
+  Instruction i = {eParameter, 0.0, 0, parameter, 0};
+  return AddNode(i, vector<unsigned int>());
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGFunctionProgram::AddFunction(const FGFunction* function)
+{
+  const vector<FGParameter*>& parameters = function->Parameters;
+  unsigned int n = parameters.size();
+  opcode op;
+
+  switch (function->Type) {
+  case FGFunction::eTopLevel:   return AddParameter(parameters[0]);
+  case FGFunction::eProduct:    op = eMultiply; break;
+  case FGFunction::eDifference: op = eSubtract; break;
+  case FGFunction::eSum:        op = eAdd; break;
+  case FGFunction::eAvg:        op = eAdd; break;
+  case FGFunction::eMin:        op = eMin; break;
+  case FGFunction::eMax:        op = eMax; break;
+  case FGFunction::eQuotient:   op = eQuotient; break;
+  case FGFunction::ePow:        op = ePow; break;
+  case FGFunction::eATan2:      op = eATan2; break;
+  case FGFunction::eMod:        op = eMod; break;
+  case FGFunction::eLT:         op = eLT; break;
+  case FGFunction::eLE:         op = eLE; break;
+  case FGFunction::eGT:         op = eGT; break;
+  case FGFunction::eGE:         op = eGE; break;
+  case FGFunction::eEQ:         op = eEQ; break;
+  case FGFunction::eNE:         op = eNE; break;
+  case FGFunction::eExp:        op = eExp; break;
+  case FGFunction::eLog2:       op = eLog2; break;
+  case FGFunction::eLn:         op = eLn; break;
+  case FGFunction::eLog10:      op = eLog10; break;
+  case FGFunction::eAbs:        op = eAbs; break;
+  case FGFunction::eSign:       op = eSign; break;
+  case FGFunction::eSin:        op = eSin; break;
+  case FGFunction::eCos:        op = eCos; break;
+  case FGFunction::eTan:        op = eTan; break;
+  case FGFunction::eASin:       op = eASin; break;
+  case FGFunction::eACos:       op = eACos; break;
+  case FGFunction::eATan:       op = eATan; break;
+  case FGFunction::eFrac:       op = eFrac; break;
+  case FGFunction::eInteger:    op = eInteger; break;
+  default:
+    // random numbers, conditions and rotations are left to the tree
+    {
+      Instruction i = {eParameter, 0.0, 0, function, 0};
+      return AddNode(i, vector<unsigned int>());
+    }
+  }
+
+  // the tree would read past its arguments: let it
+  unsigned int arity = GetArity(op);
+  if (n < arity) {
+    Instruction i = {eParameter, 0.0, 0, function, 0};
+    return AddNode(i, vector<unsigned int>());
+  }
+
+  vector<unsigned int> args;
+  switch (function->Type) {
+  case FGFunction::eProduct: case FGFunction::eDifference:
+  case FGFunction::eSum: case FGFunction::eAvg:
+  case FGFunction::eMin: case FGFunction::eMax:
+    for (unsigned int k=0; k<n; k++) args.push_back(AddParameter(parameters[k]));
+    break;
+  default:
+    // only the arguments the operation reads are evaluated
+    for (unsigned int k=0; k<arity; k++) args.push_back(AddParameter(parameters[k]));
+    return AddOperation(op, args);
+  }
+
+  unsigned int result = AddFold(op, args);
+  if (function->Type == FGFunction::eAvg) {
+    vector<unsigned int> operands(2);
+    operands[0] = result;
+    operands[1] = AddConstant(n);
+    result = AddOperation(eDivide, operands);
+  }
+  return result;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+int FGFunctionProgram::Add(const FGFunction* function)
+{
+  if (function->Type != FGFunction::eTopLevel || function->Parameters.empty())
+    return -1;
+
+  unsigned int root = AddFunction(function);
+  Nodes[root].uses++;
+  Roots.push_back(root);
+  Compiled = false;
+  return Roots.size() - 1;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGFunctionProgram::Emit(const Instruction& instruction, unsigned int& depth,
+                             unsigned int& maxDepth)
+{
+  Code.push_back(instruction);
+  depth = depth + (instruction.op == eResult ? 0 : 1) - GetArity(instruction.op);
+  if (depth > maxDepth) maxDepth = depth;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGFunctionProgram::Emit(unsigned int n, unsigned int& depth,
+                             unsigned int& maxDepth)
+{
+  Node& node = Nodes[n];
+
+  if (node.slot >= 0) {
+    Instruction load = {eLoad, 0.0, 0, 0, (unsigned int)node.slot};
+    Emit(load, depth, maxDepth);
+    return;
+  }
+
+  for (unsigned int k=0; k<node.args.size(); k++)
+    Emit(node.args[k], depth, maxDepth);
+  Emit(node.instruction, depth, maxDepth);
+
+  if (node.uses > 1 && node.instruction.op != eConstant) {
+    node.slot = Temporaries.size();
+    Temporaries.push_back(0.0);
+    Instruction store = {eStore, 0.0, 0, 0, (unsigned int)node.slot};
+    Emit(store, depth, maxDepth);
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGFunctionProgram::Compile(void)
+{
+  unsigned int depth = 0, maxDepth = 0;
+
+  Code.clear();
+  Temporaries.clear();
+  for (unsigned int n=0; n<Nodes.size(); n++) Nodes[n].slot = -1;
+
+  for (unsigned int r=0; r<Roots.size(); r++) {
+    Emit(Roots[r], depth, maxDepth);
+    Instruction result = {eResult, 0.0, 0, 0, r};
+    Emit(result, depth, maxDepth);
+  }
+
+  Stack.resize(maxDepth > 0 ? maxDepth : 1);
+  if (Temporaries.empty()) Temporaries.push_back(0.0);
+  Results.resize(Roots.size());
+  Compiled = true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGFunctionProgram::Run(void)
+{
+  if (!Compiled) Compile();
+
+  double* sp = &Stack[0];
+  double* temporaries = &Temporaries[0];
+  double* results = &Results[0];
+  const Instruction* code = &Code[0];
+  const Instruction* end = code + Code.size();
+
+  for (; code != end; ++code)
+    sp = Execute(*code, sp, temporaries, results);
+}
+
+} // namespace JSBSim
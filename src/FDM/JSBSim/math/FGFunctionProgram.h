@@ -0,0 +1,138 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGFunctionProgram.h
+ Purpose:      Evaluates compiled functions
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGFUNCTIONPROGRAM_H
+#define FGFUNCTIONPROGRAM_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <map>
+#include <string>
+#include <vector>
+#include "FGJSBBase.h"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+FORWARD DECLARATIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class SGPropertyNode;
+
+namespace JSBSim {
+
+class FGFunction;
+class FGParameter;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Evaluates a group of functions as one flat program.
+    The function trees are compiled when they are added. Properties are read
+    straight from their nodes, operations on constants are done once, when
+    compiling, and an operation found more than once, on the same operands,
+    in any of the functions of the program is only evaluated once per run.
+    The results are the same as those of the trees, computed in the same
+    order.
+
+    Tables, conditions, random numbers and the rotation operations are left
+    to the tree, which the program calls.
+*/
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGFunctionProgram : public FGJSBBase
+{
+public:
+  FGFunctionProgram(void);
+  ~FGFunctionProgram() {}
+
+  /** Compiles a top level function into the program.
+      @return the index of its result, or -1 if it cannot be compiled. */
+  int Add(const FGFunction* function);
+
+  /// Evaluates all the functions added.
+  void Run(void);
+
+  double GetResult(unsigned int i) const {return Results[i];}
+  unsigned int GetNumInstructions(void) const {return Code.size();}
+
+private:
+  enum opcode {eConstant, eProperty, eParameter, eLoad, eStore, eResult,
+               eAdd, eSubtract, eMultiply, eDivide, eQuotient, ePow, eATan2,
+               eMod, eMin, eMax, eLT, eLE, eGT, eGE, eEQ, eNE,
+               eExp, eLog2, eLn, eLog10, eAbs, eSign, eSin, eCos, eTan,
+               eASin, eACos, eATan, eFrac, eInteger};
+
+  struct Instruction {
+    opcode op;
+    double value;
+    const SGPropertyNode* node;
+    const FGParameter* parameter;
+    unsigned int slot;
+  };
+
+  // an operation of the functions, each found once
+  struct Node {
+    Instruction instruction;
+    std::vector<unsigned int> args;
+    unsigned int uses;
+    int slot;
+  };
+
+  std::vector<Node> Nodes;
+  std::map<std::string, unsigned int> NodeIndex;
+  std::vector<unsigned int> Roots;
+  bool Compiled;
+
+  std::vector<Instruction> Code;
+  std::vector<double> Stack;
+  std::vector<double> Temporaries;
+  std::vector<double> Results;
+
+  static unsigned int GetArity(opcode op);
+  static double* Execute(const Instruction& i, double* sp, double* temporaries,
+                         double* results);
+
+  unsigned int AddNode(const Instruction& instruction,
+                       const std::vector<unsigned int>& args);
+  unsigned int AddConstant(double value);
+  unsigned int AddOperation(opcode op, const std::vector<unsigned int>& args);
+  unsigned int AddFold(opcode op, const std::vector<unsigned int>& args);
+  unsigned int AddParameter(const FGParameter* parameter);
+  unsigned int AddFunction(const FGFunction* function);
+  void Compile(void);
+  void Emit(unsigned int n, unsigned int& depth, unsigned int& maxDepth);
+  void Emit(const Instruction& instruction, unsigned int& depth,
+            unsigned int& maxDepth);
+};
+
+} // namespace JSBSim
+
+#endif
@@ -72,6 +72,7 @@ public:
 
   double GetValue(void) const;
   void SetNode(FGPropertyManager* node) {PropertyNode = node;} 
+  FGPropertyManager* GetNode(void) const {return PropertyNode;}
 
   std::string GetName(void) const;
 
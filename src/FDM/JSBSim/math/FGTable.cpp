@@ -61,7 +61,7 @@ FGTable::FGTable(int NRows) : nRows(NRows), nCols(1), PropertyManager(0)
   rowCounter = 1;
   nTables = 0;
 
-  Data = Allocate();
+  Allocate();
   Debug(0);
   lastRowIndex=lastColumnIndex=2;
 }
@@ -75,7 +75,7 @@ FGTable::FGTable(int NRows, int NCols) : nRows(NRows), nCols(NCols), PropertyMan
   rowCounter = 0;
   nTables = 0;
 
-  Data = Allocate();
+  Allocate();
   Debug(0);
   lastRowIndex=lastColumnIndex=2;
 }
@@ -99,12 +99,7 @@ FGTable::FGTable(const FGTable& t) : PropertyManager(t.PropertyManager)
   lookupProperty[2] = t.lookupProperty[2];
 
   Tables = t.Tables;
-  Data = Allocate();
-  for (unsigned int r=0; r<=nRows; r++) {
-    for (unsigned int c=0; c<=nCols; c++) {
-      Data[r][c] = t.Data[r][c];
-    }
-  }
+  Data = t.Data;
   lastRowIndex = t.lastRowIndex;
   lastColumnIndex = t.lastColumnIndex;
   lastTableIndex = t.lastTableIndex;
@@ -239,7 +234,7 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
     Type = tt1D;
     colCounter = 0;
     rowCounter = 1;
-    Data = Allocate();
+    Allocate();
     Debug(0);
     lastRowIndex = lastColumnIndex = 2;
     *this << buf;
@@ -258,7 +253,7 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
     colCounter = 1;
     rowCounter = 0;
 
-    Data = Allocate();
+    Allocate();
     lastRowIndex = lastColumnIndex = 2;
     *this << buf;
     break;
@@ -271,12 +266,12 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
     rowCounter = 1;
     lastRowIndex = lastColumnIndex = 2;
 
-    Data = Allocate(); // this data array will contain the keys for the associated tables
+    Allocate(); // this data array will contain the keys for the associated tables
     Tables.reserve(nTables); // necessary?
     tableData = el->FindElement("tableData");
     for (i=0; i<nTables; i++) {
       Tables.push_back(new FGTable(PropertyManager, tableData));
-      Data[i+1][1] = tableData->GetAttributeValueAsNumber("breakPoint");
+      Row(i+1)[1] = tableData->GetAttributeValueAsNumber("breakPoint");
       Tables[i]->SetRowIndexProperty(lookupProperty[eRow]);
       Tables[i]->SetColumnIndexProperty(lookupProperty[eColumn]);
       tableData = el->FindNextElement("tableData");
@@ -301,14 +296,14 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
   // check breakpoints, if applicable
   if (dimension > 2) {
     for (b=2; b<=nTables; ++b) {
-      if (Data[b][1] <= Data[b-1][1]) {
+      if (Row(b)[1] <= Row(b-1)[1]) {
         stringstream errormsg;
         errormsg << fgred << highint << endl
              << "  FGTable: breakpoint lookup is not monotonically increasing" << endl
              << "  in breakpoint " << b;
         if (nameel != 0) errormsg << " of table in " << nameel->GetAttributeValue("name");
         errormsg << ":" << reset << endl
-                 << "  " << Data[b][1] << "<=" << Data[b-1][1] << endl;
+                 << "  " << Row(b)[1] << "<=" << Row(b-1)[1] << endl;
         throw(errormsg.str());
       }
     }
@@ -317,14 +312,14 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
   // check columns, if applicable
   if (dimension > 1) {
     for (c=2; c<=nCols; ++c) {
-      if (Data[0][c] <= Data[0][c-1]) {
+      if (Row(0)[c] <= Row(0)[c-1]) {
         stringstream errormsg;
         errormsg << fgred << highint << endl
              << "  FGTable: column lookup is not monotonically increasing" << endl
              << "  in column " << c;
         if (nameel != 0) errormsg << " of table in " << nameel->GetAttributeValue("name");
         errormsg << ":" << reset << endl
-                 << "  " << Data[0][c] << "<=" << Data[0][c-1] << endl;
+                 << "  " << Row(0)[c] << "<=" << Row(0)[c-1] << endl;
         throw(errormsg.str());
       }
     }
@@ -333,14 +328,14 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
   // check rows
   if (dimension < 3) { // in 3D tables, check only rows of subtables
     for (r=2; r<=nRows; ++r) {
-      if (Data[r][0]<=Data[r-1][0]) {
+      if (Row(r)[0]<=Row(r-1)[0]) {
         stringstream errormsg;
         errormsg << fgred << highint << endl
              << "  FGTable: row lookup is not monotonically increasing" << endl
              << "  in row " << r;
         if (nameel != 0) errormsg << " of table in " << nameel->GetAttributeValue("name");
         errormsg << ":" << reset << endl
-                 << "  " << Data[r][0] << "<=" << Data[r-1][0] << endl;
+                 << "  " << Row(r)[0] << "<=" << Row(r-1)[0] << endl;
         throw(errormsg.str());
       }
     }
@@ -353,16 +348,13 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
-double** FGTable::Allocate(void)
+// The keys and values are kept in one block, row after row, each row being
+// the row key followed by the values of the columns. The first row holds
+// the column keys.
+
+void FGTable::Allocate(void)
 {
-  Data = new double*[nRows+1];
-  for (unsigned int r=0; r<=nRows; r++) {
-    Data[r] = new double[nCols+1];
-    for (unsigned int c=0; c<=nCols; c++) {
-      Data[r][c] = 0.0;
-    }
-  }
-  return Data;
+  Data.assign((nRows+1)*(nCols+1), 0.0);
 }
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -373,9 +365,6 @@ FGTable::~FGTable()
     for (unsigned int i=0; i<nTables; i++) delete Tables[i];
     Tables.clear();
   }
-  for (unsigned int r=0; r<=nRows; r++) delete[] Data[r];
-  delete[] Data;
-
   Debug(1);
 }
 
@@ -420,43 +409,82 @@ double FGTable::GetValue(void) const
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+// Finds the breakpoint r, 2 <= r <= n, such that key lies between keys
+// r-1 and r, the i-th key being keys[i*stride]; r is 2 or n for a key off
+// either end. The breakpoint found last time is tried first, since keys
+// mostly change little from one frame to the next; otherwise the
+// breakpoints are bisected, so that a key jumping across a large table
+// costs log(n) comparisons rather than n.
+// A key equal to a breakpoint gets the interval the former linear walk from
+// the last breakpoint stopped at: the one above it when moving down, the
+// one below it when moving up, so that the results are bit for bit the same.
+
+static inline unsigned int FindBreakpoint(const double* keys, unsigned int stride,
+                                          unsigned int n, double key, int& last)
+{
+  unsigned int r = last;
+
+  if (r > 2 && key < keys[(r-1)*stride]) {
+    // first breakpoint above the key
+    unsigned int lo = 2, hi = n;
+    while (lo < hi) {
+      unsigned int mid = (lo + hi) / 2;
+      if (keys[mid*stride] <= key) lo = mid + 1;
+      else hi = mid;
+    }
+    r = lo;
+    last = r;
+  } else if (r < n && key > keys[r*stride]) {
+    // first breakpoint not below the key
+    unsigned int lo = 2, hi = n;
+    while (lo < hi) {
+      unsigned int mid = (lo + hi) / 2;
+      if (keys[mid*stride] < key) lo = mid + 1;
+      else hi = mid;
+    }
+    r = lo;
+    last = r;
+  }
+
+  return r;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
 double FGTable::GetValue(double key) const
 {
   double Factor, Value, Span;
-  unsigned int r = lastRowIndex;
+  const double* lower;
+  const double* upper;
 
   //if the key is off the end of the table, just return the
   //end-of-table value, do not extrapolate
-  if( key <= Data[1][0] ) {
+  if( key <= Row(1)[0] ) {
     lastRowIndex=2;
     //cout << "Key underneath table: " << key << endl;
-    return Data[1][1];
-  } else if ( key >= Data[nRows][0] ) {
+    return Row(1)[1];
+  } else if ( key >= Row(nRows)[0] ) {
     lastRowIndex=nRows;
     //cout << "Key over table: " << key << endl;
-    return Data[nRows][1];
+    return Row(nRows)[1];
   }
 
   // the key is somewhere in the middle, search for the right breakpoint
-  // The search is particularly efficient if 
-  // the correct breakpoint has not changed since last frame or
-  // has only changed very little
+  unsigned int r = FindBreakpoint(Row(0), nCols+1, nRows, key, lastRowIndex);
+  lower = Row(r-1);
+  upper = Row(r);
 
-  while (r > 2     && Data[r-1][0] > key) { r--; }
-  while (r < nRows && Data[r][0]   < key) { r++; }
-
-  lastRowIndex=r;
   // make sure denominator below does not go to zero.
 
-  Span = Data[r][0] - Data[r-1][0];
+  Span = upper[0] - lower[0];
   if (Span != 0.0) {
-    Factor = (key - Data[r-1][0]) / Span;
+    Factor = (key - lower[0]) / Span;
     if (Factor > 1.0) Factor = 1.0;
   } else {
     Factor = 1.0;
   }
 
-  Value = Factor*(Data[r][1] - Data[r-1][1]) + Data[r-1][1];
+  Value = Factor*(upper[1] - lower[1]) + lower[1];
 
   return Value;
 }
@@ -466,20 +494,17 @@ double FGTable::GetValue(double key) const
 double FGTable::GetValue(double rowKey, double colKey) const
 {
   double rFactor, cFactor, col1temp, col2temp, Value;
-  unsigned int r = lastRowIndex;
-  unsigned int c = lastColumnIndex;
-
-  while(r > 2     && Data[r-1][0] > rowKey) { r--; }
-  while(r < nRows && Data[r]  [0] < rowKey) { r++; }
+  const double* keys = Row(0);
 
-  while(c > 2     && Data[0][c-1] > colKey) { c--; }
-  while(c < nCols && Data[0][c]   < colKey) { c++; }
+  unsigned int r = FindBreakpoint(keys, nCols+1, nRows, rowKey, lastRowIndex);
+  unsigned int c = FindBreakpoint(keys, 1, nCols, colKey, lastColumnIndex);
 
-  lastRowIndex=r;
-  lastColumnIndex=c;
+  // the four corners are in two pairs of adjacent values
+  const double* lower = Row(r-1);
+  const double* upper = Row(r);
 
-  rFactor = (rowKey - Data[r-1][0]) / (Data[r][0] - Data[r-1][0]);
-  cFactor = (colKey - Data[0][c-1]) / (Data[0][c] - Data[0][c-1]);
+  rFactor = (rowKey - lower[0]) / (upper[0] - lower[0]);
+  cFactor = (colKey - keys[c-1]) / (keys[c] - keys[c-1]);
 
   if (rFactor > 1.0) rFactor = 1.0;
   else if (rFactor < 0.0) rFactor = 0.0;
@@ -487,8 +512,8 @@ double FGTable::GetValue(double rowKey, double colKey) const
   if (cFactor > 1.0) cFactor = 1.0;
   else if (cFactor < 0.0) cFactor = 0.0;
 
-  col1temp = rFactor*(Data[r][c-1] - Data[r-1][c-1]) + Data[r-1][c-1];
-  col2temp = rFactor*(Data[r][c] - Data[r-1][c]) + Data[r-1][c];
+  col1temp = rFactor*(upper[c-1] - lower[c-1]) + lower[c-1];
+  col2temp = rFactor*(upper[c] - lower[c]) + lower[c];
 
   Value = col1temp + cFactor*(col2temp - col1temp);
 
@@ -499,41 +524,35 @@ double FGTable::GetValue(double rowKey, double colKey) const
 
 double FGTable::GetValue(double rowKey, double colKey, double tableKey) const
 {
-  double Factor, Value, Span;
-  unsigned int r = lastRowIndex;
+  double Factor, Value, Span, lowerValue;
 
   //if the key is off the end  (or before the beginning) of the table,
   // just return the boundary-table value, do not extrapolate
 
-  if( tableKey <= Data[1][1] ) {
+  if( tableKey <= Row(1)[1] ) {
     lastRowIndex=2;
     return Tables[0]->GetValue(rowKey, colKey);
-  } else if ( tableKey >= Data[nRows][1] ) {
+  } else if ( tableKey >= Row(nRows)[1] ) {
     lastRowIndex=nRows;
     return Tables[nRows-1]->GetValue(rowKey, colKey);
   }
 
   // the key is somewhere in the middle, search for the right breakpoint
-  // The search is particularly efficient if 
-  // the correct breakpoint has not changed since last frame or
-  // has only changed very little
-
-  while(r > 2     && Data[r-1][1] > tableKey) { r--; }
-  while(r < nRows && Data[r]  [1] < tableKey) { r++; }
+  unsigned int r = FindBreakpoint(Row(0)+1, nCols+1, nRows, tableKey, lastRowIndex);
 
-  lastRowIndex=r;
   // make sure denominator below does not go to zero.
 
-  Span = Data[r][1] - Data[r-1][1];
+  Span = Row(r)[1] - Row(r-1)[1];
   if (Span != 0.0) {
-    Factor = (tableKey - Data[r-1][1]) / Span;
+    Factor = (tableKey - Row(r-1)[1]) / Span;
     if (Factor > 1.0) Factor = 1.0;
   } else {
     Factor = 1.0;
   }
 
-  Value = Factor*(Tables[r-1]->GetValue(rowKey, colKey) - Tables[r-2]->GetValue(rowKey, colKey))
-                              + Tables[r-2]->GetValue(rowKey, colKey);
+  // each of the two tables is only looked up once
+  lowerValue = Tables[r-2]->GetValue(rowKey, colKey);
+  Value = Factor*(Tables[r-1]->GetValue(rowKey, colKey) - lowerValue) + lowerValue;
 
   return Value;
 }
@@ -551,7 +570,7 @@ void FGTable::operator<<(istream& in_stream)
   for (unsigned int r=startRow; r<=nRows; r++) {
     for (unsigned int c=startCol; c<=nCols; c++) {
       if (r != 0 || c != 0) {
-        in_stream >> Data[r][c];
+        in_stream >> Row(r)[c];
       }
     }
   }
@@ -563,7 +582,7 @@ void FGTable::operator<<(istream& in_stream)
 
 FGTable& FGTable::operator<<(const double n)
 {
-  Data[rowCounter][colCounter] = n;
+  Row(rowCounter)[colCounter] = n;
   if (colCounter == (int)nCols) {
     colCounter = 0;
     rowCounter++;
@@ -617,7 +636,7 @@ void FGTable::Print(void)
       if (r == 0 && c == 0) {
         cout << "	";
       } else {
-        cout << Data[r][c] << "	";
+        cout << Row(r)[c] << "	";
         if (Type == tt3D) {
           cout << endl;
           Tables[r-1]->Print();
@@ -631,6 +650,45 @@ void FGTable::Print(void)
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+bool FGTable::GetKeyRange(unsigned int axis, double& lo, double& hi) const
+{
+  switch (Type) {
+  case tt1D:
+  case tt2D:
+    if (axis == eRow) {
+      lo = Row(1)[0];
+      hi = Row(nRows)[0];
+      return true;
+    } else if (axis == eColumn && Type == tt2D) {
+      lo = Row(0)[1];
+      hi = Row(0)[nCols];
+      return true;
+    }
+    return false;
+  case tt3D:
+    if (axis == eTable) {
+      lo = Row(1)[1];
+      hi = Row(nRows)[1];
+      return true;
+    } else if (axis == eRow || axis == eColumn) {
+      bool found = false;
+      for (unsigned int i=0; i<nTables; i++) {
+        double tableLo, tableHi;
+        if (Tables[i]->GetKeyRange(axis, tableLo, tableHi)) {
+          if (!found || tableLo < lo) lo = tableLo;
+          if (!found || tableHi > hi) hi = tableHi;
+          found = true;
+        }
+      }
+      return found;
+    }
+    return false;
+  }
+  return false;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
 void FGTable::bind(void)
 {
   typedef double (FGTable::*PMF)(void) const;
@@ -284,7 +284,7 @@ public:
   FGTable& operator<<(const double n);
   FGTable& operator<<(const int n);
 
-  inline double GetElement(int r, int c) const {return Data[r][c];}
+  inline double GetElement(int r, int c) const {return Data[r*(nCols+1)+c];}
 //  inline double GetElement(int r, int c, int t);
 
   double operator()(unsigned int r, unsigned int c) const {return GetElement(r, c);}
@@ -295,6 +295,11 @@ public:
 
   unsigned int GetNumRows() const {return nRows;}
 
+  /** Gets the smallest and largest keys along an axis of the table: 0 for
+      the rows, 1 for the columns and 2 for the tables of a 3D table.
+      @return false if the table has no such axis.*/
+  bool GetKeyRange(unsigned int axis, double& lo, double& hi) const;
+
   void Print(void);
 
   std::string GetName(void) const {return Name;}
@@ -304,12 +309,14 @@ private:
   enum axis {eRow=0, eColumn, eTable};
   bool internal;
   FGPropertyManager *lookupProperty[3];
-  double** Data;
+  std::vector <double> Data;
   std::vector <FGTable*> Tables;
   unsigned int nRows, nCols, nTables, dimension;
   int colCounter, rowCounter, tableCounter;
   mutable int lastRowIndex, lastColumnIndex, lastTableIndex;
-  double** Allocate(void);
+  void Allocate(void);
+  double* Row(unsigned int r) {return &Data[r*(nCols+1)];}
+  const double* Row(unsigned int r) const {return &Data[r*(nCols+1)];}
   FGPropertyManager* const PropertyManager;
   std::string Name;
   void bind(void);
@@ -77,6 +77,7 @@ FGAerodynamics::FGAerodynamics(FGFDMExec* FDMExec) : FGModel(FDMExec)
   axisType = atNone;
 
   AeroFunctions = new AeroFunctionArray[6];
+  ForceProgram = MomentProgram = 0;
 
   impending_stall = stall_hyst = 0.0;
   alphaclmin = alphaclmax = 0.0;
@@ -102,6 +103,8 @@ FGAerodynamics::~FGAerodynamics()
     for (j=0; j<AeroFunctions[i].size(); j++)
       delete AeroFunctions[i][j];
 
+  delete ForceProgram;
+  delete MomentProgram;
   delete[] AeroFunctions;
 
   delete AeroRPShift;
@@ -167,9 +170,19 @@ bool FGAerodynamics::Run(bool Holding)
   vFw.InitMatrix();
   vFnative.InitMatrix();
 
-  for (axis_ctr = 0; axis_ctr < 3; axis_ctr++) {
-    for (ctr=0; ctr < AeroFunctions[axis_ctr].size(); ctr++) {
-      vFnative(axis_ctr+1) += AeroFunctions[axis_ctr][ctr]->GetValue();
+  if (ForceProgram && FGFunction::GetCompiled()) {
+    ForceProgram->Run();
+    unsigned int result = 0;
+    for (axis_ctr = 0; axis_ctr < 3; axis_ctr++) {
+      for (ctr=0; ctr < AeroFunctions[axis_ctr].size(); ctr++) {
+        vFnative(axis_ctr+1) += ForceProgram->GetResult(result++);
+      }
+    }
+  } else {
+    for (axis_ctr = 0; axis_ctr < 3; axis_ctr++) {
+      for (ctr=0; ctr < AeroFunctions[axis_ctr].size(); ctr++) {
+        vFnative(axis_ctr+1) += AeroFunctions[axis_ctr][ctr]->GetValue();
+      }
     }
   }
 
@@ -220,9 +233,19 @@ bool FGAerodynamics::Run(bool Holding)
 
   vMoments = vDXYZcg*vForces; // M = r X F
 
-  for (axis_ctr = 0; axis_ctr < 3; axis_ctr++) {
-    for (ctr = 0; ctr < AeroFunctions[axis_ctr+3].size(); ctr++) {
-      vMoments(axis_ctr+1) += AeroFunctions[axis_ctr+3][ctr]->GetValue();
+  if (MomentProgram && FGFunction::GetCompiled()) {
+    MomentProgram->Run();
+    unsigned int result = 0;
+    for (axis_ctr = 0; axis_ctr < 3; axis_ctr++) {
+      for (ctr = 0; ctr < AeroFunctions[axis_ctr+3].size(); ctr++) {
+        vMoments(axis_ctr+1) += MomentProgram->GetResult(result++);
+      }
+    }
+  } else {
+    for (axis_ctr = 0; axis_ctr < 3; axis_ctr++) {
+      for (ctr = 0; ctr < AeroFunctions[axis_ctr+3].size(); ctr++) {
+        vMoments(axis_ctr+1) += AeroFunctions[axis_ctr+3][ctr]->GetValue();
+      }
     }
   }
 
@@ -296,11 +319,39 @@ bool FGAerodynamics::Load(Element *element)
     axis_element = document->FindNextElement("axis");
   }
 
+  // The forces are used in the moments, so that these two groups of
+  // functions must be evaluated apart.
+  delete ForceProgram;
+  delete MomentProgram;
+  ForceProgram = CompileAxes(0);
+  MomentProgram = CompileAxes(3);
+
   PostLoad(document, PropertyManager); // Perform base class Post-Load
 
   return true;
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Compiles the functions of three axes, from the first one given, into one
+// program, so that what they have in common is only evaluated once. The
+// results are in the order of the axes and of the functions in each.
+
+FGFunctionProgram* FGAerodynamics::CompileAxes(unsigned int first) const
+{
+  FGFunctionProgram* program = new FGFunctionProgram;
+
+  for (unsigned int axis = first; axis < first+3; axis++) {
+    for (unsigned int ctr = 0; ctr < AeroFunctions[axis].size(); ctr++) {
+      if (program->Add(AeroFunctions[axis][ctr]) < 0) {
+        delete program;
+        return 0;
+      }
+    }
+  }
+  return program;
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 //
 // This private class function checks to verify consistency in the choice of
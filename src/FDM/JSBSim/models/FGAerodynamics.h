@@ -44,6 +44,7 @@ INCLUDES
 
 #include "FGModel.h"
 #include "math/FGFunction.h"
+#include "math/FGFunctionProgram.h"
 #include "math/FGColumnVector3.h"
 #include "math/FGMatrix33.h"
 #include "input_output/FGXMLFileRead.h"
@@ -225,6 +226,9 @@ private:
   FGFunction* AeroRPShift;
   typedef vector <FGFunction*> AeroFunctionArray;
   AeroFunctionArray* AeroFunctions;
+  // the functions of the force and of the moment axes, compiled together
+  FGFunctionProgram* ForceProgram;
+  FGFunctionProgram* MomentProgram;
   FGColumnVector3 vFnative;
   FGColumnVector3 vFw;
   FGColumnVector3 vForces;
@@ -239,6 +243,7 @@ private:
 
   typedef double (FGAerodynamics::*PMF)(int) const;
   void DetermineAxisSystem(void);
+  FGFunctionProgram* CompileAxes(unsigned int first) const;
   void bind(void);
 
   void Debug(int from);
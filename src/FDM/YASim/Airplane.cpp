@@ -2,6 +2,9 @@
 #  include "config.h"
 #endif
 
+#include <stdio.h>
+#include <string.h>
+
 #include "Atmosphere.hpp"
 #include "ControlMap.hpp"
 #include "Gear.hpp"
@@ -32,6 +35,20 @@ const float STHRESH = 1;
 // oscillate.
 const float SOLVE_TWEAK = 0.3226;
 
+// Version of the solver and of the airplane model as far as its
+// solution is concerned.  Bump this whenever a change alters the
+// solution an aircraft converges to, which invalidates all cached
+// solutions.
+const int SOLUTION_VERSION = 1;
+
+static char* dupString(const char* s)
+{
+    if(!s) return 0;
+    char* s2 = new char[strlen(s)+1];
+    strcpy(s2, s);
+    return s2;
+}
+
 Airplane::Airplane()
 {
     _emptyWeight = 0;
@@ -56,6 +73,10 @@ Airplane::Airplane()
     _cruiseAoA = 0;
     _tailIncidence = 0;
 
+    _solutionIterations = 0;
+    _solutionCached = false;
+    _solutionFile = 0;
+    _solutionKey = 0;
     _failureMsg = 0;
 }
 
@@ -95,6 +116,8 @@ Airplane::~Airplane()
         delete (Wing*)_vstabs.get(i);
     for(i=0; i<_weights.size(); i++)
         delete (WeightRec*)_weights.get(i);
+    delete[] _solutionFile;
+    delete[] _solutionKey;
 }
 
 void Airplane::iterate(float dt)
@@ -436,6 +459,17 @@ int Airplane::getSolutionIterations()
     return _solutionIterations;
 }
 
+// The file is where a solution is loaded from and saved to; the key
+// identifies the aircraft definition it belongs to (e.g. a hash of
+// the XML), so that a solution is only reused for the same input.
+void Airplane::setSolutionCache(const char* file, const char* key)
+{
+    delete[] _solutionFile;
+    delete[] _solutionKey;
+    _solutionFile = dupString(file);
+    _solutionKey = dupString(key);
+}
+
 void Airplane::setupState(float aoa, float speed, float gla, State* s)
 {
     float cosAoA = Math::cos(aoa);
@@ -706,7 +740,12 @@ void Airplane::compile()
     if (_failureMsg) return;
 
     solveGear();
-    if(_wing && _tail) solve();
+    if(_wing && _tail) {
+        if(!loadSolution()) {
+            solve();
+            if(!_failureMsg) saveSolution();
+        }
+    }
     else
     {
        // The rotor(s) mass:
@@ -941,6 +980,7 @@ void Airplane::solve()
 
     float tmp[3];
     _solutionIterations = 0;
+    _solutionCached = false;
     _failureMsg = 0;
 
     while(1) {
@@ -975,6 +1015,27 @@ void Airplane::solve()
         Math::tmul33(_approachState.orient, tmp, tmp);
 	float alift = _approachWeight * tmp[2];
 
+	// Now calculate:
+	float awgt = 9.8f * _approachWeight;
+
+	float dragFactor = thrust / (thrust-xforce);
+	float liftFactor = awgt / (awgt+alift);
+
+        // Sanity:
+        if(dragFactor <= 0 || liftFactor <= 0)
+            break;
+
+        // The "minor" variables are deferred until we get the
+        // lift/drag numbers in the right ballpark, so don't spend
+        // model runs on their derivatives before that.
+	if(normFactor(dragFactor) > STHRESH*1.0001
+	   || normFactor(liftFactor) > STHRESH*1.0001)
+	{
+	    applyDragFactor(dragFactor);
+	    applyLiftRatio(liftFactor);
+	    continue;
+	}
+
 	// Modify the cruise AoA a bit to get a derivative
 	_cruiseAoA += ARCMIN;
 	runCruise();
@@ -993,18 +1054,9 @@ void Airplane::solve()
         Math::tmul33(_cruiseState.orient, tmp, tmp);
 	float pitch1 = tmp[1];
 
-	// Now calculate:
-	float awgt = 9.8f * _approachWeight;
-
-	float dragFactor = thrust / (thrust-xforce);
-	float liftFactor = awgt / (awgt+alift);
 	float aoaDelta = -clift0 * (ARCMIN/(clift1-clift0));
 	float tailDelta = -pitch0 * (ARCMIN/(pitch1-pitch0));
 
-        // Sanity:
-        if(dragFactor <= 0 || liftFactor <= 0)
-            break;
-
         // And the elevator control in the approach.  This works just
         // like the tail incidence computation (it's solving for the
         // same thing -- pitching moment -- by diddling a different
@@ -1019,20 +1071,10 @@ void Airplane::solve()
 	double apitch1 = tmp[1];
         float elevDelta = -apitch0 * (ELEVDIDDLE/(apitch1-apitch0));
 
-        // Now apply the values we just computed.  Note that the
-        // "minor" variables are deferred until we get the lift/drag
-        // numbers in the right ballpark.
-
+        // Now apply the values we just computed.
 	applyDragFactor(dragFactor);
 	applyLiftRatio(liftFactor);
 
-	// DON'T do the following until the above are sane
-	if(normFactor(dragFactor) > STHRESH*1.0001
-	   || normFactor(liftFactor) > STHRESH*1.0001)
-	{
-	    continue;
-	}
-
 	// OK, now we can adjust the minor variables:
 	_cruiseAoA += SOLVE_TWEAK*aoaDelta;
 	_tailIncidence += SOLVE_TWEAK*tailDelta;
@@ -1073,6 +1115,117 @@ void Airplane::solve()
     }
 }
 
+// Reuse a solution saved by an earlier run, if there is one for the
+// same aircraft definition and solver version.  The solution is
+// checked by running the cruise and approach configurations: their
+// forces, and their pitch moments through the steps solve() would
+// still take.  One which no longer balances the airplane is left in
+// place as the starting point for solve().
+bool Airplane::loadSolution()
+{
+    if(!_solutionFile || !_solutionKey)
+        return false;
+    FILE* f = fopen(_solutionFile, "r");
+    if(!f)
+        return false;
+
+    int version = 0, iterations = 0;
+    char key[128];
+    float drag, lift, aoa, tail, elev;
+    int n = fscanf(f, "yasim-solution %d %127s %g %g %g %g %g %d",
+                   &version, key, &drag, &lift, &aoa, &tail, &elev,
+                   &iterations);
+    fclose(f);
+    if(n != 8 || version != SOLUTION_VERSION
+       || strcmp(key, _solutionKey) != 0
+       || drag <= 0 || lift <= 0)
+        return false;
+
+    // The factors are applied the same way solveHelicopter() does,
+    // undoing the solver's tweak exponent.
+    applyDragFactor(Math::pow(drag/_dragFactor, 1/SOLVE_TWEAK));
+    applyLiftRatio(Math::pow(lift/_liftRatio, 1/SOLVE_TWEAK));
+    _cruiseAoA = aoa;
+    _tailIncidence = tail;
+    _tail->setIncidence(_tailIncidence);
+    _approachElevator.val = elev;
+
+    static const float ARCMIN = 0.0002909f;
+    static const float ELEVDIDDLE = 0.001f;
+
+    float tmp[3];
+    runCruise();
+    _model.getBody()->getAccel(tmp);
+    Math::tmul33(_cruiseState.orient, tmp, tmp);
+    float xforce = _cruiseWeight * tmp[0];
+    float clift = _cruiseWeight * tmp[2];
+
+    _model.getBody()->getAngularAccel(tmp);
+    Math::tmul33(_cruiseState.orient, tmp, tmp);
+    float pitch0 = tmp[1];
+
+    runApproach();
+    _model.getBody()->getAccel(tmp);
+    Math::tmul33(_approachState.orient, tmp, tmp);
+    float alift = _approachWeight * tmp[2];
+
+    _model.getBody()->getAngularAccel(tmp);
+    Math::tmul33(_approachState.orient, tmp, tmp);
+    double apitch0 = tmp[1];
+
+    // Ten times the solver's own convergence thresholds, to allow for
+    // the rounding of the saved values.  The solver bounds the cruise
+    // lift only through the AoA step, which allows about 1e-3.
+    if(abs(xforce/_cruiseWeight) > STHRESH*0.001 ||
+       abs(clift/_cruiseWeight) > STHRESH*0.01 ||
+       abs(alift/_approachWeight) > STHRESH*0.001)
+        return false;
+
+    // The pitch moments are checked as solve() does, by the tail
+    // incidence and approach elevator steps they would still call for.
+    _tail->setIncidence(_tailIncidence + ARCMIN);
+    runCruise();
+    _tail->setIncidence(_tailIncidence);
+
+    _model.getBody()->getAngularAccel(tmp);
+    Math::tmul33(_cruiseState.orient, tmp, tmp);
+    float pitch1 = tmp[1];
+    float tailDelta = -pitch0 * (ARCMIN/(pitch1-pitch0));
+
+    _approachElevator.val += ELEVDIDDLE;
+    runApproach();
+    _approachElevator.val -= ELEVDIDDLE;
+
+    _model.getBody()->getAngularAccel(tmp);
+    Math::tmul33(_approachState.orient, tmp, tmp);
+    double apitch1 = tmp[1];
+    float elevDelta = -apitch0 * (ELEVDIDDLE/(apitch1-apitch0));
+
+    // A NaN step, when the moment does not respond, fails both tests
+    if(!(abs(tailDelta) < STHRESH*.00017) ||
+       !(abs(elevDelta) < STHRESH*0.001))
+        return false;
+
+    _solutionIterations = iterations;
+    _solutionCached = true;
+    _failureMsg = 0;
+    return true;
+}
+
+void Airplane::saveSolution()
+{
+    if(!_solutionFile || !_solutionKey)
+        return;
+    FILE* f = fopen(_solutionFile, "w");
+    if(!f)
+        return;
+    fprintf(f, "yasim-solution %d %s\n%.9g %.9g %.9g %.9g %.9g %d\n",
+            SOLUTION_VERSION, _solutionKey, _dragFactor, _liftRatio,
+            _cruiseAoA, _tailIncidence, _approachElevator.val,
+            _solutionIterations);
+    fclose(f);
+}
+
 void Airplane::solveHelicopter()
 {
     _solutionIterations = 0;
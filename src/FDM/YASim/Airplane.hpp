@@ -80,11 +80,13 @@ public:
     float getTankCapacity(int tank);
 
     void compile(); // generate point masses & such, then solve
+    void setSolutionCache(const char* file, const char* key);
     void initEngines();
     void stabilizeThrust();
 
     // Solution output values
     int getSolutionIterations();
+    bool isSolutionCached() { return _solutionCached; }
     float getDragCoefficient();
     float getLiftRatio();
     float getCruiseAoA();
@@ -111,6 +113,8 @@ private:
     void solveGear();
     void solve();
     void solveHelicopter();
+    bool loadSolution();
+    void saveSolution();
     float compileWing(Wing* w);
     void compileRotorgear();
     float compileFuselage(Fuselage* f);
@@ -167,6 +171,9 @@ private:
     float _approachGlideAngle;
 
     int _solutionIterations;
+    bool _solutionCached;
+    char* _solutionFile;
+    char* _solutionKey;
     float _dragFactor;
     float _liftRatio;
     float _cruiseAoA;
@@ -66,6 +66,8 @@ Model::Model()
     _hook = 0;
     _launchbar = 0;
 
+    _batchedSurfaces = true;
+
     _groundEffectSpan = 0;
     _groundEffect = 0;
     for(i=0; i<3; i++) _wingCenter[i] = 0;
@@ -100,6 +102,11 @@ void Model::getThrust(float* out)
 
 void Model::initIteration()
 {
+    // Surface parameters (controls, solver coefficients) don't change
+    // during the integration step
+    if(_batchedSurfaces)
+        _surfaceBatch.gather(&_surfaces);
+
     // Precompute torque and angular momentum for the thrusters
     int i;
     for(i=0; i<3; i++)
@@ -411,21 +418,11 @@ void Model::calcForces(State* s)
     // point is different due to rotation.
     float faero[3];
     faero[0] = faero[1] = faero[2] = 0;
-    for(i=0; i<_surfaces.size(); i++) {
-	Surface* sf = (Surface*)_surfaces.get(i);
-
-	// Vsurf = wind - velocity + (rot cross (cg - pos))
-	float vs[3], pos[3];
-	sf->getPosition(pos);
-        localWind(pos, s, vs, alt);
+    if(_batchedSurfaces)
+        calcSurfaceForcesBatched(s, alt, faero);
+    else
+        calcSurfaceForces(s, alt, faero);
 
-	float force[3], torque[3];
-	sf->calcForce(vs, _rho, force, torque);
-	Math::add3(faero, force, faero);
-
-	_body.addForce(pos, force);
-	_body.addTorque(torque);
-    }
     for (j=0; j<_rotorgear.getRotors()->size();j++)
     {
         Rotor* r = (Rotor *)_rotorgear.getRotors()->get(j);
@@ -554,6 +551,100 @@ void Model::newState(State* s)
 	_crashed = true;
 }
 
+void Model::calcSurfaceForces(State* s, float alt, float* faero)
+{
+    for(int i=0; i<_surfaces.size(); i++) {
+	Surface* sf = (Surface*)_surfaces.get(i);
+
+	// Vsurf = wind - velocity + (rot cross (cg - pos))
+	float vs[3], pos[3];
+	sf->getPosition(pos);
+        localWind(pos, s, vs, alt);
+
+	float force[3], torque[3];
+	sf->calcForce(vs, _rho, force, torque);
+	Math::add3(faero, force, faero);
+
+	_body.addForce(pos, force);
+	_body.addTorque(torque);
+    }
+}
+
+// Same as calcSurfaceForces, on the surface parameters gathered by
+// initIteration().  The terms of localWind() which are the same for
+// every point are computed once.
+void Model::calcSurfaceForcesBatched(State* s, float alt, float* faero)
+{
+    SurfaceBatch& b = _surfaceBatch;
+    int n = b.size();
+    if(n == 0) return;
+
+    float* px = b.pos(0); float* py = b.pos(1); float* pz = b.pos(2);
+    float* wx = b.wind(0); float* wy = b.wind(1); float* wz = b.wind(2);
+
+    float lrot[3], lv[3], cg[3];
+    Math::vmul33(s->orient, s->rot, lrot);
+    Math::vmul33(s->orient, s->v, lv);
+    _body.getCG(cg);
+
+    // Wind at each surface: turbulence varies per point
+    int i;
+    if(_turb) {
+        for(i=0; i<n; i++) {
+            float pos[3], tmp[3], lwind[3], up[3];
+            double gpos[3];
+            pos[0] = px[i]; pos[1] = py[i]; pos[2] = pz[i];
+            Math::tmul33(s->orient, pos, tmp);
+            for(int j=0; j<3; j++)
+                gpos[j] = s->pos[j] + tmp[j];
+            Glue::geodUp(gpos, up);
+            _turb->getTurbulence(gpos, alt, up, lwind);
+            Math::add3(_wind, lwind, lwind);
+            Math::vmul33(s->orient, lwind, lwind);
+            wx[i] = lwind[0]; wy[i] = lwind[1]; wz[i] = lwind[2];
+        }
+    } else {
+        float lwind[3];
+        Math::vmul33(s->orient, _wind, lwind);
+        for(i=0; i<n; i++) {
+            wx[i] = lwind[0]; wy[i] = lwind[1]; wz[i] = lwind[2];
+        }
+    }
+
+    // wind - velocity - (rot cross (pos - cg))
+    for(i=0; i<n; i++) {
+        float dx = px[i] - cg[0], dy = py[i] - cg[1], dz = pz[i] - cg[2];
+        float rx = lrot[1]*dz - dy*lrot[2];
+        float ry = lrot[2]*dx - dz*lrot[0];
+        float rz = lrot[0]*dy - dx*lrot[1];
+        wx[i] = (wx[i] + -1*rx) - lv[0];
+        wy[i] = (wy[i] + -1*ry) - lv[1];
+        wz[i] = (wz[i] + -1*rz) - lv[2];
+    }
+
+    if(_rotorgear.isInUse()) {
+        for(i=0; i<n; i++) {
+            float pos[3], tmp[3];
+            pos[0] = px[i]; pos[1] = py[i]; pos[2] = pz[i];
+            _rotorgear.getDownWash(pos, lv, tmp);
+            wx[i] += tmp[0]; wy[i] += tmp[1]; wz[i] += tmp[2];
+        }
+    }
+
+    b.calcForces(_rho);
+
+    for(i=0; i<n; i++) {
+        float pos[3], force[3], torque[3];
+        pos[0] = px[i]; pos[1] = py[i]; pos[2] = pz[i];
+        force[0] = b.force(0)[i]; force[1] = b.force(1)[i]; force[2] = b.force(2)[i];
+        torque[0] = b.torque(0)[i]; torque[1] = b.torque(1)[i]; torque[2] = b.torque(2)[i];
+        Math::add3(faero, force, faero);
+
+	_body.addForce(pos, force);
+	_body.addTorque(torque);
+    }
+}
+
 // Calculates the airflow direction at the given point and for the
 // specified aircraft velocity.
 void Model::localWind(float* pos, State* s, float* out, float alt, bool is_rotor)
@@ -7,6 +7,7 @@
 #include "Vector.hpp"
 #include "Turbulence.hpp"
 #include "Rotor.hpp"
+#include "SurfaceBatch.hpp"
 
 namespace yasim {
 
@@ -59,6 +60,11 @@ public:
     void setThruster(int handle, Thruster* t);
     void initIteration();
     void getThrust(float* out);
+    int numSurfaces() { return _surfaces.size(); }
+
+    // Evaluate surface forces with the batched kernel (default) or
+    // one Surface at a time.  For benchmarking and validation.
+    void setBatchedSurfaces(bool batched) { _batchedSurfaces = batched; }
 
     void setGroundCallback(Ground* ground_cb);
     Ground* getGroundCallback(void);
@@ -82,6 +88,8 @@ private:
     float gearFriction(float wgt, float v, Gear* g);
     void localWind(float* pos, State* s, float* out, float alt,
         bool is_rotor = false);
+    void calcSurfaceForces(State* s, float alt, float* faero);
+    void calcSurfaceForcesBatched(State* s, float alt, float* faero);
 
     Integrator _integrator;
     RigidBody _body;
@@ -90,6 +98,8 @@ private:
 
     Vector _thrusters;
     Vector _surfaces;
+    SurfaceBatch _surfaceBatch;
+    bool _batchedSurfaces;
     Rotorgear _rotorgear;
     Vector _gears;
     Hook* _hook;
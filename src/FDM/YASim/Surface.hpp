@@ -8,6 +8,8 @@ namespace yasim {
 // front, and flaps act (in both lift and drag) toward the back.
 class Surface
 {
+    // Gathers the private parameters for batched force evaluation
+    friend class SurfaceBatch;
 public:
     Surface();
 
@@ -0,0 +1,215 @@
+#include "Math.hpp"
+#include "Surface.hpp"
+#include "SurfaceBatch.hpp"
+namespace yasim {
+
+// Number of float arrays in the batch, see realloc()
+static const int NUM_FIELDS = 49;
+
+SurfaceBatch::SurfaceBatch()
+{
+    _n = 0;
+    _capacity = 0;
+    _data = 0;
+}
+
+SurfaceBatch::~SurfaceBatch()
+{
+    delete[] _data;
+}
+
+void SurfaceBatch::realloc(int n)
+{
+    delete[] _data;
+    _capacity = n;
+    _data = new float[NUM_FIELDS * n];
+
+    float* p = _data;
+    int i;
+    for(i=0; i<3; i++) { _pos[i] = p; p += n; }
+    for(i=0; i<9; i++) { _orient[i] = p; p += n; }
+    _c0 = p; p += n;
+    _cx = p; p += n;
+    _cy = p; p += n;
+    _cz = p; p += n;
+    _cz0 = p; p += n;
+    _chord = p; p += n;
+    _incidence = p; p += n;
+    _inducedDrag = p; p += n;
+    for(i=0; i<2; i++) { _peaks[i] = p; p += n; }
+    for(i=0; i<4; i++) { _stalls[i] = p; p += n; }
+    for(i=0; i<4; i++) { _widths[i] = p; p += n; }
+    _slatAlpha = p; p += n;
+    _slatDrag = p; p += n;
+    _flapLift = p; p += n;
+    _flapDrag = p; p += n;
+    _flapEffectiveness = p; p += n;
+    _spoilerLift = p; p += n;
+    _spoilerDrag = p; p += n;
+    _slatPos = p; p += n;
+    _flapPos = p; p += n;
+    _spoilerPos = p; p += n;
+    for(i=0; i<3; i++) { _wind[i] = p; p += n; }
+    for(i=0; i<3; i++) { _force[i] = p; p += n; }
+    for(i=0; i<3; i++) { _torque[i] = p; p += n; }
+}
+
+void SurfaceBatch::gather(Vector* surfaces)
+{
+    _n = surfaces->size();
+    if(_n > _capacity)
+        realloc(_n);
+
+    int i, j;
+    for(i=0; i<_n; i++) {
+        Surface* s = (Surface*)surfaces->get(i);
+        for(j=0; j<3; j++) _pos[j][i] = s->_pos[j];
+        for(j=0; j<9; j++) _orient[j][i] = s->_orient[j];
+        _c0[i] = s->_c0;
+        _cx[i] = s->_cx;
+        _cy[i] = s->_cy;
+        _cz[i] = s->_cz;
+        _cz0[i] = s->_cz0;
+        _chord[i] = s->_chord;
+        _incidence[i] = s->_incidence + s->_twist;
+        _inducedDrag[i] = s->_inducedDrag;
+        for(j=0; j<2; j++) _peaks[j][i] = s->_peaks[j];
+        for(j=0; j<4; j++) _stalls[j][i] = s->_stalls[j];
+        for(j=0; j<4; j++) _widths[j][i] = s->_widths[j];
+        _slatAlpha[i] = s->_slatAlpha;
+        _slatDrag[i] = s->_slatDrag;
+        _flapLift[i] = s->_flapLift;
+        _flapDrag[i] = s->_flapDrag;
+        _flapEffectiveness[i] = s->_flapEffectiveness;
+        _spoilerLift[i] = s->_spoilerLift;
+        _spoilerDrag[i] = s->_spoilerDrag;
+        _slatPos[i] = s->_slatPos;
+        _flapPos[i] = s->_flapPos;
+        _spoilerPos[i] = s->_spoilerPos;
+    }
+}
+
+// The math below mirrors Surface::calcForce, stallFunc, flapLift and
+// controlDrag operation by operation, so both produce the same
+// results (bit for bit, unless the compiler contracts multiply-adds
+// differently in the two).  Keep them in sync.
+void SurfaceBatch::calcForces(float rho)
+{
+    for(int i=0; i<_n; i++) {
+        float vx = _wind[0][i], vy = _wind[1][i], vz = _wind[2][i];
+        float vel = Math::sqrt(vx*vx + vy*vy + vz*vz);
+
+        float cx = _cx[i], cy = _cy[i], cz = _cz[i], cz0 = _cz0[i];
+        if(vel == 0 || (cx == 0. && cy == 0. && cz == 0.)) {
+            _force[0][i] = _force[1][i] = _force[2][i] = 0;
+            _torque[0][i] = _torque[1][i] = _torque[2][i] = 0;
+            continue;
+        }
+
+        float m0 = _orient[0][i], m1 = _orient[1][i], m2 = _orient[2][i];
+        float m3 = _orient[3][i], m4 = _orient[4][i], m5 = _orient[5][i];
+        float m6 = _orient[6][i], m7 = _orient[7][i], m8 = _orient[8][i];
+
+        // Unit wind in surface coordinates
+        float ivel = 1/vel;
+        float x = ivel * vx, y = ivel * vy, z = ivel * vz;
+        float o0 = x*m0 + y*m1 + z*m2;
+        float o1 = x*m3 + y*m4 + z*m5;
+        float o2 = x*m6 + y*m7 + z*m8;
+
+        float incidence = _incidence[i];
+        o2 += incidence * o0;
+        float l0 = o0, l1 = o1, l2 = o2;
+
+        // stallFunc()
+        float stallMul = 1;
+        if(o0 != 0) {
+            float alpha = Math::abs(o2/o0);
+            int fwdBak = o0 > 0;
+            int posNeg = o2 < 0;
+            int k = (fwdBak<<1) | posNeg;
+            float stallAlpha = _stalls[k][i];
+            if(stallAlpha != 0) {
+                if(k == 0)
+                    stallAlpha += _slatAlpha[i];
+                if(!(alpha > stallAlpha + _widths[k][i])) {
+                    float scale = 0.5f*_peaks[fwdBak][i]/_stalls[k&2][i];
+                    if(alpha <= stallAlpha) {
+                        stallMul = scale;
+                    } else {
+                        float frac = (alpha - stallAlpha) / _widths[k][i];
+                        frac = frac*frac*(3-2*frac);
+                        stallMul = scale*(1-frac) + frac;
+                    }
+                }
+            }
+        }
+        stallMul *= 1 + _spoilerPos[i] * (_spoilerLift[i] - 1);
+        float stallLift = (stallMul - 1) * cz * o2;
+
+        // flapLift()
+        float stall0 = _stalls[0][i], width0 = _widths[0][i];
+        float flaplift = 0;
+        if(stall0 != 0) {
+            float fl = cz * _flapPos[i] * (_flapLift[i]-1) * _flapEffectiveness[i];
+            float alpha = o2 < 0 ? -o2 : o2;
+            if(alpha < stall0) {
+                flaplift = fl;
+            } else if(!(alpha > stall0 + width0)) {
+                float frac = (alpha - stall0) / width0;
+                frac = frac*frac*(3-2*frac);
+                flaplift = fl * (1-frac);
+            }
+        }
+
+        o2 *= cz;
+        o2 += cz*cz0;
+        o2 += stallLift;
+        o2 += flaplift;
+
+        // Pitching torque, converted to local coordinates
+        float ty = 0.1667f * _chord[i] * (flaplift - (cz*cz0 + stallLift));
+        float t0 = 0*m0 + ty*m3 + 0*m6;
+        float t1 = 0*m1 + ty*m4 + 0*m7;
+        float t2 = 0*m2 + ty*m5 + 0*m8;
+
+        // controlDrag()
+        float flapLiftCoef = _flapLift[i];
+        float fp = _flapPos[i];
+        if(fp < 0) {
+            fp = -fp;
+            fp -= cz0/(flapLiftCoef-1);
+            if(fp < 0) fp = 0;
+        }
+        float drag = cx * o0;
+        float flapDragAoA = (flapLiftCoef - 1 - cz0) * stall0;
+        float fd = Math::abs(o2 * flapDragAoA * fp);
+        if(drag < 0) fd = -fd;
+        drag += fd;
+        drag *= 1 + fp * (_flapDrag[i] - 1);
+        drag *= 1 + _spoilerPos[i] * (_spoilerDrag[i] - 1);
+        drag *= 1 + _slatPos[i] * (_slatDrag[i] - 1);
+        o0 = drag;
+
+        o1 *= cy;
+
+        // Induced drag
+        float ind = -1*_inducedDrag[i]*o2*l2;
+        o0 = ind*l0 + o0;
+        o1 = ind*l1 + o1;
+        o2 = ind*l2 + o2;
+
+        o2 -= incidence * o0;
+
+        // Back to local coordinates, scaled to a real force
+        float scale = 0.5f*rho*vel*vel*_c0[i];
+        _force[0][i] = scale * (o0*m0 + o1*m3 + o2*m6);
+        _force[1][i] = scale * (o0*m1 + o1*m4 + o2*m7);
+        _force[2][i] = scale * (o0*m2 + o1*m5 + o2*m8);
+        _torque[0][i] = scale * t0;
+        _torque[1][i] = scale * t1;
+        _torque[2][i] = scale * t2;
+    }
+}
+
+}; // namespace yasim
@@ -0,0 +1,77 @@
+#ifndef _SURFACEBATCH_HPP
+#define _SURFACEBATCH_HPP
+
+#include "Vector.hpp"
+
+namespace yasim {
+
+// Structure-of-arrays copy of a model's surfaces.  The parameters of
+// every Surface are gathered once per iteration, so the four force
+// evaluations of an RK4 step run over flat float arrays instead of
+// chasing a Surface pointer (and calling its helpers) per element.
+// The kernel loop has no function calls and only simple selects, so
+// the compiler can vectorize it.  Results are the same as those of
+// Surface::calcForce.
+class SurfaceBatch
+{
+public:
+    SurfaceBatch();
+    ~SurfaceBatch();
+
+    // Copy positions, coefficients and control positions of all
+    // surfaces in the vector.
+    void gather(Vector* surfaces);
+
+    int size() { return _n; }
+
+    // Position of each surface in local coordinates
+    float* pos(int axis) { return _pos[axis]; }
+
+    // Input: the local wind vector at each surface
+    float* wind(int axis) { return _wind[axis]; }
+
+    // Output of calcForces: force and torque on each surface
+    float* force(int axis) { return _force[axis]; }
+    float* torque(int axis) { return _torque[axis]; }
+
+    // Batched equivalent of Surface::calcForce for every surface
+    void calcForces(float rho);
+
+private:
+    void realloc(int n);
+
+    int _n;
+    int _capacity;
+    float* _data;
+
+    float* _pos[3];
+    float* _orient[9];
+    float* _c0;
+    float* _cx;
+    float* _cy;
+    float* _cz;
+    float* _cz0;
+    float* _chord;
+    float* _incidence; // incidence + twist
+    float* _inducedDrag;
+    float* _peaks[2];
+    float* _stalls[4];
+    float* _widths[4];
+    float* _slatAlpha;
+    float* _slatDrag;
+    float* _flapLift;
+    float* _flapDrag;
+    float* _flapEffectiveness;
+    float* _spoilerLift;
+    float* _spoilerDrag;
+    float* _slatPos;
+    float* _flapPos;
+    float* _spoilerPos;
+
+    float* _wind[3];
+    float* _force[3];
+    float* _torque[3];
+};
+
+}; // namespace yasim
+#endif // _SURFACEBATCH_HPP
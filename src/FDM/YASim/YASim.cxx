@@ -4,11 +4,13 @@
 #endif
 
 #include <cstdlib>
+#include <cstdio>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/math/sg_geodesy.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/scene/model/placement.hxx>
+#include <simgear/timing/timestamp.hxx>
 #include <simgear/xml/easyxml.hxx>
 
 #include <Main/globals.hxx>
@@ -45,6 +47,30 @@ static const float W2HP = 1.3416e-3;
 static const float INHG2PA = 3386.389;
 static const float SLUG2KG = 14.59390;
 
+// FNV-1a hash of a file's contents, as a hex string, or an empty
+// string if it can't be read.  Keys the cached solver results.
+static string hashFile(const string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+        return string();
+
+    unsigned long long hash = 14695981039346656037ULL;
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            hash ^= buf[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    fclose(f);
+
+    char key[17];
+    sprintf(key, "%016llx", hash);
+    return key;
+}
+
 YASim::YASim(double dt) :
     _simTime(0)
 {
@@ -173,8 +199,27 @@ void YASim::init()
         throw e;
     }
 
+    // Solving the airplane is slow for complex models; reuse the result
+    // of an earlier run of the same XML file if there is one.
+    if (fgGetBool("/fdm/yasim/solution-cache", true)) {
+        string key = hashFile(f.str());
+        if (!key.empty()) {
+            SGPath cache(globals->get_fg_home());
+            cache.append("cache/yasim");
+            cache.append(fgGetString("/sim/aero"));
+            cache.concat(".solution");
+            cache.create_dir(0777);
+            airplane->setSolutionCache(cache.c_str(), key.c_str());
+        }
+    }
+
     // Compile it into a real airplane, and tell the user what they got
+    SGTimeStamp solveTime;
+    solveTime.stamp();
     airplane->compile();
+    SG_LOG(SG_FLIGHT, SG_INFO, "YASim solution "
+           << (airplane->isSolutionCached() ? "loaded from cache" : "computed")
+           << " in " << solveTime.elapsedMSec() << "ms");
     report();
 
     _fdm->init();
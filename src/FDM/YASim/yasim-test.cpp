@@ -5,6 +5,7 @@
 
 #include <simgear/props/props.hxx>
 #include <simgear/xml/easyxml.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include "FGFDM.hpp"
 #include "Atmosphere.hpp"
@@ -66,9 +67,52 @@ void yasim_graph(Airplane* a, float alt, float kts)
     }
 }
 
+// Time the force evaluation of the model at the specified speed and
+// altitude (at cruise AoA), once evaluating the surfaces one at a
+// time and once with the batched kernel.  Reports iterations per
+// second of each, and whether both produced the same accelerations.
+void yasim_timing(Airplane* a, float alt, float kts, int iterations)
+{
+    Model* m = a->getModel();
+    State s;
+
+    m->setAir(Atmosphere::getStdPressure(alt),
+              Atmosphere::getStdTemperature(alt),
+              Atmosphere::getStdDensity(alt));
+    m->getBody()->recalc();
+    Airplane::setupState(a->getCruiseAoA(), kts * KTS2MPS, 0, &s);
+
+    double rate[2];
+    float acc[2][3];
+    for(int batched=0; batched<2; batched++) {
+        m->setBatchedSurfaces(batched != 0);
+        SGTimeStamp start;
+        start.stamp();
+        for(int i=0; i<iterations; i++) {
+            m->getBody()->reset();
+            m->initIteration();
+            m->calcForces(&s);
+        }
+        double secs = start.elapsedMSec() / 1000.0;
+        rate[batched] = secs > 0 ? iterations / secs : 0;
+        m->getBody()->getAccel(acc[batched]);
+    }
+    m->setBatchedSurfaces(true);
+
+    bool same = acc[0][0] == acc[1][0] && acc[0][1] == acc[1][1]
+        && acc[0][2] == acc[1][2];
+    printf("Force evaluation timing (%d surfaces, %d iterations):\n",
+           m->numSurfaces(), iterations);
+    printf("   Per surface: %.0f iterations/s\n", rate[0]);
+    printf("       Batched: %.0f iterations/s\n", rate[1]);
+    printf("       Speedup: %.2f\n", rate[0] > 0 ? rate[1] / rate[0] : 0);
+    printf(" Results match: %s\n", same ? "yes" : "no");
+}
+
 int usage()
 {
     fprintf(stderr, "Usage: yasim <ac.xml> [-g [-a alt] [-s kts]]\n");
+    fprintf(stderr, "       yasim <ac.xml> -t [-a alt] [-s kts] [-n iterations]\n");
     return 1;
 }
 
@@ -89,7 +133,10 @@ int main(int argc, char** argv)
     }
 
     // ... and run
+    SGTimeStamp solveTime;
+    solveTime.stamp();
     a->compile();
+    double solveMSec = solveTime.elapsedMSec();
     if(a->getFailureMsg())
         printf("SOLUTION FAILURE: %s\n", a->getFailureMsg());
 
@@ -101,6 +148,16 @@ int main(int argc, char** argv)
             else return usage();
         }
         yasim_graph(a, alt, kts);
+    } else if(!a->getFailureMsg() && argc > 2 && strcmp(argv[2], "-t") == 0) {
+        float alt = 5000, kts = 100;
+        int iterations = 100000;
+        for(int i=3; i<argc; i++) {
+            if     (std::strcmp(argv[i], "-a") == 0) alt = std::atof(argv[++i]);
+            else if(std::strcmp(argv[i], "-s") == 0) kts = std::atof(argv[++i]);
+            else if(std::strcmp(argv[i], "-n") == 0) iterations = std::atoi(argv[++i]);
+            else return usage();
+        }
+        yasim_timing(a, alt, kts, iterations);
     } else {
         float aoa = a->getCruiseAoA() * RAD2DEG;
         float tail = -1 * a->getTailIncidence() * RAD2DEG;
@@ -114,6 +171,7 @@ int main(int argc, char** argv)
         
         printf("Solution results:");
         printf("       Iterations: %d\n", a->getSolutionIterations());
+        printf("       Solve time: %.1f ms\n", solveMSec);
         printf(" Drag Coefficient: %f\n", drag);
         printf("       Lift Ratio: %f\n", a->getLiftRatio());
         printf("       Cruise AoA: %f\n", aoa);
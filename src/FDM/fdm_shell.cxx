@@ -32,6 +32,7 @@
 #include <Aircraft/replay.hxx>
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/frame_profiler.hxx>
 #include <Scenery/scenery.hxx>
 
 // all the FDMs, since we are the factory method
@@ -156,6 +157,10 @@ void FDMShell::update(double dt)
     return; // still waiting
   }
 
+  // one span per iteration of the FDM group's multiloop
+  static FGProfileCounter* iteration = FGFrameProfiler::counter("fdm", "iteration");
+  FGProfileScope scope(iteration);
+
 // pull environmental data in, since the FDMs are lazy
   _impl->set_Velocities_Local_Airmass(
           _wind_north->getDoubleValue(),
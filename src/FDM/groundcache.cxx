@@ -45,6 +45,7 @@
 #include <simgear/scene/util/SGNodeMasks.hxx>
 #include <simgear/scene/util/SGSceneUserData.hxx>
 #include <simgear/scene/util/OsgMath.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include <simgear/bvh/BVHNode.hxx>
 #include <simgear/bvh/BVHGroup.hxx>
@@ -62,9 +63,9 @@
 
 #ifdef GROUNDCACHE_DEBUG
 #include <simgear/scene/model/BVHDebugCollectVisitor.hxx>
-#include <Main/fg_props.hxx>
 #endif
 
+#include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
 #include <Scenery/scenery.hxx>
 #include <Scenery/tilemgr.hxx>
@@ -75,18 +76,24 @@ using namespace simgear;
 
 class FGGroundCache::CacheFill : public osg::NodeVisitor {
 public:
+    // Collects the ball at center, and the elevation below the ball at
+    // probe, which is the vehicle's own when the collected one is larger.
     CacheFill(const SGVec3d& center, const SGVec3d& down, const double& radius,
+              const SGVec3d& probe, const double& probeRadius,
               const double& startTime, const double& endTime) :
         osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN),
         _center(center),
         _down(down),
         _radius(radius),
+        _probe(probe),
+        _probeRadius(probeRadius),
         _startTime(startTime),
         _endTime(endTime),
         _sceneryHit(0, 0, 0),
-        _maxDown(SGGeod::fromCart(center).getElevationM() + 9999),
+        _maxDown(SGGeod::fromCart(probe).getElevationM() + 9999),
         _material(0),
-        _haveHit(false)
+        _haveHit(false),
+        _haveMotion(false)
     {
         setTraversalMask(SG_NODEMASK_TERRAIN_BIT);
     }
@@ -149,28 +156,38 @@ public:
         SGVec3d center = _center;
         SGVec3d down = _down;
         double radius = _radius;
+        SGVec3d probe = _probe;
+        double probeRadius = _probeRadius;
         bool haveHit = _haveHit;
         const simgear::BVHMaterial* material = _material;
 
         _haveHit = false;
         _center = toSG(inverseMatrix.preMult(toOsg(_center)));
+        _probe = toSG(inverseMatrix.preMult(toOsg(_probe)));
         _down = toSG(osg::Matrix::transform3x3(toOsg(_down), inverseMatrix));
         if (velocity) {
             SGVec3d staticCenter(_center);
+            SGVec3d staticProbe(_probe);
 
             double dtStart = velocity->referenceTime - _startTime;
             SGVec3d startCenter = staticCenter + dtStart*velocity->linear;
+            SGVec3d startProbe = staticProbe + dtStart*velocity->linear;
             SGQuatd startOr(SGQuatd::fromAngleAxis(dtStart*velocity->angular));
             startCenter = startOr.transform(startCenter);
+            startProbe = startOr.transform(startProbe);
             
             double dtEnd = velocity->referenceTime - _endTime;
             SGVec3d endCenter = staticCenter + dtEnd*velocity->linear;
+            SGVec3d endProbe = staticProbe + dtEnd*velocity->linear;
             SGQuatd endOr(SGQuatd::fromAngleAxis(dtEnd*velocity->angular));
             endCenter = endOr.transform(endCenter);
+            endProbe = endOr.transform(endProbe);
 
             _center = 0.5*(startCenter + endCenter);
+            _probe = 0.5*(startProbe + endProbe);
             _down = startOr.transform(_down);
             _radius += 0.5*dist(startCenter, endCenter);
+            _probeRadius += 0.5*dist(startProbe, endProbe);
         }
         
         simgear::BVHSubTreeCollector::NodeList parentNodeList;
@@ -192,6 +209,7 @@ public:
                 bvhTransform->setId(velocity->id);
 
                 mSubTreeCollector.popNodeList(parentNodeList, bvhTransform);
+                _haveMotion = true;
             } else {
                 simgear::BVHTransform* bvhTransform;
                 bvhTransform = new simgear::BVHTransform;
@@ -219,6 +237,8 @@ public:
         _center = center;
         _down = down;
         _radius = radius;
+        _probe = probe;
+        _probeRadius = probeRadius;
     }
 
     const SGSceneUserData::Velocity* getVelocity(osg::Node& node)
@@ -242,13 +262,13 @@ public:
             return;
 
         // Find a croase ground intersection 
-        SGLineSegmentd line(_center + _radius*_down, _center + _maxDown*_down);
+        SGLineSegmentd line(_probe + _probeRadius*_down, _probe + _maxDown*_down);
         simgear::BVHLineSegmentVisitor lineSegmentVisitor(line, _startTime);
         bvNode->accept(lineSegmentVisitor);
         if (!lineSegmentVisitor.empty()) {
             _sceneryHit = lineSegmentVisitor.getPoint();
             _material = lineSegmentVisitor.getMaterial();
-            _maxDown = SGMiscd::max(_radius, dot(_down, _sceneryHit - _center));
+            _maxDown = SGMiscd::max(_probeRadius, dot(_down, _sceneryHit - _probe));
             _haveHit = true;
         }
 
@@ -263,10 +283,15 @@ public:
         if (!bound.valid())
             return false;
 
-        SGLineSegmentd downSeg(_center, _center + _maxDown*_down);
-        double maxDist = bound._radius + _radius;
+        // the collected ball, and the line below the probed one
         SGVec3d boundCenter(toVec3d(toSG(bound._center)));
-        return distSqr(downSeg, boundCenter) <= maxDist*maxDist;
+        double maxDist = bound._radius + _radius;
+        if (distSqr(_center, boundCenter) <= maxDist*maxDist)
+            return true;
+
+        SGLineSegmentd downSeg(_probe, _probe + _maxDown*_down);
+        double probeDist = bound._radius + _probeRadius;
+        return distSqr(downSeg, boundCenter) <= probeDist*probeDist;
     }
     
     SGSharedPtr<simgear::BVHNode> getBVHNode() const
@@ -278,11 +303,17 @@ public:
     { return SGGeod::fromCart(_sceneryHit).getElevationM(); }
     const simgear::BVHMaterial* getMaterialBelowCache() const
     { return _material; }
+
+    // true if the tree contains moving geometry, like carriers
+    bool getHaveMotion() const
+    { return _haveMotion; }
     
 private:
     SGVec3d _center;
     SGVec3d _down;
     double _radius;
+    SGVec3d _probe;
+    double _probeRadius;
     double _startTime;
     double _endTime;
 
@@ -291,6 +322,7 @@ private:
     double _maxDown;
     const simgear::BVHMaterial* _material;
     bool _haveHit;
+    bool _haveMotion;
 };
 
 FGGroundCache::FGGroundCache() :
@@ -302,13 +334,44 @@ FGGroundCache::FGGroundCache() :
     reference_wgs84_point(SGVec3d(0, 0, 0)),
     reference_vehicle_radius(0),
     down(0.0, 0.0, 0.0),
-    found_ground(false)
+    found_ground(false),
+    _windowCenter(0, 0, 0),
+    _windowRadius(0),
+    _windowTime(0),
+    _windowStatic(false),
+    _lastPoint(0, 0, 0),
+    _lastTime(0),
+    _builds(0),
+    _reuses(0),
+    _lastBuildTime(0),
+    _totalBuildTime(0),
+    _maxBuildTime(0)
 {
+    SGPropertyNode* node = fgGetNode("/fdm/ground-cache", true);
+    _reuseNode = node->getNode("reuse", true);
+    if (!_reuseNode->hasValue())
+        _reuseNode->setBoolValue(true);
+    _lookaheadNode = node->getNode("lookahead-sec", true);
+    if (!_lookaheadNode->hasValue())
+        _lookaheadNode->setDoubleValue(1);
+    _maxAheadNode = node->getNode("max-lookahead-m", true);
+    if (!_maxAheadNode->hasValue())
+        _maxAheadNode->setDoubleValue(300);
+    _maxAgeNode = node->getNode("max-age-sec", true);
+    if (!_maxAgeNode->hasValue())
+        _maxAgeNode->setDoubleValue(5);
+
+    _buildsNode = node->getNode("builds", true);
+    _reusesNode = node->getNode("reuses", true);
+    _hitRateNode = node->getNode("hit-rate", true);
+    _buildTimeNode = node->getNode("build-time-ms", true);
+    _averageBuildTimeNode = node->getNode("average-build-time-ms", true);
+    _maxBuildTimeNode = node->getNode("max-build-time-ms", true);
+    _windowRadiusNode = node->getNode("window-radius-m", true);
+
 #ifdef GROUNDCACHE_DEBUG
     _lookupTime = SGTimeStamp::fromSec(0.0);
     _lookupCount = 0;
-    _buildTime = SGTimeStamp::fromSec(0.0);
-    _buildCount = 0;
 #endif
 }
 
@@ -320,12 +383,15 @@ bool
 FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
                                     const SGVec3d& pt, double rad)
 {
-#ifdef GROUNDCACHE_DEBUG
     SGTimeStamp t0 = SGTimeStamp::now();
-#endif
 
-    // Empty cache.
-    found_ground = false;
+    // Estimate the velocity from the previous request
+    SGVec3d velocity(0, 0, 0);
+    double dt = startSimTime - _lastTime;
+    if (0 < dt && dt < 1)
+        velocity = (1/dt)*(pt - _lastPoint);
+    _lastPoint = pt;
+    _lastTime = startSimTime;
 
     SGGeod geodPt = SGGeod::fromCart(pt);
     // Don't blow away the cache ground_radius and stuff if there's no
@@ -335,7 +401,6 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
                "returns false at " << geodPt << " " << pt << " " << rad);
         return false;
     }
-    _material = 0;
 
     // If we have an active wire, get some more area into the groundcache
     if (_wire)
@@ -350,13 +415,54 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
     // Get a normalized down vector valid for the whole cache
     SGQuatd hlToEc = SGQuatd::fromLonLat(geodPt);
     down = hlToEc.rotate(SGVec3d(0, 0, 1));
-    
+
+    // Keep the local tree if the requested ball is within the one it was
+    // collected for, nothing in it moves, it is not too old and it holds
+    // the ground below the vehicle, to take the fallback elevation from.
+    // Scenery models paged in since are only seen with the next build.
+    if (_reuseNode->getBoolValue() && found_ground && _windowStatic && !_wire
+        && _windowTime <= startSimTime
+        && startSimTime - _windowTime < _maxAgeNode->getDoubleValue()
+        && dist(pt, _windowCenter) + rad <= _windowRadius
+        && find_ground_in_window(pt, rad, startSimTime + cache_time_offset)) {
+        ++_reuses;
+        update_statistics();
+        return found_ground;
+    }
+
+    // Empty cache.
+    found_ground = false;
+    _material = 0;
+
+    // Collect a larger ball, reaching as far ahead as the vehicle gets in
+    // half the lookahead time, so that the next requests fall into it
+    SGVec3d center = pt;
+    double radius = rad;
+    double speed = norm(velocity);
+    if (_reuseNode->getBoolValue() && !_wire) {
+        double ahead = 0.5*_lookaheadNode->getDoubleValue()*speed;
+        ahead = SGMiscd::min(ahead, _maxAheadNode->getDoubleValue());
+        if (0 < speed)
+            center += (ahead/speed)*velocity;
+        radius += ahead + 10;
+        if (!globals->get_tile_mgr()->schedule_scenery(SGGeod::fromCart(center),
+                                                       radius, 1.0)) {
+            center = pt;
+            radius = rad;
+        }
+    }
+    _windowCenter = center;
+    _windowRadius = radius;
+    _windowTime = startSimTime;
+
     // Get the ground cache, that is a local collision tree of the environment
     startSimTime += cache_time_offset;
     endSimTime += cache_time_offset;
-    CacheFill subtreeCollector(pt, down, rad, startSimTime, endSimTime);
+    CacheFill subtreeCollector(center, down, radius, pt, rad,
+                               startSimTime, endSimTime);
     globals->get_scenery()->get_scene_graph()->accept(subtreeCollector);
     _localBvhTree = subtreeCollector.getBVHNode();
+    _windowStatic = !subtreeCollector.getHaveMotion();
 
     if (subtreeCollector.getHaveElevationBelowCache()) {
         // Use the altitude value below the cache that we gathered during
@@ -394,24 +500,19 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
         SG_LOG(SG_FLIGHT, SG_WARN, "prepare_ground_cache(): trying to build "
                "cache without any scenery below the aircraft");
 
+    _lastBuildTime = (SGTimeStamp::now() - t0).toUSecs()/1000.0;
+    _totalBuildTime += _lastBuildTime;
+    _maxBuildTime = SGMiscd::max(_maxBuildTime, _lastBuildTime);
+    ++_builds;
+    update_statistics();
+
 #ifdef GROUNDCACHE_DEBUG
-    t0 = SGTimeStamp::now() - t0;
-    _buildTime += t0;
-    _buildCount++;
-
-    if (_buildCount > 60) {
-        double buildTime = 0;
-        if (_buildCount)
-            buildTime = _buildTime.toSecs()/_buildCount;
-        double lookupTime = 0;
-        if (_lookupCount)
-            lookupTime = _lookupTime.toSecs()/_lookupCount;
-        _buildTime = SGTimeStamp::fromSec(0.0);
-        _buildCount = 0;
+    if (_lookupCount > 1000) {
+        double lookupTime = _lookupTime.toSecs()/_lookupCount;
         _lookupTime = SGTimeStamp::fromSec(0.0);
         _lookupCount = 0;
-        SG_LOG(SG_FLIGHT, SG_ALERT, "build time = " << buildTime
-               << ", lookup Time = " << lookupTime);
+        SG_LOG(SG_FLIGHT, SG_ALERT, "build time = " << _lastBuildTime
+               << " ms, lookup Time = " << lookupTime);
     }
 
     if (!_group.valid()) {
@@ -433,6 +534,40 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
     return found_ground;
 }
 
+// The elevation below the vehicle ball at pt, if the local tree holds it;
+// the same a build would find below the ball, since the tree holds all
+// scenery within the window.
+bool
+FGGroundCache::find_ground_in_window(const SGVec3d& pt, double rad, double t)
+{
+    if (!_localBvhTree)
+        return false;
+
+    double bottom = dist(pt, _windowCenter) + _windowRadius;
+    SGLineSegmentd line(pt + rad*down, pt + bottom*down);
+    simgear::BVHLineSegmentVisitor lineSegmentVisitor(line, t);
+    _localBvhTree->accept(lineSegmentVisitor);
+    if (lineSegmentVisitor.empty())
+        return false;
+
+    _altitude = SGGeod::fromCart(lineSegmentVisitor.getPoint()).getElevationM();
+    _material = lineSegmentVisitor.getMaterial();
+    return true;
+}
+
+void
+FGGroundCache::update_statistics()
+{
+    _buildsNode->setIntValue(_builds);
+    _reusesNode->setIntValue(_reuses);
+    _hitRateNode->setDoubleValue(double(_reuses)/(_builds + _reuses));
+    _buildTimeNode->setDoubleValue(_lastBuildTime);
+    if (_builds)
+        _averageBuildTimeNode->setDoubleValue(_totalBuildTime/_builds);
+    _maxBuildTimeNode->setDoubleValue(_maxBuildTime);
+    _windowRadiusNode->setDoubleValue(_windowRadius);
+}
+
 bool
 FGGroundCache::is_valid(double& ref_time, SGVec3d& pt, double& rad)
 {
@@ -28,6 +28,7 @@
 #include <simgear/math/SGMath.hxx>
 #include <simgear/math/SGGeometry.hxx>
 #include <simgear/bvh/BVHNode.hxx>
+#include <simgear/props/props.hxx>
 #include <simgear/structure/SGSharedPtr.hxx>
 
 // #define GROUNDCACHE_DEBUG
@@ -54,6 +55,9 @@ public:
     // Prepare the ground cache for the wgs84 position pt_*.
     // That is take all vertices in the ball with radius rad around the
     // position given by the pt_* and store them in a local scene graph.
+    // The ball collected is made larger in the direction of motion, so
+    // that the following calls can usually keep the same local scene
+    // graph instead of visiting the scenery again.
     bool prepare_ground_cache(double startSimTime, double endSimTime,
                               const SGVec3d& pt, double rad);
 
@@ -140,11 +144,41 @@ private:
 
     SGSharedPtr<simgear::BVHNode> _localBvhTree;
 
+    // The ball the local tree was collected for, and when. Requests
+    // within it are served from the same tree as long as it is static.
+    SGVec3d _windowCenter;
+    double _windowRadius;
+    double _windowTime;
+    bool _windowStatic;
+
+    // The previous request, to estimate the velocity
+    SGVec3d _lastPoint;
+    double _lastTime;
+
+    void update_statistics();
+    bool find_ground_in_window(const SGVec3d& pt, double rad, double t);
+
+    // Settings and statistics in /fdm/ground-cache
+    SGPropertyNode_ptr _reuseNode;
+    SGPropertyNode_ptr _lookaheadNode;
+    SGPropertyNode_ptr _maxAheadNode;
+    SGPropertyNode_ptr _maxAgeNode;
+    SGPropertyNode_ptr _buildsNode;
+    SGPropertyNode_ptr _reusesNode;
+    SGPropertyNode_ptr _hitRateNode;
+    SGPropertyNode_ptr _buildTimeNode;
+    SGPropertyNode_ptr _averageBuildTimeNode;
+    SGPropertyNode_ptr _maxBuildTimeNode;
+    SGPropertyNode_ptr _windowRadiusNode;
+    unsigned _builds;
+    unsigned _reuses;
+    double _lastBuildTime;
+    double _totalBuildTime;
+    double _maxBuildTime;
+
 #ifdef GROUNDCACHE_DEBUG
     SGTimeStamp _lookupTime;
     unsigned _lookupCount;
-    SGTimeStamp _buildTime;
-    unsigned _buildCount;
 
     osg::ref_ptr<osg::Group> _group;
 #endif
@@ -32,10 +32,19 @@
 #include <GUI/dialog.hxx>
 #include <Aircraft/replay.hxx>
 #include <Scenery/scenery.hxx>
+#include <Scenery/tilecache.hxx>
 #include <Scripting/NasalSys.hxx>
 #include <Sound/sample_queue.hxx>
+#include <AIModel/AISpatialIndex.hxx>
 #include <Airports/xmlloader.hxx>
+#include <Airports/simple.hxx>
+#include <Airports/dynamics.hxx>
+#include <Airports/groundnetwork.hxx>
 #include <Network/HTTPClient.hxx>
+#include <Network/generic.hxx>
+#include <Navaids/NavDataCache.hxx>
+#include <Autopilot/autopilotgroup.hxx>
+#include <Traffic/TrafficMgr.hxx>
 #include <Viewer/viewmgr.hxx>
 #include <Viewer/viewer.hxx>
 #include <Environment/presets.hxx>
@@ -45,6 +54,7 @@
 #include "fg_os.hxx"
 #include "fg_commands.hxx"
 #include "fg_props.hxx"
+#include "frame_profiler.hxx"
 #include "globals.hxx"
 #include "logger.hxx"
 #include "util.hxx"
@@ -480,6 +490,22 @@ do_tile_cache_reload (const SGPropertyNode * arg)
     return true;
 }
 
+/**
+ * Time the tile cache bookkeeping for a simulated flight, see
+ * TileCache::stress_test. Results are written to
+ * /sim/rendering/tile-cache-stress-test.
+ */
+static bool
+do_tile_cache_stress_test (const SGPropertyNode * arg)
+{
+    TileCache::stress_test(arg->getDoubleValue("speed-kt", 600.0),
+                           arg->getDoubleValue("duration-sec", 3600.0),
+                           arg->getDoubleValue("frame-rate", 60.0),
+                           arg->getDoubleValue("range-m", 100000.0),
+                           fgGetNode("/sim/rendering/tile-cache-stress-test", true));
+    return true;
+}
+
 /**
  * Reload the materials definition
  */
@@ -940,8 +966,7 @@ do_property_interpolate (const SGPropertyNode * arg)
         }
     }
 
-    ((SGInterpolator*)globals->get_subsystem_mgr()
-      ->get_group(SGSubsystemMgr::INIT)->get_subsystem("interpolator"))
+    ((SGInterpolator*)globals->get_subsystem("interpolator"))
       ->interpolate(prop, num_times, value.get(), time.get() );
 
     return true;
@@ -1557,6 +1582,201 @@ do_profiler_stop(const SGPropertyNode *arg)
 }
 
 
+/**
+ * Write the spans buffered by the frame profiler as a Chrome trace.
+ * The file name is relative to $FG_HOME.
+ */
+static bool
+do_frame_profiler_export(const SGPropertyNode *arg)
+{
+  SGPath path(globals->get_fg_home());
+  path.append(arg->getStringValue("filename", "fgfs-trace.json"));
+  return FGFrameProfiler::export_trace(path);
+}
+
+
+/**
+ * Time range queries of the AI spatial index against linear scans, over
+ * synthetic traffic, see FGAISpatialIndex::benchmark.
+ *
+ * objects: the number of AI objects (default 500)
+ * queries: the number of queries (default 2000)
+ * range-m: the query range in meters (default 1000)
+ *
+ * Results are logged and written to /sim/ai/index-benchmark.
+ */
+static bool
+do_ai_index_benchmark(const SGPropertyNode *arg)
+{
+  int objects = arg->getIntValue("objects", 500);
+  int queries = arg->getIntValue("queries", 2000);
+  double range = arg->getDoubleValue("range-m", 1000.0);
+  if ((objects <= 0) || (queries <= 0) || (range <= 0.0)) {
+    SG_LOG(SG_GENERAL, SG_WARN, "ai-index-benchmark: objects, queries and "
+           "range-m must be positive");
+    return false;
+  }
+
+  FGAISpatialIndex::benchmark(objects, queries, range,
+                              fgGetNode("/sim/ai/index-benchmark", true));
+  return true;
+}
+
+/**
+ * Time the binary encoders and decoders of the generic protocol, see
+ * FGGeneric::benchmark. Results are written to /sim/generic-benchmark.
+ */
+static bool
+do_generic_benchmark(const SGPropertyNode *arg)
+{
+  FGGeneric::benchmark(arg->getIntValue("fields", 50),
+                       arg->getIntValue("iterations", 100000),
+                       fgGetNode("/sim/generic-benchmark", true));
+  return true;
+}
+
+/**
+ * Time taxi route finding at an airport: routes every parking position
+ * to every runway of the ground network.
+ *
+ * airport: the ICAO ident of the airport (defaults to the start airport)
+ *
+ * Results are logged and written to /sim/ai/groundnet-benchmark.
+ */
+static bool
+do_groundnet_benchmark(const SGPropertyNode *arg)
+{
+  std::string ident = arg->getStringValue("airport",
+                          fgGetString("/sim/presets/airport-id"));
+  FGAirport* apt = FGAirport::findByIdent(ident);
+  if (!apt) {
+    SG_LOG(SG_GENERAL, SG_WARN, "groundnet-benchmark: unknown airport '" << ident << "'");
+    return false;
+  }
+
+  FGGroundNetwork* gn = apt->getDynamics()->getGroundNetwork();
+  if (!gn->exists()) {
+    SG_LOG(SG_GENERAL, SG_WARN, "groundnet-benchmark: no ground network at " << ident);
+    return false;
+  }
+
+  gn->benchmarkRouting(fgGetNode("/sim/ai/groundnet-benchmark", true));
+  return true;
+}
+
+/**
+ * Time the ground controller's separation checks with many aircraft
+ * taxiing from the parking positions to the runways, once with the
+ * active traffic indexed by position and once searched linearly.
+ *
+ * airport: the ICAO ident of the airport (defaults to the start airport)
+ * aircraft: the number of simulated aircraft (default 300)
+ * steps: the number of 10 m moves of each aircraft (default 100)
+ *
+ * Results are logged and written to /sim/ai/groundnet-traffic-benchmark.
+ */
+static bool
+do_groundnet_traffic_benchmark(const SGPropertyNode *arg)
+{
+  std::string ident = arg->getStringValue("airport",
+                          fgGetString("/sim/presets/airport-id"));
+  FGAirport* apt = FGAirport::findByIdent(ident);
+  if (!apt) {
+    SG_LOG(SG_GENERAL, SG_WARN, "groundnet-traffic-benchmark: unknown airport '" << ident << "'");
+    return false;
+  }
+
+  FGGroundNetwork* gn = apt->getDynamics()->getGroundNetwork();
+  if (!gn->exists()) {
+    SG_LOG(SG_GENERAL, SG_WARN, "groundnet-traffic-benchmark: no ground network at " << ident);
+    return false;
+  }
+
+  gn->benchmarkTraffic(arg->getIntValue("aircraft", 300),
+                       arg->getIntValue("steps", 100),
+                       fgGetNode("/sim/ai/groundnet-traffic-benchmark", true));
+  return true;
+}
+
+/**
+ * Time a mix of navaid, airway and ground network lookups against the
+ * navigation data cache, with and without its in-memory query caches.
+ *
+ * queries: the number of lookups to replay (default 100000)
+ *
+ * Results are logged and written to /sim/navdb/benchmark.
+ */
+static bool
+do_navcache_benchmark(const SGPropertyNode *arg)
+{
+  flightgear::NavDataCache::instance()->benchmarkQueries(
+      arg->getIntValue("queries", 100000),
+      fgGetNode("/sim/navdb/benchmark", true));
+  return true;
+}
+
+/**
+ * Time the updates of a property-rule or autopilot configuration, with
+ * inputs compiled and interpreted, see FGXMLAutopilotGroup::benchmark.
+ *
+ * path: the configuration file, relative to the aircraft or $FG_ROOT
+ * iterations: the number of updates of each run (default 10000)
+ * dt: the simulated time step (default 1/120 s)
+ *
+ * Results are written to /sim/autopilot-benchmark.
+ */
+static bool
+do_autopilot_benchmark(const SGPropertyNode *arg)
+{
+  if (!arg->hasValue("path")) {
+    SG_LOG(SG_GENERAL, SG_WARN, "autopilot-benchmark: no path given");
+    return false;
+  }
+
+  return FGXMLAutopilotGroup::benchmark(arg->getStringValue("path"),
+                                        arg->getIntValue("iterations", 10000),
+                                        arg->getDoubleValue("dt", 1.0 / 120),
+                                        fgGetNode("/sim/autopilot-benchmark", true));
+}
+
+/**
+ * Schedule all aircraft of the traffic manager from scratch, searching
+ * the flight queues and all flights, see FGTrafficManager::benchmark.
+ *
+ * Results are written to /sim/traffic-manager/benchmark.
+ */
+static bool
+do_traffic_benchmark(const SGPropertyNode *arg)
+{
+  FGTrafficManager* tmgr =
+    (FGTrafficManager*) globals->get_subsystem("traffic-manager");
+  if (!tmgr) {
+    SG_LOG(SG_GENERAL, SG_WARN, "traffic-benchmark: no traffic manager");
+    return false;
+  }
+
+  tmgr->benchmark(fgGetNode("/sim/traffic-manager/benchmark", true));
+  return true;
+}
+
+/**
+ * Parse the traffic schedules in FG_ROOT and write the schedule cache
+ * loaded at startup, in the background, see FGTrafficManager::rebuildCache.
+ */
+static bool
+do_traffic_cache_rebuild(const SGPropertyNode *arg)
+{
+  FGTrafficManager* tmgr =
+    (FGTrafficManager*) globals->get_subsystem("traffic-manager");
+  if (!tmgr) {
+    SG_LOG(SG_GENERAL, SG_WARN, "traffic-cache-rebuild: no traffic manager");
+    return false;
+  }
+
+  return tmgr->rebuildCache();
+}
+
+
 ////////////////////////////////////////////////////////////////////////
 // Command setup.
 ////////////////////////////////////////////////////////////////////////
@@ -1588,6 +1808,7 @@ static struct {
     { "screen-capture", do_screen_capture },
     { "hires-screen-capture", do_hires_screen_capture },
     { "tile-cache-reload", do_tile_cache_reload },
+    { "tile-cache-stress-test", do_tile_cache_stress_test },
     /*
     { "set-sea-level-air-temp-degc", do_set_sea_level_degc },
     { "set-outside-air-temp-degc", do_set_oat_degc },
@@ -1634,6 +1855,15 @@ static struct {
 
     { "profiler-start", do_profiler_start },
     { "profiler-stop",  do_profiler_stop },
+    { "frame-profiler-export", do_frame_profiler_export },
+    { "ai-index-benchmark", do_ai_index_benchmark },
+    { "groundnet-benchmark", do_groundnet_benchmark },
+    { "groundnet-traffic-benchmark", do_groundnet_traffic_benchmark },
+    { "generic-benchmark", do_generic_benchmark },
+    { "navcache-benchmark", do_navcache_benchmark },
+    { "autopilot-benchmark", do_autopilot_benchmark },
+    { "traffic-benchmark", do_traffic_benchmark },
+    { "traffic-cache-rebuild", do_traffic_cache_rebuild },
 
     { 0, 0 }			// zero-terminated
 };
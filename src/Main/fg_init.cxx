@@ -105,6 +105,7 @@
 
 #include "fg_init.hxx"
 #include "fg_io.hxx"
+#include "frame_profiler.hxx"
 #include "fg_commands.hxx"
 #include "fg_props.hxx"
 #include "options.hxx"
@@ -459,6 +460,13 @@ bool fgInitConfig ( int argc, char **argv )
 
 
 
+// publish the hit / miss counts of the nav cache lookups made while flying
+static void publishNavCacheStatistics()
+{
+  flightgear::NavDataCache::instance()->
+    writeCacheStatistics(fgGetNode("/sim/navdb/cache", true));
+}
+
 /**
  * Initialize vor/ndb/ils/fix list management and query systems (as
  * well as simple airport db list)
@@ -488,6 +496,8 @@ fgInitNav ()
   path.append( "Navaids/TACAN_freq.dat" );
   flightgear::loadTacan(path, channellist);
   
+  globals->get_event_mgr()->addTask("publishNavCacheStatistics",
+                                    &publishNavCacheStatistics, 10);
   return true;
 }
 
@@ -568,6 +578,7 @@ void fgCreateSubsystems() {
     globals->add_subsystem("performance-mon",
             new SGPerformanceMonitor(globals->get_subsystem_mgr(),
                                      fgGetNode("/sim/performance-monitor", true)));
+    globals->add_subsystem("frame-profiler", new FGFrameProfiler);
 
     ////////////////////////////////////////////////////////////////////
     // Initialize the material property subsystem.
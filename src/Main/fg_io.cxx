@@ -29,7 +29,9 @@
 #include <cstdlib>             // atoi()
 
 #include <string>
+#include <deque>
 #include <algorithm>
+#include <cmath>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/io/iochannel.hxx>
@@ -40,6 +42,8 @@
 #include <simgear/math/sg_types.hxx>
 #include <simgear/timing/timestamp.hxx>
 #include <simgear/misc/strutils.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include <Network/protocol.hxx>
 #include <Network/ATC-Main.hxx>
@@ -71,13 +75,306 @@
 #endif
 
 #include "globals.hxx"
+#include "fg_props.hxx"
 #include "fg_io.hxx"
+#include "frame_profiler.hxx"
 
 using std::atoi;
 using std::string;
 
 
-FGIO::FGIO()
+////////////////////////////////////////////////////////////////////////
+// Channel statistics
+////////////////////////////////////////////////////////////////////////
+
+// upper bucket limits in msec, the last bucket is open-ended
+const double FGIO::Histogram::bucket_limits[NUM_BUCKETS - 1] =
+    { 0.1, 0.5, 1.0, 2.0, 5.0, 10.0, 20.0, 50.0 };
+
+FGIO::Histogram::Histogram() :
+    count(0),
+    sum(0.0),
+    max(0.0)
+{
+    std::fill(buckets, buckets + NUM_BUCKETS, 0);
+}
+
+void
+FGIO::Histogram::sample( double msec )
+{
+    int b = 0;
+    while ((b < NUM_BUCKETS - 1) && (msec > bucket_limits[b])) {
+        ++b;
+    }
+    ++buckets[b];
+    ++count;
+    sum += msec;
+    max = std::max(max, msec);
+}
+
+void
+FGIO::Histogram::publish( SGPropertyNode* node ) const
+{
+    node->setIntValue("count", count);
+    node->setDoubleValue("mean", count ? sum / count : 0.0);
+    node->setDoubleValue("max", max);
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+        node->getChild("bucket", b, true)->setIntValue(buckets[b]);
+        if (b < NUM_BUCKETS - 1) {
+            node->getChild("bucket-limit", b, true)->setDoubleValue(bucket_limits[b]);
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////
+// I/O thread
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * Services I/O channels at their configured rates, independent of the
+ * frame rate, so a slow peer doesn't stall the main loop. Only channel I/O
+ * runs in this thread: outgoing messages are generated and incoming
+ * records parsed in the main loop (so all property access stays there),
+ * and whole messages are handed over in both directions. The lock only
+ * guards buffer swaps, never I/O.
+ */
+class FGIOThread : public SGThread
+{
+public:
+    FGIOThread() :
+        _done(false)
+    {
+    }
+
+    ~FGIOThread()
+    {
+        for (unsigned int i = 0; i < _slots.size(); ++i) {
+            delete _slots[i];
+        }
+    }
+
+    // must be called before the thread is started
+    void add_channel( FGIO::Channel* channel )
+    {
+        Slot* slot = new Slot;
+        slot->channel = channel;
+        slot->period = 1.0 / channel->protocol->get_hz();
+        slot->next_due = SGTimeStamp::now().toSecs();
+        slot->fresh = false;
+        slot->dropped = 0;
+        slot->write_errors = 0;
+        slot->closed = false;
+        slot->scratch.resize(FG_MAX_MSG_SIZE);
+        _slots.push_back(slot);
+    }
+
+    void stop()
+    {
+        {
+            SGGuard<SGMutex> g(_lock);
+            _done = true;
+        }
+        join();
+    }
+
+    // main loop: generate the latest outgoing message of a channel
+    void publish_message( FGIO::Channel* channel )
+    {
+        Slot* slot = find(channel);
+        slot->generated.resize(FG_MAX_MSG_SIZE);
+        int n = channel->protocol->gen_message_into(&slot->generated[0],
+                                                    slot->generated.size());
+        slot->generated.resize(std::max(n, 0));
+
+        SGGuard<SGMutex> g(_lock);
+        slot->generated.swap(slot->pending);
+        slot->fresh = true;
+    }
+
+    // main loop: apply all records received since the last call
+    void parse_records( FGIO::Channel* channel )
+    {
+        Slot* slot = find(channel);
+        {
+            SGGuard<SGMutex> g(_lock);
+            slot->parsing.swap(slot->received);
+        }
+
+        while (!slot->parsing.empty()) {
+            const string& record = slot->parsing.front();
+            channel->protocol->parse_record(record.data(), record.size());
+            slot->parsing.pop_front();
+        }
+    }
+
+    // main loop: whether writing to the channel failed since the last call;
+    // the error is handled by the protocol there, as process() would
+    bool take_write_errors( FGIO::Channel* channel )
+    {
+        Slot* slot = find(channel);
+        SGGuard<SGMutex> g(_lock);
+        bool failed = slot->write_errors > 0;
+        slot->write_errors = 0;
+        return failed;
+    }
+
+    // main loop: stop servicing a channel which has been closed
+    void close_channel( FGIO::Channel* channel )
+    {
+        Slot* slot = find(channel);
+        SGGuard<SGMutex> g(_lock);
+        slot->closed = true;
+    }
+
+    // main loop: the statistics are written by this thread
+    void publish_stats( FGIO::Channel* channel )
+    {
+        Slot* slot = find(channel);
+        SGGuard<SGMutex> g(_lock);
+        channel->latency.publish(channel->stats->getNode("latency-ms", true));
+        channel->jitter.publish(channel->stats->getNode("jitter-ms", true));
+        channel->stats->setIntValue("dropped-records", slot->dropped);
+    }
+
+    virtual void run()
+    {
+        FGFrameProfiler::set_thread_name("io");
+        for (;;) {
+            {
+                SGGuard<SGMutex> g(_lock);
+                if (_done) {
+                    break;
+                }
+            }
+
+            double now = SGTimeStamp::now().toSecs();
+            double next = now + 0.1;
+            for (unsigned int i = 0; i < _slots.size(); ++i) {
+                Slot* slot = _slots[i];
+                {
+                    SGGuard<SGMutex> g(_lock);
+                    if (slot->closed) {
+                        continue;
+                    }
+                }
+                if (now >= slot->next_due) {
+                    service(slot, now);
+                }
+                next = std::min(next, slot->next_due);
+            }
+
+            double wait = next - SGTimeStamp::now().toSecs();
+            if (wait > 0.0) {
+                SGTimeStamp::sleepFor(SGTimeStamp::fromSec(wait));
+            }
+        }
+        FGFrameProfiler::thread_exit();
+    }
+private:
+    // keep at most this many unparsed records per channel
+    static const unsigned int MAX_QUEUED_RECORDS = 256;
+
+    struct Slot
+    {
+        FGIO::Channel* channel;
+        double period;
+        double next_due;
+
+        // outgoing: generated (main loop) -> pending -> sending (I/O thread)
+        std::vector<char> generated, pending, sending;
+        bool fresh;
+
+        // incoming: received (I/O thread) -> parsing (main loop)
+        std::deque<string> received, parsing;
+        unsigned int dropped;
+
+        // errors, for the main loop to handle; closed by the main loop
+        unsigned int write_errors;
+        bool closed;
+        std::vector<char> scratch;
+    };
+
+    Slot* find( FGIO::Channel* channel ) const
+    {
+        for (unsigned int i = 0; i < _slots.size(); ++i) {
+            if (_slots[i]->channel == channel) {
+                return _slots[i];
+            }
+        }
+        return NULL;
+    }
+
+    void service( Slot* slot, double now )
+    {
+        FGProfileScope scope(slot->channel->profile);
+        FGProtocol* p = slot->channel->protocol;
+        SGIOChannel* io = p->get_io_channel();
+        SGTimeStamp st;
+        st.stamp();
+
+        if ((p->get_direction() == SG_IO_OUT) || (p->get_direction() == SG_IO_BI)) {
+            {
+                SGGuard<SGMutex> g(_lock);
+                if (slot->fresh) {
+                    slot->sending.swap(slot->pending);
+                    slot->fresh = false;
+                }
+            }
+
+            // resend the last message if the main loop is running slower
+            // than the channel, to keep the channel rate constant
+            if (!slot->sending.empty() &&
+                !io->write(&slot->sending[0], slot->sending.size())) {
+                SG_LOG( SG_IO, SG_WARN, "Error writing data." );
+                SGGuard<SGMutex> g(_lock);
+                ++slot->write_errors;
+            }
+        }
+
+        if ((p->get_direction() == SG_IO_IN) || (p->get_direction() == SG_IO_BI)) {
+            int n;
+            while ((n = p->read_record(&slot->scratch[0], slot->scratch.size())) > 0) {
+                SGGuard<SGMutex> g(_lock);
+                slot->received.push_back(string(&slot->scratch[0], n));
+                if (slot->received.size() > MAX_QUEUED_RECORDS) {
+                    slot->received.pop_front();
+                    ++slot->dropped;
+                }
+            }
+        }
+
+        double latency = st.elapsedMSec();
+        {
+            SGGuard<SGMutex> g(_lock);
+            slot->channel->latency.sample(latency);
+            if (slot->channel->last_service.toSecs() > 0.0) {
+                double interval = now - slot->channel->last_service.toSecs();
+                slot->channel->jitter.sample(fabs(interval - slot->period) * 1000.0);
+            }
+        }
+        slot->channel->last_service = SGTimeStamp::fromSec(now);
+
+        // don't try to catch up with missed deadlines in a burst
+        slot->next_due += slot->period;
+        if (slot->next_due < now) {
+            slot->next_due = now + slot->period;
+        }
+    }
+
+    std::vector<Slot*> _slots;
+    SGMutex _lock;
+    bool _done;
+};
+
+
+////////////////////////////////////////////////////////////////////////
+// FGIO
+////////////////////////////////////////////////////////////////////////
+
+FGIO::FGIO() :
+    _thread(NULL),
+    _statsCountdown(0.0)
 {
 }
 
@@ -352,6 +649,7 @@ FGIO::init()
     //         globals->get_channel_options_list()->size() << " requests." );
 
     _realDeltaTime = fgGetNode("/sim/time/delta-realtime-sec");
+    _stats = fgGetNode("/sim/io/stats", true);
 
     // we could almost do this in a single step except pushing a valid
     // port onto the port list copies the structure and destroys the
@@ -362,6 +660,10 @@ FGIO::init()
     for (; i != end; ++i ) {
         add_channel( *i );
     } // of channel options iteration
+
+    if (_thread) {
+        _thread->start();
+    }
 }
 
 // add another I/O channel
@@ -382,7 +684,24 @@ void FGIO::add_channel(const string& config)
         return;
     }
 
-    io_channels.push_back( p );
+    Channel* channel = new Channel;
+    channel->protocol = p;
+    channel->config = config;
+    channel->threaded = fgGetBool("/sim/io/threaded", false) &&
+        p->supports_threaded_io() && (p->get_hz() > 0.0);
+    channel->stats = _stats->getChild("channel", io_channels.size(), true);
+    channel->stats->setStringValue("config", config);
+    channel->stats->setBoolValue("threaded", channel->threaded);
+    channel->profile = FGFrameProfiler::counter("io", config);
+
+    if (channel->threaded) {
+        if (!_thread) {
+            _thread = new FGIOThread;
+        }
+        _thread->add_channel(channel);
+    }
+
+    io_channels.push_back( channel );
 }
 
 void
@@ -399,39 +718,106 @@ FGIO::update( double /* delta_time_sec */ )
     // see http://code.google.com/p/flightgear-bugs/issues/detail?id=125
     double delta_time_sec = _realDeltaTime->getDoubleValue();
 
-    ProtocolVec::iterator i = io_channels.begin();
-    ProtocolVec::iterator end = io_channels.end();
+    ChannelVec::iterator i = io_channels.begin();
+    ChannelVec::iterator end = io_channels.end();
     for (; i != end; ++i ) {
-        FGProtocol* p = *i;
+        Channel* c = *i;
+        FGProtocol* p = c->protocol;
         if (!p->is_enabled()) {
+            if (c->threaded) {
+                _thread->close_channel(c);
+            }
             continue;
         }
 
+        // records received by the I/O thread are applied as soon as
+        // possible, and its errors handled as process() would
+        if (c->threaded) {
+            _thread->parse_records(c);
+            if (_thread->take_write_errors(c)) {
+                p->write_failed();
+            }
+        }
+
         p->dec_count_down( delta_time_sec );
         double dt = 1 / p->get_hz();
         if ( p->get_count_down() < 0.33 * dt ) {
-            p->process();
+            if (c->threaded) {
+                if ((p->get_direction() == SG_IO_OUT) ||
+                    (p->get_direction() == SG_IO_BI)) {
+                    _thread->publish_message(c);
+                }
+            } else {
+                process_channel(*c);
+            }
             p->inc_count();
             while ( p->get_count_down() < 0.33 * dt ) {
                 p->inc_count_down( dt );
             }
         } // of channel processing
     } // of io_channels iteration
+
+    _statsCountdown -= delta_time_sec;
+    if (_statsCountdown <= 0.0) {
+        publish_stats();
+        _statsCountdown = 1.0;
+    }
+}
+
+void
+FGIO::process_channel( Channel& channel )
+{
+    FGProfileScope scope(channel.profile);
+    SGTimeStamp st;
+    st.stamp();
+    channel.protocol->process();
+    channel.latency.sample(st.elapsedMSec());
+
+    if (channel.last_service.toSecs() > 0.0) {
+        double interval = (st - channel.last_service).toSecs();
+        double period = 1.0 / channel.protocol->get_hz();
+        channel.jitter.sample(fabs(interval - period) * 1000.0);
+    }
+    channel.last_service = st;
+}
+
+void
+FGIO::publish_stats()
+{
+    ChannelVec::iterator i = io_channels.begin();
+    ChannelVec::iterator end = io_channels.end();
+    for (; i != end; ++i ) {
+        Channel* c = *i;
+        if (c->threaded) {
+            _thread->publish_stats(c);
+        } else {
+            c->latency.publish(c->stats->getNode("latency-ms", true));
+            c->jitter.publish(c->stats->getNode("jitter-ms", true));
+        }
+    }
 }
 
 void
 FGIO::shutdown()
 {
-    ProtocolVec::iterator i = io_channels.begin();
-    ProtocolVec::iterator end = io_channels.end();
+    // stop servicing channels before closing them
+    if (_thread) {
+        _thread->stop();
+        delete _thread;
+        _thread = NULL;
+    }
+
+    ChannelVec::iterator i = io_channels.begin();
+    ChannelVec::iterator end = io_channels.end();
     for (; i != end; ++i )
     {
-        FGProtocol *p = *i;
+        FGProtocol *p = (*i)->protocol;
         if ( p->is_enabled() ) {
             p->close();
         }
 
         delete p;
+        delete *i;
     }
 
     io_channels.clear();
@@ -28,11 +28,14 @@
 #include <simgear/compiler.h>
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include <vector>
 #include <string>
 
 class FGProtocol;
+class FGIOThread;
+class FGProfileCounter;
 
 class FGIO : public SGSubsystem
 {
@@ -48,20 +51,63 @@ public:
 
     void shutdown();
 
+    /**
+     * Latency/jitter histogram of one channel, published below
+     * /sim/io/stats.
+     */
+    class Histogram
+    {
+    public:
+        Histogram();
+        void sample( double msec );
+        void publish( SGPropertyNode* node ) const;
+    private:
+        static const int NUM_BUCKETS = 9;
+        static const double bucket_limits[NUM_BUCKETS - 1];
+        unsigned int buckets[NUM_BUCKETS];
+        unsigned int count;
+        double sum;
+        double max;
+    };
+
+    /**
+     * Per-channel state kept by FGIO. Channels serviced by the I/O thread
+     * are also listed there; their statistics are gathered by that thread.
+     */
+    struct Channel
+    {
+        FGProtocol* protocol;
+        std::string config;
+        bool threaded;
+        SGTimeStamp last_service;
+        Histogram latency;
+        Histogram jitter;
+        SGPropertyNode_ptr stats;
+        FGProfileCounter* profile;
+    };
+
 private:
 
     void add_channel(const std::string& config);
     FGProtocol* parse_port_config( const std::string& cfgstr );
 
+    void process_channel( Channel& channel );
+    void publish_stats();
+
 private:
 
     // define the global I/O channel list
     //io_container global_io_list;
     
-    typedef std::vector< FGProtocol* > ProtocolVec;
-    ProtocolVec io_channels;
+    typedef std::vector< Channel* > ChannelVec;
+    ChannelVec io_channels;
+
+    // services channels supporting it when /sim/io/threaded is set
+    FGIOThread* _thread;
     
     SGPropertyNode_ptr _realDeltaTime;
+    SGPropertyNode_ptr _stats;
+    double _statsCountdown;
 };
 
 
@@ -0,0 +1,476 @@
+// frame_profiler.cxx -- scoped timing of the main loop and its threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "frame_profiler.hxx"
+
+#include <ctype.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <map>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/misc/stdint.hxx>
+#include <simgear/structure/SGAtomic.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include "fg_props.hxx"
+
+#if defined(_MSC_VER)
+#  define FG_THREAD_LOCAL __declspec(thread)
+#else
+#  define FG_THREAD_LOCAL __thread
+#endif
+
+using std::string;
+using std::vector;
+
+// spans buffered per thread, a power of two
+static const unsigned int BUFFER_SIZE = 1 << 15;
+
+// durations per counter the percentiles are computed over
+static const unsigned int WINDOW_SIZE = 512;
+
+namespace {
+
+struct Span
+{
+    FGProfileCounter* counter;
+    int64_t start;      // usec
+    int64_t duration;   // usec
+};
+
+/**
+ * Spans recorded by one thread. Only that thread writes; readers copy
+ * what they need and discard anything overwritten while they copied.
+ */
+struct ThreadBuffer
+{
+    ThreadBuffer( unsigned int i ) :
+        id(i),
+        spans(BUFFER_SIZE),
+        published(0)
+    {
+    }
+
+    unsigned int id;
+    string name;
+    vector<Span> spans;
+    SGAtomic head;           // spans written so far
+    unsigned int published;  // spans fed to the counters, main loop only
+};
+
+// copy the spans written since 'from' that are still in the buffer, and
+// advance 'from' past them
+void read_spans( ThreadBuffer* buffer, unsigned int& from, vector<Span>& out )
+{
+    out.clear();
+    unsigned int head = buffer->head;
+    if (head - from > BUFFER_SIZE) {
+        from = head - BUFFER_SIZE;
+    }
+
+    for (unsigned int i = from; i != head; ++i) {
+        out.push_back(buffer->spans[i & (BUFFER_SIZE - 1)]);
+    }
+
+    // the writer may have wrapped around while we copied: span 'after' is
+    // being written to the slot of span after - BUFFER_SIZE, so that one
+    // and all spans before it may be torn
+    unsigned int after = buffer->head;
+    if (after - from >= BUFFER_SIZE) {
+        unsigned int lost = std::min<unsigned int>(after - from - BUFFER_SIZE + 1,
+                                                   out.size());
+        out.erase(out.begin(), out.begin() + lost);
+    }
+
+    // slots never written, when asked for a full buffer early on
+    unsigned int unused = 0;
+    while ((unused < out.size()) && !out[unused].counter) {
+        ++unused;
+    }
+    out.erase(out.begin(), out.begin() + unused);
+
+    from = head;
+}
+
+string property_name( const string& name )
+{
+    string result(name);
+    for (unsigned int i = 0; i < result.size(); ++i) {
+        char c = result[i];
+        if (!isalnum(c) && (c != '-') && (c != '_') && (c != '.')) {
+            result[i] = '_';
+        }
+    }
+
+    if (result.empty() || !(isalpha(result[0]) || (result[0] == '_'))) {
+        result = "_" + result;
+    }
+    return result;
+}
+
+void write_json_string( FILE* f, const string& s )
+{
+    fputc('"', f);
+    for (unsigned int i = 0; i < s.size(); ++i) {
+        unsigned char c = s[i];
+        if ((c == '"') || (c == '\\')) {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/**
+ * Stands in for a subsystem in the subsystem manager, timing its
+ * updates. FGGlobals::get_subsystem() returns the subsystem itself.
+ */
+class FGProfiledSubsystem : public SGSubsystem
+{
+public:
+    FGProfiledSubsystem( SGSubsystem* subsystem, FGProfileCounter* counter ) :
+        _subsystem(subsystem),
+        _counter(counter)
+    {
+    }
+
+    virtual ~FGProfiledSubsystem()
+    {
+        delete _subsystem;
+    }
+
+    SGSubsystem* subsystem() const { return _subsystem; }
+
+    virtual void init() { _subsystem->init(); }
+    virtual InitStatus incrementalInit() { return _subsystem->incrementalInit(); }
+    virtual void postinit() { _subsystem->postinit(); }
+    virtual void shutdown() { _subsystem->shutdown(); }
+    virtual void reinit() { _subsystem->reinit(); }
+    virtual void bind() { _subsystem->bind(); }
+    virtual void unbind() { _subsystem->unbind(); }
+
+    virtual void update( double dt )
+    {
+        FGProfileScope scope(_counter);
+        _subsystem->update(dt);
+    }
+
+    virtual void suspend() { _subsystem->suspend(); }
+    virtual void suspend( bool suspended ) { _subsystem->suspend(suspended); }
+    virtual void resume() { _subsystem->resume(); }
+    virtual bool is_suspended() const { return _subsystem->is_suspended(); }
+
+private:
+    SGSubsystem* _subsystem;
+    FGProfileCounter* _counter;
+};
+
+} // of anonymous namespace
+
+static SGMutex registry_lock;
+static vector<ThreadBuffer*> thread_buffers;
+static unsigned int thread_ids = 0;
+static std::map<string, FGProfileCounter*> counters;
+
+static FG_THREAD_LOCAL ThreadBuffer* thread_buffer = 0;
+
+static ThreadBuffer* get_thread_buffer()
+{
+    if (!thread_buffer) {
+        SGGuard<SGMutex> g(registry_lock);
+        thread_buffer = new ThreadBuffer(++thread_ids);
+        thread_buffers.push_back(thread_buffer);
+    }
+    return thread_buffer;
+}
+
+FGProfileCounter::FGProfileCounter( const string& category, const string& name ) :
+    _category(category),
+    _name(name),
+    _next(0),
+    _calls(0)
+{
+}
+
+bool FGFrameProfiler::_recording = false;
+bool FGFrameProfiler::_wrapping = false;
+
+FGFrameProfiler::FGFrameProfiler() :
+    _elapsed(0.0)
+{
+}
+
+FGFrameProfiler::~FGFrameProfiler()
+{
+    _recording = false;
+
+    SGGuard<SGMutex> g(registry_lock);
+    for (unsigned int i = 0; i < thread_buffers.size(); ++i) {
+        delete thread_buffers[i];
+    }
+    thread_buffers.clear();
+    thread_buffer = 0;
+}
+
+void
+FGFrameProfiler::init()
+{
+    _root = fgGetNode("/sim/performance", true);
+    _enabled = _root->getNode("profiler/enabled", true);
+    _interval = _root->getNode("profiler/interval-sec", true);
+    if (!_interval->hasValue()) {
+        _interval->setDoubleValue(1.0);
+    }
+
+    _last_update = SGTimeStamp::now();
+    set_thread_name("main");
+}
+
+void
+FGFrameProfiler::update( double )
+{
+    // counters are published at wall clock intervals, also when paused
+    SGTimeStamp now = SGTimeStamp::now();
+    double elapsed_sec = (now - _last_update).toSecs();
+    _last_update = now;
+
+    _recording = _enabled->getBoolValue();
+    if (!_recording) {
+        _elapsed = 0.0;
+        return;
+    }
+
+    // the lock keeps exiting threads from freeing their buffers meanwhile
+    {
+        SGGuard<SGMutex> g(registry_lock);
+        vector<Span> spans;
+        for (unsigned int i = 0; i < thread_buffers.size(); ++i) {
+            read_spans(thread_buffers[i], thread_buffers[i]->published, spans);
+            for (unsigned int j = 0; j < spans.size(); ++j) {
+                FGProfileCounter* c = spans[j].counter;
+                if (c->_window.size() < WINDOW_SIZE) {
+                    c->_window.push_back(spans[j].duration / 1000.0);
+                } else {
+                    c->_window[c->_next] = spans[j].duration / 1000.0;
+                    c->_next = (c->_next + 1) % WINDOW_SIZE;
+                }
+                ++c->_calls;
+            }
+        }
+    }
+
+    _elapsed += elapsed_sec;
+    if (_elapsed >= _interval->getDoubleValue()) {
+        publish(_elapsed);
+        _elapsed = 0.0;
+    }
+}
+
+void
+FGFrameProfiler::publish( double elapsed_sec )
+{
+    vector<FGProfileCounter*> all;
+    {
+        SGGuard<SGMutex> g(registry_lock);
+        std::map<string, FGProfileCounter*>::iterator it;
+        for (it = counters.begin(); it != counters.end(); ++it) {
+            all.push_back(it->second);
+        }
+    }
+
+    vector<float> sorted;
+    for (unsigned int i = 0; i < all.size(); ++i) {
+        FGProfileCounter* c = all[i];
+        if (c->_window.empty()) {
+            continue;
+        }
+
+        if (!c->_node) {
+            c->_node = _root->getNode(property_name(c->_category), true)
+                ->getNode(property_name(c->_name), true);
+        }
+
+        sorted = c->_window;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (unsigned int j = 0; j < sorted.size(); ++j) {
+            sum += sorted[j];
+        }
+
+        unsigned int n = sorted.size();
+        c->_node->setDoubleValue("p50-ms", sorted[(n - 1) * 50 / 100]);
+        c->_node->setDoubleValue("p95-ms", sorted[(n - 1) * 95 / 100]);
+        c->_node->setDoubleValue("p99-ms", sorted[(n - 1) * 99 / 100]);
+        c->_node->setDoubleValue("max-ms", sorted[n - 1]);
+        c->_node->setDoubleValue("mean-ms", sum / n);
+        c->_node->setDoubleValue("calls-per-sec",
+                                 elapsed_sec > 0.0 ? c->_calls / elapsed_sec : 0.0);
+        c->_calls = 0;
+    }
+}
+
+FGProfileCounter*
+FGFrameProfiler::counter( const string& category, const string& name )
+{
+    SGGuard<SGMutex> g(registry_lock);
+    string key = category + "/" + name;
+    std::map<string, FGProfileCounter*>::iterator it = counters.find(key);
+    if (it != counters.end()) {
+        return it->second;
+    }
+
+    FGProfileCounter* c = new FGProfileCounter(category, name);
+    counters[key] = c;
+    return c;
+}
+
+void
+FGFrameProfiler::record( FGProfileCounter* counter, const SGTimeStamp& start )
+{
+    ThreadBuffer* buffer = get_thread_buffer();
+    unsigned int head = buffer->head;
+    Span& span = buffer->spans[head & (BUFFER_SIZE - 1)];
+    span.counter = counter;
+    span.start = start.toUSecs();
+    span.duration = (SGTimeStamp::now() - start).toUSecs();
+    ++buffer->head;
+}
+
+void
+FGFrameProfiler::set_thread_name( const string& name )
+{
+    ThreadBuffer* buffer = get_thread_buffer();
+    SGGuard<SGMutex> g(registry_lock);
+    buffer->name = name;
+}
+
+void
+FGFrameProfiler::thread_exit()
+{
+    if (!thread_buffer) {
+        return;
+    }
+
+    SGGuard<SGMutex> g(registry_lock);
+    vector<ThreadBuffer*>::iterator it =
+        std::find(thread_buffers.begin(), thread_buffers.end(), thread_buffer);
+    if (it != thread_buffers.end()) {
+        thread_buffers.erase(it);
+    }
+    delete thread_buffer;
+    thread_buffer = 0;
+}
+
+bool
+FGFrameProfiler::export_trace( const SGPath& path )
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write trace to " << path.str());
+        return false;
+    }
+
+    // copy the spans and thread ids under the lock, since exiting threads
+    // free their buffers
+    vector<unsigned int> ids;
+    vector<string> names;
+    vector<vector<Span> > spans;
+    {
+        SGGuard<SGMutex> g(registry_lock);
+        spans.resize(thread_buffers.size());
+        for (unsigned int i = 0; i < thread_buffers.size(); ++i) {
+            ids.push_back(thread_buffers[i]->id);
+            names.push_back(thread_buffers[i]->name);
+            unsigned int from = (unsigned int) thread_buffers[i]->head - BUFFER_SIZE;
+            read_spans(thread_buffers[i], from, spans[i]);
+        }
+    }
+
+    int64_t origin = 0;
+    bool first = true;
+    for (unsigned int i = 0; i < spans.size(); ++i) {
+        for (unsigned int j = 0; j < spans[i].size(); ++j) {
+            if (first || (spans[i][j].start < origin)) {
+                origin = spans[i][j].start;
+                first = false;
+            }
+        }
+    }
+
+    unsigned int count = 0;
+    fputs("{\"traceEvents\":[\n", f);
+    for (unsigned int i = 0; i < spans.size(); ++i) {
+        string name = names[i].empty() ? "thread" : names[i];
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%u,\"args\":{\"name\":", i ? ",\n" : "",
+                ids[i]);
+        write_json_string(f, name);
+        fputs("}}", f);
+
+        for (unsigned int j = 0; j < spans[i].size(); ++j) {
+            const Span& s = spans[i][j];
+            fputs(",\n{\"name\":", f);
+            write_json_string(f, s.counter->name());
+            fputs(",\"cat\":", f);
+            write_json_string(f, s.counter->category());
+            fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}",
+                    ids[i], (long long) (s.start - origin),
+                    (long long) s.duration);
+            ++count;
+        }
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+
+    bool ok = !ferror(f);
+    fclose(f);
+    SG_LOG(SG_GENERAL, SG_INFO, "Wrote " << count << " profiler spans to "
+           << path.str());
+    return ok;
+}
+
+SGSubsystem*
+FGFrameProfiler::instrument( const char* name, SGSubsystem* subsystem )
+{
+    if (!fgGetBool("/sim/performance/profiler/subsystems", false)) {
+        return subsystem;
+    }
+
+    _wrapping = true;
+    return new FGProfiledSubsystem(subsystem, counter("subsystems", name));
+}
+
+SGSubsystem*
+FGFrameProfiler::unwrap( SGSubsystem* subsystem )
+{
+    if (!_wrapping || !subsystem) {
+        return subsystem;
+    }
+
+    FGProfiledSubsystem* wrapper = dynamic_cast<FGProfiledSubsystem*>(subsystem);
+    return wrapper ? wrapper->subsystem() : subsystem;
+}
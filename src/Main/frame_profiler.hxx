@@ -0,0 +1,157 @@
+// frame_profiler.hxx -- scoped timing of the main loop and its threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_FRAME_PROFILER_HXX
+#define _FG_FRAME_PROFILER_HXX
+
+#include <string>
+#include <vector>
+
+#include <simgear/compiler.h>
+#include <simgear/structure/subsystem_mgr.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+class SGPath;
+
+/**
+ * A named span type, such as the update of one subsystem. Counters are
+ * created once and live as long as the program; call sites keep the
+ * pointer.
+ */
+class FGProfileCounter
+{
+public:
+    FGProfileCounter( const std::string& category, const std::string& name );
+
+    const std::string& category() const { return _category; }
+    const std::string& name() const { return _name; }
+
+private:
+    friend class FGFrameProfiler;
+
+    std::string _category;
+    std::string _name;
+
+    // rolling window of the latest durations in msec, only used by
+    // the main loop
+    std::vector<float> _window;
+    unsigned int _next;
+    unsigned int _calls;
+    SGPropertyNode_ptr _node;
+};
+
+/**
+ * Collects timed spans from any thread into per-thread ring buffers,
+ * publishes rolling percentiles of every counter below /sim/performance
+ * and exports the buffered spans as a Chrome trace (chrome://tracing,
+ * or any viewer of the trace event JSON format).
+ *
+ * Recording is switched by /sim/performance/profiler/enabled; while it
+ * is off, a span costs a single flag test. Subsystem updates are only
+ * instrumented if /sim/performance/profiler/subsystems is set at
+ * startup, since this wraps each subsystem as it is added.
+ */
+class FGFrameProfiler : public SGSubsystem
+{
+public:
+    FGFrameProfiler();
+    virtual ~FGFrameProfiler();
+
+    virtual void init();
+    virtual void update( double dt );
+
+    static bool is_recording() { return _recording; }
+
+    /**
+     * The counter of that category and name, created on first use.
+     */
+    static FGProfileCounter* counter( const std::string& category,
+                                      const std::string& name );
+
+    /**
+     * Record a span of the calling thread, from start until now.
+     */
+    static void record( FGProfileCounter* counter, const SGTimeStamp& start );
+
+    /**
+     * Name the calling thread in exported traces.
+     */
+    static void set_thread_name( const std::string& name );
+
+    /**
+     * Free the span buffer of the calling thread, which is about to exit.
+     * The buffers of the threads still running when the profiler is
+     * destroyed are freed then.
+     */
+    static void thread_exit();
+
+    /**
+     * Write the spans currently buffered by all threads.
+     */
+    static bool export_trace( const SGPath& path );
+
+    /**
+     * Used when a subsystem is added: returns a wrapper timing its
+     * updates if subsystems are instrumented, otherwise the subsystem.
+     */
+    static SGSubsystem* instrument( const char* name, SGSubsystem* subsystem );
+
+    /**
+     * The subsystem a wrapper returned by instrument() stands for.
+     */
+    static SGSubsystem* unwrap( SGSubsystem* subsystem );
+
+private:
+    void publish( double elapsed_sec );
+
+    static bool _recording;
+    static bool _wrapping;
+
+    SGPropertyNode_ptr _enabled;
+    SGPropertyNode_ptr _interval;
+    SGPropertyNode_ptr _root;
+    SGTimeStamp _last_update;
+    double _elapsed;
+};
+
+/**
+ * Times the enclosing scope as one span of a counter.
+ */
+class FGProfileScope
+{
+public:
+    FGProfileScope( FGProfileCounter* counter ) :
+        _counter(FGFrameProfiler::is_recording() ? counter : 0)
+    {
+        if (_counter) {
+            _start.stamp();
+        }
+    }
+
+    ~FGProfileScope()
+    {
+        if (_counter) {
+            FGFrameProfiler::record(_counter, _start);
+        }
+    }
+
+private:
+    FGProfileCounter* _counter;
+    SGTimeStamp _start;
+};
+
+#endif // _FG_FRAME_PROFILER_HXX
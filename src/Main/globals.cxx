@@ -58,6 +58,7 @@
 
 #include "fg_props.hxx"
 #include "fg_io.hxx"
+#include "frame_profiler.hxx"
 
 class AircraftResourceProvider : public simgear::ResourceProvider
 {
@@ -187,7 +188,7 @@ FGGlobals::~FGGlobals()
     // deallocation of AIModel objects. To ensure we can safely
     // shut down all subsystems, make sure we take down the 
     // AIModels system first.
-    SGSubsystem* ai = subsystem_mgr->remove("ai-model");
+    SGSubsystem* ai = remove_subsystem("ai-model");
     if (ai) {
         ai->unbind();
         delete ai;
@@ -366,7 +367,7 @@ FGGlobals::get_subsystem_mgr () const
 SGSubsystem *
 FGGlobals::get_subsystem (const char * name)
 {
-    return subsystem_mgr->get_subsystem(name);
+    return FGFrameProfiler::unwrap(subsystem_mgr->get_subsystem(name));
 }
 
 void
@@ -375,14 +376,22 @@ FGGlobals::add_subsystem (const char * name,
                           SGSubsystemMgr::GroupType type,
                           double min_time_sec)
 {
-    subsystem_mgr->add(name, subsystem, type, min_time_sec);
+    subsystem_mgr->add(name, FGFrameProfiler::instrument(name, subsystem),
+                       type, min_time_sec);
+}
+
+SGSubsystem *
+FGGlobals::remove_subsystem (const char * name)
+{
+    return subsystem_mgr->remove(name);
 }
 
 SGSoundMgr *
 FGGlobals::get_soundmgr () const
 {
     if (subsystem_mgr)
-        return (SGSoundMgr*) subsystem_mgr->get_subsystem("sound");
+        return (SGSoundMgr*) FGFrameProfiler::unwrap(
+                                 subsystem_mgr->get_subsystem("sound"));
 
     return NULL;
 }
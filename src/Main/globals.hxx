@@ -167,6 +167,12 @@ public:
                                 type = SGSubsystemMgr::GENERAL,
                                 double min_time_sec = 0);
 
+    /**
+     * Take a subsystem out of the manager; the caller owns it, and it
+     * may be wrapped for the frame profiler.
+     */
+    virtual SGSubsystem *remove_subsystem (const char * name);
+
     virtual SGEventMgr *get_event_mgr () const;
 
     virtual SGSoundMgr *get_soundmgr () const;
@@ -8,16 +8,42 @@
 #endif
 
 #include "logger.hxx"
+#include "logger_binary.hxx"
+
+#include <string.h>
 
 #include <fstream>
 #include <string>
 
 #include <simgear/debug/logstream.hxx>
+#include <simgear/misc/stdint.hxx>
 
 #include "fg_props.hxx"
 
 using std::string;
-using std::endl;
+
+// records buffered for the writer thread of a binary log
+static const int DEFAULT_BUFFER_RECORDS = 1024;
+
+static FGBinaryLogFormat::Type
+binaryLogType (const SGPropertyNode * node)
+{
+  switch (node->getType()) {
+  case simgear::props::BOOL:  return FGBinaryLogFormat::TYPE_BOOL;
+  case simgear::props::INT:   return FGBinaryLogFormat::TYPE_INT;
+  case simgear::props::LONG:  return FGBinaryLogFormat::TYPE_LONG;
+  case simgear::props::FLOAT: return FGBinaryLogFormat::TYPE_FLOAT;
+  default:                    return FGBinaryLogFormat::TYPE_DOUBLE;
+  }
+}
+
+template <class T>
+static inline char *
+putValue (char * p, T value)
+{
+  memcpy(p, &value, sizeof(value));
+  return p + sizeof(value);
+}
 
 ////////////////////////////////////////////////////////////////////////
 // Implementation of FGLogger
@@ -29,6 +55,8 @@ FGLogger::FGLogger ()
 
 FGLogger::~FGLogger ()
 {
+  for (unsigned int i = 0; i < _logs.size(); i++)
+    delete _logs[i];
 }
 
 void
@@ -46,12 +74,19 @@ FGLogger::init ()
     if (!child->getBoolValue("enabled", false))
         continue;
 
-    _logs.push_back(Log());
-    Log &log = _logs[_logs.size()-1];
+    _logs.push_back(new Log);
+    Log &log = *_logs.back();
+
+    string format = child->getStringValue("format");
+    if (format.size() == 0) {
+        format = "csv";
+        child->setStringValue("format", format.c_str());
+    }
+    bool binary = (format == "binary");
     
     string filename = child->getStringValue("filename");
     if (filename.size() == 0) {
-        filename = "fg_log.csv";
+        filename = binary ? "fg_log.bin" : "fg_log.csv";
         child->setStringValue("filename", filename.c_str());
     }
 
@@ -64,17 +99,12 @@ FGLogger::init ()
     log.interval_ms = child->getLongValue("interval-ms");
     log.last_time_ms = globals->get_sim_time_sec() * 1000;
     log.delimiter = delimiter.c_str()[0];
-    log.output = new std::ofstream(filename.c_str());
-    if (!log.output) {
-      SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write log to " << filename);
-      continue;
-    }
 
     //
     // Process the individual entries (Time is automatic).
     //
     std::vector<SGPropertyNode_ptr> entries = child->getChildren("entry");
-    (*log.output) << "Time";
+    std::vector<string> titles;
     for (unsigned int j = 0; j < entries.size(); j++) {
       SGPropertyNode * entry = entries[j];
 
@@ -92,16 +122,50 @@ FGLogger::init ()
       SGPropertyNode * node =
 	fgGetNode(entry->getStringValue("property"), true);
       log.nodes.push_back(node);
-      (*log.output) << log.delimiter
-		    << entry->getStringValue("title", node->getPath().c_str());
+      titles.push_back(entry->getStringValue("title", node->getPath().c_str()));
     }
-    (*log.output) << endl;
+
+    if (binary) {
+      FGBinaryLogFormat columns;
+      for (unsigned int j = 0; j < log.nodes.size(); j++) {
+        FGBinaryLogFormat::Type type = binaryLogType(log.nodes[j]);
+        columns.addColumn(titles[j], log.nodes[j]->getPath(), type);
+        log.types.push_back(type);
+      }
+
+      int capacity = child->getIntValue("buffer-records", DEFAULT_BUFFER_RECORDS);
+      log.binary = new FGBinaryLogWriter(columns, capacity > 0 ? capacity : 1);
+      if (!log.binary->open(filename)) {
+        SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write log to " << filename);
+        delete log.binary;
+        log.binary = 0;
+        log.nodes.clear();
+        continue;
+      }
+
+      log.dropped = child->getNode("dropped-records", true);
+      log.dropped->setIntValue(0);
+      continue;
+    }
+
+    log.output = new std::ofstream(filename.c_str());
+    if (!(*log.output)) {
+      SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write log to " << filename);
+      continue;
+    }
+
+    (*log.output) << "Time";
+    for (unsigned int j = 0; j < titles.size(); j++)
+      (*log.output) << log.delimiter << titles[j];
+    (*log.output) << '\n';
   }
 }
 
 void
 FGLogger::reinit ()
 {
+    for (unsigned int i = 0; i < _logs.size(); i++)
+        delete _logs[i];
     _logs.clear();
     init();
 }
@@ -122,26 +186,75 @@ FGLogger::update (double dt)
     double sim_time_sec = globals->get_sim_time_sec();
     double sim_time_ms = sim_time_sec * 1000;
     for (unsigned int i = 0; i < _logs.size(); i++) {
-        while ((sim_time_ms - _logs[i].last_time_ms) >= _logs[i].interval_ms) {
-            _logs[i].last_time_ms += _logs[i].interval_ms;
-            (*_logs[i].output) << sim_time_sec;
-            for (unsigned int j = 0; j < _logs[i].nodes.size(); j++) {
-                (*_logs[i].output) << _logs[i].delimiter
-			   << _logs[i].nodes[j]->getStringValue();
+        Log &log = *_logs[i];
+        while ((sim_time_ms - log.last_time_ms) >= log.interval_ms) {
+            log.last_time_ms += log.interval_ms;
+            if (log.binary) {
+                writeBinaryRecord(log, sim_time_sec);
+                continue;
+            }
+
+            if (!log.output)
+                continue;
+
+            // no flush per row: the stream is flushed when its buffer
+            // fills up, and when the log is closed
+            (*log.output) << sim_time_sec;
+            for (unsigned int j = 0; j < log.nodes.size(); j++) {
+                (*log.output) << log.delimiter
+			   << log.nodes[j]->getStringValue();
             }
-            (*_logs[i].output) << endl;
+            (*log.output) << '\n';
+        }
+
+        if (log.binary) {
+            int dropped = log.binary->droppedRecords();
+            if (log.dropped->getIntValue() != dropped)
+                log.dropped->setIntValue(dropped);
         }
     }
 }
 
+void
+FGLogger::writeBinaryRecord (Log &log, double sim_time_sec)
+{
+    char * p = log.binary->beginRecord();
+    if (!p)
+        return;			// the writer thread is behind, counted as dropped
+
+    p = putValue(p, sim_time_sec);
+    for (unsigned int j = 0; j < log.nodes.size(); j++) {
+        SGPropertyNode * node = log.nodes[j];
+        switch (log.types[j]) {
+        case FGBinaryLogFormat::TYPE_BOOL:
+            p = putValue<uint8_t>(p, node->getBoolValue() ? 1 : 0);
+            break;
+        case FGBinaryLogFormat::TYPE_INT:
+            p = putValue<int32_t>(p, node->getIntValue());
+            break;
+        case FGBinaryLogFormat::TYPE_LONG:
+            p = putValue<int64_t>(p, node->getLongValue());
+            break;
+        case FGBinaryLogFormat::TYPE_FLOAT:
+            p = putValue<float>(p, node->getFloatValue());
+            break;
+        default:
+            p = putValue<double>(p, node->getDoubleValue());
+            break;
+        }
+    }
+    log.binary->commitRecord();
+}
+
+
 
-
 ////////////////////////////////////////////////////////////////////////
 // Implementation of FGLogger::Log
 ////////////////////////////////////////////////////////////////////////
 
 FGLogger::Log::Log ()
   : output(0),
+    binary(0),
     interval_ms(0),
     last_time_ms(-999999.0),
     delimiter(',')
@@ -151,6 +264,7 @@ FGLogger::Log::Log ()
 FGLogger::Log::~Log ()
 {
   delete output;
+  delete binary;		// writes out the queued records
 }
 
 // end of logger.cxx
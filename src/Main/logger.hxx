@@ -13,8 +13,10 @@
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/props/props.hxx>
 
+class FGBinaryLogWriter;
+
 /**
- * Log any property values to any number of CSV files.
+ * Log any property values to any number of CSV or binary files.
  */
 class FGLogger : public SGSubsystem
 {
@@ -40,12 +42,20 @@ private:
     virtual ~Log ();
     std::vector<SGPropertyNode_ptr> nodes;
     std::ostream * output;
+    FGBinaryLogWriter * binary;	// instead of output, in binary format
+    std::vector<int> types;	// of the binary columns
+    SGPropertyNode_ptr dropped;
     long interval_ms;
     double last_time_ms;
     char delimiter;
+  private:
+    Log (const Log &);		// not implemented
+    Log & operator= (const Log &);
   };
 
-  std::vector<Log> _logs;
+  void writeBinaryRecord (Log &log, double sim_time_sec);
+
+  std::vector<Log *> _logs;
 
 };
 
@@ -0,0 +1,249 @@
+// logger_binary.cxx - binary log files written by FGLogger.
+//
+// This file is in the Public Domain, and comes with no warranty.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "logger_binary.hxx"
+
+#include <string.h>
+
+#include <simgear/misc/stdint.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+using std::string;
+
+static const char MAGIC[8] = { 'F', 'G', 'B', 'I', 'N', 'L', 'O', 'G' };
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// how often the writer thread drains the ring buffer
+static const int WRITE_INTERVAL_MS = 20;
+
+static bool
+writeUInt32 (FILE *file, uint32_t value)
+{
+  return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool
+readUInt32 (FILE *file, uint32_t &value)
+{
+  return fread(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool
+writeString (FILE *file, const string &s)
+{
+  uint16_t length = s.size() > 0xffff ? 0xffff : s.size();
+  return (fwrite(&length, sizeof(length), 1, file) == 1) &&
+    (fwrite(s.data(), 1, length, file) == length);
+}
+
+static bool
+readString (FILE *file, string &s)
+{
+  uint16_t length;
+  if (fread(&length, sizeof(length), 1, file) != 1)
+    return false;
+
+  s.resize(length);
+  return (length == 0) || (fread(&s[0], 1, length, file) == length);
+}
+
+
+////////////////////////////////////////////////////////////////////////
+// Implementation of FGBinaryLogFormat
+////////////////////////////////////////////////////////////////////////
+
+FGBinaryLogFormat::FGBinaryLogFormat ()
+  : _recordSize(sizeof(double))	// the time
+{
+}
+
+void
+FGBinaryLogFormat::addColumn (const string &title, const string &path,
+                              Type type)
+{
+  Column column;
+  column.title = title;
+  column.path = path;
+  column.type = type;
+  column.offset = _recordSize;
+  _columns.push_back(column);
+  _recordSize += typeSize(type);
+}
+
+bool
+FGBinaryLogFormat::writeHeader (FILE *file) const
+{
+  if ((fwrite(MAGIC, sizeof(MAGIC), 1, file) != 1) ||
+      !writeUInt32(file, VERSION) ||
+      !writeUInt32(file, BYTE_ORDER_MARK) ||
+      !writeUInt32(file, _columns.size()) ||
+      !writeUInt32(file, _recordSize))
+    return false;
+
+  for (unsigned int i = 0; i < _columns.size(); i++) {
+    uint8_t type = _columns[i].type;
+    if ((fwrite(&type, sizeof(type), 1, file) != 1) ||
+        !writeString(file, _columns[i].title) ||
+        !writeString(file, _columns[i].path))
+      return false;
+  }
+
+  return true;
+}
+
+bool
+FGBinaryLogFormat::readHeader (FILE *file)
+{
+  _columns.clear();
+  _recordSize = sizeof(double);
+
+  char magic[sizeof(MAGIC)];
+  uint32_t version, byteOrder, count, recordSize;
+  if ((fread(magic, sizeof(magic), 1, file) != 1) ||
+      memcmp(magic, MAGIC, sizeof(MAGIC)) ||
+      !readUInt32(file, version) || (version != VERSION) ||
+      !readUInt32(file, byteOrder) || (byteOrder != BYTE_ORDER_MARK) ||
+      !readUInt32(file, count) ||
+      !readUInt32(file, recordSize))
+    return false;
+
+  for (unsigned int i = 0; i < count; i++) {
+    uint8_t type;
+    string title, path;
+    if ((fread(&type, sizeof(type), 1, file) != 1) ||
+        (typeSize((Type) type) == 0) ||
+        !readString(file, title) ||
+        !readString(file, path))
+      return false;
+
+    addColumn(title, path, (Type) type);
+  }
+
+  return _recordSize == recordSize;
+}
+
+unsigned int
+FGBinaryLogFormat::typeSize (Type type)
+{
+  switch (type) {
+  case TYPE_BOOL:   return sizeof(uint8_t);
+  case TYPE_INT:    return sizeof(int32_t);
+  case TYPE_LONG:   return sizeof(int64_t);
+  case TYPE_FLOAT:  return sizeof(float);
+  case TYPE_DOUBLE: return sizeof(double);
+  }
+  return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+// Implementation of FGBinaryLogWriter
+////////////////////////////////////////////////////////////////////////
+
+FGBinaryLogWriter::FGBinaryLogWriter (const FGBinaryLogFormat &format,
+                                      unsigned int capacity)
+  : _format(format),
+    _file(0),
+    _capacity(1),
+    _dropped(0)
+{
+  while (_capacity < capacity)
+    _capacity <<= 1;
+  _buffer.resize(_capacity * _format.recordSize());
+}
+
+FGBinaryLogWriter::~FGBinaryLogWriter ()
+{
+  close();
+}
+
+bool
+FGBinaryLogWriter::open (const string &filename)
+{
+  _file = fopen(filename.c_str(), "wb");
+  if (!_file)
+    return false;
+
+  if (!_format.writeHeader(_file)) {
+    fclose(_file);
+    _file = 0;
+    return false;
+  }
+
+  start();
+  return true;
+}
+
+void
+FGBinaryLogWriter::close ()
+{
+  if (!_file)
+    return;
+
+  ++_done;
+  join();
+
+  fclose(_file);
+  _file = 0;
+}
+
+char *
+FGBinaryLogWriter::beginRecord ()
+{
+  unsigned int head = _head;
+  if (head - (unsigned int) _tail >= _capacity) {
+    ++_dropped;
+    return 0;
+  }
+
+  return &_buffer[(head & (_capacity - 1)) * _format.recordSize()];
+}
+
+void
+FGBinaryLogWriter::commitRecord ()
+{
+  ++_head;
+}
+
+void
+FGBinaryLogWriter::run ()
+{
+  while (!_done) {
+    drain();
+    SGTimeStamp::sleepForMSec(WRITE_INTERVAL_MS);
+  }
+
+  drain();
+  fflush(_file);
+}
+
+void
+FGBinaryLogWriter::drain ()
+{
+  unsigned int head = _head;
+  unsigned int tail = _tail;
+  unsigned int size = _format.recordSize();
+
+  while (tail != head) {
+    // write up to the end of the queued records or of the buffer,
+    // whichever comes first
+    unsigned int index = tail & (_capacity - 1);
+    unsigned int count = head - tail;
+    if (index + count > _capacity)
+      count = _capacity - index;
+
+    fwrite(&_buffer[index * size], size, count, _file);
+
+    // only this thread moves the tail, so the exchange always succeeds;
+    // it publishes the freed space to the main loop
+    _tail.compareAndExchange(tail, tail + count);
+    tail += count;
+  }
+}
+
+// end of logger_binary.cxx
@@ -0,0 +1,129 @@
+// logger_binary.hxx - binary log files written by FGLogger.
+//
+// This file is in the Public Domain, and comes with no warranty.
+
+#ifndef __LOGGER_BINARY_HXX
+#define __LOGGER_BINARY_HXX 1
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <simgear/compiler.h>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/structure/SGAtomic.hxx>
+
+/**
+ * Layout of a binary log file.
+ *
+ * The file starts with a header: the magic "FGBINLOG", then the uint32
+ * fields version, byte order mark (0x01020304 as written), column
+ * count and record size. Each column follows as a uint8 type and the
+ * title and property path, each a uint16 length plus characters.
+ *
+ * Fixed-size records follow the header, in the byte order of the
+ * machine that wrote them: the simulation time in seconds as a double,
+ * then one value per column, packed without padding.
+ */
+class FGBinaryLogFormat
+{
+public:
+
+  enum Type {
+    TYPE_BOOL = 1,		// uint8, 0 or 1
+    TYPE_INT = 2,		// int32
+    TYPE_LONG = 3,		// int64
+    TYPE_FLOAT = 4,
+    TYPE_DOUBLE = 5
+  };
+
+  struct Column {
+    std::string title;
+    std::string path;
+    Type type;
+    unsigned int offset;	// within a record
+  };
+
+  static const unsigned int VERSION = 1;
+
+  FGBinaryLogFormat ();
+
+  void addColumn (const std::string &title, const std::string &path, Type type);
+
+  const std::vector<Column> &columns () const { return _columns; }
+  unsigned int recordSize () const { return _recordSize; }
+
+  bool writeHeader (FILE *file) const;
+
+  /**
+   * Read the header of a log file, replacing any columns. Returns false
+   * if this is not a binary log, or was written by an incompatible
+   * version or machine.
+   */
+  bool readHeader (FILE *file);
+
+  static unsigned int typeSize (Type type);
+
+private:
+  std::vector<Column> _columns;
+  unsigned int _recordSize;
+};
+
+/**
+ * Writes the records of one binary log from a background thread.
+ *
+ * The main loop fills records in place in a single-producer,
+ * single-consumer ring buffer; the thread drains it to the file every
+ * few milliseconds. Neither side ever waits for the other: when the
+ * buffer is full, the record is dropped and counted.
+ */
+class FGBinaryLogWriter : public SGThread
+{
+public:
+
+  FGBinaryLogWriter (const FGBinaryLogFormat &format, unsigned int capacity);
+  virtual ~FGBinaryLogWriter ();
+
+  /**
+   * Open the file and write the header; the thread is started on
+   * success.
+   */
+  bool open (const std::string &filename);
+
+  /**
+   * Stop the thread once everything queued so far is written, and
+   * close the file.
+   */
+  void close ();
+
+  /**
+   * Main loop: the next free record, or 0 if the buffer is full. The
+   * record is handed to the thread by commitRecord().
+   */
+  char *beginRecord ();
+  void commitRecord ();
+
+  unsigned int droppedRecords () const { return _dropped; }
+
+protected:
+  virtual void run ();
+
+private:
+  void drain ();
+
+  FGBinaryLogFormat _format;
+  FILE *_file;
+  std::vector<char> _buffer;
+  unsigned int _capacity;	// in records, a power of two
+
+  // counts of records committed and written; only ever increase, the
+  // ring position is the count modulo the capacity
+  SGAtomic _head;
+  SGAtomic _tail;
+  SGAtomic _done;
+
+  unsigned int _dropped;
+};
+
+#endif // __LOGGER_BINARY_HXX
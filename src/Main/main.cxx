@@ -58,6 +58,7 @@
 
 #include "fg_commands.hxx"
 #include "fg_io.hxx"
+#include "frame_profiler.hxx"
 #include "main.hxx"
 #include "util.hxx"
 #include "fg_init.hxx"
@@ -93,7 +94,11 @@ static void fgMainLoop( void )
     timeMgr->computeTimeDeltas(sim_dt, real_dt);
 
     // update all subsystems
-    globals->get_subsystem_mgr()->update(sim_dt);
+    static FGProfileCounter* frame = FGFrameProfiler::counter("main-loop", "frame");
+    {
+        FGProfileScope scope(frame);
+        globals->get_subsystem_mgr()->update(sim_dt);
+    }
 
     simgear::AtomicChangeListener::fireChangeListeners();
 
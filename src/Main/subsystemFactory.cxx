@@ -140,7 +140,7 @@ do_add_subsystem (const SGPropertyNode * arg)
         name =  subsystem;
     }
   
-    if (globals->get_subsystem_mgr()->get_subsystem(name)) {
+    if (globals->get_subsystem(name.c_str())) {
         SG_LOG(SG_GENERAL, SG_ALERT, "do_add_subsystem:" 
             << "duplicate subsystem name:" << name);
       return false;
@@ -178,7 +178,7 @@ static bool do_remove_subsystem(const SGPropertyNode * arg)
 {
   std::string name = arg->getStringValue("subsystem");
   
-  SGSubsystem* instance = globals->get_subsystem_mgr()->get_subsystem(name);
+  SGSubsystem* instance = globals->get_subsystem(name.c_str());
   if (!instance) {
     SG_LOG(SG_GENERAL, SG_ALERT, "do_remove_subsystem: unknown subsytem:" << name);
     return false;
@@ -188,11 +188,9 @@ static bool do_remove_subsystem(const SGPropertyNode * arg)
   instance->shutdown();
   instance->unbind();
 
-  // unplug from the manager
-  globals->get_subsystem_mgr()->remove(name.c_str());
-  
-  // and finally kill off the instance.
-  delete instance;
+  // unplug from the manager, or from its subsystem lane, and finally
+  // kill off the instance (which may be wrapped for profiling)
+  delete globals->remove_subsystem(name.c_str());
   
   return true;
 }
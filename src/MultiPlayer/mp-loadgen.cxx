@@ -0,0 +1,179 @@
+// mp-loadgen - send the position messages of many simulated multiplayer
+// peers to a running FlightGear, to load its multiplayer receiver.
+//
+// Start FlightGear with --multiplay=in,<rate>,<host>,<port> and run
+//   mp-loadgen <host> <port> <peers> [rate [seconds]]
+// The peers fly circles of different radius around KSFO.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simgear/io/raw_socket.hxx>
+#include <simgear/math/SGMath.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "mpmessages.hxx"
+
+// as in multiplaymgr.cxx
+#define MAX_PACKET_SIZE 1200
+
+// surface positions, as in the property id table of multiplaymgr.cxx
+static const unsigned sPropertyIds[] = { 100, 101, 102, 103, 104 };
+static const unsigned sNumProperties =
+  sizeof(sPropertyIds) / sizeof(sPropertyIds[0]);
+
+struct Peer {
+  char callsign[MAX_CALLSIGN_LEN];
+  double radius;     // of its circle, meters
+  double phase;      // radians
+};
+
+// encode the message of a peer at time t, return its length
+static unsigned
+encode(char* buf, const Peer& peer, const SGGeod& center, double t)
+{
+  T_MsgHdr* hdr = reinterpret_cast<T_MsgHdr*>(buf);
+  T_PositionMsg* pos = reinterpret_cast<T_PositionMsg*>(buf + sizeof(T_MsgHdr));
+  xdr_data_t* props = reinterpret_cast<xdr_data_t*>(buf + sizeof(T_MsgHdr)
+                                                    + sizeof(T_PositionMsg));
+
+  // fly the circle at 60 m/s
+  double omega = 60.0 / peer.radius;
+  double angle = peer.phase + omega * t;
+  double north = peer.radius * cos(angle);
+  double east = peer.radius * sin(angle);
+  SGGeod geod = SGGeod::fromRadM(center.getLongitudeRad()
+                                 + east / (SG_RAD_TO_NM * SG_NM_TO_METER
+                                           * cos(center.getLatitudeRad())),
+                                 center.getLatitudeRad()
+                                 + north / (SG_RAD_TO_NM * SG_NM_TO_METER),
+                                 center.getElevationM());
+  SGVec3d position = SGVec3d::fromGeod(geod);
+
+  SGQuatf qEc2Hl = SGQuatf::fromLonLatRad((float)geod.getLongitudeRad(),
+                                          (float)geod.getLatitudeRad());
+  float heading = (float)(angle + 0.5 * SGD_PI);
+  float roll = (float)atan(60.0 * omega / 9.81);
+  SGQuatf orientation = qEc2Hl*SGQuatf::fromYawPitchRoll(heading, 0, roll);
+  SGVec3f angleAxis;
+  orientation.getAngleAxis(angleAxis);
+
+  memset(pos->Model, 0, MAX_MODEL_NAME_LEN);
+  strncpy(pos->Model, "Aircraft/c172p/Models/c172p.xml", MAX_MODEL_NAME_LEN - 1);
+  pos->time = XDR_encode_double(t);
+  pos->lag = XDR_encode_double(0.1);
+  for (unsigned i = 0; i < 3; ++i) {
+    pos->position[i] = XDR_encode_double(position(i));
+    pos->orientation[i] = XDR_encode_float(angleAxis(i));
+    pos->linearVel[i] = XDR_encode_float(i == 0 ? 60.0f : 0.0f);
+    pos->angularVel[i] = XDR_encode_float(i == 2 ? (float)omega : 0.0f);
+    pos->linearAccel[i] = XDR_encode_float(0.0);
+    pos->angularAccel[i] = XDR_encode_float(0.0);
+  }
+  pos->pad = 0;
+
+  xdr_data_t* ptr = props;
+  for (unsigned i = 0; i < sNumProperties; ++i) {
+    *ptr++ = XDR_encode_uint32(sPropertyIds[i]);
+    *ptr++ = XDR_encode_float((float)sin(angle + i));
+  }
+
+  unsigned len = reinterpret_cast<char*>(ptr) - buf;
+  hdr->Magic = XDR_encode_uint32(MSG_MAGIC);
+  hdr->Version = XDR_encode_uint32(PROTO_VER);
+  hdr->MsgId = XDR_encode_uint32(POS_DATA_ID);
+  hdr->MsgLen = XDR_encode_uint32(len);
+  hdr->ReplyAddress = 0;
+  hdr->ReplyPort = 0;
+  memcpy(hdr->Callsign, peer.callsign, MAX_CALLSIGN_LEN);
+  return len;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 4) {
+    fprintf(stderr, "Usage: mp-loadgen <host> <port> <peers> [rate [seconds]]\n");
+    return EXIT_FAILURE;
+  }
+
+  const char* host = argv[1];
+  int port = atoi(argv[2]);
+  unsigned numPeers = atoi(argv[3]);
+  double rate = argc > 4 ? atof(argv[4]) : 10.0;
+  double duration = argc > 5 ? atof(argv[5]) : 60.0;
+  if ((numPeers == 0) || (rate <= 0.0)) {
+    fprintf(stderr, "mp-loadgen: need at least one peer and a positive rate\n");
+    return EXIT_FAILURE;
+  }
+
+  simgear::Socket socket;
+  if (!socket.open(false)) {
+    fprintf(stderr, "mp-loadgen: cannot open socket\n");
+    return EXIT_FAILURE;
+  }
+  simgear::IPAddress address(host, port);
+
+  // KSFO 28R
+  SGGeod center = SGGeod::fromDegM(-122.3576, 37.6135, 600.0);
+
+  Peer* peers = new Peer[numPeers];
+  for (unsigned i = 0; i < numPeers; ++i) {
+    memset(peers[i].callsign, 0, MAX_CALLSIGN_LEN);
+    snprintf(peers[i].callsign, MAX_CALLSIGN_LEN, "LG%05u", i);
+    peers[i].radius = 1000.0 + 100.0 * (i % 50);
+    peers[i].phase = 2.0 * SGD_PI * i / numPeers;
+  }
+
+  printf("Sending %u peers at %.1f Hz to %s:%d for %.0f s\n",
+         numPeers, rate, host, port, duration);
+
+  char buf[MAX_PACKET_SIZE];
+  unsigned long sent = 0, failed = 0;
+  SGTimeStamp start;
+  start.stamp();
+  double period = 1.0 / rate;
+  for (unsigned long frame = 0; ; ++frame) {
+    double t = frame * period;
+    if (t >= duration)
+      break;
+
+    for (unsigned i = 0; i < numPeers; ++i) {
+      unsigned len = encode(buf, peers[i], center, t);
+      if (socket.sendto(buf, len, 0, &address) < 0)
+        ++failed;
+      else
+        ++sent;
+    }
+
+    double ahead = t + period - (SGTimeStamp::now() - start).toSecs();
+    if (ahead > 0.0)
+      SGTimeStamp::sleepFor(SGTimeStamp::fromSec(ahead));
+  }
+
+  double elapsed = (SGTimeStamp::now() - start).toSecs();
+  printf("%lu packets sent, %lu failed in %.1f s (%.0f packets/s)\n",
+         sent, failed, elapsed, elapsed > 0.0 ? sent / elapsed : 0.0);
+
+  delete [] peers;
+  socket.close();
+  return EXIT_SUCCESS;
+}
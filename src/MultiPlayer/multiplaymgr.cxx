@@ -266,8 +266,24 @@ namespace
   };    
 }
 
+// The entry of each property id, looked up for every property of every
+// position message. Built by init(), before the receiver thread starts.
+static std::vector<const IdPropertyList*> sPropertyIndex;
+
+static void buildPropertyIndex()
+{
+  if (!sPropertyIndex.empty())
+    return;
+  sPropertyIndex.resize(sIdPropertyList[numProperties - 1].id + 1, 0);
+  for (unsigned i = 0; i < numProperties; ++i)
+    sPropertyIndex[sIdPropertyList[i].id] = &sIdPropertyList[i];
+}
+
 const IdPropertyList* findProperty(unsigned id)
 {
+  if (!sPropertyIndex.empty())
+    return id < sPropertyIndex.size() ? sPropertyIndex[id] : 0;
+
   std::pair<const IdPropertyList*, const IdPropertyList*> result
     = std::equal_range(sIdPropertyList, sIdPropertyList + numProperties, id,
                        ComparePropertyId());
@@ -363,6 +379,69 @@ private:
   FGMultiplayMgr* _multiplay;
 };
 
+//////////////////////////////////////////////////////////////////////
+//
+//  A message received and decoded by the receiver thread, waiting to
+//  be processed by the main loop.
+//
+//////////////////////////////////////////////////////////////////////
+struct FGMultiplayMgr::ReceivedMsg
+{
+  unsigned MsgId;       // CHAT_MSG_ID or POS_DATA_ID
+  string Callsign;
+  string Model;         // position messages only
+  string Text;          // chat messages only
+  FGExternalMotionData MotionInfo;
+};
+
+//////////////////////////////////////////////////////////////////////
+//
+//  Reads the receive socket in a thread of its own and decodes the
+//  messages into a single-producer, single-consumer ring buffer that
+//  the main loop drains every frame. When the main loop falls behind
+//  and the buffer is full, further messages are dropped and counted.
+//
+//////////////////////////////////////////////////////////////////////
+class FGMultiplayMgr::Receiver : public SGThread
+{
+public:
+  Receiver(FGMultiplayMgr* mgr, simgear::Socket* socket, unsigned capacity);
+  virtual ~Receiver();
+
+  void start() { mRunning = true; SGThread::start(); }
+
+  // stop the thread; messages already queued stay available
+  void stop();
+
+  // main loop: the oldest queued message, or 0; pop() releases it
+  ReceivedMsg* front();
+  void pop();
+
+  unsigned received() const { return mReceived; }
+  unsigned dropped() const { return mDropped; }
+
+protected:
+  virtual void run();
+
+private:
+  void receive();
+
+  FGMultiplayMgr* mMgr;
+  simgear::Socket* mSocket;
+  std::vector<ReceivedMsg> mQueue;
+  unsigned mCapacity;   // a power of two
+
+  // messages queued and processed so far; the ring position is the
+  // count modulo the capacity
+  SGAtomic mHead;
+  SGAtomic mTail;
+  SGAtomic mDone;
+
+  SGAtomic mReceived;
+  SGAtomic mDropped;
+  bool mRunning;
+};
+
 //////////////////////////////////////////////////////////////////////
 //
 //  MultiplayMgr constructor
@@ -373,6 +452,9 @@ FGMultiplayMgr::FGMultiplayMgr()
   mInitialised   = false;
   mHaveServer    = false;
   mListener = NULL;
+  mDecoded = 0;
+  mExpiredApplied = 0;
+  mExpiredSkipped = 0;
 } // FGMultiplayMgr::FGMultiplayMgr()
 //////////////////////////////////////////////////////////////////////
 
@@ -383,7 +465,7 @@ FGMultiplayMgr::FGMultiplayMgr()
 //////////////////////////////////////////////////////////////////////
 FGMultiplayMgr::~FGMultiplayMgr() 
 {
-  
+  mReceiver.reset();
 } // FGMultiplayMgr::~FGMultiplayMgr()
 //////////////////////////////////////////////////////////////////////
 
@@ -470,6 +552,16 @@ FGMultiplayMgr::init (void)
     return;
   }
   
+  mPacketsReceived = fgGetNode("/sim/multiplay/stats/packets-received", true);
+  mPacketsDropped = fgGetNode("/sim/multiplay/stats/packets-dropped", true);
+  mPropertiesDecoded = fgGetNode("/sim/multiplay/stats/properties-decoded", true);
+  mPropertiesApplied = fgGetNode("/sim/multiplay/stats/properties-applied", true);
+  mPropertiesSkipped = fgGetNode("/sim/multiplay/stats/properties-skipped", true);
+  buildPropertyIndex();
+  mReceiver.reset(new Receiver(this, mSocket.get(),
+                               fgGetInt("/sim/multiplay/rx-queue-size", 1024)));
+  mReceiver->start();
+
   mPropertiesChanged = true;
   mListener = new MPPropertyListener(this);
   globals->get_props()->addChangeListener(mListener, false);
@@ -498,6 +590,11 @@ FGMultiplayMgr::shutdown (void)
 {
   fgSetBool("/sim/multiplay/online", false);
   
+  if (mReceiver.get()) {
+    mReceiver->stop();
+    mReceiver.reset();
+  }
+
   if (mSocket.get()) {
     mSocket->close();
     mSocket.reset(); 
@@ -854,101 +951,30 @@ FGMultiplayMgr::update(double dt)
   }
 
   //////////////////////////////////////////////////
-  //  Read the receive socket and process any data
+  //  Process the messages decoded by the receiver
+  //  thread since the last frame
   //////////////////////////////////////////////////
-  ssize_t bytes;
-  do {
-    MsgBuf msgBuf;
-    //////////////////////////////////////////////////
-    //  Although the recv call asks for 
-    //  MAX_PACKET_SIZE of data, the number of bytes
-    //  returned will only be that of the next
-    //  packet waiting to be processed.
-    //////////////////////////////////////////////////
-    simgear::IPAddress SenderAddress;
-    int RecvStatus = mSocket->recvfrom(msgBuf.Msg, sizeof(msgBuf.Msg), 0,
-                              &SenderAddress);
-    //////////////////////////////////////////////////
-    //  no Data received
-    //////////////////////////////////////////////////
-    if (RecvStatus == 0)
-        break;
-
-    // socket error reported?
-    // errno isn't thread-safe - so only check its value when
-    // socket return status < 0 really indicates a failure.
-    if ((RecvStatus < 0)&&
-        ((errno == EAGAIN) || (errno == 0))) // MSVC output "NoError" otherwise
-    {
-        // ignore "normal" errors
-        break;
+  if (mReceiver.get()) {
+    while (ReceivedMsg* msg = mReceiver->front()) {
+      if (msg->MsgId == CHAT_MSG_ID)
+        ProcessChatMsg(*msg);
+      else
+        ProcessPosMsg(*msg, stamp);
+      mReceiver->pop();
     }
-
-    if (RecvStatus<0)
-    {
-        SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - Unable to receive data. "
-               << strerror(errno) << "(errno " << errno << ")");
-        break;
-    }
-
-    // status is positive: bytes received
-    bytes = (ssize_t) RecvStatus;
-    if (bytes <= static_cast<ssize_t>(sizeof(T_MsgHdr))) {
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "received message with insufficient data" );
-      break;
-    }
-    //////////////////////////////////////////////////
-    //  Read header
-    //////////////////////////////////////////////////
-    T_MsgHdr* MsgHdr = msgBuf.msgHdr();
-    MsgHdr->Magic       = XDR_decode_uint32 (MsgHdr->Magic);
-    MsgHdr->Version     = XDR_decode_uint32 (MsgHdr->Version);
-    MsgHdr->MsgId       = XDR_decode_uint32 (MsgHdr->MsgId);
-    MsgHdr->MsgLen      = XDR_decode_uint32 (MsgHdr->MsgLen);
-    MsgHdr->ReplyPort   = XDR_decode_uint32 (MsgHdr->ReplyPort);
-    MsgHdr->Callsign[MAX_CALLSIGN_LEN -1] = '\0';
-    if (MsgHdr->Magic != MSG_MAGIC) {
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "message has invalid magic number!" );
-      break;
-    }
-    if (MsgHdr->Version != PROTO_VER) {
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "message has invalid protocol number!" );
-      break;
-    }
-    if (static_cast<ssize_t>(MsgHdr->MsgLen) != bytes) {
-      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-             << "message from " << MsgHdr->Callsign << " has invalid length!");
-      break;
-    }
-    //////////////////////////////////////////////////
-    //  Process messages
-    //////////////////////////////////////////////////
-    switch (MsgHdr->MsgId) {
-    case CHAT_MSG_ID:
-      ProcessChatMsg(msgBuf, SenderAddress);
-      break;
-    case POS_DATA_ID:
-      ProcessPosMsg(msgBuf, SenderAddress, stamp);
-      break;
-    case UNUSABLE_POS_DATA_ID:
-    case OLD_OLD_POS_DATA_ID:
-    case OLD_PROP_MSG_ID:
-    case OLD_POS_DATA_ID:
-      break;
-    default:
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "Unknown message Id received: " << MsgHdr->MsgId );
-      break;
-    }
-  } while (bytes > 0);
+    mPacketsReceived->setIntValue(mReceiver->received());
+    mPacketsDropped->setIntValue(mReceiver->dropped());
+  }
 
   // check for expiry
+  unsigned applied = 0, skipped = 0;
   MultiPlayerMap::iterator it = mMultiPlayerMap.begin();
   while (it != mMultiPlayerMap.end()) {
+    applied += it->second->getPropertiesApplied();
+    skipped += it->second->getPropertiesSkipped();
     if (it->second->getLastTimestamp() + 10 < stamp) {
+      mExpiredApplied += it->second->getPropertiesApplied();
+      mExpiredSkipped += it->second->getPropertiesSkipped();
       std::string name = it->first;
       it->second->setDie(true);
       mMultiPlayerMap.erase(it);
@@ -956,6 +982,12 @@ FGMultiplayMgr::update(double dt)
     } else
       ++it;
   }
+
+  if (mPropertiesDecoded) {
+    mPropertiesDecoded->setIntValue(mDecoded);
+    mPropertiesApplied->setIntValue(mExpiredApplied + applied);
+    mPropertiesSkipped->setIntValue(mExpiredSkipped + skipped);
+  }
 } // FGMultiplayMgr::ProcessData(void)
 //////////////////////////////////////////////////////////////////////
 
@@ -1095,21 +1127,20 @@ FGMultiplayMgr::Send()
 
 //////////////////////////////////////////////////////////////////////
 //
-//  handle a position message
+//  decode a position message, in the receiver thread
 //
 //////////////////////////////////////////////////////////////////////
-void
-FGMultiplayMgr::ProcessPosMsg(const FGMultiplayMgr::MsgBuf& Msg,
-                              const simgear::IPAddress& SenderAddress, long stamp)
+bool
+FGMultiplayMgr::DecodePosMsg(const FGMultiplayMgr::MsgBuf& Msg,
+                             FGExternalMotionData& motionInfo)
 {
   const T_MsgHdr* MsgHdr = Msg.msgHdr();
   if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + sizeof(T_PositionMsg)) {
     SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
             << "Position message received with insufficient data" );
-    return;
+    return false;
   }
   const T_PositionMsg* PosMsg = Msg.posMsg();
-  FGExternalMotionData motionInfo;
   motionInfo.time = XDR_decode_double(PosMsg->time);
   motionInfo.lag = XDR_decode_double(PosMsg->lag);
   for (unsigned i = 0; i < 3; ++i)
@@ -1134,7 +1165,7 @@ FGMultiplayMgr::ProcessPosMsg(const FGMultiplayMgr::MsgBuf& Msg,
       SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::ProcessPosMsg - "
               << "Position message with invalid data (NaN) received from "
               << MsgHdr->Callsign);
-      return;
+      return false;
   }
 
   //cout << "INPUT MESSAGE\n";
@@ -1245,10 +1276,23 @@ FGMultiplayMgr::ProcessPosMsg(const FGMultiplayMgr::MsgBuf& Msg,
     }
   }
  noprops:
-  FGAIMultiplayer* mp = getMultiplayer(MsgHdr->Callsign);
+  return true;
+} // FGMultiplayMgr::DecodePosMsg()
+//////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////
+//
+//  handle a position message
+//
+//////////////////////////////////////////////////////////////////////
+void
+FGMultiplayMgr::ProcessPosMsg(ReceivedMsg& Msg, long stamp)
+{
+  FGAIMultiplayer* mp = getMultiplayer(Msg.Callsign);
   if (!mp)
-    mp = addMultiplayer(MsgHdr->Callsign, PosMsg->Model);
-  mp->addMotionInfo(motionInfo, stamp);
+    mp = addMultiplayer(Msg.Callsign, Msg.Model);
+  mDecoded += Msg.MotionInfo.properties.size();
+  mp->addMotionInfo(Msg.MotionInfo, stamp);
 } // FGMultiplayMgr::ProcessPosMsg()
 //////////////////////////////////////////////////////////////////////
 
@@ -1259,29 +1303,209 @@ FGMultiplayMgr::ProcessPosMsg(const FGMultiplayMgr::MsgBuf& Msg,
 //
 //////////////////////////////////////////////////////////////////////
 void
-FGMultiplayMgr::ProcessChatMsg(const MsgBuf& Msg,
-                               const simgear::IPAddress& SenderAddress)
+FGMultiplayMgr::ProcessChatMsg(const ReceivedMsg& Msg)
 {
-  const T_MsgHdr* MsgHdr = Msg.msgHdr();
-  if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + 1) {
-    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-            << "Chat message received with insufficient data" );
+  SG_LOG (SG_NETWORK, SG_WARN, "Chat [" << Msg.Callsign << "]"
+           << " " << Msg.Text);
+} // FGMultiplayMgr::ProcessChatMsg ()
+//////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////
+//
+//  The receiver thread
+//
+//////////////////////////////////////////////////////////////////////
+
+// forget the properties a slot still owns, before it is reused
+static void
+clearProperties(FGExternalMotionData& motionInfo)
+{
+  for (unsigned i = 0; i < motionInfo.properties.size(); ++i)
+    delete motionInfo.properties[i];
+  motionInfo.properties.clear();
+}
+
+FGMultiplayMgr::Receiver::Receiver(FGMultiplayMgr* mgr, simgear::Socket* socket,
+                                   unsigned capacity) :
+  mMgr(mgr),
+  mSocket(socket),
+  mCapacity(1),
+  mRunning(false)
+{
+  while (mCapacity < capacity)
+    mCapacity <<= 1;
+  mQueue.resize(mCapacity);
+}
+
+FGMultiplayMgr::Receiver::~Receiver()
+{
+  stop();
+  for (unsigned i = 0; i < mQueue.size(); ++i)
+    clearProperties(mQueue[i].MotionInfo);
+}
+
+void
+FGMultiplayMgr::Receiver::stop()
+{
+  if (!mRunning)
     return;
+  ++mDone;
+  join();
+  mRunning = false;
+}
+
+FGMultiplayMgr::ReceivedMsg*
+FGMultiplayMgr::Receiver::front()
+{
+  unsigned tail = mTail;
+  if (tail == (unsigned) mHead)
+    return 0;
+  return &mQueue[tail & (mCapacity - 1)];
+}
+
+void
+FGMultiplayMgr::Receiver::pop()
+{
+  ++mTail;
+}
+
+void
+FGMultiplayMgr::Receiver::run()
+{
+  while (!mDone) {
+    // wait for data, but look at the done flag now and then
+    simgear::Socket* reads[] = { mSocket, 0 };
+    simgear::Socket* writes[] = { 0 };
+    simgear::Socket::select(reads, writes, 100);
+    receive();
   }
-  
-  char *chatStr = new char[MsgHdr->MsgLen - sizeof(T_MsgHdr)];
-  const T_ChatMsg* ChatMsg
-      = reinterpret_cast<const T_ChatMsg *>(Msg.Msg + sizeof(T_MsgHdr));
-  strncpy(chatStr, ChatMsg->Text,
-          MsgHdr->MsgLen - sizeof(T_MsgHdr));
-  chatStr[MsgHdr->MsgLen - sizeof(T_MsgHdr) - 1] = '\0';
-  
-  SG_LOG (SG_NETWORK, SG_WARN, "Chat [" << MsgHdr->Callsign << "]"
-           << " " << chatStr);
+}
 
-  delete [] chatStr;
-} // FGMultiplayMgr::ProcessChatMsg ()
-//////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////
+//  Read the receive socket until it is empty and
+//  queue the decoded messages
+//////////////////////////////////////////////////
+void
+FGMultiplayMgr::Receiver::receive()
+{
+  while (true) {
+    MsgBuf msgBuf;
+    //////////////////////////////////////////////////
+    //  Although the recv call asks for 
+    //  MAX_PACKET_SIZE of data, the number of bytes
+    //  returned will only be that of the next
+    //  packet waiting to be processed.
+    //////////////////////////////////////////////////
+    simgear::IPAddress SenderAddress;
+    int RecvStatus = mSocket->recvfrom(msgBuf.Msg, sizeof(msgBuf.Msg), 0,
+                              &SenderAddress);
+    //////////////////////////////////////////////////
+    //  no Data received
+    //////////////////////////////////////////////////
+    if (RecvStatus == 0)
+        return;
+
+    // socket error reported?
+    // errno is per thread, so this is the error of our recvfrom - still
+    // only check its value when the status really indicates a failure.
+    if ((RecvStatus < 0)&&
+        ((errno == EAGAIN) || (errno == 0))) // MSVC output "NoError" otherwise
+    {
+        // ignore "normal" errors
+        return;
+    }
+
+    if (RecvStatus<0)
+    {
+        SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - Unable to receive data. "
+               << strerror(errno) << "(errno " << errno << ")");
+        return;
+    }
+
+    // status is positive: bytes received
+    ssize_t bytes = (ssize_t) RecvStatus;
+    if (bytes <= static_cast<ssize_t>(sizeof(T_MsgHdr))) {
+      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+              << "received message with insufficient data" );
+      continue;
+    }
+    //////////////////////////////////////////////////
+    //  Read header
+    //////////////////////////////////////////////////
+    T_MsgHdr* MsgHdr = msgBuf.msgHdr();
+    MsgHdr->Magic       = XDR_decode_uint32 (MsgHdr->Magic);
+    MsgHdr->Version     = XDR_decode_uint32 (MsgHdr->Version);
+    MsgHdr->MsgId       = XDR_decode_uint32 (MsgHdr->MsgId);
+    MsgHdr->MsgLen      = XDR_decode_uint32 (MsgHdr->MsgLen);
+    MsgHdr->ReplyPort   = XDR_decode_uint32 (MsgHdr->ReplyPort);
+    MsgHdr->Callsign[MAX_CALLSIGN_LEN -1] = '\0';
+    if (MsgHdr->Magic != MSG_MAGIC) {
+      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+              << "message has invalid magic number!" );
+      continue;
+    }
+    if (MsgHdr->Version != PROTO_VER) {
+      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+              << "message has invalid protocol number!" );
+      continue;
+    }
+    if (static_cast<ssize_t>(MsgHdr->MsgLen) != bytes) {
+      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+             << "message from " << MsgHdr->Callsign << " has invalid length!");
+      continue;
+    }
+
+    switch (MsgHdr->MsgId) {
+    case CHAT_MSG_ID:
+    case POS_DATA_ID:
+      break;
+    case UNUSABLE_POS_DATA_ID:
+    case OLD_OLD_POS_DATA_ID:
+    case OLD_PROP_MSG_ID:
+    case OLD_POS_DATA_ID:
+      continue;
+    default:
+      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+              << "Unknown message Id received: " << MsgHdr->MsgId );
+      continue;
+    }
+
+    ++mReceived;
+
+    unsigned head = mHead;
+    if (head - (unsigned) mTail >= mCapacity) {
+      ++mDropped;
+      continue;
+    }
+
+    //////////////////////////////////////////////////
+    //  Decode the message into the free slot
+    //////////////////////////////////////////////////
+    ReceivedMsg& msg = mQueue[head & (mCapacity - 1)];
+    msg.MsgId = MsgHdr->MsgId;
+    msg.Callsign = MsgHdr->Callsign;
+    if (msg.MsgId == CHAT_MSG_ID) {
+      if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + 1) {
+        SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+                << "Chat message received with insufficient data" );
+        continue;
+      }
+      const T_ChatMsg* ChatMsg
+          = reinterpret_cast<const T_ChatMsg *>(msgBuf.Msg + sizeof(T_MsgHdr));
+      size_t len = MsgHdr->MsgLen - sizeof(T_MsgHdr);
+      msg.Text.assign(ChatMsg->Text, strnlen(ChatMsg->Text, len - 1));
+    } else {
+      clearProperties(msg.MotionInfo);
+      if (!mMgr->DecodePosMsg(msgBuf, msg.MotionInfo))
+        continue;
+      const T_PositionMsg* PosMsg = msgBuf.posMsg();
+      msg.Model.assign(PosMsg->Model, strnlen(PosMsg->Model, MAX_MODEL_NAME_LEN));
+    }
+
+    // hand it to the main loop
+    ++mHead;
+  }
+}
 
 void
 FGMultiplayMgr::FillMsgHdr(T_MsgHdr *MsgHdr, int MsgId, unsigned _len)
@@ -1312,8 +1536,9 @@ FGAIMultiplayer*
 FGMultiplayMgr::addMultiplayer(const std::string& callsign,
                                const std::string& modelName)
 {
-  if (0 < mMultiPlayerMap.count(callsign))
-    return mMultiPlayerMap[callsign].get();
+  MultiPlayerMap::iterator it = mMultiPlayerMap.find(callsign);
+  if (it != mMultiPlayerMap.end())
+    return it->second.get();
 
   FGAIMultiplayer* mp = new FGAIMultiplayer;
   mp->setPath(modelName.c_str());
@@ -1335,8 +1560,9 @@ FGMultiplayMgr::addMultiplayer(const std::string& callsign,
 FGAIMultiplayer*
 FGMultiplayMgr::getMultiplayer(const std::string& callsign)
 {
-  if (0 < mMultiPlayerMap.count(callsign))
-    return mMultiPlayerMap[callsign].get();
+  MultiPlayerMap::iterator it = mMultiPlayerMap.find(callsign);
+  if (it != mMultiPlayerMap.end())
+    return it->second.get();
   else
     return 0;
 }
@@ -40,6 +40,8 @@
 #include <simgear/props/props.hxx>
 #include <simgear/io/raw_socket.hxx>
 #include <simgear/structure/subsystem_mgr.hxx>
+#include <simgear/structure/SGAtomic.hxx>
+#include <simgear/threads/SGThread.hxx>
 
 struct FGExternalMotionData;
 class MPPropertyListener;
@@ -77,13 +79,17 @@ private:
   void SendMyPosition(const FGExternalMotionData& motionInfo);
 
   union MsgBuf;
+  struct ReceivedMsg;
+  class Receiver;
+  friend class Receiver;
+
   FGAIMultiplayer* addMultiplayer(const std::string& callsign,
                                   const std::string& modelName);
   FGAIMultiplayer* getMultiplayer(const std::string& callsign);
   void FillMsgHdr(T_MsgHdr *MsgHdr, int iMsgId, unsigned _len = 0u);
-  void ProcessPosMsg(const MsgBuf& Msg, const simgear::IPAddress& SenderAddress,
-                     long stamp);
-  void ProcessChatMsg(const MsgBuf& Msg, const simgear::IPAddress& SenderAddress);
+  bool DecodePosMsg(const MsgBuf& Msg, FGExternalMotionData& motionInfo);
+  void ProcessPosMsg(ReceivedMsg& Msg, long stamp);
+  void ProcessChatMsg(const ReceivedMsg& Msg);
   bool isSane(const FGExternalMotionData& motionInfo);
 
   /// maps from the callsign string to the FGAIMultiplayer
@@ -91,6 +97,8 @@ private:
   MultiPlayerMap mMultiPlayerMap;
 
   std::auto_ptr<simgear::Socket> mSocket;
+  // reads and decodes the packets arriving at mSocket
+  std::auto_ptr<Receiver> mReceiver;
   simgear::IPAddress mServer;
   bool mHaveServer;
   bool mInitialised;
@@ -106,6 +114,18 @@ private:
   
   double mDt; // reciprocal of /sim/multiplay/tx-rate-hz
   double mTimeUntilSend;
+
+  SGPropertyNode_ptr mPacketsReceived;
+  SGPropertyNode_ptr mPacketsDropped;
+
+  // properties received, and written or skipped as unchanged by the
+  // players; including those of players that have expired
+  unsigned mDecoded;
+  unsigned mExpiredApplied;
+  unsigned mExpiredSkipped;
+  SGPropertyNode_ptr mPropertiesDecoded;
+  SGPropertyNode_ptr mPropertiesApplied;
+  SGPropertyNode_ptr mPropertiesSkipped;
 };
 
 #endif
@@ -0,0 +1,239 @@
+// DatFileReader - line and token scanner for the (gzipped) text data
+// files: apt.dat, nav.dat, fix.dat and awy.dat
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "DatFileReader.hxx"
+
+#include <stdlib.h> // atof(), atoi()
+#include <zlib.h>
+
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/misc/stdint.hxx>
+
+namespace flightgear
+{
+
+static const size_t BLOCK_SIZE = 256 * 1024;
+
+// powers of ten up to 1e22 are exact doubles
+static const double POW10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isBlank(char c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+double DatToken::toDouble() const
+{
+  const char* p = _begin;
+  bool negative = false;
+  if ((p < _end) && ((*p == '-') || (*p == '+'))) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+// an integer mantissa below 2^53 and a power of ten up to 1e22 are both
+// exact, so a single division rounds exactly like strtod() does
+  uint64_t mantissa = 0;
+  int digits = 0, fractionDigits = 0;
+  bool point = false, any = false;
+  for (; p < _end; ++p) {
+    if ((*p >= '0') && (*p <= '9')) {
+      any = true;
+      if (mantissa || (*p != '0')) {
+        if (++digits > 15) {
+          return atof(_begin);
+        }
+      }
+      mantissa = mantissa * 10 + (*p - '0');
+      if (point) {
+        ++fractionDigits;
+      }
+    } else if ((*p == '.') && !point) {
+      point = true;
+    } else {
+      return atof(_begin); // exponent, or not a number at all
+    }
+  }
+
+  if (!any || (fractionDigits > 22)) {
+    return atof(_begin);
+  }
+
+  double v = static_cast<double>(mantissa);
+  if (fractionDigits) {
+    v /= POW10[fractionDigits];
+  }
+  return negative ? -v : v;
+}
+
+int DatToken::toInt() const
+{
+  const char* p = _begin;
+  bool negative = false;
+  if ((p < _end) && ((*p == '-') || (*p == '+'))) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  int v = 0;
+  for (; (p < _end) && (*p >= '0') && (*p <= '9'); ++p) {
+    v = v * 10 + (*p - '0');
+  }
+  return negative ? -v : v;
+}
+
+DatFileReader::DatFileReader(const SGPath& path) :
+  _file(gzopen(path.c_str(), "rb")),
+  _pos(0),
+  _end(0),
+  _eof(false),
+  _bytesRead(0),
+  _lineNumber(0)
+{
+  _buffer.resize(BLOCK_SIZE);
+}
+
+DatFileReader::~DatFileReader()
+{
+  if (_file) {
+    gzclose(static_cast<gzFile>(_file));
+  }
+}
+
+void DatFileReader::fill()
+{
+// keep the unconsumed partial line, and make room for another block
+  size_t remaining = _end - _pos;
+  if (_pos > 0) {
+    memmove(&_buffer[0], &_buffer[_pos], remaining);
+    _pos = 0;
+    _end = remaining;
+  }
+
+  if (_buffer.size() - _end < BLOCK_SIZE) {
+    _buffer.resize(_end + BLOCK_SIZE);
+  }
+
+  int n = gzread(static_cast<gzFile>(_file), &_buffer[_end], BLOCK_SIZE);
+  if (n <= 0) {
+    _eof = true;
+    return;
+  }
+
+  _end += n;
+  _bytesRead += n;
+}
+
+bool DatFileReader::nextLine()
+{
+  _tokens.clear();
+  if (!_file) {
+    return false;
+  }
+
+  char* begin;
+  char* end;
+  for (;;) {
+    begin = &_buffer[0] + _pos;
+    end = static_cast<char*>(memchr(begin, '\n', _end - _pos));
+    if (end) {
+      _pos = end - &_buffer[0] + 1;
+      break;
+    }
+
+    if (_eof) {
+      if (_pos == _end) {
+        return false;
+      }
+
+    // last line without a line feed; terminate it in spare space
+      if (_buffer.size() == _end) {
+        _buffer.resize(_end + 1);
+        begin = &_buffer[0] + _pos;
+      }
+      end = begin + (_end - _pos);
+      _pos = _end;
+      break;
+    }
+
+    fill();
+  }
+
+  while ((end > begin) && (end[-1] == '\r')) {
+    --end;
+  }
+  *end = 0;
+
+  _line = DatToken(begin, end);
+  ++_lineNumber;
+  tokenize();
+  return true;
+}
+
+void DatFileReader::tokenize()
+{
+  const char* p = _line.begin();
+  const char* end = _line.end();
+  while (p < end) {
+    while ((p < end) && isBlank(*p)) {
+      ++p;
+    }
+
+    const char* start = p;
+    while ((p < end) && !isBlank(*p)) {
+      ++p;
+    }
+
+    if (p > start) {
+      _tokens.push_back(DatToken(start, p));
+    }
+  }
+}
+
+DatToken DatFileReader::rest(unsigned int i) const
+{
+  if (i >= _tokens.size()) {
+    return DatToken();
+  }
+
+  const char* end = _line.end();
+  while ((end > _tokens[i].begin()) && isBlank(end[-1])) {
+    --end;
+  }
+  return DatToken(_tokens[i].begin(), end);
+}
+
+std::string DatFileReader::join(unsigned int i) const
+{
+  std::string result;
+  for (; i < _tokens.size(); ++i) {
+    if (!result.empty()) {
+      result += ' ';
+    }
+    result.append(_tokens[i].begin(), _tokens[i].end());
+  }
+  return result;
+}
+
+} // of namespace flightgear
@@ -0,0 +1,123 @@
+/**
+ * DatFileReader - line and token scanner for the (gzipped) text data
+ * files: apt.dat, nav.dat, fix.dat and awy.dat
+ */
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_DAT_FILE_READER_HXX
+#define FG_DAT_FILE_READER_HXX
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+class SGPath;
+
+namespace flightgear
+{
+
+/**
+ * A whitespace-separated token of the current line: a view into the
+ * reader's buffer, so only valid until the next call to nextLine().
+ */
+class DatToken
+{
+public:
+  DatToken() : _begin(NULL), _end(NULL) { }
+  DatToken(const char* b, const char* e) : _begin(b), _end(e) { }
+
+  const char* begin() const { return _begin; }
+  const char* end() const { return _end; }
+  unsigned int size() const { return _end - _begin; }
+  bool empty() const { return _begin == _end; }
+  char operator[](unsigned int i) const { return _begin[i]; }
+
+  std::string str() const { return std::string(_begin, _end); }
+
+  bool operator==(const char* s) const
+  {
+    return (strlen(s) == size()) && (strncmp(_begin, s, size()) == 0);
+  }
+
+  /**
+   * the same values atof() and atoi() would return, parsed without
+   * copying. Plain decimals take a fast path, anything else (exponents,
+   * very long mantissas) falls back to the C library.
+   */
+  double toDouble() const;
+  int toInt() const;
+private:
+  const char* _begin;
+  const char* _end;
+};
+
+/**
+ * Reads a text file, gzipped or not, in large decompressed blocks and
+ * yields its lines, split into tokens in place. No memory is allocated
+ * per line once the buffers have grown to the longest line.
+ */
+class DatFileReader
+{
+public:
+  DatFileReader(const SGPath& path);
+  ~DatFileReader();
+
+  bool isOpen() const { return _file != NULL; }
+
+  /**
+   * advance to the next line, returns false at the end of the file.
+   * Trailing carriage returns are removed.
+   */
+  bool nextLine();
+
+  /// the current line, NUL terminated
+  const char* line() const { return _line.begin(); }
+  unsigned int lineLength() const { return _line.size(); }
+  unsigned int lineNumber() const { return _lineNumber; }
+
+  unsigned int numTokens() const { return _tokens.size(); }
+  const DatToken& token(unsigned int i) const { return _tokens[i]; }
+
+  /// the remainder of the line from token i, with whitespace kept as-is
+  /// but trimmed from the end. Empty if there are not that many tokens.
+  DatToken rest(unsigned int i) const;
+
+  /// tokens i onwards, joined by single spaces
+  std::string join(unsigned int i) const;
+
+  /// total size of the decompressed data read so far
+  size_t bytesRead() const { return _bytesRead; }
+private:
+  DatFileReader(const DatFileReader&); // not implemented
+  DatFileReader& operator=(const DatFileReader&);
+
+  void fill();
+  void tokenize();
+
+  void* _file; // gzFile
+  std::vector<char> _buffer;
+  size_t _pos, _end;
+  bool _eof;
+  size_t _bytesRead;
+
+  DatToken _line;
+  unsigned int _lineNumber;
+  std::vector<DatToken> _tokens;
+};
+
+} // of namespace flightgear
+
+#endif // of FG_DAT_FILE_READER_HXX
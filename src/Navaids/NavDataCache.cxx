@@ -32,6 +32,8 @@
 
 // std
 #include <map>
+#include <list>
+#include <algorithm>
 #include <cassert>
 #include <stdint.h> // for int64_t
 // boost
@@ -45,10 +47,13 @@
 #include <simgear/bucket/newbucket.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/misc/strutils.hxx>
+#include <simgear/math/sg_random.h>
+#include <simgear/props/props.hxx>
 #include <simgear/threads/SGThread.hxx>
 #include <simgear/threads/SGGuard.hxx>
 
 #include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
 #include "markerbeacon.hxx"
 #include "navrecord.hxx"
 #include <Airports/simple.hxx>
@@ -73,6 +78,7 @@ namespace {
 const int MAX_RETRIES = 10;
 const int SCHEMA_VERSION = 6;
 const int CACHE_SIZE_KBYTES= 16000;
+const unsigned int QUERY_CACHE_SIZE = 4096; // entries, per kind of query
     
 // bind a std::string to a sqlite statement. The std::string must live the
 // entire duration of the statement execution - do not pass a temporary
@@ -176,9 +182,190 @@ private:
   bool _isFinished;
 };
 
+/**
+ * Thread parsing one of the navigation data files into records, while the
+ * rebuild thread is busy inserting the records of the files before it.
+ * Only the inserts touch the database, so they all stay on the rebuild
+ * thread, in one transaction.
+ */
+class ParseThread : public SGThread
+{
+public:
+  ParseThread(const SGPath& path) :
+  _path(path),
+  _parseMSec(0),
+  _succeeded(false),
+  _joined(false)
+  {
+  }
+  
+  /// wait for the parse to complete, re-throwing any error it hit.
+  /// Returns false if the file could not be read at all.
+  bool finish()
+  {
+    wait();
+    if (!_error.empty()) {
+      throw sg_exception(_error, _path.str());
+    }
+    return _succeeded;
+  }
+  
+  void wait()
+  {
+    if (!_joined) {
+      join();
+      _joined = true;
+    }
+  }
+  
+  double parseMSec() const
+  {
+    return _parseMSec;
+  }
+  
+  virtual void run()
+  {
+    SGTimeStamp st;
+    st.stamp();
+    try {
+      _succeeded = parse(_path);
+    } catch (std::exception& e) {
+      _error = e.what();
+    }
+    _parseMSec = st.elapsedMSec();
+  }
+protected:
+  virtual bool parse(const SGPath& path) = 0;
+private:
+  SGPath _path;
+  std::string _error;
+  double _parseMSec;
+  bool _succeeded;
+  bool _joined;
+};
+  
+class FixParseThread : public ParseThread
+{
+public:
+  FixParseThread(const SGPath& path) : ParseThread(path) { }
+  FixRecordVec records;
+protected:
+  virtual bool parse(const SGPath& path)
+  {
+    return parseFixes(path, records);
+  }
+};
+  
+class NavParseThread : public ParseThread
+{
+public:
+  NavParseThread(const SGPath& path, bool isCarrierNav) :
+    ParseThread(path),
+    _isCarrierNav(isCarrierNav)
+  { }
+  NavRecordVec records;
+protected:
+  virtual bool parse(const SGPath& path)
+  {
+    return parseNavaids(path, _isCarrierNav, records);
+  }
+private:
+  bool _isCarrierNav;
+};
+  
+class AirwayParseThread : public ParseThread
+{
+public:
+  AirwayParseThread(const SGPath& path) : ParseThread(path) { }
+  Airway::EdgeRecordVec records;
+protected:
+  virtual bool parse(const SGPath& path)
+  {
+    Airway::parse(path, records);
+    return true;
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////////
   
 typedef std::map<PositionedID, FGPositionedRef> PositionedCache;
+
+/**
+ * Least-recently-used cache of query results, keyed by the query
+ * parameters. Each kind of query has its own instance, so a burst of one
+ * kind (e.g. an airway route search) cannot evict the others.
+ * Entries must be invalidated by whoever modifies the underlying tables.
+ */
+template <class Key, class Value>
+class QueryCache
+{
+public:
+  QueryCache(const char* aName, unsigned int aCapacity) :
+    _name(aName),
+    _capacity(aCapacity),
+    _hits(0),
+    _misses(0)
+  {}
+
+  bool get(const Key& k, Value& v)
+  {
+    typename EntryMap::iterator it = _lookup.find(k);
+    if (it == _lookup.end()) {
+      ++_misses;
+      return false;
+    }
+
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, it->second);
+    v = it->second->second;
+    return true;
+  }
+
+  void put(const Key& k, const Value& v)
+  {
+    if (_lookup.find(k) != _lookup.end()) {
+      return;
+    }
+
+    _entries.push_front(std::make_pair(k, v));
+    _lookup[k] = _entries.begin();
+    if (_entries.size() > _capacity) {
+      _lookup.erase(_entries.back().first);
+      _entries.pop_back();
+    }
+  }
+
+  void clear()
+  {
+    _entries.clear();
+    _lookup.clear();
+  }
+
+  void writeStatistics(SGPropertyNode* aNode) const
+  {
+    SGPropertyNode* n = aNode->getChild(_name, 0, true);
+    n->setIntValue("hits", _hits);
+    n->setIntValue("misses", _misses);
+    n->setIntValue("entries", _lookup.size());
+    n->setIntValue("capacity", _capacity);
+  }
+private:
+  typedef std::list<std::pair<Key, Value> > EntryList;
+  typedef std::map<Key, typename EntryList::iterator> EntryMap;
+
+  const char* _name;
+  unsigned int _capacity;
+  EntryList _entries; // most recently used at the front
+  EntryMap _lookup;
+  unsigned int _hits, _misses;
+};
+
+// (network, from) -> airway edges
+typedef std::pair<int, PositionedID> AirwayEdgeKey;
+// (from, only-pushback) -> ground-net edge destinations
+typedef std::pair<PositionedID, bool> GroundnetEdgeKey;
+// (frequency, (min type, max type)) -> navaids, in no particular order
+typedef std::pair<int, std::pair<int, int> > NavaidFreqKey;
   
 class AirportTower : public FGPositioned
 {
@@ -199,6 +386,11 @@ public:
     path(p),
     cacheHits(0),
     cacheMisses(0),
+    groundnetGeneration(0),
+    queryCachesEnabled(true),
+    airwayEdgeCache("airway-edges", QUERY_CACHE_SIZE),
+    groundnetEdgeCache("groundnet-edges", QUERY_CACHE_SIZE),
+    navaidFreqCache("navaids-by-freq", QUERY_CACHE_SIZE),
     transactionLevel(0),
     transactionAborted(false)
   {
@@ -683,6 +875,13 @@ public:
                                  "radius >= ?2 AND gate_type = ?3 AND "
                                  "parking.rowid=positioned.rowid");
     sqlite3_bind_int(findAirportParking, 4, FGPositioned::PARKING);
+    
+    dropParking = prepare("DELETE FROM parking WHERE rowid IN "
+                          "(SELECT rowid FROM positioned WHERE type=?1 AND airport=?2)");
+    dropTaxiNodes = prepare("DELETE FROM taxi_node WHERE rowid IN "
+                            "(SELECT rowid FROM positioned WHERE (type=?1 OR type=?2) AND airport=?3)");
+    dropGroundnetPositioned = prepare("DELETE FROM positioned WHERE (type=?1 OR type=?2) AND airport=?3");
+    dropGroundnetEdges = prepare("DELETE FROM groundnet_edge WHERE airport=?1");
   }
   
   void writeIntProperty(const string& key, int value)
@@ -908,6 +1107,44 @@ public:
     return length;
   }
   
+  /**
+   * navaids on a frequency within a type range, in no particular order.
+   * Uses (and fills) the query cache when enabled.
+   */
+  PositionedIDVec navaidsByFreq(int freqKhz, int minType, int maxType)
+  {
+    NavaidFreqKey key(freqKhz, std::make_pair(minType, maxType));
+    PositionedIDVec result;
+    if (queryCachesEnabled && navaidFreqCache.get(key, result)) {
+      return result;
+    }
+    
+    sqlite3_bind_int(findNavsByFreqNoPos, 1, freqKhz);
+    sqlite3_bind_int(findNavsByFreqNoPos, 2, minType);
+    sqlite3_bind_int(findNavsByFreqNoPos, 3, maxType);
+    result = selectIds(findNavsByFreqNoPos);
+    
+    if (queryCachesEnabled) {
+      navaidFreqCache.put(key, result);
+    }
+    return result;
+  }
+  
+  /// drop cached query results, after the tables they come from changed
+  void invalidateQueryCaches()
+  {
+    airwayEdgeCache.clear();
+    groundnetEdgeCache.clear();
+    navaidFreqCache.clear();
+  }
+  
+  /// record the duration of a rebuild phase, to publish once it is done
+  void rebuildPhase(const string& phase, double msec)
+  {
+    SG_LOG(SG_NAVCACHE, SG_INFO, "NavCache rebuild: " << phase << " took:" << msec << "msec");
+    rebuildTimings.push_back(std::make_pair(phase, msec));
+  }
+  
   void flushDeferredOctreeUpdates()
   {
     BOOST_FOREACH(Octree::Branch* nd, deferredOctreeUpdates) {
@@ -928,6 +1165,15 @@ public:
   /// the cache drops its reference
   PositionedCache cache;
   unsigned int cacheHits, cacheMisses;
+  
+  unsigned int groundnetGeneration;
+  
+  /// caches of adjacency and frequency query results. Unlike the positioned
+  /// objects above these are bounded, since they are cheap to re-query
+  bool queryCachesEnabled;
+  QueryCache<AirwayEdgeKey, AirwayEdgeVec> airwayEdgeCache;
+  QueryCache<GroundnetEdgeKey, PositionedIDVec> groundnetEdgeCache;
+  QueryCache<NavaidFreqKey, PositionedIDVec> navaidFreqCache;
 
   /**
    * record the levels of open transaction objects we have
@@ -973,6 +1219,8 @@ public:
   sqlite3_stmt_ptr taxiEdgesFrom, pushbackEdgesFrom, insertTaxiEdge, markTaxiNodeAsPushback,
     airportTaxiNodes, airportPushbackNodes, findNearestTaxiNode, findAirportParking,
     setParkingPushBack, findNearestRunwayTaxiNode;
+  sqlite3_stmt_ptr dropParking, dropTaxiNodes, dropGroundnetPositioned,
+    dropGroundnetEdges;
   
 // since there's many permutations of ident/name queries, we create
 // them programtically, but cache the exact query by its raw SQL once
@@ -987,6 +1235,10 @@ public:
   // if we're performing a rebuild, the thread that is doing the work.
   // otherwise, NULL
   std::auto_ptr<RebuildThread> rebuilder;
+  
+  // phase timings of the last rebuild, in msec. Written by the rebuild
+  // thread, read once it has finished.
+  std::vector<std::pair<string, double> > rebuildTimings;
 };
 
   //////////////////////////////////////////////////////////////////////
@@ -1176,16 +1428,40 @@ bool NavDataCache::rebuild()
   bool fin = d->rebuilder->isFinished();
   if (fin) {
     d->rebuilder.reset(); // all done!
+    
+    SGPropertyNode* timings = fgGetNode("/sim/navdb/rebuild", true);
+    for (unsigned int i=0; i<d->rebuildTimings.size(); ++i) {
+      timings->setDoubleValue(d->rebuildTimings[i].first + "-msec",
+                              d->rebuildTimings[i].second);
+    }
   }
   return fin;
 }
   
 void NavDataCache::doRebuild()
 {
+// the text files are parsed concurrently, while this thread inserts the
+// records in dependency order: navaids refer to runways, airways to
+// fixes and navaids. apt.dat is parsed here, since its parser inserts
+// as it goes.
+  FixParseThread fixes(d->fixDatPath);
+  NavParseThread navaids(d->navDatPath, false);
+  NavParseThread carriers(d->carrierDatPath, true);
+  AirwayParseThread airways(d->airwayDatPath);
+  ParseThread* parsers[] = { &fixes, &navaids, &carriers, &airways };
+  BOOST_FOREACH(ParseThread* p, parsers) {
+    p->start();
+  }
+  
+  d->rebuildTimings.clear();
+  SGTimeStamp total;
+  total.stamp();
+  
   try {
     d->close(); // completely close the sqlite object
     d->path.remove(); // remove the file on disk
     d->init(); // star again from scratch
+    d->invalidateQueryCaches();
     
     Transaction txn(this);
   // initialise the root octree node
@@ -1195,39 +1471,63 @@ void NavDataCache::doRebuild()
     st.stamp();
     
     airportDBLoad(d->aptDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "apt.dat load took:" << st.elapsedMSec());
-    
     metarDataLoad(d->metarDatPath);
     stampCacheFile(d->aptDatPath);
     stampCacheFile(d->metarDatPath);
+    d->rebuildPhase("apt-dat", st.elapsedMSec());
     
+    if (!fixes.finish()) {
+      exit(-1); // as loadFixes()
+    }
+    d->rebuildPhase("fix-dat-parse", fixes.parseMSec());
     st.stamp();
-    loadFixes(d->fixDatPath);
+    insertFixes(fixes.records);
     stampCacheFile(d->fixDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "fix.dat load took:" << st.elapsedMSec());
+    d->rebuildPhase("fix-dat-insert", st.elapsedMSec());
     
+    if (!navaids.finish()) {
+      SG_LOG(SG_NAVCACHE, SG_ALERT, "NavCache: unable to load " << d->navDatPath.str());
+    }
+    d->rebuildPhase("nav-dat-parse", navaids.parseMSec());
     st.stamp();
-    navDBInit(d->navDatPath);
+    insertNavaids(navaids.records);
     stampCacheFile(d->navDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "nav.dat load took:" << st.elapsedMSec());
+    d->rebuildPhase("nav-dat-insert", st.elapsedMSec());
     
-    loadCarrierNav(d->carrierDatPath);
+    if (!carriers.finish()) {
+      SG_LOG(SG_NAVCACHE, SG_ALERT, "NavCache: unable to load " << d->carrierDatPath.str());
+    }
+    d->rebuildPhase("carrier-nav-parse", carriers.parseMSec());
+    st.stamp();
+    insertNavaids(carriers.records);
     stampCacheFile(d->carrierDatPath);
+    d->rebuildPhase("carrier-nav-insert", st.elapsedMSec());
     
+    airways.finish();
+    d->rebuildPhase("awy-dat-parse", airways.parseMSec());
     st.stamp();
-    Airway::load(d->airwayDatPath);
+    Airway::insertEdges(airways.records);
     stampCacheFile(d->airwayDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "awy.dat load took:" << st.elapsedMSec());
+    d->rebuildPhase("awy-dat-insert", st.elapsedMSec());
     
+    st.stamp();
     d->flushDeferredOctreeUpdates();
     
     string sceneryPaths = simgear::strutils::join(globals->get_fg_scenery(), ";");
     writeStringProperty("scenery_paths", sceneryPaths);
     
     txn.commit();
+    d->rebuildPhase("commit", st.elapsedMSec());
   } catch (sg_exception& e) {
     SG_LOG(SG_NAVCACHE, SG_ALERT, "caught exception rebuilding navCache:" << e.what());
   }
+  
+// on failure, don't leave parsers running on our stack
+  BOOST_FOREACH(ParseThread* p, parsers) {
+    p->wait();
+  }
+  
+  d->rebuildPhase("total", total.elapsedMSec());
 }
   
 int NavDataCache::readIntProperty(const string& key)
@@ -1453,6 +1753,131 @@ FGPositioned* NavDataCache::loadById(PositionedID rowid)
   return pos;
 }
 
+void NavDataCache::writeCacheStatistics(SGPropertyNode* aNode) const
+{
+  SGPropertyNode* n = aNode->getChild("positioned", 0, true);
+  n->setIntValue("hits", d->cacheHits);
+  n->setIntValue("misses", d->cacheMisses);
+  n->setIntValue("entries", d->cache.size());
+  
+  d->airwayEdgeCache.writeStatistics(aNode);
+  d->groundnetEdgeCache.writeStatistics(aNode);
+  d->navaidFreqCache.writeStatistics(aNode);
+}
+
+// one lookup of the query benchmark
+struct BenchmarkLookup
+{
+  enum Kind { NAVAID_FREQ, AIRWAY_EDGES, GROUNDNET_EDGES };
+  
+  Kind kind;
+  int key; // frequency or airway network
+  PositionedID id;
+  SGGeod pos;
+};
+
+void NavDataCache::benchmarkQueries(unsigned int aNumQueries, SGPropertyNode* aResults)
+{
+  typedef BenchmarkLookup Lookup;
+  
+// sample a pool of distinct lookups of each kind from the cache file;
+// replaying them in random order gives the repetition radio tuning,
+// route and taxi searches show.
+  const int SAMPLES = 200;
+  std::vector<Lookup> lookups;
+  Lookup l;
+  
+  sqlite3_stmt_ptr q = d->prepare("SELECT navaid.freq, lon, lat FROM navaid, positioned "
+                                  "WHERE navaid.rowid=positioned.rowid AND navaid.freq>0 "
+                                  "ORDER BY random() LIMIT ?1");
+  sqlite3_bind_int(q, 1, SAMPLES);
+  l.kind = Lookup::NAVAID_FREQ;
+  l.id = 0;
+  while (d->stepSelect(q)) {
+    l.key = sqlite3_column_int(q, 0);
+    l.pos = SGGeod::fromDeg(sqlite3_column_double(q, 1), sqlite3_column_double(q, 2));
+    lookups.push_back(l);
+  }
+  d->finalize(q);
+  
+  q = d->prepare("SELECT network, a FROM airway_edge ORDER BY random() LIMIT ?1");
+  sqlite3_bind_int(q, 1, SAMPLES);
+  l.kind = Lookup::AIRWAY_EDGES;
+  while (d->stepSelect(q)) {
+    l.key = sqlite3_column_int(q, 0);
+    l.id = sqlite3_column_int64(q, 1);
+    lookups.push_back(l);
+  }
+  d->finalize(q);
+  
+  q = d->prepare("SELECT a FROM groundnet_edge ORDER BY random() LIMIT ?1");
+  sqlite3_bind_int(q, 1, SAMPLES);
+  l.kind = Lookup::GROUNDNET_EDGES;
+  while (d->stepSelect(q)) {
+    l.id = sqlite3_column_int64(q, 0);
+    lookups.push_back(l);
+  }
+  d->finalize(q);
+  
+  if (lookups.empty()) {
+    SG_LOG(SG_NAVCACHE, SG_WARN, "NavCache query benchmark: no data to query");
+    return;
+  }
+  
+  std::vector<unsigned int> order;
+  for (unsigned int i=0; i<aNumQueries; ++i) {
+    order.push_back(std::min<unsigned int>(sg_random() * lookups.size(),
+                                           lookups.size() - 1));
+  }
+  
+// pass 0 goes straight to SQLite, pass 1 through the query caches
+  double msec[2];
+  PositionedID checksum[2];
+  bool wasEnabled = d->queryCachesEnabled;
+  for (int pass=0; pass<2; ++pass) {
+    d->queryCachesEnabled = (pass == 1);
+    d->invalidateQueryCaches();
+    checksum[pass] = 0;
+    
+    SGTimeStamp st;
+    st.stamp();
+    BOOST_FOREACH(unsigned int i, order) {
+      const Lookup& lk(lookups[i]);
+      if (lk.kind == Lookup::NAVAID_FREQ) {
+        PositionedIDVec r = findNavaidsByFreq(lk.key, lk.pos, NULL);
+        checksum[pass] += r.size();
+        BOOST_FOREACH(PositionedID id, r) checksum[pass] += id;
+      } else if (lk.kind == Lookup::AIRWAY_EDGES) {
+        AirwayEdgeVec r = airwayEdgesFrom(lk.key, lk.id);
+        checksum[pass] += r.size();
+        BOOST_FOREACH(AirwayEdge e, r) checksum[pass] += e.second;
+      } else {
+        PositionedIDVec r = groundNetEdgesFrom(lk.id, false);
+        checksum[pass] += r.size();
+        BOOST_FOREACH(PositionedID id, r) checksum[pass] += id;
+      }
+    }
+    msec[pass] = st.elapsedMSec();
+  }
+  d->queryCachesEnabled = wasEnabled;
+  
+  SG_LOG(SG_NAVCACHE, SG_INFO, "NavCache query benchmark: " << aNumQueries
+         << " lookups over " << lookups.size() << " distinct: SQLite "
+         << msec[0] << "ms, cached " << msec[1] << "ms");
+  if (checksum[0] != checksum[1]) {
+    SG_LOG(SG_NAVCACHE, SG_ALERT, "NavCache query benchmark: result mismatch");
+  }
+  
+  if (aResults) {
+    aResults->setIntValue("queries", aNumQueries);
+    aResults->setIntValue("distinct-queries", lookups.size());
+    aResults->setDoubleValue("sqlite-msec", msec[0]);
+    aResults->setDoubleValue("cached-msec", msec[1]);
+    aResults->setBoolValue("results-match", checksum[0] == checksum[1]);
+    writeCacheStatistics(aResults->getChild("statistics", 0, true));
+  }
+}
+
 PositionedID NavDataCache::insertAirport(FGPositioned::Type ty, const string& ident,
                                          const string& name)
 {
@@ -1588,6 +2013,7 @@ NavDataCache::insertNavaid(FGPositioned::Type ty, const string& ident,
   sqlite3_bind_int(d->insertNavaid, 3, range);
   sqlite3_bind_double(d->insertNavaid, 4, multiuse);
   sqlite3_bind_int64(d->insertNavaid, 5, runway);
+  d->navaidFreqCache.clear();
   return d->execInsert(d->insertNavaid);
 }
 
@@ -1810,36 +2236,48 @@ NavDataCache::findCommByFreq(int freqKhz, const SGGeod& aPos, FGPositioned::Filt
 PositionedIDVec
 NavDataCache::findNavaidsByFreq(int freqKhz, const SGGeod& aPos, FGPositioned::Filter* aFilter)
 {
-  sqlite3_bind_int(d->findNavsByFreq, 1, freqKhz);
-  if (aFilter) {
-    sqlite3_bind_int(d->findNavsByFreq, 2, aFilter->minType());
-    sqlite3_bind_int(d->findNavsByFreq, 3, aFilter->maxType());
-  } else { // full type range
-    sqlite3_bind_int(d->findNavsByFreq, 2, FGPositioned::NDB);
-    sqlite3_bind_int(d->findNavsByFreq, 3, FGPositioned::GS);
+  int minType = aFilter ? aFilter->minType() : FGPositioned::NDB;
+  int maxType = aFilter ? aFilter->maxType() : FGPositioned::GS;
+  SGVec3d cartPos(SGVec3d::fromGeod(aPos));
+  
+  if (!d->queryCachesEnabled) {
+    sqlite3_bind_int(d->findNavsByFreq, 1, freqKhz);
+    sqlite3_bind_int(d->findNavsByFreq, 2, minType);
+    sqlite3_bind_int(d->findNavsByFreq, 3, maxType);
+    sqlite3_bind_double(d->findNavsByFreq, 4, cartPos.x());
+    sqlite3_bind_double(d->findNavsByFreq, 5, cartPos.y());
+    sqlite3_bind_double(d->findNavsByFreq, 6, cartPos.z());
+    return d->selectIds(d->findNavsByFreq);
   }
   
-  SGVec3d cartPos(SGVec3d::fromGeod(aPos));
-  sqlite3_bind_double(d->findNavsByFreq, 4, cartPos.x());
-  sqlite3_bind_double(d->findNavsByFreq, 5, cartPos.y());
-  sqlite3_bind_double(d->findNavsByFreq, 6, cartPos.z());
+// only a handful of navaids share a frequency, so sort the cached set by
+// range here rather than have SQLite do it on every call
+  PositionedIDVec ids = d->navaidsByFreq(freqKhz, minType, maxType);
+  std::vector<std::pair<double, PositionedID> > ranged;
+  ranged.reserve(ids.size());
+  BOOST_FOREACH(PositionedID id, ids) {
+    FGPositioned* pos = loadById(id);
+    ranged.push_back(std::make_pair(distSqr(cartPos, pos->cart()), id));
+  }
   
-  return d->selectIds(d->findNavsByFreq);
+  std::sort(ranged.begin(), ranged.end());
+  PositionedIDVec result;
+  result.reserve(ranged.size());
+  for (unsigned int i=0; i<ranged.size(); ++i) {
+    result.push_back(ranged[i].second);
+  }
+  return result;
 }
 
 PositionedIDVec
 NavDataCache::findNavaidsByFreq(int freqKhz, FGPositioned::Filter* aFilter)
 {
-  sqlite3_bind_int(d->findNavsByFreqNoPos, 1, freqKhz);
   if (aFilter) {
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 2, aFilter->minType());
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 3, aFilter->maxType());
-  } else { // full type range
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 2, FGPositioned::NDB);
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 3, FGPositioned::GS);
+    return d->navaidsByFreq(freqKhz, aFilter->minType(), aFilter->maxType());
   }
   
-  return d->selectIds(d->findNavsByFreqNoPos);
+  // full type range
+  return d->navaidsByFreq(freqKhz, FGPositioned::NDB, FGPositioned::GS);
 }
   
 PositionedIDVec
@@ -1949,6 +2387,8 @@ void NavDataCache::insertEdge(int network, int airwayID, PositionedID from, Posi
     
     std::swap(from, to);
   }
+  
+  d->airwayEdgeCache.clear();
 }
   
 bool NavDataCache::isInAirwayNetwork(int network, PositionedID pos)
@@ -1963,10 +2403,15 @@ bool NavDataCache::isInAirwayNetwork(int network, PositionedID pos)
 
 AirwayEdgeVec NavDataCache::airwayEdgesFrom(int network, PositionedID pos)
 {
+  AirwayEdgeKey key(network, pos);
+  AirwayEdgeVec result;
+  if (d->queryCachesEnabled && d->airwayEdgeCache.get(key, result)) {
+    return result;
+  }
+  
   sqlite3_bind_int(d->airwayEdgesFrom, 1, network);
   sqlite3_bind_int64(d->airwayEdgesFrom, 2, pos);
   
-  AirwayEdgeVec result;
   while (d->stepSelect(d->airwayEdgesFrom)) {
     result.push_back(AirwayEdge(
                      sqlite3_column_int(d->airwayEdgesFrom, 0),
@@ -1975,6 +2420,10 @@ AirwayEdgeVec NavDataCache::airwayEdgesFrom(int network, PositionedID pos)
   }
   
   d->reset(d->airwayEdgesFrom);
+  
+  if (d->queryCachesEnabled) {
+    d->airwayEdgeCache.put(key, result);
+  }
   return result;
 }
 
@@ -2038,6 +2487,7 @@ void NavDataCache::insertGroundnetEdge(PositionedID aAirport, PositionedID from,
   sqlite3_bind_int64(d->insertTaxiEdge, 2, from);
   sqlite3_bind_int64(d->insertTaxiEdge, 3, to);
   d->execInsert(d->insertTaxiEdge);
+  d->groundnetEdgeCache.clear();
 }
   
 PositionedIDVec NavDataCache::groundNetNodes(PositionedID aAirport, bool onlyPushback)
@@ -2051,6 +2501,7 @@ void NavDataCache::markGroundnetAsPushback(PositionedID nodeId)
 {
   sqlite3_bind_int64(d->markTaxiNodeAsPushback, 1, nodeId);
   d->execUpdate(d->markTaxiNodeAsPushback);
+  d->groundnetEdgeCache.clear(); // the pushback edges changed
 }
 
 static double headingDifferenceDeg(double crs1, double crs2)
@@ -2094,9 +2545,20 @@ PositionedID NavDataCache::findGroundNetNode(PositionedID airport, const SGGeod&
   
 PositionedIDVec NavDataCache::groundNetEdgesFrom(PositionedID pos, bool onlyPushback)
 {
+  GroundnetEdgeKey key(pos, onlyPushback);
+  PositionedIDVec result;
+  if (d->queryCachesEnabled && d->groundnetEdgeCache.get(key, result)) {
+    return result;
+  }
+  
   sqlite3_stmt_ptr q = onlyPushback ? d->pushbackEdgesFrom : d->taxiEdgesFrom;
   sqlite3_bind_int64(q, 1, pos);
-  return d->selectIds(q);
+  result = d->selectIds(q);
+  
+  if (d->queryCachesEnabled) {
+    d->groundnetEdgeCache.put(key, result);
+  }
+  return result;
 }
 
 PositionedIDVec NavDataCache::findAirportParking(PositionedID airport, const std::string& flightType,
@@ -2111,26 +2573,30 @@ PositionedIDVec NavDataCache::findAirportParking(PositionedID airport, const std
 
 void NavDataCache::dropGroundnetFor(PositionedID aAirport)
 {
-  sqlite3_stmt_ptr q = d->prepare("DELETE FROM parking WHERE rowid IN (SELECT rowid FROM positioned WHERE type=?1 AND airport=?2)");
-  sqlite3_bind_int(q, 1, FGPositioned::PARKING);
-  sqlite3_bind_int64(q, 2, aAirport);
-  d->execUpdate(q);
+  sqlite3_bind_int(d->dropParking, 1, FGPositioned::PARKING);
+  sqlite3_bind_int64(d->dropParking, 2, aAirport);
+  d->execUpdate(d->dropParking);
   
-  q = d->prepare("DELETE FROM taxi_node WHERE rowid IN (SELECT rowid FROM positioned WHERE (type=?1 OR type=?2) AND airport=?3)");
-  sqlite3_bind_int(q, 1, FGPositioned::TAXI_NODE);
-  sqlite3_bind_int(q, 2, FGPositioned::PARKING);
-  sqlite3_bind_int64(q, 3, aAirport);
-  d->execUpdate(q);
+  sqlite3_bind_int(d->dropTaxiNodes, 1, FGPositioned::TAXI_NODE);
+  sqlite3_bind_int(d->dropTaxiNodes, 2, FGPositioned::PARKING);
+  sqlite3_bind_int64(d->dropTaxiNodes, 3, aAirport);
+  d->execUpdate(d->dropTaxiNodes);
   
-  q = d->prepare("DELETE FROM positioned WHERE (type=?1 OR type=?2) AND airport=?3");
-  sqlite3_bind_int(q, 1, FGPositioned::TAXI_NODE);
-  sqlite3_bind_int(q, 2, FGPositioned::PARKING);
-  sqlite3_bind_int64(q, 3, aAirport);
-  d->execUpdate(q);
+  sqlite3_bind_int(d->dropGroundnetPositioned, 1, FGPositioned::TAXI_NODE);
+  sqlite3_bind_int(d->dropGroundnetPositioned, 2, FGPositioned::PARKING);
+  sqlite3_bind_int64(d->dropGroundnetPositioned, 3, aAirport);
+  d->execUpdate(d->dropGroundnetPositioned);
   
-  q = d->prepare("DELETE FROM groundnet_edge WHERE airport=?1");
-  sqlite3_bind_int64(q, 1, aAirport);
-  d->execUpdate(q);
+  sqlite3_bind_int64(d->dropGroundnetEdges, 1, aAirport);
+  d->execUpdate(d->dropGroundnetEdges);
+  
+  d->groundnetEdgeCache.clear();
+  ++d->groundnetGeneration;
+}
+
+unsigned int NavDataCache::groundnetGeneration() const
+{
+  return d->groundnetGeneration;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,7 @@
 #include <Navaids/positioned.hxx>
     
 class SGPath;
+class SGPropertyNode;
 class FGRunway;
 
 namespace flightgear
@@ -92,6 +93,20 @@ public:
    */
   FGPositioned* loadById(PositionedID guid);
   
+  /**
+   * write the hit / miss counts and sizes of the in-memory caches (loaded
+   * objects, and adjacency / frequency query results) below a node
+   */
+  void writeCacheStatistics(SGPropertyNode* aNode) const;
+  
+  /**
+   * Replay a random mix of navaid-by-frequency, airway and ground-network
+   * lookups, sampled from the cache file, once against SQLite and once
+   * through the in-memory caches. Timings are logged and written below
+   * aResults, if not NULL.
+   */
+  void benchmarkQueries(unsigned int aNumQueries, SGPropertyNode* aResults);
+  
   PositionedID insertAirport(FGPositioned::Type ty, const std::string& ident,
                              const std::string& name);
   void insertTower(PositionedID airportId, const SGGeod& pos);
@@ -120,6 +135,12 @@ public:
   
   void dropGroundnetFor(PositionedID aAirport);
   
+  /**
+   * incremented each time a ground network is dropped, so data derived
+   * from the ground networks can tell it must be rebuilt
+   */
+  unsigned int groundnetGeneration() const;
+  
   PositionedID insertParking(const std::string& name, const SGGeod& aPos,
                              PositionedID aAirport,
                              double aHeading, int aRadius, const std::string& aAircraftType,
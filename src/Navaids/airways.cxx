@@ -22,13 +22,13 @@
 #endif
 
 #include "airways.hxx"
+#include "DatFileReader.hxx"
 
 #include <algorithm>
 #include <set>
 
 #include <simgear/sg_inlines.h>
 #include <simgear/structure/exception.hxx>
-#include <simgear/misc/sgstream.hxx>
 #include <simgear/misc/sg_path.hxx>
 
 #include <boost/foreach.hpp>
@@ -123,42 +123,66 @@ Airway::Airway(const std::string& aIdent, double aTop, double aBottom) :
 
 void Airway::load(const SGPath& path)
 {
-  std::string identStart, identEnd, name;
-  double latStart, lonStart, latEnd, lonEnd;
-  int type, base, top;
-  //int airwayIndex = 0;
-  //FGNode *n;
-
-  sg_gzifstream in( path.str() );
-  if ( !in.is_open() ) {
+  EdgeRecordVec records;
+  parse(path, records);
+  insertEdges(records);
+}
+
+void Airway::parse(const SGPath& path, EdgeRecordVec& records)
+{
+  DatFileReader in(path);
+  if ( !in.isOpen() ) {
     SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
     throw sg_io_exception("Could not open airways data", sg_location(path.str()));
   }
 // toss the first two lines of the file
-  in >> skipeol;
-  in >> skipeol;
+  in.nextLine();
+  in.nextLine();
 
 // read in each remaining line of the file
-  while (!in.eof()) {
-    in >> identStart;
-
-    if (identStart == "99") {
+  EdgeRecord r;
+  while (in.nextLine()) {
+    if (in.numTokens() == 0) {
+      continue;
+    }
+    
+    if (in.token(0) == "99") {
       break;
     }
     
-    in >> latStart >> lonStart >> identEnd >> latEnd >> lonEnd >> type >> base >> top >> name;
-    in >> skipeol;
+    if (in.numTokens() < 10) {
+      SG_LOG(SG_NAVAID, SG_WARN, "malformed airway line " << in.lineNumber()
+             << " in " << path.str());
+      continue;
+    }
+    
+    r.identStart = in.token(0).str();
+    r.latStart = in.token(1).toDouble();
+    r.lonStart = in.token(2).toDouble();
+    r.identEnd = in.token(3).str();
+    r.latEnd = in.token(4).toDouble();
+    r.lonEnd = in.token(5).toDouble();
+    r.type = in.token(6).toInt();
+    r.base = in.token(7).toInt();
+    r.top = in.token(8).toInt();
+    r.name = in.token(9).str();
+    records.push_back(r);
+  } // of file line iteration
+}
 
+void Airway::insertEdges(const EdgeRecordVec& records)
+{
+  for (EdgeRecordVec::const_iterator it = records.begin(); it != records.end(); ++it) {
     // type = 1; low-altitude
     // type = 2; high-altitude
-    Network* net = (type == 1) ? lowLevel() : highLevel();
+    Network* net = (it->type == 1) ? lowLevel() : highLevel();
   
-    SGGeod startPos(SGGeod::fromDeg(lonStart, latStart)),
-      endPos(SGGeod::fromDeg(lonEnd, latEnd));
+    SGGeod startPos(SGGeod::fromDeg(it->lonStart, it->latStart)),
+      endPos(SGGeod::fromDeg(it->lonEnd, it->latEnd));
     
-    int awy = net->findAirway(name, top, base);
-    net->addEdge(awy, startPos, identStart, endPos, identEnd);
-  } // of file line iteration
+    int awy = net->findAirway(it->name, it->top, it->base);
+    net->addEdge(awy, startPos, it->identStart, endPos, it->identEnd);
+  }
 }
 
 int Airway::Network::findAirway(const std::string& aName, double aTop, double aBase)
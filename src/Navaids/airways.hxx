@@ -44,6 +44,28 @@ public:
   
   static void load(const SGPath& path);
   
+  /// an awy.dat record, parsed but not yet inserted into the cache
+  struct EdgeRecord
+  {
+    std::string identStart, identEnd, name;
+    double latStart, lonStart, latEnd, lonEnd;
+    int type, base, top;
+  };
+  
+  typedef std::vector<EdgeRecord> EdgeRecordVec;
+  
+  /**
+   * parse awy.dat into records, without touching the NavDataCache, so
+   * this may run on any thread.
+   */
+  static void parse(const SGPath& path, EdgeRecordVec& records);
+  
+  /**
+   * insert parsed airway edges. The end points are looked up by ident
+   * and position, so fixes and navaids must be in the cache already.
+   */
+  static void insertEdges(const EdgeRecordVec& records);
+  
   /**
    * Track a network of airways
    *
@@ -28,11 +28,11 @@
 #include <algorithm>
 
 #include <simgear/debug/logstream.hxx>
-#include <simgear/misc/sgstream.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/math/sg_geodesy.hxx>
 
 #include "fixlist.hxx"
+#include "DatFileReader.hxx"
 #include <Navaids/fix.hxx>
 #include <Navaids/NavDataCache.hxx>
 
@@ -47,29 +47,53 @@ namespace flightgear
   
 void loadFixes(const SGPath& path)
 {
-  sg_gzifstream in( path.str() );
-  if ( !in.is_open() ) {
-    SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
+  FixRecordVec records;
+  if (!parseFixes(path, records)) {
     exit(-1);
   }
   
-  // toss the first two lines of the file
-  in >> skipeol;
-  in >> skipeol;
+  insertFixes(records);
+}
   
-  NavDataCache* cache = NavDataCache::instance();
+bool parseFixes(const SGPath& path, FixRecordVec& records)
+{
+  DatFileReader in(path);
+  if ( !in.isOpen() ) {
+    SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
+    return false;
+  }
+  
+  // toss the first two lines of the file
+  in.nextLine();
+  in.nextLine();
   
   // read in each remaining line of the file
-  while ( ! in.eof() ) {
-    double lat, lon;
-    std::string ident;
-    in >> lat >> lon >> ident;
-    if (lat > 95) break;
+  FixRecord r;
+  while (in.nextLine()) {
+    if ((in.numTokens() == 0) || (in.line()[0] == '#')) {
+      continue; // blank line or comment
+    }
     
-    cache->insertFix(ident, SGGeod::fromDeg(lon, lat));
-    in >> skipcomment;
+    r.lat = in.token(0).toDouble();
+    if (r.lat > 95) break;
+    if (in.numTokens() < 3) {
+      continue;
+    }
+    
+    r.lon = in.token(1).toDouble();
+    r.ident = in.token(2).str();
+    records.push_back(r);
+  }
+  
+  return true;
+}
+  
+void insertFixes(const FixRecordVec& records)
+{
+  NavDataCache* cache = NavDataCache::instance();
+  for (FixRecordVec::const_iterator it = records.begin(); it != records.end(); ++it) {
+    cache->insertFix(it->ident, SGGeod::fromDeg(it->lon, it->lat));
   }
-
 }
   
 } // of namespace flightgear;
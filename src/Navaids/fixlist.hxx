@@ -27,13 +27,33 @@
 
 #include <simgear/compiler.h>
 
+#include <string>
+#include <vector>
+
 class SGPath;
 
 namespace flightgear
 {
   
+  /// a fix.dat record, parsed but not yet inserted into the cache
+  struct FixRecord
+  {
+    std::string ident;
+    double lat, lon;
+  };
+  
+  typedef std::vector<FixRecord> FixRecordVec;
+  
   void loadFixes(const SGPath& path);
   
+  /**
+   * parse fix.dat into records, without touching the NavDataCache, so
+   * this may run on any thread. Returns false if the file can't be read.
+   */
+  bool parseFixes(const SGPath& path, FixRecordVec& records);
+  
+  void insertFixes(const FixRecordVec& records);
+  
 }
 
 #endif // _FG_FIXLIST_HXX
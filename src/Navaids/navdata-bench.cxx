@@ -0,0 +1,151 @@
+// navdata-bench - compare the old istream / split based parsing of the
+// navigation data files with DatFileReader.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/misc/sgstream.hxx>
+#include <simgear/misc/strutils.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "DatFileReader.hxx"
+
+using std::string;
+using std::vector;
+
+// Both parsers convert every token of every line to a number, and
+// checksum the result so neither loop can be optimised away and the
+// two can be compared.
+struct BenchResult
+{
+  BenchResult() : lines(0), tokens(0), bytes(0), sum(0.0), msec(0.0) { }
+
+  unsigned int lines, tokens;
+  size_t bytes;
+  double sum;
+  double msec;
+};
+
+static BenchResult parseWithStream(const SGPath& path)
+{
+  BenchResult r;
+  SGTimeStamp st;
+  st.stamp();
+
+  sg_gzifstream in(path.str());
+  string line;
+  while (std::getline(in, line)) {
+    ++r.lines;
+    r.bytes += line.size() + 1;
+    vector<string> tokens(simgear::strutils::split(line));
+    for (unsigned int i = 0; i < tokens.size(); ++i) {
+      r.sum += atof(tokens[i].c_str());
+    }
+    r.tokens += tokens.size();
+  }
+
+  r.msec = st.elapsedMSec();
+  return r;
+}
+
+static BenchResult parseWithReader(const SGPath& path)
+{
+  BenchResult r;
+  SGTimeStamp st;
+  st.stamp();
+
+  flightgear::DatFileReader in(path);
+  while (in.nextLine()) {
+    ++r.lines;
+    for (unsigned int i = 0; i < in.numTokens(); ++i) {
+      r.sum += in.token(i).toDouble();
+    }
+    r.tokens += in.numTokens();
+  }
+
+  r.bytes = in.bytesRead();
+  r.msec = st.elapsedMSec();
+  return r;
+}
+
+static double mbPerSec(const BenchResult& r)
+{
+  if (r.msec <= 0.0) {
+    return 0.0;
+  }
+
+  return (r.bytes / (1024.0 * 1024.0)) / (r.msec / 1000.0);
+}
+
+static void bench(const SGPath& path)
+{
+  if (!path.exists()) {
+    printf("%s: not found, skipping\n", path.c_str());
+    return;
+  }
+
+  BenchResult a = parseWithStream(path);
+  BenchResult b = parseWithReader(path);
+
+  printf("%s: %u lines, %u tokens, %.1f MB\n", path.c_str(), b.lines, b.tokens,
+         b.bytes / (1024.0 * 1024.0));
+  printf("        stream: %8.1f ms %8.1f MB/s\n", a.msec, mbPerSec(a));
+  printf(" DatFileReader: %8.1f ms %8.1f MB/s\n", b.msec, mbPerSec(b));
+  printf("       speedup: %.2f\n", b.msec > 0.0 ? a.msec / b.msec : 0.0);
+  printf(" results match: %s\n",
+         ((a.tokens == b.tokens) && (a.sum == b.sum)) ? "yes" : "no");
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "Usage: navdata-bench <fg-root> [file.dat.gz ...]\n");
+    return 1;
+  }
+
+  SGPath root(argv[1]);
+  if (argc > 2) {
+    for (int i = 2; i < argc; ++i) {
+      bench(SGPath(argv[i]));
+    }
+    return 0;
+  }
+
+  const char* files[] = {
+    "Airports/apt.dat.gz",
+    "Navaids/nav.dat.gz",
+    "Navaids/fix.dat.gz",
+    "Navaids/awy.dat.gz",
+    NULL
+  };
+
+  for (int i = 0; files[i]; ++i) {
+    SGPath p(root);
+    p.append(files[i]);
+    bench(p);
+  }
+
+  return 0;
+}
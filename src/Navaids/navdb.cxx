@@ -37,6 +37,7 @@
 #include <simgear/sg_inlines.h>
 
 #include "navrecord.hxx"
+#include "DatFileReader.hxx"
 #include "navlist.hxx"
 #include <Main/globals.hxx>
 #include <Navaids/markerbeacon.hxx>
@@ -127,35 +128,48 @@ static double defaultNavRange(const string& ident, FGPositioned::Type type)
 namespace flightgear
 {
   
-static PositionedID readNavFromStream(std::istream& aStream,
-                                        FGPositioned::Type type = FGPositioned::INVALID)
+static bool readNavRecord(const DatFileReader& aLine, NavRecord& aRecord,
+                          FGPositioned::Type type = FGPositioned::INVALID)
 {
-  NavDataCache* cache = NavDataCache::instance();
-  
-  int rawType;
-  aStream >> rawType;
-  if (aStream.eof() || (rawType == 99)) {
-    return 0; // happens with, eg, carrier_nav.dat
+  if (aLine.numTokens() == 0) {
+    return false;
   }
   
-  double lat, lon, elev_ft, multiuse;
-  int freq, range;
-  std::string name, ident;
-  aStream >> lat >> lon >> elev_ft >> freq >> range >> multiuse >> ident;
-  getline(aStream, name);
+  int rawType = aLine.token(0).toInt();
+  if ((rawType == 99) || (aLine.numTokens() < 8)) {
+    return false; // happens with, eg, carrier_nav.dat
+  }
   
-  SGGeod pos(SGGeod::fromDegFt(lon, lat, elev_ft));
-  name = simgear::strutils::strip(name);
+  aRecord.lat = aLine.token(1).toDouble();
+  aRecord.lon = aLine.token(2).toDouble();
+  aRecord.elevFt = aLine.token(3).toDouble();
+  aRecord.freq = aLine.token(4).toInt();
+  aRecord.range = aLine.token(5).toInt();
+  aRecord.multiuse = aLine.token(6).toDouble();
+  aRecord.ident = aLine.token(7).str();
+  aRecord.name = aLine.rest(8).str();
   
 // the type can be forced by our caller, but normally we use th value
 // supplied in the .dat file
   if (type == FGPositioned::INVALID) {
     type = mapRobinTypeToFGPType(rawType);
   }
-  if (type == FGPositioned::INVALID) {
-    return 0;
-  }
-
+  
+  aRecord.type = type;
+  return (type != FGPositioned::INVALID);
+}
+  
+static PositionedID insertNavRecord(const NavRecord& aRecord)
+{
+  NavDataCache* cache = NavDataCache::instance();
+  
+  FGPositioned::Type type = aRecord.type;
+  const string& name(aRecord.name);
+  const string& ident(aRecord.ident);
+  double elev_ft = aRecord.elevFt, multiuse = aRecord.multiuse;
+  int freq = aRecord.freq, range = aRecord.range;
+  SGGeod pos(SGGeod::fromDegFt(aRecord.lon, aRecord.lat, elev_ft));
+  
   if ((type >= FGPositioned::OM) && (type <= FGPositioned::IM)) {
     AirportRunwayPair arp(cache->findAirportRunway(name));
     if (arp.second && (elev_ft < 0.01)) {
@@ -218,46 +232,70 @@ static PositionedID readNavFromStream(std::istream& aStream,
 // load and initialize the navigational databases
 bool navDBInit(const SGPath& path)
 {
-    sg_gzifstream in( path.str() );
-    if ( !in.is_open() ) {
-        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
-      return false;
-    }
-  
-  autoAlignLocalizers = fgGetBool("/sim/navdb/localizers/auto-align", true);
-  autoAlignThreshold = fgGetDouble( "/sim/navdb/localizers/auto-align-threshold-deg", 5.0 );
-
-    // skip first two lines
-    in >> skipeol;
-    in >> skipeol;
-
-    while (!in.eof()) {
-      readNavFromStream(in);
-      in >> skipcomment;
-    } // of stream data loop
+  NavRecordVec records;
+  if (!parseNavaids(path, false, records)) {
+    return false;
+  }
   
+  insertNavaids(records);
   return true;
 }
   
   
 bool loadCarrierNav(const SGPath& path)
 {    
+  NavRecordVec records;
+  if (!parseNavaids(path, true, records)) {
+    return false;
+  }
+  
+  insertNavaids(records);
+  return true;
+}
+  
+bool parseNavaids(const SGPath& path, bool isCarrierNav, NavRecordVec& records)
+{
     SG_LOG( SG_NAVAID, SG_INFO, "opening file: " << path.str() );    
-    sg_gzifstream incarrier( path.str() );
-    
-    if ( !incarrier.is_open() ) {
+    DatFileReader in(path);
+    if ( !in.isOpen() ) {
         SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
       return false;
     }
-    
-    while ( ! incarrier.eof() ) {
-      // force the type to be MOBILE_TACAN
-      readNavFromStream(incarrier, FGPositioned::MOBILE_TACAN);
-    } // end while
+  
+    if (!isCarrierNav) {
+      // skip first two lines
+      in.nextLine();
+      in.nextLine();
+    }
 
+    NavRecord r;
+    while (in.nextLine()) {
+      if (in.line()[0] == '#') {
+        continue; // comment
+      }
+      
+      // carrier navaids are forced to be MOBILE_TACAN
+      if (readNavRecord(in, r, isCarrierNav ? FGPositioned::MOBILE_TACAN
+                                            : FGPositioned::INVALID)) {
+        records.push_back(r);
+      } else if ((in.numTokens() > 0) && (in.token(0) == "99")) {
+        break; // end-of-file code
+      }
+    } // of stream data loop
+  
   return true;
 }
   
+void insertNavaids(const NavRecordVec& records)
+{
+  autoAlignLocalizers = fgGetBool("/sim/navdb/localizers/auto-align", true);
+  autoAlignThreshold = fgGetDouble( "/sim/navdb/localizers/auto-align-threshold-deg", 5.0 );
+  
+  for (NavRecordVec::const_iterator it = records.begin(); it != records.end(); ++it) {
+    insertNavRecord(*it);
+  }
+}
+  
 bool loadTacan(const SGPath& path, FGTACANList *channellist)
 {
     SG_LOG( SG_NAVAID, SG_INFO, "opening file: " << path.str() );
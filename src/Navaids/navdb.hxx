@@ -27,6 +27,9 @@
 
 #include <simgear/compiler.h>
 #include <string>
+#include <vector>
+
+#include <Navaids/positioned.hxx>
 
 // forward decls
 class FGTACANList;
@@ -41,6 +44,30 @@ namespace flightgear
 bool navDBInit(const SGPath& path);
   
 bool loadCarrierNav(const SGPath& path);
+
+/// a nav.dat record, parsed but not yet inserted into the cache
+struct NavRecord
+{
+  FGPositioned::Type type;
+  double lat, lon, elevFt, multiuse;
+  int freq, range;
+  std::string ident, name;
+};
+
+typedef std::vector<NavRecord> NavRecordVec;
+
+/**
+ * parse nav.dat (or, with isCarrierNav, carrier_nav.dat) into records,
+ * without touching the NavDataCache, so this may run on any thread.
+ * Returns false if the file can't be read.
+ */
+bool parseNavaids(const SGPath& path, bool isCarrierNav, NavRecordVec& records);
+
+/**
+ * insert parsed navaids. nav.dat records refer to airports and runways,
+ * so these must be in the cache already.
+ */
+void insertNavaids(const NavRecordVec& records);
   
 bool loadTacan(const SGPath& path, FGTACANList *channellist);
 
@@ -27,6 +27,8 @@
 #include <string.h>                // strstr()
 #include <stdlib.h>                // strtod(), atoi()
 
+#include <algorithm>
+
 #include <simgear/debug/logstream.hxx>
 #include <simgear/io/iochannel.hxx>
 #include <simgear/structure/exception.hxx>
@@ -35,6 +37,7 @@
 #include <simgear/props/props.hxx>
 #include <simgear/props/props_io.hxx>
 #include <simgear/math/SGMath.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
@@ -42,7 +45,12 @@
 #include <Main/util.hxx>
 #include "generic.hxx"
 
-FGGeneric::FGGeneric(vector<string> tokens) : exitOnError(false), initOk(false)
+FGGeneric::FGGeneric(vector<string> tokens) :
+    _out_plan_ok(false),
+    _in_plan_ok(false),
+    _out_plan_length(0),
+    exitOnError(false),
+    initOk(false)
 {
     size_t configToken;
     if (tokens[1] == "socket") {
@@ -72,6 +80,16 @@ FGGeneric::FGGeneric(vector<string> tokens) : exitOnError(false), initOk(false)
     reinit();
 }
 
+// only used for benchmarking, configured through read_config()
+FGGeneric::FGGeneric() :
+    _out_plan_ok(false),
+    _in_plan_ok(false),
+    _out_plan_length(0),
+    exitOnError(false),
+    initOk(false)
+{
+}
+
 FGGeneric::~FGGeneric() {
 }
 
@@ -144,7 +162,7 @@ bool FGGeneric::gen_message_binary() {
         case FG_DOUBLE:
         {
             val = _out_message[i].offset +
-                 _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+                 _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
             u64 tmpun64;
             tmpun64.doubleVal = val;
 
@@ -181,7 +199,12 @@ bool FGGeneric::gen_message_binary() {
         }
     }
 
-    // add the footer to the packet ("line")
+    add_binary_footer();
+    return true;
+}
+
+// add the footer to the packet ("line")
+void FGGeneric::add_binary_footer() {
     switch (binary_footer_type) {
         case FOOTER_LENGTH:
             binary_footer_value = length;
@@ -200,74 +223,200 @@ bool FGGeneric::gen_message_binary() {
         memcpy(&buf[length], &intValue, sizeof(int32_t));
         length += sizeof(int32_t);
     }
+}
 
-    return true;
+// append n characters to the message, as far as there is room for them
+static inline void append_to_message(char *&p, const char *end,
+                                     const char *data, size_t n)
+{
+    if (n > (size_t)(end - p)) {
+        n = end - p;
+    }
+    memcpy(p, data, n);
+    p += n;
 }
 
 bool FGGeneric::gen_message_ascii() {
-    string generic_sentence;
-    char tmp[255];
+    // chunks are formatted straight into the message buffer, limited to
+    // 255 characters each as before
+    const int max_chunk = 255;
+    char *p = buf;
+    char *end = buf + FG_MAX_MSG_SIZE;
     length = 0;
 
     double val;
     for (unsigned int i = 0; i < _out_message.size(); i++) {
+        const _serial_prot &chunk = _out_message[i];
 
         if (i > 0) {
-            generic_sentence += var_separator;
+            append_to_message(p, end, var_separator.data(), var_separator.size());
         }
 
-        switch (_out_message[i].type) {
+        // snprintf needs room for the terminator, which is overwritten by
+        // the next chunk
+        int room = std::min<int>(max_chunk, end - p);
+        if (room <= 1) {
+            break;
+        }
+
+        int n;
+        switch (chunk.type) {
         case FG_INT:
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getIntValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (int)val);
+            val = chunk.offset + chunk.prop->getIntValue() * chunk.factor;
+            n = snprintf(p, room, chunk.format.c_str(), (int)val);
             break;
 
         case FG_BOOL:
-            snprintf(tmp, 255, _out_message[i].format.c_str(),
-                               _out_message[i].prop->getBoolValue());
+            n = snprintf(p, room, chunk.format.c_str(), chunk.prop->getBoolValue());
             break;
 
         case FG_FIXED:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (float)val);
-            break;
-
         case FG_FLOAT:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (float)val);
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            n = snprintf(p, room, chunk.format.c_str(), (float)val);
             break;
 
         case FG_DOUBLE:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (double)val);
+            val = chunk.offset + chunk.prop->getDoubleValue() * chunk.factor;
+            n = snprintf(p, room, chunk.format.c_str(), (double)val);
             break;
 
         default: // SG_STRING
-            snprintf(tmp, 255, _out_message[i].format.c_str(),
-                                   _out_message[i].prop->getStringValue());
+            n = snprintf(p, room, chunk.format.c_str(), chunk.prop->getStringValue());
         }
 
-        generic_sentence += tmp;
+        if (n > 0) {
+            p += std::min(n, room - 1);
+        }
     }
 
     /* After each lot of variables has been added, put the line separator
      * char/string
      */
-    generic_sentence += line_separator;
+    append_to_message(p, end, line_separator.data(), line_separator.size());
+
+    length = p - buf;
+    return true;
+}
+
+bool FGGeneric::compile_binary_plan(const vector<_serial_prot> &msg,
+                                    vector<_binary_slot> &plan, int &record_length)
+{
+    plan.clear();
+    record_length = 0;
+
+    for (unsigned int i = 0; i < msg.size(); i++) {
+        _binary_slot slot;
+        slot.type = msg[i].type;
+        slot.pos = record_length;
+        slot.offset = msg[i].offset;
+        slot.factor = msg[i].factor;
+        slot.prop = msg[i].prop.ptr();
+        slot.chunk = i;
+
+        switch (msg[i].type) {
+        case FG_BOOL:
+            slot.size = 1;
+            break;
+        case FG_DOUBLE:
+            slot.size = sizeof(int64_t);
+            break;
+        case FG_STRING:
+            // variable length, no fixed layout
+            plan.clear();
+            return false;
+        default:
+            slot.size = sizeof(int32_t);
+            break;
+        }
+
+        record_length += slot.size;
+        plan.push_back(slot);
+    }
+
+    return true;
+}
+
+void FGGeneric::swap_binary_record(char *rec, int length,
+                                   const vector<_binary_slot> &plan)
+{
+    for (vector<_binary_slot>::const_iterator it = plan.begin(); it != plan.end(); ++it) {
+        if (it->pos + it->size > length) {
+            break;
+        }
+
+        char *p = rec + it->pos;
+        if (it->size == sizeof(uint32_t)) {
+            uint32_t v;
+            memcpy(&v, p, sizeof(uint32_t));
+            v = sg_bswap_32(v);
+            memcpy(p, &v, sizeof(uint32_t));
+        } else if (it->size == sizeof(uint64_t)) {
+            uint64_t v;
+            memcpy(&v, p, sizeof(uint64_t));
+            v = sg_bswap_64(v);
+            memcpy(p, &v, sizeof(uint64_t));
+        }
+    }
+}
+
+// generate a fixed-layout message: store all values in host order at their
+// precomputed offsets, then fix the byte order of the whole record at once
+bool FGGeneric::gen_message_binary_plan() {
+    for (vector<_binary_slot>::const_iterator it = _out_plan.begin(); it != _out_plan.end(); ++it) {
+        char *p = buf + it->pos;
+
+        switch (it->type) {
+        case FG_INT:
+        {
+            int32_t intVal = it->offset + it->prop->getIntValue() * it->factor;
+            memcpy(p, &intVal, sizeof(int32_t));
+            break;
+        }
+
+        case FG_BOOL:
+            *p = (char) (it->prop->getBoolValue() ? true : false);
+            break;
+
+        case FG_FIXED:
+        {
+            double val = it->offset + it->prop->getFloatValue() * it->factor;
+            int32_t fixed = (int)(val * 65536.0f);
+            memcpy(p, &fixed, sizeof(int32_t));
+            break;
+        }
+
+        case FG_FLOAT:
+        {
+            float floatVal = static_cast<float>(it->offset + it->prop->getFloatValue() * it->factor);
+            memcpy(p, &floatVal, sizeof(float));
+            break;
+        }
+
+        case FG_DOUBLE:
+        {
+            double doubleVal = it->offset + it->prop->getDoubleValue() * it->factor;
+            memcpy(p, &doubleVal, sizeof(double));
+            break;
+        }
+
+        default: // strings are never part of a plan
+            break;
+        }
+    }
 
-    length =  generic_sentence.length();
-    strncpy( buf, generic_sentence.c_str(), length );
+    length = _out_plan_length;
+    if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
+        swap_binary_record(buf, length, _out_plan);
+    }
 
+    add_binary_footer();
     return true;
 }
 
 bool FGGeneric::gen_message() {
     if (binary_mode) {
-        return gen_message_binary();
+        return _out_plan_ok ? gen_message_binary_plan() : gen_message_binary();
     } else {
         return gen_message_ascii();
     }
@@ -339,6 +488,66 @@ bool FGGeneric::parse_message_binary(int length) {
     return true;
 }
 
+// parse a fixed-layout message: fix the byte order of the whole record at
+// once, then read all values from their precomputed offsets
+bool FGGeneric::parse_message_binary_plan(int length) {
+    if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
+        swap_binary_record(buf, length, _in_plan);
+    }
+
+    for (vector<_binary_slot>::const_iterator it = _in_plan.begin(); it != _in_plan.end(); ++it) {
+        if (it->pos + it->size > length) {
+            break;
+        }
+
+        const char *p = buf + it->pos;
+        _serial_prot &chunk = _in_message[it->chunk];
+
+        switch (it->type) {
+        case FG_INT:
+        {
+            int32_t intVal;
+            memcpy(&intVal, p, sizeof(int32_t));
+            updateValue(chunk, (int)intVal);
+            break;
+        }
+
+        case FG_BOOL:
+            updateValue(chunk, p[0] != 0);
+            break;
+
+        case FG_FIXED:
+        {
+            int32_t fixed;
+            memcpy(&fixed, p, sizeof(int32_t));
+            updateValue(chunk, (float)fixed / 65536.0f);
+            break;
+        }
+
+        case FG_FLOAT:
+        {
+            float floatVal;
+            memcpy(&floatVal, p, sizeof(float));
+            updateValue(chunk, floatVal);
+            break;
+        }
+
+        case FG_DOUBLE:
+        {
+            double doubleVal;
+            memcpy(&doubleVal, p, sizeof(double));
+            updateValue(chunk, doubleVal);
+            break;
+        }
+
+        default: // strings are never part of a plan
+            break;
+        }
+    }
+
+    return true;
+}
+
 bool FGGeneric::parse_message_ascii(int length) {
     char *p1 = buf;
     int i = -1;
@@ -398,7 +607,8 @@ bool FGGeneric::parse_message_ascii(int length) {
 
 bool FGGeneric::parse_message_len(int length) {
     if (binary_mode) {
-        return parse_message_binary(length);
+        return _in_plan_ok ? parse_message_binary_plan(length)
+                           : parse_message_binary(length);
     } else {
         return parse_message_ascii(length);
     }
@@ -502,6 +712,51 @@ error_out:
 }
 
 
+bool FGGeneric::supports_threaded_io() const {
+    // files are read record by record in lock-step with the simulation
+    return get_io_channel()->get_type() != sgFileType;
+}
+
+int FGGeneric::gen_message_into(char *data, int size) {
+    gen_message();
+    int n = std::min(length, size);
+    memcpy(data, buf, n);
+    return n;
+}
+
+int FGGeneric::read_record(char *data, int size) {
+    SGIOChannel *io = get_io_channel();
+    if (!binary_mode) {
+        return io->readline( data, size );
+    }
+
+    int n = io->read( data, std::min(binary_record_length, size) );
+    if ( n > 0 && n != binary_record_length ) {
+        SG_LOG( SG_IO, SG_ALERT,
+                "Generic protocol: Received binary "
+                "record of unexpected size, expected: "
+                << binary_record_length << " but received: "
+                << n);
+        return 0;
+    }
+    return n;
+}
+
+bool FGGeneric::parse_record(const char *data, int length) {
+    if (length <= 0 || length > FG_MAX_MSG_SIZE) {
+        return false;
+    }
+    memcpy(buf, data, length);
+    return parse_message_len( length );
+}
+
+void FGGeneric::write_failed() {
+    if (exitOnError) {
+        fgOSExit(1);
+    }
+}
+
+
 // close the channel
 bool FGGeneric::close() {
     SGIOChannel *io = get_io_channel();
@@ -528,6 +783,8 @@ bool FGGeneric::close() {
 void
 FGGeneric::reinit()
 {
+    _out_plan_ok = _in_plan_ok = false;
+
     SGPath path( globals->get_fg_root() );
     path.append("Protocol");
     path.append(file_name.c_str());
@@ -573,6 +830,12 @@ FGGeneric::reinit()
         }
     }
 
+    if (binary_mode) {
+        int in_length;
+        _out_plan_ok = compile_binary_plan(_out_message, _out_plan, _out_plan_length);
+        _in_plan_ok = compile_binary_plan(_in_message, _in_plan, in_length);
+    }
+
     initOk = true;
 }
 
@@ -759,3 +1022,88 @@ void FGGeneric::updateValue(FGGeneric::_serial_prot& prot, bool val)
     setValue(prot.prop, val);
   }
 }
+
+void FGGeneric::benchmark(int fields, int iterations, SGPropertyNode* results)
+{
+    static const char *types[] = { "int", "bool", "float", "double", "fixed" };
+    static const char *formats[] = { "%d", "%d", "%f", "%lf", "%f" };
+
+    SGPropertyNode *values = fgGetNode("/sim/generic-benchmark/values", true);
+    SGPropertyNode binary_config, ascii_config;
+    binary_config.setBoolValue("binary_mode", true);
+    ascii_config.setBoolValue("binary_mode", false);
+    ascii_config.setStringValue("var_separator", ",");
+    ascii_config.setStringValue("line_separator", "newline");
+
+    for (int i = 0; i < fields; i++) {
+        SGPropertyNode *value = values->getChild("field", i, true);
+        value->setDoubleValue(i * 1.25);
+
+        SGPropertyNode *chunks[] = { binary_config.getChild("chunk", i, true),
+                                     ascii_config.getChild("chunk", i, true) };
+        for (int c = 0; c < 2; c++) {
+            chunks[c]->setStringValue("type", types[i % 5]);
+            chunks[c]->setStringValue("format", formats[i % 5]);
+            chunks[c]->setStringValue("node", value->getPath());
+            chunks[c]->setDoubleValue("factor", 1.5);
+        }
+    }
+
+    FGGeneric out, in, ascii;
+    out.read_config(&binary_config, out._out_message);
+    in.read_config(&binary_config, in._in_message);
+    ascii.read_config(&ascii_config, ascii._out_message);
+    compile_binary_plan(out._out_message, out._out_plan, out._out_plan_length);
+    int in_length;
+    compile_binary_plan(in._in_message, in._in_plan, in_length);
+
+    SGTimeStamp st;
+    st.stamp();
+    for (int i = 0; i < iterations; i++) {
+        out.gen_message_binary();
+    }
+    double encode_msec = st.elapsedMSec();
+
+    st.stamp();
+    for (int i = 0; i < iterations; i++) {
+        out.gen_message_binary_plan();
+    }
+    double encode_plan_msec = st.elapsedMSec();
+
+    // decoding may swap the buffer in place, so start from a copy each time
+    int record_length = out.length;
+    st.stamp();
+    for (int i = 0; i < iterations; i++) {
+        memcpy(in.buf, out.buf, record_length);
+        in.parse_message_binary(record_length);
+    }
+    double decode_msec = st.elapsedMSec();
+
+    st.stamp();
+    for (int i = 0; i < iterations; i++) {
+        memcpy(in.buf, out.buf, record_length);
+        in.parse_message_binary_plan(record_length);
+    }
+    double decode_plan_msec = st.elapsedMSec();
+
+    st.stamp();
+    for (int i = 0; i < iterations; i++) {
+        ascii.gen_message_ascii();
+    }
+    double ascii_msec = st.elapsedMSec();
+
+    SG_LOG(SG_IO, SG_INFO, "Generic protocol benchmark, " << fields << " fields x "
+           << iterations << " messages: encode " << encode_msec << "ms (plan "
+           << encode_plan_msec << "ms), decode " << decode_msec << "ms (plan "
+           << decode_plan_msec << "ms), ASCII encode " << ascii_msec << "ms");
+
+    if (results) {
+        results->setIntValue("fields", fields);
+        results->setIntValue("iterations", iterations);
+        results->setDoubleValue("encode-msec", encode_msec);
+        results->setDoubleValue("encode-plan-msec", encode_plan_msec);
+        results->setDoubleValue("decode-msec", decode_msec);
+        results->setDoubleValue("decode-plan-msec", decode_plan_msec);
+        results->setDoubleValue("ascii-encode-msec", ascii_msec);
+    }
+}
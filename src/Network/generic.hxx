@@ -55,9 +55,24 @@ public:
     // close the channel
     bool close();
 
+    // threaded I/O, see FGProtocol
+    bool supports_threaded_io() const;
+    int gen_message_into(char *data, int size);
+    int read_record(char *data, int size);
+    bool parse_record(const char *data, int length);
+    void write_failed();
+
     void setExitOnError(bool val) { exitOnError = val; }
     bool getExitOnError() { return exitOnError; }
     bool getInitOk(void) { return initOk; }
+
+    /**
+     * Time encoding and decoding of a synthetic binary protocol with the
+     * given number of fields of each type, through the per-field and the
+     * compiled code paths. Results are logged and written below results,
+     * if not NULL.
+     */
+    static void benchmark(int fields, int iterations, SGPropertyNode* results);
 protected:
 
     enum e_type { FG_BOOL=0, FG_INT, FG_FLOAT, FG_DOUBLE, FG_STRING, FG_FIXED };
@@ -74,7 +89,20 @@ protected:
         SGPropertyNode_ptr prop;
     } _serial_prot;
 
+    // A chunk of a fixed-layout binary record, resolved once when the
+    // protocol is loaded.
+    typedef struct {
+        e_type type;
+        int pos;        // byte offset within the record
+        int size;       // bytes in the record
+        double offset;
+        double factor;
+        SGPropertyNode *prop;
+        int chunk;      // index of the originating _serial_prot
+    } _binary_slot;
+
 private:
+    FGGeneric();
 
     string file_name;
     string direction;
@@ -97,11 +125,27 @@ private:
     int binary_record_length;
     enum {BYTE_ORDER_NEEDS_CONVERSION, BYTE_ORDER_MATCHES_NETWORK_ORDER} binary_byte_order;
 
+    // Binary records without strings have a fixed layout, and are encoded
+    // and decoded through a precomputed plan (see compile_binary_plan).
+    // Records containing strings use the generic per-chunk path.
+    vector<_binary_slot> _out_plan;
+    vector<_binary_slot> _in_plan;
+    bool _out_plan_ok;
+    bool _in_plan_ok;
+    int _out_plan_length;
+
     bool gen_message_ascii();
     bool gen_message_binary();
+    bool gen_message_binary_plan();
+    void add_binary_footer();
     bool parse_message_ascii(int length);
     bool parse_message_binary(int length);
+    bool parse_message_binary_plan(int length);
     bool read_config(SGPropertyNode *root, vector<_serial_prot> &msg);
+    static bool compile_binary_plan(const vector<_serial_prot> &msg,
+                                    vector<_binary_slot> &plan, int &record_length);
+    static void swap_binary_record(char *rec, int length,
+                                   const vector<_binary_slot> &plan);
     bool exitOnError;
     bool initOk;
     
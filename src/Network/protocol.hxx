@@ -80,6 +80,27 @@ public:
     virtual bool gen_message();
     virtual bool parse_message();
 
+    // Threaded I/O. Protocols which can keep property access apart from
+    // channel I/O return true from supports_threaded_io(); FGIO may then
+    // call gen_message_into() and parse_record() from the main loop, and
+    // read_record() and the channel's write() from its I/O thread, instead
+    // of calling process().
+    virtual bool supports_threaded_io() const { return false; }
+
+    // generate the next outgoing message into data, returning its length
+    virtual int gen_message_into( char *data, int size ) { return 0; }
+
+    // read one incoming record from the channel, returning its length
+    // (zero or less if none is available)
+    virtual int read_record( char *data, int size ) { return 0; }
+
+    // apply a record returned by read_record()
+    virtual bool parse_record( const char *data, int length ) { return false; }
+
+    // called from the main loop when the I/O thread failed to write to the
+    // channel, to handle the error as process() would have
+    virtual void write_failed() {}
+
     // inline string get_protocol() const { return protocol_str; }
     // inline void set_protocol( const string& str ) { protocol_str = str; }
 
@@ -24,9 +24,15 @@
 #  include <config.h>
 #endif
 
+#include <algorithm>
+
+#include <simgear/constants.h>
 #include <simgear/bucket/newbucket.hxx>
 #include <simgear/debug/logstream.hxx>
+#include <simgear/math/sg_geodesy.hxx>
 #include <simgear/misc/sg_path.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include "tileentry.hxx"
 #include "tilecache.hxx"
@@ -43,11 +49,40 @@ TileCache::~TileCache( void ) {
 }
 
 
+bool TileCache::DropKey::operator<(const DropKey& other) const {
+    if (time_expired != other.time_expired)
+        return time_expired < other.time_expired;
+    if (priority != other.priority)
+        return priority < other.priority;
+    return index < other.index;
+}
+
+
+void TileCache::index_tile( long tile_index, TileEntry* e ) {
+    DropKey key;
+    key.time_expired = e->get_time_expired();
+    key.priority = e->get_priority();
+    key.index = tile_index;
+    drop_handles[tile_index] = drop_candidates.insert(key).first;
+}
+
+
+void TileCache::unindex_tile( long tile_index ) {
+    drop_handle_map::iterator it = drop_handles.find( tile_index );
+    if ( it == drop_handles.end() )
+        return;
+
+    drop_candidates.erase( it->second );
+    drop_handles.erase( it );
+}
+
+
 // Free a tile cache entry
 void TileCache::entry_free( long tile_index ) {
     SG_LOG( SG_TERRAIN, SG_DEBUG, "FREEING CACHE ENTRY = " << tile_index );
     TileEntry *tile = tile_cache[tile_index];
     tile->removeFromSceneGraph();
+    unindex_tile( tile_index );
     tile_cache.erase( tile_index );
     delete tile;
 }
@@ -80,68 +115,63 @@ bool TileCache::exists( const SGBucket& b ) const {
 // Return the index of a tile to be dropped from the cache, return -1 if
 // nothing available to be removed.
 long TileCache::get_drop_tile() {
-    long min_index = -1;
-    double min_time = DBL_MAX;
-    float priority = FLT_MAX;
-
-    tile_map_iterator current = tile_cache.begin();
-    tile_map_iterator end = tile_cache.end();
+    // tiles in the current view are never queued, so the front of the queue
+    // is the oldest tile with the lowest priority
+    drop_queue::const_iterator oldest = drop_candidates.begin();
+    if (( oldest == drop_candidates.end() )||
+        !( current_time > oldest->time_expired ))
+    {
+        SG_LOG( SG_TERRAIN, SG_DEBUG, "    no expired tile to drop" );
+        return -1;
+    }
 
-    for ( ; current != end; ++current ) {
-        long index = current->first;
-        TileEntry *e = current->second;
-        if (( !e->is_current_view() )&&
-            ( e->is_expired(current_time) ))
-        {
-            if (e->is_expired(current_time - 1.0)&&
-                !e->is_loaded())
-            {
-                /* Immediately drop "empty" tiles which are no longer used/requested, and were last requested > 1 second ago...
-                 * Allow a 1 second timeout since an empty tiles may just be loaded...
-                 */
-                SG_LOG( SG_TERRAIN, SG_DEBUG, "    dropping an unused and empty tile");
-                min_index = index;
-                break;
-            }
-            if (( e->get_time_expired() < min_time )||
-                (( e->get_time_expired() == min_time)&&
-                 ( priority > e->get_priority())))
-            {
-                // drop oldest tile with lowest priority
-                min_time = e->get_time_expired();
-                priority = e->get_priority();
-                min_index = index;
-            }
+    /* Immediately drop "empty" tiles which are no longer used/requested, and were last requested > 1 second ago...
+     * Allow a 1 second timeout since an empty tiles may just be loaded...
+     * Whether a tile is loaded changes in the pager thread, so it can't be
+     * part of the queue order; only look at the oldest few instead.
+     */
+    const int max_empty_scan = 16;
+    drop_queue::const_iterator it = oldest;
+    for (int i = 0; ( i < max_empty_scan )&&( it != drop_candidates.end() )&&
+             ( current_time - 1.0 > it->time_expired ); ++i, ++it)
+    {
+        TileEntry *e = get_tile( it->index );
+        if ( e && !e->is_loaded() ) {
+            SG_LOG( SG_TERRAIN, SG_DEBUG, "    dropping an unused and empty tile");
+            return it->index;
         }
     }
 
-    SG_LOG( SG_TERRAIN, SG_DEBUG, "    index = " << min_index );
-    SG_LOG( SG_TERRAIN, SG_DEBUG, "    min_time = " << min_time );
+    SG_LOG( SG_TERRAIN, SG_DEBUG, "    index = " << oldest->index );
+    SG_LOG( SG_TERRAIN, SG_DEBUG, "    min_time = " << oldest->time_expired );
 
-    return min_index;
+    return oldest->index;
 }
 
 
 // Clear all flags indicating tiles belonging to the current view
 void TileCache::clear_current_view()
 {
-    tile_map_iterator current = tile_cache.begin();
-    tile_map_iterator end = tile_cache.end();
+    std::vector<long>::const_iterator current = current_view_tiles.begin();
+    std::vector<long>::const_iterator end = current_view_tiles.end();
 
     for ( ; current != end; ++current ) {
-        TileEntry *e = current->second;
-        if (e->is_current_view())
+        TileEntry *e = get_tile( *current );
+        if (e && e->is_current_view())
         {
             // update expiry time for tiles belonging to most recent position
             e->update_time_expired( current_time );
             e->set_current_view( false );
+            index_tile( *current, e );
         }
     }
+    current_view_tiles.clear();
 }
 
 // Clear a cache entry, note that the cache only holds pointers
 // and this does not free the object which is pointed to.
 void TileCache::clear_entry( long tile_index ) {
+    unindex_tile( tile_index );
     tile_cache.erase( tile_index );
 }
 
@@ -175,6 +205,8 @@ bool TileCache::insert_tile( TileEntry *e ) {
     long tile_index = e->get_tile_bucket().gen_index();
     tile_cache[tile_index] = e;
     e->update_time_expired(current_time);
+    if (!e->is_current_view())
+        index_tile( tile_index, e );
 
     return true;
 }
@@ -200,6 +232,9 @@ void TileCache::request_tile(TileEntry* t,float priority,bool current_view,doubl
     if ((!current_view)&&(request_time<=0.0))
         return;
 
+    long tile_index = t->get_tile_bucket().gen_index();
+    unindex_tile( tile_index );
+
     // update priority when higher - or old request has expired
     if ((t->is_expired(current_time))||
          (priority > t->get_priority()))
@@ -210,10 +245,100 @@ void TileCache::request_tile(TileEntry* t,float priority,bool current_view,doubl
     if (current_view)
     {
         t->update_time_expired( current_time );
-        t->set_current_view( true );
+        if (!t->is_current_view())
+        {
+            t->set_current_view( true );
+            current_view_tiles.push_back( tile_index );
+        }
     }
     else
     {
         t->update_time_expired( current_time+request_time );
     }
+
+    if (!t->is_current_view())
+        index_tile( tile_index, t );
+}
+
+void TileCache::stress_test( double speed_kt, double duration_sec, double frame_rate,
+                             double range_m, SGPropertyNode* results )
+{
+    TileCache cache;
+    SGGeod pos = SGGeod::fromDeg(-122.0, 37.0);
+    const double course = 60.0;
+    const double dt = 1.0 / frame_rate;
+    const double step_m = speed_kt * SG_KT_TO_MPS * dt;
+
+    SGBucket previous;
+    previous.make_bad();
+    int frames = 0, schedules = 0, drops = 0;
+    double total_msec = 0.0, max_msec = 0.0;
+
+    for (double t = 0.0; t < duration_sec; t += dt, ++frames) {
+        SGTimeStamp st;
+        st.stamp();
+        cache.set_current_time( t );
+
+        // as FGTileMgr::schedule_needed, whenever a bucket boundary is crossed
+        SGBucket current( pos );
+        if ( current != previous ) {
+            int xrange = (int)(range_m / current.get_width_m()) + 1;
+            int yrange = (int)(range_m / current.get_height_m()) + 1;
+            cache.set_max_cache_size( (2*xrange + 2) * (2*yrange + 2) * 2 );
+            cache.clear_current_view();
+
+            for ( int x = -xrange; x <= xrange; ++x ) {
+                for ( int y = -yrange; y <= yrange; ++y ) {
+                    SGBucket b = sgBucketOffset( pos.getLongitudeDeg(), pos.getLatitudeDeg(), x, y );
+                    TileEntry *e = cache.get_tile( b );
+                    if ( !e ) {
+                        e = new TileEntry( b );
+                        cache.insert_tile( e );
+                    }
+                    cache.request_tile( e, (-1.0) * (x*x+y*y), true, 0.0 );
+                }
+            }
+            previous = current;
+            ++schedules;
+        }
+
+        // as FGTileMgr::update_queues
+        int drop_count = (int)cache.get_size() - cache.get_max_cache_size();
+        while ( drop_count-- > 0 ) {
+            long drop_index = cache.get_drop_tile();
+            if ( drop_index < 0 )
+                break;
+            cache.entry_free( drop_index );
+            ++drops;
+        }
+
+        double msec = st.elapsedMSec();
+        total_msec += msec;
+        max_msec = std::max( max_msec, msec );
+
+        pos = SGGeodesy::direct( pos, course, step_m );
+    }
+
+    // the entries are never loaded, so clear_cache() would not free them
+    std::vector<long> indexList;
+    for ( const_tile_map_iterator it = cache.begin();
+          it != cache.end(); ++it ) {
+        indexList.push_back( it->first );
+    }
+    for ( unsigned int i = 0; i < indexList.size(); ++i ) {
+        cache.entry_free( indexList[i] );
+    }
+
+    SG_LOG( SG_TERRAIN, SG_INFO, "Tile cache stress test: " << frames << " frames at "
+            << speed_kt << "kt, " << schedules << " reschedules, " << drops
+            << " tiles dropped, " << total_msec << "ms total, "
+            << max_msec << "ms worst frame" );
+
+    if ( results ) {
+        results->setIntValue( "frames", frames );
+        results->setIntValue( "schedules", schedules );
+        results->setIntValue( "drops", drops );
+        results->setDoubleValue( "total-msec", total_msec );
+        results->setDoubleValue( "max-frame-msec", max_msec );
+    }
 }
@@ -25,12 +25,16 @@
 #define _TILECACHE_HXX
 
 #include <map>
+#include <set>
+#include <vector>
 
 #include <simgear/bucket/newbucket.hxx>
 #include "tileentry.hxx"
 
 using std::map;
 
+class SGPropertyNode;
+
 // A class to store and manage a pile of tiles
 class TileCache {
 public:
@@ -49,6 +53,28 @@ private:
 
     double current_time;
 
+    // Eviction order of all tiles not in the current view: oldest expiry
+    // time first, then lowest priority. Each tile's position in the queue
+    // is kept in drop_handles, so re-prioritising a tile is logarithmic.
+    struct DropKey {
+        double time_expired;
+        float priority;
+        long index;
+        bool operator<(const DropKey& other) const;
+    };
+    typedef std::set<DropKey> drop_queue;
+    typedef map < long, drop_queue::iterator > drop_handle_map;
+
+    drop_queue drop_candidates;
+    drop_handle_map drop_handles;
+
+    // tiles flagged as belonging to the current view
+    std::vector<long> current_view_tiles;
+
+    // (re-)insert a tile into the eviction queue, or remove it
+    void index_tile( long tile_index, TileEntry* e );
+    void unindex_tile( long tile_index );
+
     // Free a tile cache entry
     void entry_free( long cache_index );
 
@@ -129,6 +155,12 @@ public:
 
     // update tile's priority and expiry time according to current request
     void request_tile(TileEntry* t,float priority,bool current_view,double requesttime);
+
+    // Time the cache bookkeeping (scheduling and eviction, no loading) for
+    // a simulated flight through the bucket grid. Results are logged and
+    // written below results, if not NULL.
+    static void stress_test( double speed_kt, double duration_sec, double frame_rate,
+                             double range_m, SGPropertyNode* results );
 };
 
 #endif // _TILECACHE_HXX
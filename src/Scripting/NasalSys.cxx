@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #include <simgear/nasal/nasal.h>
 #include <simgear/props/props.hxx>
@@ -33,6 +34,7 @@
 #include <Main/globals.hxx>
 #include <Main/util.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/frame_profiler.hxx>
 
 
 using std::map;
@@ -101,6 +103,7 @@ FGNasalSys::FGNasalSys()
     _gcHash = naNil();
     _nextGCKey = 0; // Any value will do
     _callCount = 0;
+    _listenerTiming = false;
 }
 
 // Utility.  Sets a named key in a hash by C string, rather than nasal
@@ -379,8 +382,7 @@ static naRef f_interpolate(naContext c, naRef me, int argc, naRef* args)
         deltas[i] = naNumValue(naVec_get(curve, 2*i+1)).num;
     }
 
-    ((SGInterpolator*)globals->get_subsystem_mgr()
-        ->get_group(SGSubsystemMgr::INIT)->get_subsystem("interpolator"))
+    ((SGInterpolator*)globals->get_subsystem("interpolator"))
         ->interpolate(node, nPoints, values, deltas);
 
     delete[] values;
@@ -592,12 +594,31 @@ void FGNasalSys::update(double)
     if( NasalClipboard::getInstance() )
         NasalClipboard::getInstance()->update();
 
+    if(!_listenerStats)
+        _listenerStats = fgGetNode("/sim/nasal/listeners", true);
+    _listenerTiming = _listenerStats->getBoolValue("statistics");
+
+    dispatchPendingListeners();
+
     if(!_dead_listener.empty()) {
         vector<FGNasalListener *>::iterator it, end = _dead_listener.end();
-        for(it = _dead_listener.begin(); it != end; ++it) delete *it;
+        for(it = _dead_listener.begin(); it != end; ++it) {
+            // removed by a listener callback after being notified
+            if((*it)->_pending)
+                _pending_listener.erase(std::remove(_pending_listener.begin(),
+                                                    _pending_listener.end(), *it),
+                                        _pending_listener.end());
+            delete *it;
+        }
         _dead_listener.clear();
     }
 
+    if(_listenerTiming &&
+       _listenerStatsStamp.elapsedMSec() >= 1000) {
+        publishListenerStatistics();
+        _listenerStatsStamp.stamp();
+    }
+
     if (!_loadList.empty())
     {
         // process Nasal load hook (only one per update loop to avoid excessive lags)
@@ -910,6 +931,8 @@ void FGNasalSys::setTimer(naContext c, int argc, naRef* args)
 
 void FGNasalSys::handleTimer(NasalTimer* t)
 {
+    static FGProfileCounter* timers = FGFrameProfiler::counter("nasal", "timers");
+    FGProfileScope scope(timers);
     call(t->handler, 0, 0, naNil());
     gcRelease(t->gcKey);
 }
@@ -934,16 +957,19 @@ void FGNasalSys::NasalTimer::timerExpired()
 
 int FGNasalSys::_listenerId = 0;
 
-// setlistener(<property>, <func> [, <initial=0> [, <persistent=1>]])
+// setlistener(<property>, <func> [, <initial=0> [, <persistent=1>
+//             [, <coalesce=0>]]])
 // Attaches a callback function to a property (specified as a global
 // property path string or a SGPropertyNode_ptr* ghost). If the third,
 // optional argument (default=0) is set to 1, then the function is also
 // called initially. If the fourth, optional argument is set to 0, then the
 // function is only called when the property node value actually changes.
 // Otherwise it's called independent of the value whenever the node is
-// written to (default). The setlistener() function returns a unique
-// id number, which is to be used as argument to the removelistener()
-// function.
+// written to (default). If the fifth, optional argument is set to 1, the
+// function is not called for every notification, but at most once per
+// frame, with the arguments of the last notification of that frame.
+// The setlistener() function returns a unique id number, which is to be
+// used as argument to the removelistener() function.
 naRef FGNasalSys::setListener(naContext c, int argc, naRef* args)
 {
     SGPropertyNode_ptr node;
@@ -967,8 +993,21 @@ naRef FGNasalSys::setListener(naContext c, int argc, naRef* args)
 
     int init = argc > 2 && naIsNum(args[2]) ? int(args[2].num) : 0;
     int type = argc > 3 && naIsNum(args[3]) ? int(args[3].num) : 1;
+    bool coalesce = argc > 4 && naIsNum(args[4]) && args[4].num != 0;
     FGNasalListener *nl = new FGNasalListener(node, code, this,
-            gcSave(code), _listenerId, init, type);
+            gcSave(code), _listenerId, init, type, coalesce);
+
+    // the caller of the setlistener() wrapper in globals.nas, if any
+    int depth = naStackDepth(c);
+    if(depth > 0) {
+        int frame = depth > 1 ? 1 : 0;
+        naRef file = naGetSourceFile(c, frame);
+        if(naIsString(file)) {
+            std::ostringstream source;
+            source << naStr_data(file) << ":" << naGetLine(c, frame);
+            nl->_source = source.str();
+        }
+    }
 
     node->addChangeListener(nl, init != 0);
 
@@ -994,13 +1033,79 @@ naRef FGNasalSys::removeListener(naContext c, int argc, naRef* args)
     return naNum(_listener.size());
 }
 
+// Calls the coalescing listeners notified since the last frame. Those
+// notified again by these calls are called in the next frame.
+void FGNasalSys::dispatchPendingListeners()
+{
+    if(_pending_listener.empty())
+        return;
+
+    vector<FGNasalListener *> pending;
+    pending.swap(_pending_listener);
+    vector<FGNasalListener *>::iterator it, end = pending.end();
+    for(it = pending.begin(); it != end; ++it) {
+        FGNasalListener* l = *it;
+        SGPropertyNode_ptr node = l->_pending_node;
+        l->_pending_node = 0;
+        l->_pending = false;
+        if(!l->_dead)
+            l->call(node, naNum(l->_pending_mode));
+    }
+}
+
+static bool moreExpensive(const FGNasalListener* a, const FGNasalListener* b)
+{
+    return a->cost() > b->cost();
+}
+
+// Lists the listeners that took the most time below
+// /sim/nasal/listeners/listener[n], with totals over all listeners.
+void FGNasalSys::publishListenerStatistics()
+{
+    vector<FGNasalListener *> listeners;
+    unsigned int calls = 0, notifications = 0;
+    double time = 0.0;
+    map<int, FGNasalListener *>::iterator it, end = _listener.end();
+    for(it = _listener.begin(); it != end; ++it) {
+        FGNasalListener* l = it->second;
+        listeners.push_back(l);
+        calls += l->_calls;
+        notifications += l->_notifications;
+        time += l->_time_ms;
+    }
+
+    unsigned int count = _listenerStats->getIntValue("statistics-count", 20);
+    count = std::min<unsigned int>(count, listeners.size());
+    std::partial_sort(listeners.begin(), listeners.begin() + count,
+                      listeners.end(), moreExpensive);
+
+    _listenerStats->removeChildren("listener", false);
+    for(unsigned int i = 0; i < count; i++) {
+        FGNasalListener* l = listeners[i];
+        SGPropertyNode* n = _listenerStats->getChild("listener", i, true);
+        n->setIntValue("id", l->_id);
+        n->setStringValue("property", l->_node->getPath().c_str());
+        n->setStringValue("source", l->_source.c_str());
+        n->setBoolValue("coalesce", l->_coalesce);
+        n->setIntValue("notifications", l->_notifications);
+        n->setIntValue("calls", l->_calls);
+        n->setDoubleValue("time-ms", l->_time_ms);
+        n->setDoubleValue("mean-ms", l->_calls ? l->_time_ms / l->_calls : 0.0);
+    }
+
+    _listenerStats->setIntValue("count", listeners.size());
+    _listenerStats->setIntValue("total-notifications", notifications);
+    _listenerStats->setIntValue("total-calls", calls);
+    _listenerStats->setDoubleValue("total-time-ms", time);
+}
+
 
 
 // FGNasalListener class.
 
 FGNasalListener::FGNasalListener(SGPropertyNode *node, naRef code,
                                  FGNasalSys* nasal, int key, int id,
-                                 int init, int type) :
+                                 int init, int type, bool coalesce) :
     _node(node),
     _code(code),
     _gcKey(key),
@@ -1011,7 +1116,13 @@ FGNasalListener::FGNasalListener(SGPropertyNode *node, naRef code,
     _active(0),
     _dead(false),
     _last_int(0L),
-    _last_float(0.0)
+    _last_float(0.0),
+    _coalesce(coalesce),
+    _pending(false),
+    _pending_mode(0),
+    _notifications(0),
+    _calls(0),
+    _time_ms(0.0)
 {
     if(_type == 0 && !_init)
         changed(node);
@@ -1026,34 +1137,64 @@ FGNasalListener::~FGNasalListener()
 void FGNasalListener::call(SGPropertyNode* which, naRef mode)
 {
     if(_active || _dead) return;
+    static FGProfileCounter* listeners = FGFrameProfiler::counter("nasal", "listeners");
+    FGProfileScope scope(listeners);
     SG_LOG(SG_NASAL, SG_DEBUG, "trigger listener #" << _id);
     _active++;
+    _calls++;
+    SGTimeStamp start;
+    if(_nas->_listenerTiming)
+        start.stamp();
+
     naRef arg[4];
     arg[0] = _nas->propNodeGhost(which);
     arg[1] = _nas->propNodeGhost(_node);
     arg[2] = mode;                  // value changed, child added/removed
     arg[3] = naNum(_node != which); // child event?
     _nas->call(_code, 4, arg, naNil());
+
+    if(_nas->_listenerTiming)
+        _time_ms += start.elapsedMSec();
     _active--;
 }
 
+void FGNasalListener::notify(SGPropertyNode* which, int mode)
+{
+    _notifications++;
+    if(!_coalesce) {
+        call(which, naNum(mode));
+        return;
+    }
+
+    _pending_node = which;
+    _pending_mode = mode;
+    if(!_pending && !_dead) {
+        _pending = true;
+        _nas->_pending_listener.push_back(this);
+    }
+}
+
 void FGNasalListener::valueChanged(SGPropertyNode* node)
 {
     if(_type < 2 && node != _node) return;   // skip child events
-    if(_type > 0 || changed(_node) || _init)
-        call(node, naNum(0));
+    if(_type > 0 || changed(_node) || _init) {
+        if(_init)
+            call(node, naNum(0));            // the initial call isn't deferred
+        else
+            notify(node, 0);
+    }
 
     _init = 0;
 }
 
 void FGNasalListener::childAdded(SGPropertyNode*, SGPropertyNode* child)
 {
-    if(_type == 2) call(child, naNum(1));
+    if(_type == 2) notify(child, 1);
 }
 
 void FGNasalListener::childRemoved(SGPropertyNode*, SGPropertyNode* child)
 {
-    if(_type == 2) call(child, naNum(-1));
+    if(_type == 2) notify(child, -1);
 }
 
 bool FGNasalListener::changed(SGPropertyNode* node)
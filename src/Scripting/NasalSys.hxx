@@ -8,6 +8,7 @@
 #include <simgear/scene/model/modellib.hxx>
 #include <simgear/xml/easyxml.hxx>
 #include <simgear/threads/SGQueue.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include <map>
 
@@ -177,6 +178,16 @@ private:
     vector<FGNasalListener *> _dead_listener;
     static int _listenerId;
 
+    // coalescing listeners notified since the last update
+    vector<FGNasalListener *> _pending_listener;
+    void dispatchPendingListeners();
+
+    // per-listener costs, see /sim/nasal/listeners
+    SGPropertyNode_ptr _listenerStats;
+    bool _listenerTiming;
+    SGTimeStamp _listenerStatsStamp;
+    void publishListenerStatistics();
+
     void loadPropertyScripts();
     void loadPropertyScripts(SGPropertyNode* n);
     void loadScriptDirectory(simgear::Dir nasalDir);
@@ -219,16 +230,19 @@ private:
 class FGNasalListener : public SGPropertyChangeListener {
 public:
     FGNasalListener(SGPropertyNode* node, naRef code, FGNasalSys* nasal,
-                    int key, int id, int init, int type);
+                    int key, int id, int init, int type, bool coalesce);
 
     virtual ~FGNasalListener();
     virtual void valueChanged(SGPropertyNode* node);
     virtual void childAdded(SGPropertyNode* parent, SGPropertyNode* child);
     virtual void childRemoved(SGPropertyNode* parent, SGPropertyNode* child);
 
+    double cost() const { return _time_ms; }
+
 private:
     bool changed(SGPropertyNode* node);
     void call(SGPropertyNode* which, naRef mode);
+    void notify(SGPropertyNode* which, int mode);
 
     friend class FGNasalSys;
     SGPropertyNode_ptr _node;
@@ -243,6 +257,18 @@ private:
     long _last_int;
     double _last_float;
     string _last_string;
+
+    // coalescing listeners are called once per frame, from
+    // FGNasalSys::update(), with the last notification of the frame
+    bool _coalesce;
+    bool _pending;
+    SGPropertyNode_ptr _pending_node;
+    int _pending_mode;
+
+    string _source; // where setlistener() was called
+    unsigned int _notifications;
+    unsigned int _calls;
+    double _time_ms;
 };
 
 
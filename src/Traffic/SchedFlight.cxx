@@ -46,6 +46,7 @@
 #include <fstream>
 
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -81,6 +82,7 @@ FGScheduledFlight::FGScheduledFlight()
     available = true;
     departurePort = NULL;
     arrivalPort = NULL;
+    queue = NULL;
 }
   
 FGScheduledFlight::FGScheduledFlight(const FGScheduledFlight &other)
@@ -98,6 +100,7 @@ FGScheduledFlight::FGScheduledFlight(const FGScheduledFlight &other)
   initialized       = other.initialized;
   requiredAircraft  = other.requiredAircraft;
   available         = other.available;
+  queue             = NULL;
 }
 
 FGScheduledFlight::FGScheduledFlight(const string& cs,
@@ -148,6 +151,7 @@ FGScheduledFlight::FGScheduledFlight(const string& cs,
       departureTime -= repeatPeriod;
     }
   initialized = false;
+  queue = NULL;
   available   = true;
 }
 
@@ -212,6 +216,8 @@ void FGScheduledFlight::update()
 {
   departureTime += repeatPeriod;
   arrivalTime  += repeatPeriod;
+  if (queue)
+    queue->invalidate();
 }
 
 void FGScheduledFlight::adjustTime(time_t now)
@@ -220,6 +226,8 @@ void FGScheduledFlight::adjustTime(time_t now)
   //   << " " << arrivalTime << " " << arrivalTime+repeatPeriod << endl;
   // Make sure that the arrival time is in between 
   // the current time and the next repeat period.
+  if (queue && ((arrivalTime < now) || (arrivalTime > now+repeatPeriod)))
+    queue->invalidate();
   while ((arrivalTime < now) || (arrivalTime > now+repeatPeriod))
     {
       if (arrivalTime < now)
@@ -295,3 +303,68 @@ bool compareScheduledFlights(FGScheduledFlight *a, FGScheduledFlight *b)
 { 
   return (*a) < (*b); 
 };
+
+
+/******************************************************************************
+ * FGScheduledFlightQueue stuff
+ *****************************************************************************/
+
+FGScheduledFlightQueue::FGScheduledFlightQueue() :
+  sorted(false),
+  adjustedTime(0),
+  firstArrival(0)
+{
+}
+
+FGScheduledFlightQueue::~FGScheduledFlightQueue()
+{
+  for (FGScheduledFlightVecIterator i = flights.begin(); i != flights.end(); i++)
+    (*i)->queue = NULL;
+}
+
+void FGScheduledFlightQueue::add(FGScheduledFlight *flight)
+{
+  flights.push_back(flight);
+  flight->queue = this;
+  sorted = false;
+}
+
+void FGScheduledFlightQueue::adjust(time_t now)
+{
+  // Moving forward in time, flights only need to move once they arrived.
+  if (sorted && (adjustedTime <= now) && (now <= firstArrival))
+    return;
+
+  for (FGScheduledFlightVecIterator i = flights.begin(); i != flights.end(); i++)
+    (*i)->adjustTime(now);
+  std::sort(flights.begin(), flights.end(), compareScheduledFlights);
+
+  firstArrival = now;
+  for (FGScheduledFlightVecIterator i = flights.begin(); i != flights.end(); i++) {
+    if ((i == flights.begin()) || ((*i)->getArrivalTime() < firstArrival))
+      firstArrival = (*i)->getArrivalTime();
+  }
+  adjustedTime = now;
+  sorted = true;
+}
+
+FGScheduledFlight *FGScheduledFlightQueue::find(time_t now, time_t earliest,
+                                                time_t latest)
+{
+  adjust(now);
+
+  FGScheduledFlight key;
+  key.departureTime = earliest;
+  FGScheduledFlightVecIterator i = std::lower_bound(flights.begin(), flights.end(),
+                                                    &key, compareScheduledFlights);
+  for (; i != flights.end(); i++) {
+    if (latest && ((*i)->getDepartureTime() > latest))
+      break;
+    if (!(*i)->isAvailable())
+      continue;
+    if (!(((*i)->getArrivalAirport()) && ((*i)->getDepartureAirport())))
+      continue;
+    return (*i);
+  }
+  return NULL;
+}
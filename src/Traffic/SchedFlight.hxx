@@ -41,6 +41,7 @@
 #define _FGSCHEDFLIGHT_HXX_
 
 class FGAirport;
+class FGScheduledFlightQueue;
 
 class FGScheduledFlight
 {
@@ -60,6 +61,9 @@ private:
   bool initialized;
   bool available;
 
+  // the queue the flight is in, told when its times change
+  FGScheduledFlightQueue *queue;
+  friend class FGScheduledFlightQueue;
  
  
 public:
@@ -87,6 +91,7 @@ public:
   time_t getArrivalTime  () { return arrivalTime;   };
   
   void setDepartureAirport(const std::string& port) { depId = port; };
+  const std::string& getDepartureAirportId() { return depId; };
   void setArrivalAirport  (const std::string& port) { arrId = port; };
   FGAirport *getDepartureAirport();
   FGAirport *getArrivalAirport  ();
@@ -119,5 +124,41 @@ typedef std::map < std::string, FGScheduledFlightVec > FGScheduledFlightMap;
 
 bool compareScheduledFlights(FGScheduledFlight *a, FGScheduledFlight *b);
 
+/**
+ * The flights for one kind of aircraft from one departure airport,
+ * ordered by departure time after moving them by whole repeat periods
+ * to arrive between now and one period later, as adjustTime() does.
+ *
+ * The order only needs to be restored when one of the flights has
+ * arrived since, or when the time of a flight was changed otherwise,
+ * so finding the next departure is a binary search most of the time.
+ */
+class FGScheduledFlightQueue
+{
+public:
+  FGScheduledFlightQueue();
+  ~FGScheduledFlightQueue();
+
+  void add(FGScheduledFlight *flight);
+  void invalidate() { sorted = false; };
+
+  // The first available flight departing between earliest and latest,
+  // or 0; latest is ignored if it is 0.
+  FGScheduledFlight *find(time_t now, time_t earliest, time_t latest);
+
+  unsigned size() const { return flights.size(); };
+
+private:
+  void adjust(time_t now);
+
+  FGScheduledFlightVec flights;
+  bool sorted;
+  time_t adjustedTime;
+  time_t firstArrival;
+};
+
+// departure airport id to the flights leaving there
+typedef std::map < std::string, FGScheduledFlightQueue > FGScheduledFlightQueueMap;
+
 
 #endif
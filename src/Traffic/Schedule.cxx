@@ -58,6 +58,8 @@
  * the FGAISchedule class contains data members and code to maintain a
  * schedule of Flights for an artificially controlled aircraft.
  *****************************************************************************/
+bool FGAISchedule::useFlightQueues = true;
+
 FGAISchedule::FGAISchedule()
   : heavy(false),
     radius(0),
@@ -499,6 +501,33 @@ bool FGAISchedule::next()
    return true;
 }
 
+unsigned int FGAISchedule::scheduleAll(time_t now)
+{
+  const string& userPort = fgGetString("/sim/presets/airport-id");
+  FGScheduledFlightVec scheduled;
+  scheduled.swap(flights);
+  string destination = currentDestination;
+  currentDestination.clear();
+
+  FGScheduledFlight *flight = findAvailableFlight(userPort, flightIdentifier, now, (now+6400));
+  if (!flight)
+      flight = findAvailableFlight(currentDestination, flightIdentifier);
+  while (flight) {
+      flights.push_back(flight);
+      currentDestination = flight->getArrivalAirport()->getId();
+      if (currentDestination == homePort)
+          break;
+      flight = findAvailableFlight(currentDestination, flightIdentifier);
+  }
+
+  unsigned int count = flights.size();
+  for (FGScheduledFlightVecIterator i = flights.begin(); i != flights.end(); i++)
+      (*i)->release();
+  flights.swap(scheduled);
+  currentDestination = destination;
+  return count;
+}
+
 FGScheduledFlight* FGAISchedule::findAvailableFlight (const string &currentDestination,
                                                       const string &req,
                                                      time_t min, time_t max)
@@ -506,6 +535,39 @@ FGScheduledFlight* FGAISchedule::findAvailableFlight (const string &currentDesti
     time_t now = time(NULL) + fgGetLong("/sim/time/warp");
 
     FGTrafficManager *tmgr = (FGTrafficManager *) globals->get_subsystem("traffic-manager");
+
+    if (useFlightQueues) {
+        // the departure time needs to be after the arrival of the
+        // previous flight, and in [min, max] if min is given
+        time_t earliest = 0, latest = 0;
+        if (flights.size())
+            earliest = flights.back()->getArrivalTime() + groundTimeFromRadius();
+        if (min != 0) {
+            earliest = std::max(earliest, min);
+            latest = max;
+            if (latest < earliest)
+                return NULL;
+        }
+
+        FGScheduledFlightQueueMap& queues = tmgr->getFlightQueues(req);
+        FGScheduledFlight *found = NULL;
+        if (!currentDestination.empty()) {
+            FGScheduledFlightQueueMap::iterator it = queues.find(currentDestination);
+            if (it != queues.end())
+                found = it->second.find(now, earliest, latest);
+        } else {
+            // from anywhere: the earliest departure of all airports
+            for (FGScheduledFlightQueueMap::iterator it = queues.begin(); it != queues.end(); it++) {
+                FGScheduledFlight *flight = it->second.find(now, earliest, latest);
+                if (flight && (!found || (flight->getDepartureTime() < found->getDepartureTime())))
+                    found = flight;
+            }
+        }
+        if (found)
+            found->lock();
+        return found;
+    }
+
     FGScheduledFlightVecIterator fltBegin, fltEnd;
     fltBegin = tmgr->getFirstFlight(req);
     fltEnd   = tmgr->getLastFlight(req);
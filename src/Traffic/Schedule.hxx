@@ -66,6 +66,9 @@ class FGAISchedule
 
   bool scheduleFlights(time_t now);
   int groundTimeFromRadius();
+
+  // search the flight queues of the traffic manager instead of all flights
+  static bool useFlightQueues;
   
   /**
    * Transition this schedule from distant mode to AI mode;
@@ -130,6 +133,11 @@ class FGAISchedule
   void         assign         (FGScheduledFlight *ref) { flights.push_back(ref); };
   void         setFlightType  (const std::string& val) { flightType = val; };
   FGScheduledFlight*findAvailableFlight (const std::string& currentDestination, const std::string &req, time_t min=0, time_t max=0);
+  // schedule all flights up to the return to the home port, as
+  // scheduleFlights() does, and release them again; for benchmarks
+  unsigned int scheduleAll(time_t now);
+  static void setUseFlightQueues(bool use) { useFlightQueues = use; };
+  static bool getUseFlightQueues() { return useFlightQueues; };
   // used to sort in descending order of score: I've probably found a better way to
   // descending order sorting, but still need to test that.
   bool operator< (const FGAISchedule &other) const;
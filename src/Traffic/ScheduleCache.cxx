@@ -0,0 +1,351 @@
+/******************************************************************************
+ * ScheduleCache.cxx
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ **************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/stdint.hxx>
+
+#include <Main/globals.hxx>
+
+#include "ScheduleCache.hxx"
+
+using std::string;
+
+// the file starts with these, and with the size of an int written as one,
+// so that a cache from another version or machine is not used
+static const char CACHE_MAGIC[4] = { 'F', 'G', 'T', 'C' };
+static const int CACHE_VERSION = 1;
+
+namespace {
+
+/**
+ * The whole file is built in memory, and written at once. Numbers are
+ * written as they are in memory: the cache is not meant to be moved to
+ * another machine.
+ */
+class Writer
+{
+public:
+  template <class T>
+  void put(T value)
+  {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void put(const string& s)
+  {
+    put<int>(s.size());
+    buffer.append(s);
+  }
+
+  string buffer;
+};
+
+/**
+ * Reads from a file loaded at once; once something does not fit, all
+ * further reads fail.
+ */
+class Reader
+{
+public:
+  Reader(const std::vector<char>& data) :
+    pos(data.empty() ? 0 : &data[0]),
+    end(pos + data.size()),
+    ok(true)
+  {
+  }
+
+  template <class T>
+  bool get(T& value)
+  {
+    if (!ok || (end - pos < (long) sizeof(T)))
+      return ok = false;
+    memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool get(string& s)
+  {
+    int len;
+    if (!get(len) || (len < 0) || (end - pos < len))
+      return ok = false;
+    s.assign(pos, len);
+    pos += len;
+    return true;
+  }
+
+  bool get(bool& b)
+  {
+    char c;
+    if (!get<char>(c))
+      return false;
+    b = c != 0;
+    return true;
+  }
+
+  const char* pos;
+  const char* end;
+  bool ok;
+};
+
+} // of anonymous namespace
+
+void FGScheduleCache::clear()
+{
+  sources.clear();
+  aircraft.clear();
+  flights.clear();
+  order.clear();
+  index.clear();
+}
+
+void FGScheduleCache::addSource(const SGPath& path, bool included)
+{
+  Source s;
+  s.path = path.str();
+  s.modTime = path.modTime();
+  s.included = included;
+  sources.push_back(s);
+}
+
+void FGScheduleCache::addAircraft(const Aircraft& a)
+{
+  order.push_back(AIRCRAFT);
+  index.push_back(aircraft.size());
+  aircraft.push_back(a);
+}
+
+void FGScheduleCache::addFlight(const Flight& f)
+{
+  order.push_back(FLIGHT);
+  index.push_back(flights.size());
+  flights.push_back(f);
+}
+
+bool FGScheduleCache::isCurrent(const simgear::PathList& files) const
+{
+  unsigned next = 0;
+  for (std::vector<Source>::const_iterator i = sources.begin(); i != sources.end(); i++) {
+    if (!i->included) {
+      if ((next == files.size()) || (files[next].str() != i->path)) {
+        SG_LOG(SG_AI, SG_INFO, "Traffic cache: files in AI/Traffic changed");
+        return false;
+      }
+      next++;
+    }
+
+    SGPath path(i->path);
+    if (!path.exists() || (path.modTime() != i->modTime)) {
+      SG_LOG(SG_AI, SG_INFO, "Traffic cache: " << i->path << " changed");
+      return false;
+    }
+  }
+
+  if (next != files.size()) {
+    SG_LOG(SG_AI, SG_INFO, "Traffic cache: files in AI/Traffic changed");
+    return false;
+  }
+  return true;
+}
+
+bool FGScheduleCache::read(const SGPath& path)
+{
+  clear();
+
+  std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  in.seekg(0, std::ios::end);
+  std::streamoff length = in.tellg();
+  in.seekg(0, std::ios::beg);
+  if (length <= 0) {
+    return false;
+  }
+  std::vector<char> data(length);
+  if (!in.read(&data[0], length)) {
+    SG_LOG(SG_AI, SG_WARN, "Traffic cache: cannot read " << path);
+    return false;
+  }
+
+  Reader r(data);
+  char magic[4];
+  int version, intSize;
+  for (int i = 0; i < 4; i++) {
+    r.get(magic[i]);
+  }
+  r.get(version);
+  r.get(intSize);
+  if (!r.ok || memcmp(magic, CACHE_MAGIC, 4) || (version != CACHE_VERSION) ||
+      (intSize != (int) sizeof(int))) {
+    SG_LOG(SG_AI, SG_INFO, "Traffic cache: ignoring " << path
+           << ", made by another version");
+    return false;
+  }
+
+  int numSources, numRecords;
+  r.get(numSources);
+  for (int i = 0; r.ok && (i < numSources); i++) {
+    Source s;
+    int64_t modTime;
+    r.get(s.path);
+    r.get(modTime);
+    r.get(s.included);
+    s.modTime = modTime;
+    sources.push_back(s);
+  }
+
+  r.get(numRecords);
+  for (int i = 0; r.ok && (i < numRecords); i++) {
+    char type;
+    if (!r.get(type))
+      break;
+
+    if (type == AIRCRAFT) {
+      Aircraft a;
+      r.get(a.model);
+      r.get(a.livery);
+      r.get(a.homePort);
+      r.get(a.registration);
+      r.get(a.requiredAircraft);
+      r.get(a.acType);
+      r.get(a.airline);
+      r.get(a.m_class);
+      r.get(a.flighttype);
+      r.get(a.heavy);
+      r.get(a.radius);
+      r.get(a.offset);
+      addAircraft(a);
+    } else if (type == FLIGHT) {
+      Flight f;
+      r.get(f.callsign);
+      r.get(f.fltrules);
+      r.get(f.departurePort);
+      r.get(f.arrivalPort);
+      r.get(f.departureTime);
+      r.get(f.arrivalTime);
+      r.get(f.repeat);
+      r.get(f.requiredAircraft);
+      r.get(f.cruiseAlt);
+      addFlight(f);
+    } else {
+      r.ok = false;
+    }
+  }
+
+  if (!r.ok || (r.pos != r.end)) {
+    SG_LOG(SG_AI, SG_WARN, "Traffic cache: " << path << " is damaged, ignoring it");
+    clear();
+    return false;
+  }
+  return true;
+}
+
+bool FGScheduleCache::write(const SGPath& path) const
+{
+  Writer w;
+  for (int i = 0; i < 4; i++) {
+    w.put(CACHE_MAGIC[i]);
+  }
+  w.put(CACHE_VERSION);
+  w.put<int>(sizeof(int));
+
+  w.put<int>(sources.size());
+  for (std::vector<Source>::const_iterator i = sources.begin(); i != sources.end(); i++) {
+    w.put(i->path);
+    w.put<int64_t>(i->modTime);
+    w.put<char>(i->included);
+  }
+
+  w.put<int>(order.size());
+  for (unsigned i = 0; i < order.size(); i++) {
+    w.put<char>(order[i]);
+    if (order[i] == AIRCRAFT) {
+      const Aircraft& a = aircraft[index[i]];
+      w.put(a.model);
+      w.put(a.livery);
+      w.put(a.homePort);
+      w.put(a.registration);
+      w.put(a.requiredAircraft);
+      w.put(a.acType);
+      w.put(a.airline);
+      w.put(a.m_class);
+      w.put(a.flighttype);
+      w.put<char>(a.heavy);
+      w.put(a.radius);
+      w.put(a.offset);
+    } else {
+      const Flight& f = flights[index[i]];
+      w.put(f.callsign);
+      w.put(f.fltrules);
+      w.put(f.departurePort);
+      w.put(f.arrivalPort);
+      w.put(f.departureTime);
+      w.put(f.arrivalTime);
+      w.put(f.repeat);
+      w.put(f.requiredAircraft);
+      w.put(f.cruiseAlt);
+    }
+  }
+
+  SGPath dir(path);
+  dir.create_dir(0755);
+
+  // write to a new file and move it in place, so that a cache being read
+  // by another instance is never seen half written
+  SGPath tmp(path.str() + ".new");
+  std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out.write(w.buffer.data(), w.buffer.size())) {
+    SG_LOG(SG_AI, SG_WARN, "Traffic cache: cannot write " << tmp);
+    return false;
+  }
+  out.close();
+
+  SGPath target(path);
+#ifdef _WIN32
+  // rename() does not replace an existing file on Windows
+  if (target.exists()) {
+    target.remove();
+  }
+#endif
+  if (::rename(tmp.c_str(), target.c_str()) != 0) {
+    SG_LOG(SG_AI, SG_WARN, "Traffic cache: cannot write " << path);
+    return false;
+  }
+
+  SG_LOG(SG_AI, SG_INFO, "Traffic cache: wrote " << aircraft.size()
+         << " aircraft and " << flights.size() << " flights to " << path);
+  return true;
+}
+
+SGPath FGScheduleCache::getDefaultPath()
+{
+  SGPath path(globals->get_fg_home());
+  path.append("ai/traffic-schedules.cache");
+  return path;
+}
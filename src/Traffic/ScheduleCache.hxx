@@ -0,0 +1,107 @@
+/* -*- Mode: C++ -*- *****************************************************
+ * ScheduleCache.hxx
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ **************************************************************************/
+
+/**************************************************************************
+ * The schedule cache is a binary copy of what the traffic manager reads
+ * from the XML files in AI/Traffic: the aircraft and flight elements, in
+ * the order they were found, as they were written. Nothing that depends
+ * on the time, the settings or the installed models is kept, so that
+ * loading the cache goes through the same code as parsing the XML, only
+ * without the parsing.
+ *
+ * The cache knows the files it was made from and their time stamps, and
+ * is only used while these are unchanged.
+ **************************************************************************/
+
+#ifndef _FGSCHEDULECACHE_HXX_
+#define _FGSCHEDULECACHE_HXX_
+
+#include <string>
+#include <vector>
+
+#include <simgear/misc/sg_path.hxx>
+
+class FGScheduleCache
+{
+public:
+  struct Aircraft
+  {
+    std::string model, livery, homePort, registration, requiredAircraft,
+      acType, airline, m_class, flighttype;
+    bool heavy;
+    double radius, offset;
+  };
+
+  struct Flight
+  {
+    std::string callsign, fltrules, departurePort, arrivalPort,
+      departureTime, arrivalTime, repeat, requiredAircraft;
+    int cruiseAlt;
+  };
+
+  enum RecordType { AIRCRAFT, FLIGHT };
+
+  void clear();
+
+  /**
+   * Stamp a file read while making the cache. Included files are those
+   * read through an include attribute rather than found in AI/Traffic.
+   */
+  void addSource(const SGPath& path, bool included);
+  void addAircraft(const Aircraft& aircraft);
+  void addFlight(const Flight& flight);
+
+  /**
+   * True if the top level files are the given ones, and none of the files
+   * read has changed since.
+   */
+  bool isCurrent(const simgear::PathList& files) const;
+
+  bool read(const SGPath& path);
+  bool write(const SGPath& path) const;
+
+  /// the records, in the order they were added
+  unsigned size() const { return order.size(); }
+  RecordType getType(unsigned i) const { return (RecordType) order[i]; }
+  const Aircraft& getAircraft(unsigned i) const { return aircraft[index[i]]; }
+  const Flight& getFlight(unsigned i) const { return flights[index[i]]; }
+
+  unsigned getNumAircraft() const { return aircraft.size(); }
+  unsigned getNumFlights() const { return flights.size(); }
+
+  /// where the cache of the traffic in FG_ROOT is kept
+  static SGPath getDefaultPath();
+
+private:
+  struct Source
+  {
+    std::string path;
+    time_t modTime;
+    bool included;
+  };
+
+  std::vector<Source> sources;
+  std::vector<Aircraft> aircraft;
+  std::vector<Flight> flights;
+  std::vector<unsigned char> order;
+  std::vector<unsigned> index;
+};
+
+#endif
@@ -60,6 +60,7 @@
 #include <simgear/xml/easyxml.hxx>
 #include <simgear/threads/SGThread.hxx>
 #include <simgear/threads/SGGuard.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 #include <AIModel/AIAircraft.hxx>
 #include <AIModel/AIFlightPlan.hxx>
@@ -73,6 +74,21 @@ using std::sort;
 using std::strcmp;
 using std::endl;
 
+// the schedule files, in the sub-directories of AI/Traffic
+static simgear::PathList listTrafficFiles(const SGPath& trafficDirPath)
+{
+  simgear::PathList result;
+  simgear::Dir trafficDir(trafficDirPath);
+  simgear::PathList d = trafficDir.children(simgear::Dir::TYPE_DIR | simgear::Dir::NO_DOT_OR_DOTDOT);
+
+  BOOST_FOREACH(SGPath p, d) {
+    simgear::Dir d2(p);
+    simgear::PathList trafficFiles = d2.children(simgear::Dir::TYPE_FILE, ".xml");
+    result.insert(result.end(), trafficFiles.begin(), trafficFiles.end());
+  }
+  return result;
+}
+
 /**
  * Thread encapsulating parsing the traffic schedules. 
  */
@@ -82,7 +98,9 @@ public:
   ScheduleParseThread(FGTrafficManager* traffic) :
     _trafficManager(traffic),
     _isFinished(false),
-    _cancelThread(false)
+    _cancelThread(false),
+    _useCache(true),
+    _rebuild(false)
   {
     
   }
@@ -104,6 +122,17 @@ public:
   {
     _trafficDirPath = trafficDirPath;
   }
+
+  void setUseCache(bool useCache)
+  {
+    _useCache = useCache;
+  }
+
+  // parse and write the cache even if it is current
+  void setRebuild(bool rebuild)
+  {
+    _rebuild = rebuild;
+  }
   
   bool isFinished() const
   {
@@ -116,22 +145,37 @@ public:
     SGTimeStamp st;
     st.stamp();
     
-    simgear::Dir trafficDir(_trafficDirPath);
-    simgear::PathList d = trafficDir.children(simgear::Dir::TYPE_DIR | simgear::Dir::NO_DOT_OR_DOTDOT);
+    simgear::PathList trafficFiles = listTrafficFiles(_trafficDirPath);
+    SGPath cachePath = FGScheduleCache::getDefaultPath();
+    FGScheduleCache cache;
     
-    BOOST_FOREACH(SGPath p, d) {
-      simgear::Dir d2(p);
-      simgear::PathList trafficFiles = d2.children(simgear::Dir::TYPE_FILE, ".xml");
+    if (_useCache && !_rebuild &&
+        cache.read(cachePath) && cache.isCurrent(trafficFiles)) {
+      _trafficManager->loadCache(cache);
+      SG_LOG(SG_AI, SG_INFO, "loading traffic schedules from " << cachePath
+             << " took:" << st.elapsedMSec() << "msec");
+    } else {
+      cache.clear();
+      if (_useCache) {
+        _trafficManager->cacheRecorder = &cache;
+      }
+      
       BOOST_FOREACH(SGPath xml, trafficFiles) {
         _trafficManager->parseSchedule(xml);
         if (_cancelThread) {
+          _trafficManager->cacheRecorder = NULL;
           return;
         }
       }
-    } // of sub-directories in AI/Traffic iteration
-    
-  //  _trafficManager->parseSchedules(schedulesToRead);
-    SG_LOG(SG_AI, SG_INFO, "parsing traffic schedules took:" << st.elapsedMSec() << "msec");
+      
+      _trafficManager->cacheRecorder = NULL;
+    //  _trafficManager->parseSchedules(schedulesToRead);
+      SG_LOG(SG_AI, SG_INFO, "parsing traffic schedules took:" << st.elapsedMSec() << "msec");
+      
+      if (_useCache) {
+        cache.write(cachePath);
+      }
+    }
     
     SGGuard<SGMutex> g(_lock);
     _isFinished = true;
@@ -141,6 +185,8 @@ private:
   mutable SGMutex _lock;
   bool _isFinished;
   bool _cancelThread;
+  bool _useCache;
+  bool _rebuild;
   SGPath _trafficDirPath;
 };
 
@@ -158,6 +204,8 @@ FGTrafficManager::FGTrafficManager() :
   radius(0),
   offset(0),
   heavy(false),
+  cacheRecorder(NULL),
+  recordOnly(false),
   enabled("/sim/traffic-manager/enabled"),
   aiEnabled("/sim/ai/enabled"),
   realWxEnabled("/environment/realwx/enabled"),
@@ -218,6 +266,7 @@ void FGTrafficManager::shutdown()
         cachefile.close();
     }
     scheduledAircraft.clear();
+    flightQueues.clear();
     flights.clear();
 
     currAircraft = scheduledAircraft.begin();
@@ -225,14 +274,123 @@ void FGTrafficManager::shutdown()
     inited = false;
 }
 
+FGScheduledFlightQueueMap& FGTrafficManager::getFlightQueues(const string &ref)
+{
+    std::map<std::string, FGScheduledFlightQueueMap>::iterator it = flightQueues.find(ref);
+    if (it != flightQueues.end())
+        return it->second;
+
+    FGScheduledFlightQueueMap& queues = flightQueues[ref];
+    FGScheduledFlightVec& vec = flights[ref];
+    for (FGScheduledFlightVecIterator i = vec.begin(); i != vec.end(); i++)
+        queues[(*i)->getDepartureAirportId()].add(*i);
+    return queues;
+}
+
+void FGTrafficManager::benchmark(SGPropertyNode* result)
+{
+    time_t now = time(NULL) + fgGetLong("/sim/time/warp");
+    bool indexed = FGAISchedule::getUseFlightQueues();
+
+    unsigned found[2] = { 0, 0 };
+    double msec[2];
+    for (int pass = 0; pass < 2; ++pass) {
+        FGAISchedule::setUseFlightQueues(pass == 0);
+        SGTimeStamp st;
+        st.stamp();
+        BOOST_FOREACH(FGAISchedule* acft, scheduledAircraft) {
+            found[pass] += acft->scheduleAll(now);
+        }
+        msec[pass] = (SGTimeStamp::now() - st).toUSecs() / 1000.0;
+    }
+    FGAISchedule::setUseFlightQueues(indexed);
+
+    result->setIntValue("aircraft", scheduledAircraft.size());
+    result->setIntValue("flights", found[0]);
+    result->setIntValue("flights-linear", found[1]);
+    result->setDoubleValue("indexed-msec", msec[0]);
+    result->setDoubleValue("linear-msec", msec[1]);
+    SG_LOG(SG_AI, SG_INFO, "Traffic benchmark: " << scheduledAircraft.size()
+           << " aircraft, " << found[0] << " flights, indexed " << msec[0]
+           << " ms, linear " << msec[1] << " ms");
+}
+
 /// caution - this is run on the helper thread to improve startup
 /// responsiveness - do not access properties or global state from
 /// here, since there's no locking protection at all
 void FGTrafficManager::parseSchedule(const SGPath& path)
 {
+  if (cacheRecorder) {
+    cacheRecorder->addSource(path, false);
+  }
   readXML(path.str(), *this);
 }
 
+void FGTrafficManager::loadCache(const FGScheduleCache& cache)
+{
+    for (unsigned i = 0; i < cache.size(); i++) {
+        if (cache.getType(i) == FGScheduleCache::AIRCRAFT) {
+            const FGScheduleCache::Aircraft& a = cache.getAircraft(i);
+            mdl = a.model;
+            livery = a.livery;
+            homePort = a.homePort;
+            registration = a.registration;
+            requiredAircraft = a.requiredAircraft;
+            acType = a.acType;
+            airline = a.airline;
+            m_class = a.m_class;
+            flighttype = a.flighttype;
+            heavy = a.heavy;
+            radius = a.radius;
+            offset = a.offset;
+            endAircraft();
+        } else {
+            const FGScheduleCache::Flight& f = cache.getFlight(i);
+            callsign = f.callsign;
+            fltrules = f.fltrules;
+            departurePort = f.departurePort;
+            arrivalPort = f.arrivalPort;
+            departureTime = f.departureTime;
+            arrivalTime = f.arrivalTime;
+            repeat = f.repeat;
+            requiredAircraft = f.requiredAircraft;
+            cruiseAlt = f.cruiseAlt;
+            addFlight();
+        }
+    }
+}
+
+bool FGTrafficManager::rebuildCache()
+{
+    // the startup parse may be writing the same cache file; once the
+    // schedules are loaded, its thread is joined before starting another
+    if (doingInit && !inited) {
+        SG_LOG(SG_AI, SG_WARN, "traffic schedules still loading, not rebuilding the cache");
+        return false;
+    }
+    if (scheduleParser.get()) {
+        scheduleParser->join();
+        scheduleParser.reset();
+    }
+
+    if (cacheRebuilder.get() && !cacheRebuilder->isFinished()) {
+        SG_LOG(SG_AI, SG_WARN, "traffic schedule cache rebuild already running");
+        return false;
+    }
+
+    // the schedules are parsed into a manager of their own, which only
+    // records them, so the running traffic is left alone
+    cacheRebuilder.reset();
+    cacheParser.reset(new FGTrafficManager);
+    cacheParser->recordOnly = true;
+
+    cacheRebuilder.reset(new ScheduleParseThread(cacheParser.get()));
+    cacheRebuilder->setTrafficDir(SGPath(globals->get_fg_root(), "AI/Traffic"));
+    cacheRebuilder->setRebuild(true);
+    cacheRebuilder->start();
+    return true;
+}
+
 void FGTrafficManager::init()
 {
     if (!enabled) {
@@ -244,6 +402,7 @@ void FGTrafficManager::init()
     if (string(fgGetString("/sim/traffic-manager/datafile")).empty()) {
         scheduleParser.reset(new ScheduleParseThread(this));
         scheduleParser->setTrafficDir(SGPath(globals->get_fg_root(), "AI/Traffic"));      
+        scheduleParser->setUseCache(fgGetBool("/sim/traffic-manager/use-cache", true));
         scheduleParser->start();
     } else {
         fgSetBool("/sim/traffic-manager/heuristics", false);
@@ -624,6 +783,9 @@ void FGTrafficManager::startElement(const char *name,
         SGPath path = globals->get_fg_root();
         path.append("/Traffic/");
         path.append(attval);
+        if (cacheRecorder) {
+            cacheRecorder->addSource(path, true);
+        }
         readXML(path.str(), *this);
     }
     elementValueStack.push_back("");
@@ -683,55 +845,7 @@ void FGTrafficManager::endElement(const char *name)
     else if (!strcmp(name, "flight")) {
         // We have loaded and parsed all the information belonging to this flight
         // so we temporarily store it. 
-        //cerr << "Pusing back flight " << callsign << endl;
-        //cerr << callsign  <<  " " << fltrules     << " "<< departurePort << " " <<  arrivalPort << " "
-        //   << cruiseAlt <<  " " << departureTime<< " "<< arrivalTime   << " " << repeat << endl;
-
-        //Prioritize aircraft 
-        string apt = fgGetString("/sim/presets/airport-id");
-        //cerr << "Airport information: " << apt << " " << departurePort << " " << arrivalPort << endl;
-        //if (departurePort == apt) score++;
-        //flights.push_back(new FGScheduledFlight(callsign,
-        //                                fltrules,
-        //                                departurePort,
-        //                                arrivalPort,
-        //                                cruiseAlt,
-        //                                departureTime,
-        //                                arrivalTime,
-        //                                repeat));
-        if (requiredAircraft == "") {
-            char buffer[16];
-            snprintf(buffer, 16, "%d", acCounter);
-            requiredAircraft = buffer;
-        }
-        SG_LOG(SG_AI, SG_DEBUG, "Adding flight: " << callsign << " "
-               << fltrules << " "
-               << departurePort << " "
-               << arrivalPort << " "
-               << cruiseAlt << " "
-               << departureTime << " "
-               << arrivalTime << " " << repeat << " " << requiredAircraft);
-        // For database maintainance purposes, it may be convenient to
-        // 
-        if (fgGetBool("/sim/traffic-manager/dumpdata") == true) {
-             SG_LOG(SG_AI, SG_ALERT, "Traffic Dump FLIGHT," << callsign << ","
-                          << fltrules << ","
-                          << departurePort << ","
-                          << arrivalPort << ","
-                          << cruiseAlt << ","
-                          << departureTime << ","
-                          << arrivalTime << "," << repeat << "," << requiredAircraft);
-        }
-        flights[requiredAircraft].push_back(new FGScheduledFlight(callsign,
-                                                                  fltrules,
-                                                                  departurePort,
-                                                                  arrivalPort,
-                                                                  cruiseAlt,
-                                                                  departureTime,
-                                                                  arrivalTime,
-                                                                  repeat,
-                                                                  requiredAircraft));
-        requiredAircraft = "";
+        addFlight();
     } else if (!strcmp(name, "aircraft")) {
         endAircraft();
     }
@@ -739,8 +853,100 @@ void FGTrafficManager::endElement(const char *name)
     elementValueStack.pop_back();
 }
 
+void FGTrafficManager::addFlight()
+{
+    if (cacheRecorder) {
+        FGScheduleCache::Flight f;
+        f.callsign = callsign;
+        f.fltrules = fltrules;
+        f.departurePort = departurePort;
+        f.arrivalPort = arrivalPort;
+        f.departureTime = departureTime;
+        f.arrivalTime = arrivalTime;
+        f.repeat = repeat;
+        f.requiredAircraft = requiredAircraft;
+        f.cruiseAlt = cruiseAlt;
+        cacheRecorder->addFlight(f);
+        if (recordOnly) {
+            requiredAircraft = "";
+            return;
+        }
+    }
+
+    //cerr << "Pusing back flight " << callsign << endl;
+    //cerr << callsign  <<  " " << fltrules     << " "<< departurePort << " " <<  arrivalPort << " "
+    //   << cruiseAlt <<  " " << departureTime<< " "<< arrivalTime   << " " << repeat << endl;
+
+    //Prioritize aircraft 
+    string apt = fgGetString("/sim/presets/airport-id");
+    //cerr << "Airport information: " << apt << " " << departurePort << " " << arrivalPort << endl;
+    //if (departurePort == apt) score++;
+    //flights.push_back(new FGScheduledFlight(callsign,
+    //                                fltrules,
+    //                                departurePort,
+    //                                arrivalPort,
+    //                                cruiseAlt,
+    //                                departureTime,
+    //                                arrivalTime,
+    //                                repeat));
+    if (requiredAircraft == "") {
+        char buffer[16];
+        snprintf(buffer, 16, "%d", acCounter);
+        requiredAircraft = buffer;
+    }
+    SG_LOG(SG_AI, SG_DEBUG, "Adding flight: " << callsign << " "
+           << fltrules << " "
+           << departurePort << " "
+           << arrivalPort << " "
+           << cruiseAlt << " "
+           << departureTime << " "
+           << arrivalTime << " " << repeat << " " << requiredAircraft);
+    // For database maintainance purposes, it may be convenient to
+    // 
+    if (fgGetBool("/sim/traffic-manager/dumpdata") == true) {
+         SG_LOG(SG_AI, SG_ALERT, "Traffic Dump FLIGHT," << callsign << ","
+                      << fltrules << ","
+                      << departurePort << ","
+                      << arrivalPort << ","
+                      << cruiseAlt << ","
+                      << departureTime << ","
+                      << arrivalTime << "," << repeat << "," << requiredAircraft);
+    }
+    flights[requiredAircraft].push_back(new FGScheduledFlight(callsign,
+                                                              fltrules,
+                                                              departurePort,
+                                                              arrivalPort,
+                                                              cruiseAlt,
+                                                              departureTime,
+                                                              arrivalTime,
+                                                              repeat,
+                                                              requiredAircraft));
+    requiredAircraft = "";
+}
+
 void FGTrafficManager::endAircraft()
 {
+    if (cacheRecorder) {
+        FGScheduleCache::Aircraft a;
+        a.model = mdl;
+        a.livery = livery;
+        a.homePort = homePort;
+        a.registration = registration;
+        a.requiredAircraft = requiredAircraft;
+        a.acType = acType;
+        a.airline = airline;
+        a.m_class = m_class;
+        a.flighttype = flighttype;
+        a.heavy = heavy;
+        a.radius = radius;
+        a.offset = offset;
+        cacheRecorder->addAircraft(a);
+        if (recordOnly) {
+            requiredAircraft = homePort = "";
+            return;
+        }
+    }
+
     string isHeavy = heavy ? "true" : "false";
 
     if (missingModels.find(mdl) != missingModels.end()) {
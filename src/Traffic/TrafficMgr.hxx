@@ -57,6 +57,7 @@
 
 #include "SchedFlight.hxx"
 #include "Schedule.hxx"
+#include "ScheduleCache.hxx"
 
 class Heuristic
 {
@@ -102,6 +103,12 @@ private:
   bool heavy;
     
   FGScheduledFlightMap flights;
+  // while parsing, the aircraft and flights read are also added to this;
+  // with recordOnly, they are not used otherwise
+  FGScheduleCache* cacheRecorder;
+  bool recordOnly;
+  // the same flights by departure airport, built when first needed
+  std::map<std::string, FGScheduledFlightQueueMap> flightQueues;
 
   void readTimeTableFromFile(SGPath infilename);
   void Tokenize(const string& str, vector<string>& tokens, const string& delimiters = " ");
@@ -115,11 +122,22 @@ private:
   
   friend class ScheduleParseThread;
   std::auto_ptr<ScheduleParseThread> scheduleParser;
+
+  // rewriting the schedule cache, see rebuildCache; the thread is
+  // declared last so it is stopped before its parser is destroyed
+  std::auto_ptr<FGTrafficManager> cacheParser;
+  std::auto_ptr<ScheduleParseThread> cacheRebuilder;
   
   // helper to read and parse the schedule data.
   // this is run on a helper thread, so be careful about
   // accessing properties during parsing
   void parseSchedule(const SGPath& path);
+
+  // create the aircraft and flights from a schedule cache, as if
+  // they were parsed; run on the helper thread as well
+  void loadCache(const FGScheduleCache& cache);
+
+  void addFlight();
   
   bool metarReady(double dt);
 
@@ -131,6 +149,21 @@ public:
 
   FGScheduledFlightVecIterator getFirstFlight(const string &ref) { return flights[ref].begin(); }
   FGScheduledFlightVecIterator getLastFlight(const string &ref) { return flights[ref].end(); }
+  FGScheduledFlightQueueMap& getFlightQueues(const string &ref);
+
+  /**
+   * Schedule all aircraft from scratch, once with the flight queues and
+   * once searching all flights, without keeping the result. The times
+   * and number of flights found are written to the result node.
+   */
+  void benchmark(SGPropertyNode* result);
+
+  /**
+   * Start parsing the traffic files in FG_ROOT on a helper thread, and
+   * writing the schedule cache used to skip parsing at startup, whether
+   * or not it is current. Returns false if a rebuild is already running.
+   */
+  bool rebuildCache();
 
   void endAircraft();
   
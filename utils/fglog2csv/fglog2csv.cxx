@@ -0,0 +1,144 @@
+// fglog2csv - convert a binary FlightGear property log to CSV.
+//
+// This file is in the Public Domain, and comes with no warranty.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <simgear/misc/stdint.hxx>
+
+#include <Main/logger_binary.hxx>
+
+using std::string;
+using std::vector;
+
+static void
+usage ()
+{
+  fprintf(stderr, "Usage:  fglog2csv [-d <delimiter>] [-p] <infile> [<outfile>]\n");
+  fprintf(stderr, "  -d  field delimiter (default ',')\n");
+  fprintf(stderr, "  -p  use the property paths instead of the titles\n");
+}
+
+static void
+writeValue (FILE *out, const char *p, FGBinaryLogFormat::Type type)
+{
+  switch (type) {
+  case FGBinaryLogFormat::TYPE_BOOL: {
+    uint8_t v;
+    memcpy(&v, p, sizeof(v));
+    fputs(v ? "true" : "false", out);
+    break;
+  }
+  case FGBinaryLogFormat::TYPE_INT: {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    fprintf(out, "%d", (int) v);
+    break;
+  }
+  case FGBinaryLogFormat::TYPE_LONG: {
+    int64_t v;
+    memcpy(&v, p, sizeof(v));
+    fprintf(out, "%lld", (long long) v);
+    break;
+  }
+  case FGBinaryLogFormat::TYPE_FLOAT: {
+    float v;
+    memcpy(&v, p, sizeof(v));
+    fprintf(out, "%.9g", v);
+    break;
+  }
+  case FGBinaryLogFormat::TYPE_DOUBLE: {
+    double v;
+    memcpy(&v, p, sizeof(v));
+    fprintf(out, "%.17g", v);
+    break;
+  }
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  char delimiter = ',';
+  bool paths = false;
+  vector<string> files;
+
+  for (int i = 1; i < argc; i++) {
+    string s = argv[i];
+    if (s == "-h" || s == "--help") {
+      usage();
+      return 0;
+    } else if (s == "-d") {
+      if (i + 1 == argc || argv[i + 1][0] == 0) {
+        usage();
+        return 1;
+      }
+      delimiter = argv[++i][0];
+    } else if (s == "-p") {
+      paths = true;
+    } else {
+      files.push_back(s);
+    }
+  }
+
+  if (files.empty() || files.size() > 2) {
+    usage();
+    return 1;
+  }
+
+  FILE *in = fopen(files[0].c_str(), "rb");
+  if (!in) {
+    fprintf(stderr, "Error: cannot open %s\n", files[0].c_str());
+    return 2;
+  }
+
+  FGBinaryLogFormat format;
+  if (!format.readHeader(in)) {
+    fprintf(stderr, "Error: %s is not a binary log written by this "
+            "version, or on a machine of different byte order\n",
+            files[0].c_str());
+    fclose(in);
+    return 2;
+  }
+
+  FILE *out = stdout;
+  if (files.size() > 1) {
+    out = fopen(files[1].c_str(), "w");
+    if (!out) {
+      fprintf(stderr, "Error: cannot write %s\n", files[1].c_str());
+      fclose(in);
+      return 2;
+    }
+  }
+
+  const vector<FGBinaryLogFormat::Column> &columns = format.columns();
+  fputs("Time", out);
+  for (unsigned int i = 0; i < columns.size(); i++) {
+    fputc(delimiter, out);
+    fputs(paths ? columns[i].path.c_str() : columns[i].title.c_str(), out);
+  }
+  fputc('\n', out);
+
+  vector<char> record(format.recordSize());
+  unsigned int count = 0;
+  while (fread(&record[0], record.size(), 1, in) == 1) {
+    writeValue(out, &record[0], FGBinaryLogFormat::TYPE_DOUBLE);
+    for (unsigned int i = 0; i < columns.size(); i++) {
+      fputc(delimiter, out);
+      writeValue(out, &record[columns[i].offset], columns[i].type);
+    }
+    fputc('\n', out);
+    count++;
+  }
+
+  fclose(in);
+  if (out != stdout)
+    fclose(out);
+
+  fprintf(stderr, "%u records converted\n", count);
+  return 0;
+}